@@ -58,8 +58,16 @@ struct codec_model_params {
     int32_t n_threads;
 };
 
+struct lm_ggml_backend_arena;
+
 struct codec_context_params {
     int32_t seed;
+    // optional host compute arena shared with contexts that never compute at the same time
+    // (see lm_ggml_backend_arena_new), must outlive the context
+    struct lm_ggml_backend_arena * compute_arena;
+    // compute on a backend instance of its own (on the model's device) instead of the model's,
+    // so the context can run concurrently with other contexts of the same model
+    bool own_backend;
 };
 
 struct codec_encode_params {
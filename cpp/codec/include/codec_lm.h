@@ -362,6 +362,42 @@ enum codec_status codec_lm_step_finish(
     struct codec_lm_state * st,
     int32_t *               out_codes);  // [n_codebook]
 
+// ─────────────────────────────────────────────────────────────────────
+// Batched step machine: advance `n_seq` states of the SAME codec_lm in
+// lock-step, one graph per codebook instead of one per state.  Used to
+// run several utterances as parallel backbone sequences.
+//
+//   codec_lm_step_begin_batch(states, n, h);      // h: [n * hidden_dim]
+//   for (int k = 0; k < info->n_codebook; ++k) {
+//       const float * logits[n]; int32_t cb_idx, vocab;
+//       codec_lm_step_logits_batch(states, n, logits, &cb_idx, &vocab);
+//       for (int s = 0; s < n; ++s)
+//           codec_lm_step_push_code(states[s], caller_sample(logits[s], vocab));
+//   }
+//   for (int s = 0; s < n; ++s) codec_lm_step_finish(states[s], codes[s]);
+//
+// Each state keeps its own invariants exactly as with the single-state
+// calls; every state must be in the same phase (same `next_cb`) or the
+// call returns INVALID_STATE without touching any of them.  Kinds that
+// cannot batch a given step fall back to per-state evaluation, so the
+// results always match the single-state API.
+// ─────────────────────────────────────────────────────────────────────
+
+enum codec_status codec_lm_step_begin_batch(
+    struct codec_lm_state ** states,
+    int32_t                  n_seq,
+    const float *            h_in);      // [n_seq * hidden_dim], seq-major
+
+// `out_logits[s]` receives state s's logits pointer (same lifetime as
+// codec_lm_step_logits).  `out_cb_idx` / `out_n` are shared by all
+// states since they are at the same codebook.
+enum codec_status codec_lm_step_logits_batch(
+    struct codec_lm_state ** states,
+    int32_t                  n_seq,
+    const float **           out_logits, // [n_seq]
+    int32_t *                out_cb_idx,
+    int32_t *                out_n);
+
 // ─────────────────────────────────────────────────────────────────────
 // End-of-audio decision (codebook kinds only).
 //
@@ -275,6 +275,8 @@ struct codec_model_params codec_model_default_params(void) {
 struct codec_context_params codec_context_default_params(void) {
     struct codec_context_params result = {
         /*.seed =*/ CODEC_DEFAULT_SEED,
+        /*.compute_arena =*/ nullptr,
+        /*.own_backend =*/ false,
     };
 
     return result;
@@ -523,6 +525,8 @@ static enum codec_status codec_encode_impl(
         return CODEC_STATUS_INVALID_ARG;
     }
 
+    codec_arena_lease lease(ctx);
+
     codec_token_buffer_free(out_tokens);
     if (out_latent != nullptr) {
         codec_latent_buffer_free(out_latent);
@@ -593,6 +597,8 @@ enum codec_status codec_decode(
         return CODEC_STATUS_INVALID_ARG;
     }
 
+    codec_arena_lease lease(ctx);
+
     codec_pcm_buffer_free(out_pcm);
     codec_context_set_error(ctx, "");
 
@@ -622,6 +628,8 @@ enum codec_status codec_decode_quantized_representation(
         return CODEC_STATUS_INVALID_ARG;
     }
 
+    codec_arena_lease lease(ctx);
+
     codec_pcm_buffer_free(out_pcm);
     codec_context_set_error(ctx, "");
 
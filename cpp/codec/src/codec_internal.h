@@ -9,6 +9,8 @@
 
 #include <string>
 #include <cstdint>
+#include <initializer_list>
+#include <unordered_map>
 #include <vector>
 
 struct codec_model {
@@ -60,6 +62,22 @@ struct codec_graph_cache_key {
 
     // Latent decode shapes
     int32_t latent_dim = 0; // DAC latent dimension
+
+    bool operator==(const codec_graph_cache_key & o) const {
+        return kind == o.kind && n_frames == o.n_frames && n_q == o.n_q &&
+               hop == o.hop && n_in == o.n_in && latent_dim == o.latent_dim;
+    }
+};
+
+struct codec_graph_cache_key_hash {
+    size_t operator()(const codec_graph_cache_key & k) const {
+        uint64_t h = 0;
+        for (int32_t v : { k.kind, k.n_frames, k.n_q, k.hop, k.n_in, k.latent_dim }) {
+            h = (h ^ (uint32_t) v) * 11400714819323198485llu;
+            h ^= h >> 29;
+        }
+        return (size_t) h;
+    }
 };
 
 typedef bool (*codec_graph_build_fn)(lm_ggml_context * ctx_eval, void * user_data, lm_ggml_tensor ** out);
@@ -71,16 +89,20 @@ struct codec_graph_cache_entry {
     std::vector<uint8_t> build_user_data;
     int32_t last_graph_size = 0; // exact ggml graph capacity: max(n_nodes, n_leafs)
     int32_t last_sched_graph_size = 0; // exact scheduler base size: n_nodes + n_leafs
+    uint64_t last_used = 0; // graph_cache_tick of the last lookup, for LRU eviction
 };
 
 struct codec_context {
     struct codec_model * model;
     lm_ggml_backend_t backend = nullptr;
     lm_ggml_backend_t cpu_backend = nullptr;
+    lm_ggml_backend_t owned_backend = nullptr; // set with params.own_backend, aliased by backend
     lm_ggml_backend_sched_t sched = nullptr;
     struct codec_context_params params;
     std::string last_error;
-    std::vector<codec_graph_cache_entry> graph_cache;
+    // Node-based so entry pointers (eval_entry, callers' out_entry) stay valid across inserts.
+    std::unordered_map<codec_graph_cache_key, codec_graph_cache_entry, codec_graph_cache_key_hash> graph_cache;
+    uint64_t graph_cache_tick = 0;
     void * eval_arena_buf = nullptr;
     size_t eval_arena_size = 0;
     lm_ggml_context * eval_ctx = nullptr;
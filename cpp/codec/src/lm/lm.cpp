@@ -699,6 +699,119 @@ enum codec_status codec_lm_step_finish(
     return CODEC_STATUS_SUCCESS;
 }
 
+// Batched variants: check every state up front so a phase mismatch
+// leaves all of them untouched, then dispatch to the kind's batched
+// entry point or loop the single-state one.
+static bool codec_lm_batch_states_valid(struct codec_lm_state ** states, int32_t n_seq) {
+    if (states == nullptr || n_seq <= 0 || states[0] == nullptr ||
+        states[0]->lm == nullptr || states[0]->lm->vtable == nullptr) {
+        return false;
+    }
+    for (int32_t s = 1; s < n_seq; ++s) {
+        if (states[s] == nullptr || states[s]->lm != states[0]->lm) {
+            return false;
+        }
+    }
+    return true;
+}
+
+enum codec_status codec_lm_step_begin_batch(
+    struct codec_lm_state ** states,
+    int32_t n_seq,
+    const float * h_in) {
+    if (!codec_lm_batch_states_valid(states, n_seq) || h_in == nullptr) {
+        return CODEC_STATUS_INVALID_ARG;
+    }
+    const codec_lm_kind_vtable * vt = states[0]->lm->vtable;
+    if (vt->step_begin == nullptr) {
+        return CODEC_STATUS_NOT_SUPPORTED;
+    }
+    for (int32_t s = 0; s < n_seq; ++s) {
+        if (states[s]->step_in_progress) {
+            states[s]->last_error = "codec_lm_step_begin_batch: step already in progress";
+            return CODEC_STATUS_INVALID_STATE;
+        }
+    }
+
+    for (int32_t s = 0; s < n_seq; ++s) {
+        codec_lm_state * st = states[s];
+        st->next_cb        = 0;
+        st->logits_pending = false;
+        std::fill(st->codes_buf.begin(), st->codes_buf.end(), 0);
+    }
+
+    if (vt->step_begin_batch != nullptr && n_seq > 1) {
+        enum codec_status rc = vt->step_begin_batch(states, n_seq, h_in);
+        if (rc != CODEC_STATUS_SUCCESS) {
+            return rc;
+        }
+    } else {
+        const size_t hidden = (size_t) states[0]->lm->info.hidden_dim;
+        for (int32_t s = 0; s < n_seq; ++s) {
+            enum codec_status rc = vt->step_begin(states[s], h_in + (size_t) s * hidden);
+            if (rc != CODEC_STATUS_SUCCESS) {
+                return rc;
+            }
+        }
+    }
+    for (int32_t s = 0; s < n_seq; ++s) {
+        states[s]->step_in_progress = true;
+    }
+    return CODEC_STATUS_SUCCESS;
+}
+
+enum codec_status codec_lm_step_logits_batch(
+    struct codec_lm_state ** states,
+    int32_t n_seq,
+    const float ** out_logits,
+    int32_t * out_cb_idx,
+    int32_t * out_n) {
+    if (!codec_lm_batch_states_valid(states, n_seq) || out_logits == nullptr) {
+        return CODEC_STATUS_INVALID_ARG;
+    }
+    const codec_lm * lm = states[0]->lm;
+    const int32_t cb = states[0]->next_cb;
+    for (int32_t s = 0; s < n_seq; ++s) {
+        codec_lm_state * st = states[s];
+        if (!st->step_in_progress || st->logits_pending || st->next_cb != cb) {
+            st->last_error = "codec_lm_step_logits_batch: states are not at the same codebook";
+            return CODEC_STATUS_INVALID_STATE;
+        }
+    }
+    if (cb >= lm->info.n_codebook) {
+        states[0]->last_error = "codec_lm_step_logits_batch called past n_codebook";
+        return CODEC_STATUS_INVALID_STATE;
+    }
+    if (lm->vtable->step_logits == nullptr) {
+        return CODEC_STATUS_NOT_SUPPORTED;
+    }
+
+    if (lm->vtable->step_logits_batch != nullptr && n_seq > 1) {
+        enum codec_status rc = lm->vtable->step_logits_batch(states, n_seq, out_logits);
+        if (rc != CODEC_STATUS_SUCCESS) {
+            return rc;
+        }
+    } else {
+        for (int32_t s = 0; s < n_seq; ++s) {
+            int32_t cb_idx = -1;
+            out_logits[s] = lm->vtable->step_logits(states[s], &cb_idx, nullptr);
+            if (out_logits[s] == nullptr) {
+                return CODEC_STATUS_INTERNAL_ERROR;
+            }
+            if (cb_idx != cb) {
+                states[s]->last_error = "kind step_logits returned wrong cb_idx (state machine corrupted)";
+                return CODEC_STATUS_INTERNAL_ERROR;
+            }
+        }
+    }
+    for (int32_t s = 0; s < n_seq; ++s) {
+        states[s]->logits_pending = true;
+    }
+    if (out_cb_idx != nullptr) *out_cb_idx = cb;
+    if (out_n      != nullptr) *out_n      = lm->info.codebook_sizes[cb];
+    return CODEC_STATUS_SUCCESS;
+}
+
 // ---------------------------------------------------------------------
 // End-of-audio decision
 // ---------------------------------------------------------------------
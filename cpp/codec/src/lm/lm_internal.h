@@ -161,6 +161,14 @@ struct codec_lm_kind_vtable {
     // tests): the reference patch replaces the codec's own patch as the cond +
     // LocEnc feedback source.  NULL for other kinds.
     enum codec_status (*set_teacher_patch)(codec_lm_state * st, const float * patch, int32_t n);
+
+    // Batched step machine across `n_seq` states of the same codec_lm,
+    // all at the same codebook.  lm.cpp has already checked the phase of
+    // every state.  `h_in` is [n_seq * hidden_dim], seq-major; logits
+    // land in `out_logits[s]` for state `s`.  NULL → lm.cpp loops the
+    // single-state entry points instead.
+    enum codec_status (*step_begin_batch)(codec_lm_state ** states, int32_t n_seq, const float * h_in);
+    enum codec_status (*step_logits_batch)(codec_lm_state ** states, int32_t n_seq, const float ** out_logits);
 };
 
 // Map between the GGUF string and the C enum.  Returns
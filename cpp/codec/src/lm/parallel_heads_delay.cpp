@@ -33,7 +33,9 @@
 //   single [hidden_dim] vector named `lm.compose.out`.
 //
 // Both graphs are fixed-shape per (hidden_dim, n_codebook), so the
-// state's codec_context graph cache hits after the first call.
+// state's codec_context graph cache hits after the first call.  The
+// logits graph also takes `n_seq` hidden columns at once so batched
+// states share one matmul per head (step_begin_batch).
 // =====================================================================
 
 namespace {
@@ -76,6 +78,7 @@ struct phd_state {
 struct phd_logits_build_data {
     phd_impl *  impl;
     int32_t     hidden_dim;
+    int32_t     n_seq;      // columns of h_in (one per batched state)
 };
 
 struct phd_compose_build_data {
@@ -94,13 +97,13 @@ bool phd_build_logits(lm_ggml_context * ctx_eval, void * user_data, lm_ggml_tens
     }
     phd_impl * impl = b->impl;
 
-    // Input: backbone hidden state, shape [hidden, 1].
-    lm_ggml_tensor * t_h = lm_ggml_new_tensor_2d(ctx_eval, LM_GGML_TYPE_F32, b->hidden_dim, 1);
+    // Input: backbone hidden states, shape [hidden, n_seq].
+    lm_ggml_tensor * t_h = lm_ggml_new_tensor_2d(ctx_eval, LM_GGML_TYPE_F32, b->hidden_dim, b->n_seq);
     lm_ggml_set_name(t_h, "lm.step.h_in");
 
     // For each codebook, compute logits = head @ h.  lm_ggml_mul_mat
     // contracts on ne[0] of both operands; head has ne=[hidden, vocab],
-    // h has ne=[hidden, 1], so result is [vocab, 1].  Mark every per-cb
+    // h has ne=[hidden, n_seq], so result is [vocab, n_seq].  Mark every per-cb
     // logits tensor as a graph output so galloc keeps each row pinned
     // (only the terminal is auto-flagged by the runtime; the other N-1
     // would otherwise be reused after their last graph use).
@@ -296,78 +299,105 @@ void state_reset(codec_lm_state * st) {
 // step machine
 // ---------------------------------------------------------------------
 
-enum codec_status step_begin(codec_lm_state * st, const float * h_in) {
-    if (st == nullptr || h_in == nullptr) {
-        return CODEC_STATUS_INVALID_ARG;
-    }
-    phd_impl * impl = static_cast<phd_impl *>(st->lm->impl);
-    phd_state * sst = static_cast<phd_state *>(st->impl);
+// Evaluate all heads for `n_seq` states in one graph on the first
+// state's context.  Each state's hidden is one column of h_in; each
+// [vocab, n_seq] logits tensor is scattered back into the per-state
+// scratch buffers.
+enum codec_status phd_run_logits(codec_lm_state ** states, int32_t n_seq, const float * h_in) {
+    codec_lm_state * lead = states[0];
+    phd_impl * impl = static_cast<phd_impl *>(lead->lm->impl);
 
-    phd_logits_build_data build = { impl, impl->hidden_dim };
+    phd_logits_build_data build = { impl, impl->hidden_dim, n_seq };
 
-    codec_graph_eval_guard guard(st->ctx);
+    codec_graph_eval_guard guard(lead->ctx);
     std::string err;
     codec_graph_cache_entry * entry = nullptr;
     codec_graph_cache_key key = {};
-    key.kind   = CODEC_GRAPH_LM_PARALLEL_HEADS_LOGITS;
-    key.n_q    = impl->n_codebook;
-    key.n_in   = impl->hidden_dim;
+    key.kind     = CODEC_GRAPH_LM_PARALLEL_HEADS_LOGITS;
+    key.n_frames = n_seq;
+    key.n_q      = impl->n_codebook;
+    key.n_in     = impl->hidden_dim;
 
     if (!codec_graph_cache_get_or_build(
-            st->ctx,
+            lead->ctx,
             key,
             phd_build_logits,
             &build,
             sizeof(build),
             &entry,
             &err)) {
-        st->last_error = err;
+        lead->last_error = err;
         return CODEC_STATUS_INTERNAL_ERROR;
     }
 
-    lm_ggml_tensor * t_h = codec_graph_get_tensor(st->ctx, entry, "lm.step.h_in");
+    lm_ggml_tensor * t_h = codec_graph_get_tensor(lead->ctx, entry, "lm.step.h_in");
     if (t_h == nullptr) {
-        st->last_error = "logits graph missing input tensor";
+        lead->last_error = "logits graph missing input tensor";
         return CODEC_STATUS_INTERNAL_ERROR;
     }
 
-    if (!codec_graph_prepare_io(st->ctx, entry, &err)) {
-        st->last_error = err;
+    if (!codec_graph_prepare_io(lead->ctx, entry, &err)) {
+        lead->last_error = err;
         return CODEC_STATUS_INTERNAL_ERROR;
     }
-    if (!codec_runtime_write_tensor(t_h, h_in, (size_t) impl->hidden_dim * sizeof(float), &err)) {
-        st->last_error = err;
+    if (!codec_runtime_write_tensor(t_h, h_in, (size_t) impl->hidden_dim * (size_t) n_seq * sizeof(float), &err)) {
+        lead->last_error = err;
         return CODEC_STATUS_INTERNAL_ERROR;
     }
-    const int32_t n_threads = st->lm->codec->n_threads > 0 ? st->lm->codec->n_threads : 1;
-    if (!codec_graph_compute(st->ctx, entry, n_threads, &err)) {
-        st->last_error = err;
+    const int32_t n_threads = lead->lm->codec->n_threads > 0 ? lead->lm->codec->n_threads : 1;
+    if (!codec_graph_compute(lead->ctx, entry, n_threads, &err)) {
+        lead->last_error = err;
         return CODEC_STATUS_INTERNAL_ERROR;
     }
 
-    // Copy each logits tensor into the state's per-cb scratch.
+    // Copy each logits tensor into the states' per-cb scratch.
+    std::vector<float> batch_logits;
     char buf[64];
     for (int32_t i = 0; i < impl->n_codebook; ++i) {
         std::snprintf(buf, sizeof(buf), "lm.step.logits_%d", i);
-        lm_ggml_tensor * t_lg = codec_graph_get_tensor(st->ctx, entry, buf);
+        lm_ggml_tensor * t_lg = codec_graph_get_tensor(lead->ctx, entry, buf);
         if (t_lg == nullptr) {
-            st->last_error = std::string("logits graph missing output: ") + buf;
+            lead->last_error = std::string("logits graph missing output: ") + buf;
             return CODEC_STATUS_INTERNAL_ERROR;
         }
-        const int32_t vocab = st->lm->info.codebook_sizes[i];
+        const int32_t vocab = lead->lm->info.codebook_sizes[i];
         const size_t n_bytes = (size_t) vocab * sizeof(float);
-        if (!codec_runtime_read_tensor(
-                t_lg,
-                sst->logits_buf[(size_t) i].data(),
-                n_bytes,
-                &err)) {
-            st->last_error = err;
+        if (n_seq == 1) {
+            phd_state * sst = static_cast<phd_state *>(lead->impl);
+            if (!codec_runtime_read_tensor(t_lg, sst->logits_buf[(size_t) i].data(), n_bytes, &err)) {
+                lead->last_error = err;
+                return CODEC_STATUS_INTERNAL_ERROR;
+            }
+            continue;
+        }
+        batch_logits.resize((size_t) vocab * (size_t) n_seq);
+        if (!codec_runtime_read_tensor(t_lg, batch_logits.data(), n_bytes * (size_t) n_seq, &err)) {
+            lead->last_error = err;
             return CODEC_STATUS_INTERNAL_ERROR;
         }
+        for (int32_t s = 0; s < n_seq; ++s) {
+            phd_state * sst = static_cast<phd_state *>(states[s]->impl);
+            std::memcpy(sst->logits_buf[(size_t) i].data(),
+                        batch_logits.data() + (size_t) s * vocab, n_bytes);
+        }
     }
     return CODEC_STATUS_SUCCESS;
 }
 
+enum codec_status step_begin(codec_lm_state * st, const float * h_in) {
+    if (st == nullptr || h_in == nullptr) {
+        return CODEC_STATUS_INVALID_ARG;
+    }
+    return phd_run_logits(&st, 1, h_in);
+}
+
+enum codec_status step_begin_batch(codec_lm_state ** states, int32_t n_seq, const float * h_in) {
+    if (states == nullptr || n_seq <= 0 || h_in == nullptr) {
+        return CODEC_STATUS_INVALID_ARG;
+    }
+    return phd_run_logits(states, n_seq, h_in);
+}
+
 bool step_pending(const codec_lm_state * st) {
     return st != nullptr && st->next_cb < st->lm->info.n_codebook;
 }
@@ -383,6 +413,14 @@ const float * step_logits(codec_lm_state * st, int32_t * out_cb_idx, int32_t * o
     return sst->logits_buf[(size_t) cb].data();
 }
 
+enum codec_status step_logits_batch(codec_lm_state ** states, int32_t n_seq, const float ** out_logits) {
+    // Every head was evaluated for all states in step_begin_batch.
+    for (int32_t s = 0; s < n_seq; ++s) {
+        out_logits[s] = step_logits(states[s], nullptr, nullptr);
+    }
+    return CODEC_STATUS_SUCCESS;
+}
+
 enum codec_status step_push_code(codec_lm_state * st, int32_t code) {
     // Generic state machine in lm.cpp records `code` into st->codes_buf
     // and advances next_cb; nothing kind-specific to do here for
@@ -597,4 +635,11 @@ const codec_lm_kind_vtable codec_lm_vtable_parallel_heads_delay = {
     /*.compose_audio_embd =*/ compose_audio_embd,
     /*.compose_next_embd  =*/ compose_next_embd,
     /*.speaker_encode     =*/ nullptr,
+    /*.step_generate      =*/ nullptr,
+    /*.step_feedback_embd =*/ nullptr,
+    /*.text_prefill       =*/ nullptr,
+    /*.set_min_len        =*/ nullptr,
+    /*.set_teacher_patch  =*/ nullptr,
+    /*.step_begin_batch   =*/ step_begin_batch,
+    /*.step_logits_batch  =*/ step_logits_batch,
 };
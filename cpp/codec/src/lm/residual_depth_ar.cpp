@@ -328,17 +328,19 @@ static bool rda_copy_embd_row(
 // ---------------------------------------------------------------------
 
 // step_begin's c0 head graph:
-//   input:  t_h_in (hidden_dim,)
-//   output: c0_logits (vocab_0,)  via c0_head @ t_h_in.
+//   input:  t_h_in (hidden_dim, n_seq)
+//   output: c0_logits (vocab_0, n_seq)  via c0_head @ t_h_in.
+// n_seq > 1 when several states are stepped together (step_begin_batch).
 struct rda_c0_build {
     rda_impl * impl;
+    int32_t    n_seq;
 };
 
 bool rda_build_c0(lm_ggml_context * ctx_eval, void * ud, lm_ggml_tensor ** out) {
     auto * b = static_cast<rda_c0_build *>(ud);
     if (!ctx_eval || !b || !b->impl || !out) return false;
 
-    lm_ggml_tensor * t_h = lm_ggml_new_tensor_1d(ctx_eval, LM_GGML_TYPE_F32, b->impl->hidden_dim);
+    lm_ggml_tensor * t_h = lm_ggml_new_tensor_2d(ctx_eval, LM_GGML_TYPE_F32, b->impl->hidden_dim, b->n_seq);
     lm_ggml_set_name(t_h, "lm.c0.h_in");
 
     lm_ggml_tensor * head = codec_graph_mat_lhs(ctx_eval, b->impl->c0_head);
@@ -563,25 +565,29 @@ lm_ggml_tensor * rda_depth_layer_kv(
     bool    has_qk_norm,
     int32_t rope_mode,
     bool    use_rope,
-    lm_ggml_tensor * k_cache_l,
-    lm_ggml_tensor * v_cache_l,
-    int32_t kv_pos_start,
-    int32_t kv_total) {
-
-    const int64_t T_new  = x_ht->ne[1];
+    lm_ggml_tensor * const * k_cache_l,
+    lm_ggml_tensor * const * v_cache_l,
+    int32_t n_seq,
+    int32_t kv_pos_start) {
+
+    // x_ht holds n_seq sequences of T_new positions each, seq-major.
+    // Projections, RoPE and the FFN run over all columns at once; only
+    // attention is per sequence, against that sequence's own cache.
+    const int64_t T_all  = x_ht->ne[1];
+    const int64_t T_new  = T_all / n_seq;
     const int32_t q_dim  = n_heads    * head_dim;
     const int32_t kv_dim = n_kv_heads * head_dim;
 
     // ── Attention pre-norm + projections (T_new positions) ─────────
     lm_ggml_tensor * h = codec_op_rms_norm_ct(ctx, x_ht, rms_eps, w.attn_norm);
 
-    lm_ggml_tensor * q     = codec_op_lm_per_pos_linear(ctx, w.q, h, q_dim,  (int32_t) T_new);
-    lm_ggml_tensor * k_new = codec_op_lm_per_pos_linear(ctx, w.k, h, kv_dim, (int32_t) T_new);
-    lm_ggml_tensor * v_new = codec_op_lm_per_pos_linear(ctx, w.v, h, kv_dim, (int32_t) T_new);
+    lm_ggml_tensor * q     = codec_op_lm_per_pos_linear(ctx, w.q, h, q_dim,  (int32_t) T_all);
+    lm_ggml_tensor * k_new = codec_op_lm_per_pos_linear(ctx, w.k, h, kv_dim, (int32_t) T_all);
+    lm_ggml_tensor * v_new = codec_op_lm_per_pos_linear(ctx, w.v, h, kv_dim, (int32_t) T_all);
 
-    q     = lm_ggml_reshape_3d(ctx, q,     head_dim, n_heads,    T_new);
-    k_new = lm_ggml_reshape_3d(ctx, k_new, head_dim, n_kv_heads, T_new);
-    v_new = lm_ggml_reshape_3d(ctx, v_new, head_dim, n_kv_heads, T_new);
+    q     = lm_ggml_reshape_3d(ctx, q,     head_dim, n_heads,    T_all);
+    k_new = lm_ggml_reshape_3d(ctx, k_new, head_dim, n_kv_heads, T_all);
+    v_new = lm_ggml_reshape_3d(ctx, v_new, head_dim, n_kv_heads, T_all);
 
     if (has_qk_norm && w.q_norm && w.k_norm) {
         q     = codec_op_rms_norm_ct(ctx, q,     rms_eps, w.q_norm);
@@ -600,72 +606,90 @@ lm_ggml_tensor * rda_depth_layer_kv(
                               freq_scale, ext_factor, attn_factor, beta_fast, beta_slow);
     }
 
-    // ── Build the full K/V for attention via concat with cache ─────
-    lm_ggml_tensor * k_all;
-    lm_ggml_tensor * v_all;
-    if (kv_pos_start > 0) {
-        // Cache view (positions 0 .. kv_pos_start) → concat with new.
-        lm_ggml_tensor * k_old = lm_ggml_view_3d(ctx, k_cache_l,
-            head_dim, n_kv_heads, (int64_t) kv_pos_start,
-            k_cache_l->nb[1], k_cache_l->nb[2], 0);
-        lm_ggml_tensor * v_old = lm_ggml_view_3d(ctx, v_cache_l,
-            head_dim, n_kv_heads, (int64_t) kv_pos_start,
-            v_cache_l->nb[1], v_cache_l->nb[2], 0);
-        k_all = lm_ggml_concat(ctx, k_old, k_new, 2);
-        v_all = lm_ggml_concat(ctx, v_old, v_new, 2);
-    } else {
-        k_all = k_new;
-        v_all = v_new;
-    }
-
-    // ── GQA attention ───────────────────────────────────────────────
-    lm_ggml_tensor * q_p = lm_ggml_cont(ctx, lm_ggml_permute(ctx, q,     0, 2, 1, 3));
-    lm_ggml_tensor * k_p = lm_ggml_cont(ctx, lm_ggml_permute(ctx, k_all, 0, 2, 1, 3));
-
-    lm_ggml_tensor * scores = lm_ggml_mul_mat(ctx, k_p, q_p);
-    scores = lm_ggml_scale(ctx, scores, 1.0f / std::sqrt((float) head_dim));
-    // Causal mask offset by the already-cached prefix: q at relative
-    // position i (overall = kv_pos_start + i) can attend to k at
-    // overall positions 0..(kv_pos_start + i).  lm_ggml_diag_mask_inf
-    // masks scores[k_idx, q_idx, h] for k_idx > q_idx + n_past, exactly
-    // matching when n_past = kv_pos_start.  For T_new=1 the mask is a
-    // no-op (k_all length = kv_pos_start+1, all positions visible).
-    scores = lm_ggml_diag_mask_inf(ctx, scores, kv_pos_start);
-    scores = lm_ggml_soft_max(ctx, scores);
-
-    lm_ggml_tensor * v_p = lm_ggml_cont(ctx, lm_ggml_permute(ctx, v_all, 1, 2, 0, 3));
-    lm_ggml_tensor * attn = lm_ggml_mul_mat(ctx, v_p, scores);
-    attn = lm_ggml_cont(ctx, lm_ggml_permute(ctx, attn, 0, 2, 1, 3));
-    attn = lm_ggml_reshape_2d(ctx, attn, (int64_t) q_dim, T_new);
+    lm_ggml_tensor * attn_all = nullptr;
+    for (int32_t seq = 0; seq < n_seq; ++seq) {
+        lm_ggml_tensor * k_cache = k_cache_l[seq];
+        lm_ggml_tensor * v_cache = v_cache_l[seq];
+        lm_ggml_tensor * q_s = q;
+        lm_ggml_tensor * k_s = k_new;
+        lm_ggml_tensor * v_s = v_new;
+        if (n_seq > 1) {
+            q_s = lm_ggml_view_3d(ctx, q, head_dim, n_heads, T_new,
+                q->nb[1], q->nb[2], (size_t) seq * T_new * q->nb[2]);
+            k_s = lm_ggml_view_3d(ctx, k_new, head_dim, n_kv_heads, T_new,
+                k_new->nb[1], k_new->nb[2], (size_t) seq * T_new * k_new->nb[2]);
+            v_s = lm_ggml_view_3d(ctx, v_new, head_dim, n_kv_heads, T_new,
+                v_new->nb[1], v_new->nb[2], (size_t) seq * T_new * v_new->nb[2]);
+        }
+
+        // ── Build the full K/V for attention via concat with cache ─────
+        lm_ggml_tensor * k_all;
+        lm_ggml_tensor * v_all;
+        if (kv_pos_start > 0) {
+            // Cache view (positions 0 .. kv_pos_start) → concat with new.
+            lm_ggml_tensor * k_old = lm_ggml_view_3d(ctx, k_cache,
+                head_dim, n_kv_heads, (int64_t) kv_pos_start,
+                k_cache->nb[1], k_cache->nb[2], 0);
+            lm_ggml_tensor * v_old = lm_ggml_view_3d(ctx, v_cache,
+                head_dim, n_kv_heads, (int64_t) kv_pos_start,
+                v_cache->nb[1], v_cache->nb[2], 0);
+            k_all = lm_ggml_concat(ctx, k_old, k_s, 2);
+            v_all = lm_ggml_concat(ctx, v_old, v_s, 2);
+        } else {
+            k_all = k_s;
+            v_all = v_s;
+        }
+
+        // ── GQA attention ───────────────────────────────────────────────
+        lm_ggml_tensor * q_p = lm_ggml_cont(ctx, lm_ggml_permute(ctx, q_s,   0, 2, 1, 3));
+        lm_ggml_tensor * k_p = lm_ggml_cont(ctx, lm_ggml_permute(ctx, k_all, 0, 2, 1, 3));
+
+        lm_ggml_tensor * scores = lm_ggml_mul_mat(ctx, k_p, q_p);
+        scores = lm_ggml_scale(ctx, scores, 1.0f / std::sqrt((float) head_dim));
+        // Causal mask offset by the already-cached prefix: q at relative
+        // position i (overall = kv_pos_start + i) can attend to k at
+        // overall positions 0..(kv_pos_start + i).  lm_ggml_diag_mask_inf
+        // masks scores[k_idx, q_idx, h] for k_idx > q_idx + n_past, exactly
+        // matching when n_past = kv_pos_start.  For T_new=1 the mask is a
+        // no-op (k_all length = kv_pos_start+1, all positions visible).
+        scores = lm_ggml_diag_mask_inf(ctx, scores, kv_pos_start);
+        scores = lm_ggml_soft_max(ctx, scores);
+
+        lm_ggml_tensor * v_p = lm_ggml_cont(ctx, lm_ggml_permute(ctx, v_all, 1, 2, 0, 3));
+        lm_ggml_tensor * attn = lm_ggml_mul_mat(ctx, v_p, scores);
+        attn = lm_ggml_cont(ctx, lm_ggml_permute(ctx, attn, 0, 2, 1, 3));
+        attn = lm_ggml_reshape_2d(ctx, attn, (int64_t) q_dim, T_new);
+        attn_all = (attn_all == nullptr) ? attn : lm_ggml_concat(ctx, attn_all, attn, 1);
+
+        // ── Cache writes (side-effect roots) ────────────────────────────
+        // lm_ggml_cpy(src, dst) returns a view of dst; flag both with
+        // lm_ggml_set_output so the codec.cpp graph framework expands them as
+        // separate roots, guaranteeing they're executed in this compute.
+        lm_ggml_tensor * k_dst = lm_ggml_view_3d(ctx, k_cache,
+            head_dim, n_kv_heads, T_new,
+            k_cache->nb[1], k_cache->nb[2],
+            (size_t) kv_pos_start * k_cache->nb[2]);
+        lm_ggml_tensor * v_dst = lm_ggml_view_3d(ctx, v_cache,
+            head_dim, n_kv_heads, T_new,
+            v_cache->nb[1], v_cache->nb[2],
+            (size_t) kv_pos_start * v_cache->nb[2]);
+        lm_ggml_tensor * k_cpy = lm_ggml_cpy(ctx, k_s, k_dst);
+        lm_ggml_tensor * v_cpy = lm_ggml_cpy(ctx, v_s, v_dst);
+        lm_ggml_set_output(k_cpy);
+        lm_ggml_set_output(v_cpy);
+    }
 
     const int32_t hidden = (int32_t) x_ht->ne[0];
-    lm_ggml_tensor * o = codec_op_lm_per_pos_linear(ctx, w.o, attn, hidden, (int32_t) T_new);
+    lm_ggml_tensor * o = codec_op_lm_per_pos_linear(ctx, w.o, attn_all, hidden, (int32_t) T_all);
     x_ht = lm_ggml_add(ctx, x_ht, o);
 
-    // ── Cache writes (side-effect roots) ────────────────────────────
-    // lm_ggml_cpy(src, dst) returns a view of dst; flag both with
-    // lm_ggml_set_output so the codec.cpp graph framework expands them as
-    // separate roots, guaranteeing they're executed in this compute.
-    lm_ggml_tensor * k_dst = lm_ggml_view_3d(ctx, k_cache_l,
-        head_dim, n_kv_heads, T_new,
-        k_cache_l->nb[1], k_cache_l->nb[2],
-        (size_t) kv_pos_start * k_cache_l->nb[2]);
-    lm_ggml_tensor * v_dst = lm_ggml_view_3d(ctx, v_cache_l,
-        head_dim, n_kv_heads, T_new,
-        v_cache_l->nb[1], v_cache_l->nb[2],
-        (size_t) kv_pos_start * v_cache_l->nb[2]);
-    lm_ggml_tensor * k_cpy = lm_ggml_cpy(ctx, k_new, k_dst);
-    lm_ggml_tensor * v_cpy = lm_ggml_cpy(ctx, v_new, v_dst);
-    lm_ggml_set_output(k_cpy);
-    lm_ggml_set_output(v_cpy);
-
     // ── FFN (SwiGLU) ────────────────────────────────────────────────
     h = codec_op_rms_norm_ct(ctx, x_ht, rms_eps, w.ffn_norm);
     const int32_t inter = (int32_t) w.ffn_gate->ne[1];
-    lm_ggml_tensor * gate = codec_op_lm_per_pos_linear(ctx, w.ffn_gate, h, inter,  (int32_t) T_new);
-    lm_ggml_tensor * up   = codec_op_lm_per_pos_linear(ctx, w.ffn_up,   h, inter,  (int32_t) T_new);
+    lm_ggml_tensor * gate = codec_op_lm_per_pos_linear(ctx, w.ffn_gate, h, inter,  (int32_t) T_all);
+    lm_ggml_tensor * up   = codec_op_lm_per_pos_linear(ctx, w.ffn_up,   h, inter,  (int32_t) T_all);
     lm_ggml_tensor * mlp  = lm_ggml_mul(ctx, lm_ggml_silu(ctx, gate), up);
-    lm_ggml_tensor * down = codec_op_lm_per_pos_linear(ctx, w.ffn_down, mlp, hidden, (int32_t) T_new);
+    lm_ggml_tensor * down = codec_op_lm_per_pos_linear(ctx, w.ffn_down, mlp, hidden, (int32_t) T_all);
     x_ht = lm_ggml_add(ctx, x_ht, down);
 
     return x_ht;
@@ -673,10 +697,11 @@ lm_ggml_tensor * rda_depth_layer_kv(
 
 struct rda_depth_kv_build {
     rda_impl *      impl;
-    int32_t         T_new;
+    int32_t         T_new;         // new positions per sequence
     int32_t         kv_pos_start;
     int32_t         head_idx;
-    lm_ggml_tensor **  k_cache;   // depth_layers entries
+    int32_t         n_seq;         // states evaluated together
+    lm_ggml_tensor **  k_cache;   // depth_layers * n_seq entries, layer-major
     lm_ggml_tensor **  v_cache;
 };
 
@@ -685,17 +710,21 @@ bool rda_build_depth_step_kv(lm_ggml_context * ctx_eval, void * ud, lm_ggml_tens
     if (!ctx_eval || !b || !b->impl || !out || !b->k_cache || !b->v_cache) return false;
     rda_impl * impl = b->impl;
     const int32_t T_new        = b->T_new;
+    const int32_t n_seq        = b->n_seq;
+    const int32_t T_all        = T_new * n_seq;
     const int32_t kv_pos_start = b->kv_pos_start;
     const int32_t kv_total     = kv_pos_start + T_new;
-    if (T_new < 1 || kv_total > impl->n_codebook + 1) return false;
+    if (T_new < 1 || n_seq < 1 || kv_total > impl->n_codebook + 1) return false;
 
+    // Inputs cover every sequence back to back: columns
+    // [s * T_new, (s + 1) * T_new) belong to sequence s.
     lm_ggml_tensor * t_x = lm_ggml_new_tensor_2d(
-        ctx_eval, LM_GGML_TYPE_F32, impl->audio_embed_dim, T_new);
+        ctx_eval, LM_GGML_TYPE_F32, impl->audio_embed_dim, T_all);
     lm_ggml_set_name(t_x, "lm.depth.kv.x");
 
     lm_ggml_tensor * t_pos = nullptr;
     if (impl->use_rope) {
-        t_pos = lm_ggml_new_tensor_1d(ctx_eval, LM_GGML_TYPE_I32, T_new);
+        t_pos = lm_ggml_new_tensor_1d(ctx_eval, LM_GGML_TYPE_I32, T_all);
         lm_ggml_set_name(t_pos, "lm.depth.kv.pos");
     }
 
@@ -703,7 +732,7 @@ bool rda_build_depth_step_kv(lm_ggml_context * ctx_eval, void * ud, lm_ggml_tens
     lm_ggml_tensor * x;
     if (impl->has_in_proj && impl->in_proj != nullptr) {
         x = codec_op_lm_per_pos_linear(
-            ctx_eval, impl->in_proj, t_x, impl->depth_hidden, T_new);
+            ctx_eval, impl->in_proj, t_x, impl->depth_hidden, T_all);
         if (impl->in_proj_bias != nullptr) {
             lm_ggml_tensor * bias_f32 = codec_graph_cast_f32(ctx_eval, impl->in_proj_bias);
             x = lm_ggml_add(ctx_eval, x, bias_f32);
@@ -730,18 +759,19 @@ bool rda_build_depth_step_kv(lm_ggml_context * ctx_eval, void * ud, lm_ggml_tens
             impl->depth_head_dim, impl->depth_n_heads, impl->depth_n_kv_heads,
             impl->depth_rope_theta, impl->depth_rms_eps,
             impl->has_qk_norm, rope_mode, impl->use_rope,
-            b->k_cache[(size_t) l], b->v_cache[(size_t) l],
-            kv_pos_start, kv_total);
+            b->k_cache + (size_t) l * n_seq, b->v_cache + (size_t) l * n_seq,
+            n_seq, kv_pos_start);
     }
 
     if (impl->has_output_norm && impl->depth_output_norm != nullptr) {
         x = codec_op_rms_norm_ct(ctx_eval, x, impl->depth_rms_eps, impl->depth_output_norm);
     }
 
-    // Pick last position.
-    lm_ggml_tensor * x_last = lm_ggml_view_1d(
-        ctx_eval, x, impl->depth_hidden,
-        (size_t) (T_new - 1) * impl->depth_hidden * sizeof(float));
+    // Pick the last position of every sequence → (depth_hidden, n_seq).
+    lm_ggml_tensor * x_last = lm_ggml_view_2d(
+        ctx_eval, x, impl->depth_hidden, n_seq,
+        (size_t) T_new * x->nb[1],
+        (size_t) (T_new - 1) * x->nb[1]);
     x_last = lm_ggml_cont(ctx_eval, x_last);
 
     if (impl->has_pre_head_norm) {
@@ -1155,18 +1185,46 @@ void state_reset(codec_lm_state * st) {
 // step machine
 // ---------------------------------------------------------------------
 
-// Run the c0 head over `h_in` and copy logits into the state's scratch.
-enum codec_status run_c0_head(codec_lm_state * st, const float * h_in) {
+// Read a (vocab, n_seq) logits tensor into `logits_buf[cb]` of each
+// state, column s → state s.
+static enum codec_status rda_scatter_logits(
+        codec_lm_state ** states, int32_t n_seq,
+        lm_ggml_tensor * t_lg, int32_t cb, int32_t vocab) {
+    std::string err;
+    const size_t n_bytes = (size_t) vocab * sizeof(float);
+    if (n_seq == 1) {
+        rda_state * sst = static_cast<rda_state *>(states[0]->impl);
+        if (!codec_runtime_read_tensor(t_lg, sst->logits_buf[(size_t) cb].data(), n_bytes, &err)) {
+            states[0]->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
+        }
+        return CODEC_STATUS_SUCCESS;
+    }
+    std::vector<float> all((size_t) vocab * n_seq);
+    if (!codec_runtime_read_tensor(t_lg, all.data(), all.size() * sizeof(float), &err)) {
+        states[0]->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
+    }
+    for (int32_t s = 0; s < n_seq; ++s) {
+        rda_state * sst = static_cast<rda_state *>(states[s]->impl);
+        std::memcpy(sst->logits_buf[(size_t) cb].data(), all.data() + (size_t) s * vocab, n_bytes);
+    }
+    return CODEC_STATUS_SUCCESS;
+}
+
+// Run the c0 head over `h_in` ([hidden_dim, n_seq], one column per
+// state) and copy each state's logits into its scratch.  Evaluated on
+// the first state's context.
+enum codec_status run_c0_head(codec_lm_state ** states, int32_t n_seq, const float * h_in) {
+    codec_lm_state * st = states[0];
     rda_impl * impl = static_cast<rda_impl *>(st->lm->impl);
-    rda_state * sst = static_cast<rda_state *>(st->impl);
 
-    rda_c0_build build = { impl };
+    rda_c0_build build = { impl, n_seq };
     codec_graph_eval_guard guard(st->ctx);
     std::string err;
     codec_graph_cache_entry * entry = nullptr;
     codec_graph_cache_key key = {};
-    key.kind = (int32_t) CODEC_GRAPH_LM_RDA_C0_HEAD;
-    key.n_in = impl->hidden_dim;
+    key.kind     = (int32_t) CODEC_GRAPH_LM_RDA_C0_HEAD;
+    key.n_frames = n_seq;
+    key.n_in     = impl->hidden_dim;
 
     if (!codec_graph_cache_get_or_build(
             st->ctx, key, rda_build_c0, &build, sizeof(build), &entry, &err)) {
@@ -1180,7 +1238,7 @@ enum codec_status run_c0_head(codec_lm_state * st, const float * h_in) {
     if (!codec_graph_prepare_io(st->ctx, entry, &err)) {
         st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
     }
-    if (!codec_runtime_write_tensor(t_h, h_in, (size_t) impl->hidden_dim * sizeof(float), &err)) {
+    if (!codec_runtime_write_tensor(t_h, h_in, (size_t) impl->hidden_dim * n_seq * sizeof(float), &err)) {
         st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
     }
     const int32_t n_threads = st->lm->codec->n_threads > 0 ? st->lm->codec->n_threads : 1;
@@ -1188,11 +1246,7 @@ enum codec_status run_c0_head(codec_lm_state * st, const float * h_in) {
         st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
     }
     const int32_t v0 = st->lm->info.codebook_sizes[0];
-    if (!codec_runtime_read_tensor(t_lg, sst->logits_buf[0].data(),
-                                   (size_t) v0 * sizeof(float), &err)) {
-        st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
-    }
-    return CODEC_STATUS_SUCCESS;
+    return rda_scatter_logits(states, n_seq, t_lg, 0, v0);
 }
 
 // Compose the depth decoder's prefix embeddings (length T = current_k+1)
@@ -1353,7 +1407,12 @@ enum codec_status run_depth_step(codec_lm_state * st, int32_t current_k) {
 // from `rda_state` for everything before.  Called only when
 // `sst->kv_ok = true` (state_init confirmed allocation succeeded AND
 // the model variant is supported — see rda_alloc_kv_cache).
-enum codec_status run_depth_step_kv(codec_lm_state * st, int32_t current_k) {
+//
+// With n_seq > 1 every state must be kv_ok and at the same kv_pos; the
+// states' prefixes are laid out back to back in one graph, each
+// attending over its own cache (step_logits_batch checks this).
+enum codec_status run_depth_step_kv(codec_lm_state ** states, int32_t n_seq, int32_t current_k) {
+    codec_lm_state * st = states[0];
     rda_impl  * impl = static_cast<rda_impl  *>(st->lm->impl);
     rda_state * sst  = static_cast<rda_state *>(st->impl);
     if (current_k < 0 || current_k >= impl->n_codebook) {
@@ -1377,45 +1436,67 @@ enum codec_status run_depth_step_kv(codec_lm_state * st, int32_t current_k) {
         return CODEC_STATUS_INTERNAL_ERROR;
     }
 
-    // ---- Build the (audio_embed_dim, T_new) prefix host-side --------
+    // ---- Build the (audio_embed_dim, T_new * n_seq) prefix host-side --
     const int32_t row_dim = impl->audio_embed_dim;
-    std::vector<float> prefix((size_t) row_dim * (size_t) T_new, 0.0f);
-
-    for (int32_t i = 0; i < T_new; ++i) {
-        const int32_t pos = kv_pos_start + i;
-        if (pos == 0) {
-            // Shared in_proj mode (CSM / Qwen3-TTS): pos 0 = raw h_in.
-            // (Per-pos / depth_emits_c0 / flex_heads not on KV path —
-            //  rda_alloc_kv_cache refuses those variants, so we never
-            //  enter this branch for Moshi / LFM2.)
-            std::memcpy(prefix.data() + (size_t) i * row_dim,
-                        sst->h_in_buf.data(),
-                        (size_t) impl->hidden_dim * sizeof(float));
-        } else {
-            const int32_t embd_idx = pos - 1;
-            if ((size_t) embd_idx >= impl->audio_embds.size() ||
-                impl->audio_embds[(size_t) embd_idx] == nullptr) {
-                st->last_error = "depth step kv: missing audio_embd for prefix pos";
-                return CODEC_STATUS_INTERNAL_ERROR;
-            }
-            std::string err;
-            if (!rda_copy_embd_row(
-                    impl->audio_embds[(size_t) embd_idx],
-                    st->codes_buf[(size_t) embd_idx],
-                    row_dim,
-                    prefix.data() + (size_t) i * row_dim,
-                    "audio_embd", &err)) {
-                st->last_error = "depth step kv: " + err;
-                return CODEC_STATUS_INTERNAL_ERROR;
+    std::vector<float> prefix((size_t) row_dim * (size_t) T_new * n_seq, 0.0f);
+
+    for (int32_t s = 0; s < n_seq; ++s) {
+        rda_state * sst_s = static_cast<rda_state *>(states[s]->impl);
+        float * prefix_s = prefix.data() + (size_t) s * T_new * row_dim;
+        for (int32_t i = 0; i < T_new; ++i) {
+            const int32_t pos = kv_pos_start + i;
+            if (pos == 0) {
+                // Shared in_proj mode (CSM / Qwen3-TTS): pos 0 = raw h_in.
+                // (Per-pos / depth_emits_c0 / flex_heads not on KV path —
+                //  rda_alloc_kv_cache refuses those variants, so we never
+                //  enter this branch for Moshi / LFM2.)
+                std::memcpy(prefix_s + (size_t) i * row_dim,
+                            sst_s->h_in_buf.data(),
+                            (size_t) impl->hidden_dim * sizeof(float));
+            } else {
+                const int32_t embd_idx = pos - 1;
+                if ((size_t) embd_idx >= impl->audio_embds.size() ||
+                    impl->audio_embds[(size_t) embd_idx] == nullptr) {
+                    st->last_error = "depth step kv: missing audio_embd for prefix pos";
+                    return CODEC_STATUS_INTERNAL_ERROR;
+                }
+                std::string err;
+                if (!rda_copy_embd_row(
+                        impl->audio_embds[(size_t) embd_idx],
+                        states[s]->codes_buf[(size_t) embd_idx],
+                        row_dim,
+                        prefix_s + (size_t) i * row_dim,
+                        "audio_embd", &err)) {
+                    states[s]->last_error = "depth step kv: " + err;
+                    return CODEC_STATUS_INTERNAL_ERROR;
+                }
             }
         }
     }
 
     const int32_t head_idx = impl->depth_emits_c0 ? current_k : (current_k - 1);
 
+    // Layer-major cache table: entry [l * n_seq + s] is layer l of state s.
+    std::vector<lm_ggml_tensor *> k_caches;
+    std::vector<lm_ggml_tensor *> v_caches;
+    lm_ggml_tensor ** k_cache = sst->k_cache.data();
+    lm_ggml_tensor ** v_cache = sst->v_cache.data();
+    if (n_seq > 1) {
+        k_caches.resize((size_t) impl->depth_layers * n_seq);
+        v_caches.resize((size_t) impl->depth_layers * n_seq);
+        for (int32_t l = 0; l < impl->depth_layers; ++l) {
+            for (int32_t s = 0; s < n_seq; ++s) {
+                rda_state * sst_s = static_cast<rda_state *>(states[s]->impl);
+                k_caches[(size_t) l * n_seq + s] = sst_s->k_cache[(size_t) l];
+                v_caches[(size_t) l * n_seq + s] = sst_s->v_cache[(size_t) l];
+            }
+        }
+        k_cache = k_caches.data();
+        v_cache = v_caches.data();
+    }
+
     rda_depth_kv_build build = {
-        impl, T_new, kv_pos_start, head_idx,
-        sst->k_cache.data(), sst->v_cache.data(),
+        impl, T_new, kv_pos_start, head_idx, n_seq, k_cache, v_cache,
     };
 
     codec_graph_eval_guard guard(st->ctx);
@@ -1426,6 +1507,7 @@ enum codec_status run_depth_step_kv(codec_lm_state * st, int32_t current_k) {
     key.n_frames = T_new;
     key.n_q      = head_idx;
     key.n_in     = kv_pos_start;   // overload n_in for the cache offset
+    key.hop      = n_seq;          // and hop for the batch width
 
     if (!codec_graph_cache_get_or_build(
             st->ctx, key, rda_build_depth_step_kv, &build, sizeof(build), &entry, &err)) {
@@ -1447,8 +1529,10 @@ enum codec_status run_depth_step_kv(codec_lm_state * st, int32_t current_k) {
         st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
     }
     if (impl->use_rope) {
-        std::vector<int32_t> positions((size_t) T_new);
-        for (int32_t i = 0; i < T_new; ++i) positions[(size_t) i] = kv_pos_start + i;
+        std::vector<int32_t> positions((size_t) T_new * n_seq);
+        for (size_t i = 0; i < positions.size(); ++i) {
+            positions[i] = kv_pos_start + (int32_t) (i % (size_t) T_new);
+        }
         if (!codec_runtime_write_tensor(t_pos, positions.data(),
                                         positions.size() * sizeof(int32_t), &err)) {
             st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
@@ -1459,11 +1543,13 @@ enum codec_status run_depth_step_kv(codec_lm_state * st, int32_t current_k) {
         st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
     }
     const int32_t vk = st->lm->info.codebook_sizes[current_k];
-    if (!codec_runtime_read_tensor(t_lg, sst->logits_buf[(size_t) current_k].data(),
-                                   (size_t) vk * sizeof(float), &err)) {
-        st->last_error = err; return CODEC_STATUS_INTERNAL_ERROR;
+    const enum codec_status rc = rda_scatter_logits(states, n_seq, t_lg, current_k, vk);
+    if (rc != CODEC_STATUS_SUCCESS) {
+        return rc;
+    }
+    for (int32_t s = 0; s < n_seq; ++s) {
+        static_cast<rda_state *>(states[s]->impl)->kv_pos = T_target;
     }
-    sst->kv_pos = T_target;
     return CODEC_STATUS_SUCCESS;
 }
 
@@ -1480,7 +1566,22 @@ enum codec_status step_begin(codec_lm_state * st, const float * h_in) {
         // the first depth step (T=1).
         return CODEC_STATUS_SUCCESS;
     }
-    return run_c0_head(st, h_in);
+    return run_c0_head(&st, 1, h_in);
+}
+
+enum codec_status step_begin_batch(codec_lm_state ** states, int32_t n_seq, const float * h_in) {
+    if (!states || n_seq <= 0 || !h_in) return CODEC_STATUS_INVALID_ARG;
+    rda_impl * impl = static_cast<rda_impl *>(states[0]->lm->impl);
+    for (int32_t s = 0; s < n_seq; ++s) {
+        rda_state * sst = static_cast<rda_state *>(states[s]->impl);
+        std::memcpy(sst->h_in_buf.data(), h_in + (size_t) s * impl->hidden_dim,
+                    (size_t) impl->hidden_dim * sizeof(float));
+        sst->kv_pos = 0;
+    }
+    if (impl->depth_emits_c0) {
+        return CODEC_STATUS_SUCCESS;
+    }
+    return run_c0_head(states, n_seq, h_in);
 }
 
 bool step_pending(const codec_lm_state * st) {
@@ -1506,7 +1607,7 @@ const float * step_logits(codec_lm_state * st, int32_t * out_cb_idx, int32_t * o
     // in_proj keep using the prefix-recompute path until that's wired).
     if (impl->depth_emits_c0 || k >= 1) {
         const enum codec_status rc = sst->kv_ok
-            ? run_depth_step_kv(st, k)
+            ? run_depth_step_kv(&st, 1, k)
             : run_depth_step(st, k);
         if (rc != CODEC_STATUS_SUCCESS) {
             return nullptr;
@@ -1517,6 +1618,36 @@ const float * step_logits(codec_lm_state * st, int32_t * out_cb_idx, int32_t * o
     return sst->logits_buf[(size_t) k].data();
 }
 
+// Batched depth step: one graph for every state when all of them are
+// on the KV path at the same cache position; otherwise per-state.
+enum codec_status step_logits_batch(codec_lm_state ** states, int32_t n_seq, const float ** out_logits) {
+    if (!states || n_seq <= 0 || !out_logits) return CODEC_STATUS_INVALID_ARG;
+    rda_impl * impl = static_cast<rda_impl *>(states[0]->lm->impl);
+    const int32_t k = states[0]->next_cb;
+
+    bool batched = impl->depth_emits_c0 || k >= 1;
+    const int32_t kv_pos = static_cast<rda_state *>(states[0]->impl)->kv_pos;
+    for (int32_t s = 0; s < n_seq && batched; ++s) {
+        const rda_state * sst = static_cast<const rda_state *>(states[s]->impl);
+        batched = sst->kv_ok && sst->kv_pos == kv_pos;
+    }
+    if (batched) {
+        const enum codec_status rc = run_depth_step_kv(states, n_seq, k);
+        if (rc != CODEC_STATUS_SUCCESS) return rc;
+        for (int32_t s = 0; s < n_seq; ++s) {
+            out_logits[s] = static_cast<rda_state *>(states[s]->impl)->logits_buf[(size_t) k].data();
+        }
+        return CODEC_STATUS_SUCCESS;
+    }
+    // c0 from the separate head (already computed), or a variant off
+    // the KV path: the single-state step handles both.
+    for (int32_t s = 0; s < n_seq; ++s) {
+        out_logits[s] = step_logits(states[s], nullptr, nullptr);
+        if (out_logits[s] == nullptr) return CODEC_STATUS_INTERNAL_ERROR;
+    }
+    return CODEC_STATUS_SUCCESS;
+}
+
 enum codec_status step_push_code(codec_lm_state * /*st*/, int32_t /*code*/) {
     // Generic dispatch records code into st->codes_buf[k]; nothing
     // kind-specific here in the prefix-recompute regime.  The next
@@ -1774,4 +1905,11 @@ const codec_lm_kind_vtable codec_lm_vtable_residual_depth_ar = {
                                          // public function falls back to
                                          // compose_audio_embd and ignores step.
     /*.speaker_encode     =*/ nullptr,
+    /*.step_generate      =*/ nullptr,
+    /*.step_feedback_embd =*/ nullptr,
+    /*.text_prefill       =*/ nullptr,
+    /*.set_min_len        =*/ nullptr,
+    /*.set_teacher_patch  =*/ nullptr,
+    /*.step_begin_batch   =*/ step_begin_batch,
+    /*.step_logits_batch  =*/ step_logits_batch,
 };
@@ -15,6 +15,7 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <new>
 #include <string>
@@ -1054,12 +1055,18 @@ enum codec_status codec_mimi_decode_with(
         return CODEC_STATUS_INVALID_ARG;
     }
 
-    const int32_t t = tokens->n_frames;
+    // The decoder is causal end to end (causal convs / transposed convs and a
+    // causal transformer), so trailing pad frames never reach the first
+    // n_frames * hop samples: decode at the bucketed length, trim the tail,
+    // and keep the graph alive so the next chunk in the same bucket reuses it.
+    const int32_t t_real = tokens->n_frames;
+    const int32_t t = codec_graph_bucket_frames(t_real);
     const int32_t q = use_n_q;
 
-    codec_graph_eval_guard eval_guard(ctx);
+    codec_graph_eval_guard eval_guard(ctx, /*persist=*/true);
     const int32_t n_sem = std::max(1, std::min(mm.num_semantic_quantizers, q));
-    mimi_decode_build build = {};
+    mimi_decode_build build;
+    std::memset(&build, 0, sizeof(build)); // padding bytes take part in the fast-path memcmp
     std::string err;
     if (!codec_mimi_init_decode_build(ctx, &mm, t, q, n_sem, &build, &err)) {
         codec_context_set_error(ctx, err);
@@ -1092,8 +1099,9 @@ enum codec_status codec_mimi_decode_with(
 
     std::vector<int32_t> tok_i32((size_t) t * (size_t) q, 0);
     for (int32_t ti = 0; ti < t; ++ti) {
+        const int32_t src_t = std::min(ti, t_real - 1); // pad by repeating the last frame
         for (int32_t qi = 0; qi < q; ++qi) {
-            int32_t tok = tokens->data[(size_t) ti * (size_t) tokens->n_q + (size_t) qi];
+            int32_t tok = tokens->data[(size_t) src_t * (size_t) tokens->n_q + (size_t) qi];
             tok = std::max(0, std::min(build.codebook_size - 1, tok));
             tok_i32[(size_t) qi * (size_t) t + (size_t) ti] = tok;
         }
@@ -1110,14 +1118,18 @@ enum codec_status codec_mimi_decode_with(
         return CODEC_STATUS_INTERNAL_ERROR;
     }
 
-    const int32_t n_samples = (int32_t) t_out->ne[0];
+    const int32_t n_samples = (int32_t) t_out->ne[0] - (t - t_real) * build.hop;
+    if (n_samples <= 0) {
+        codec_context_set_error(ctx, "Mimi decode produced no samples");
+        return CODEC_STATUS_INTERNAL_ERROR;
+    }
     float * pcm = static_cast<float *>(std::malloc((size_t) n_samples * sizeof(float)));
     if (pcm == nullptr) {
         codec_context_set_error(ctx, "failed to allocate pcm output");
         return CODEC_STATUS_INTERNAL_ERROR;
     }
 
-    if (!codec_runtime_read_tensor(t_out, pcm, (size_t) n_samples * sizeof(float), &err)) {
+    if (!codec_runtime_read_tensor_head(t_out, pcm, (size_t) n_samples * sizeof(float), &err)) {
         std::free(pcm);
         codec_context_set_error(ctx, err);
         return CODEC_STATUS_INTERNAL_ERROR;
@@ -8,6 +8,7 @@
 #include "../runtime/graph.h"
 #include "../runtime/tensor_utils.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -358,18 +359,24 @@ static enum codec_status codec_pocket_mimi_decode_latent(
         return CODEC_STATUS_INVALID_ARG;
     }
 
-    pm_decode_build build = {};
-    build.n_frames = n_frames;
+    // Every conv, transposed conv and attention in the decoder is causal, so
+    // decode at the bucketed length (pad by repeating the last latent frame),
+    // trim the tail, and keep the graph alive for the next same-bucket chunk.
+    const int32_t t = codec_graph_bucket_frames(n_frames);
+
+    pm_decode_build build;
+    std::memset(&build, 0, sizeof(build)); // padding bytes take part in the fast-path memcmp
+    build.n_frames = t;
     build.latent_dim = latent_dim;
     build.cfg = m;
     build.model = ctx->model;
 
-    codec_graph_eval_guard guard(ctx);
+    codec_graph_eval_guard guard(ctx, /*persist=*/true);
     std::string err;
     codec_graph_cache_entry * entry = nullptr;
     if (!codec_graph_cache_get_or_build(
             ctx,
-            { CODEC_GRAPH_POCKET_MIMI_DECODE, /*n_frames=*/n_frames, /*n_q=*/0,
+            { CODEC_GRAPH_POCKET_MIMI_DECODE, /*n_frames=*/t, /*n_q=*/0,
               /*hop=*/m.hop_size, /*n_in=*/0, /*latent_dim=*/latent_dim },
             pm_build_decode, &build, sizeof(build), &entry, &err)) {
         codec_context_set_error(ctx, err);
@@ -386,8 +393,20 @@ static enum codec_status codec_pocket_mimi_decode_latent(
         codec_context_set_error(ctx, err);
         return CODEC_STATUS_INTERNAL_ERROR;
     }
-    if (!codec_runtime_write_tensor(t_lat, quantized_representation,
-                                    (size_t) n_frames * (size_t) latent_dim * sizeof(float), &err)) {
+    // Latent buffer is [latent_dim, n_frames]; widen each row to t frames.
+    std::vector<float> lat_pad;
+    const float * lat = quantized_representation;
+    if (t != n_frames) {
+        lat_pad.resize((size_t) t * (size_t) latent_dim);
+        for (int32_t c = 0; c < latent_dim; ++c) {
+            const float * src = quantized_representation + (size_t) c * (size_t) n_frames;
+            float * dst = lat_pad.data() + (size_t) c * (size_t) t;
+            std::memcpy(dst, src, (size_t) n_frames * sizeof(float));
+            std::fill(dst + n_frames, dst + t, src[n_frames - 1]);
+        }
+        lat = lat_pad.data();
+    }
+    if (!codec_runtime_write_tensor(t_lat, lat, (size_t) t * (size_t) latent_dim * sizeof(float), &err)) {
         codec_context_set_error(ctx, err);
         return CODEC_STATUS_INTERNAL_ERROR;
     }
@@ -400,9 +419,13 @@ static enum codec_status codec_pocket_mimi_decode_latent(
         codec_context_set_error(ctx, "unexpected Pocket-Mimi output shape/type");
         return CODEC_STATUS_INTERNAL_ERROR;
     }
-    const int32_t n_samples = (int32_t) t_out->ne[0];
+    const int32_t n_samples = (int32_t) t_out->ne[0] - (t - n_frames) * m.hop_size;
+    if (n_samples <= 0) {
+        codec_context_set_error(ctx, "Pocket-Mimi decode produced no samples");
+        return CODEC_STATUS_INTERNAL_ERROR;
+    }
     std::vector<float> pcm_v((size_t) n_samples, 0.0f);
-    if (!codec_runtime_read_tensor(t_out, pcm_v.data(), pcm_v.size() * sizeof(float), &err)) {
+    if (!codec_runtime_read_tensor_head(t_out, pcm_v.data(), pcm_v.size() * sizeof(float), &err)) {
         codec_context_set_error(ctx, err);
         return CODEC_STATUS_INTERNAL_ERROR;
     }
@@ -3,10 +3,13 @@
 #include "lm_ggml_ops.h"
 #include "../runtime/tensor_utils.h"
 
-// Conv weights are loaded directly from the GGUF context. Quantized weight
-// types can't be reshaped (their row size is fixed by the block format), so
-// cast to F32 before any reshape/im2col path. F16 weights are kept as F16 to
-// preserve the fast im2col-F16 path that lm_ggml_conv_1d uses.
+// Conv weights are loaded directly from the GGUF context. F16 weights are kept
+// as F16 to preserve the fast im2col-F16 path that lm_ggml_conv_1d uses.
+// Quantized weights codec_graph_native_quant accepts stay quantized when
+// the kernel taps are whole blocks: the [k, c_in, c_out] -> [k*c_in, c_out]
+// reshape then keeps every block intact and the weight can feed
+// lm_ggml_mul_mat as src[0] (see codec_conv1d_impl).
+// Anything else is cast to F32 before the reshape/im2col path.
 static lm_ggml_tensor * codec_conv1d_prepare_w(lm_ggml_context * ctx, lm_ggml_tensor * w) {
     if (w == nullptr) {
         return nullptr;
@@ -14,6 +17,10 @@ static lm_ggml_tensor * codec_conv1d_prepare_w(lm_ggml_context * ctx, lm_ggml_te
     if (w->type == LM_GGML_TYPE_F32 || w->type == LM_GGML_TYPE_F16) {
         return w;
     }
+    if (codec_graph_native_quant(w) && lm_ggml_is_contiguous(w) &&
+        w->ne[0] % lm_ggml_blck_size(w->type) == 0) {
+        return w;
+    }
     return lm_ggml_cast(ctx, w, LM_GGML_TYPE_F32);
 }
 
@@ -63,7 +70,15 @@ static lm_ggml_tensor * codec_conv1d_impl(
 
     lm_ggml_tensor * lhs = lm_ggml_reshape_2d(ctx, im2col, im2col->ne[0], im2col->ne[2] * im2col->ne[1]);
     lm_ggml_tensor * rhs = lm_ggml_reshape_2d(ctx, w, w->ne[0] * w->ne[1], w->ne[2]);
-    lm_ggml_tensor * y = lm_ggml_mul_mat(ctx, lhs, rhs);
+    lm_ggml_tensor * y = nullptr;
+    if (lm_ggml_is_quantized(w->type)) {
+        // A quantized weight is only accepted as src[0]: run the transposed
+        // product [c_out, t] and flip it back to the im2col layout [t, c_out].
+        y = lm_ggml_mul_mat(ctx, rhs, lhs);
+        y = y == nullptr ? nullptr : lm_ggml_cont(ctx, lm_ggml_transpose(ctx, y));
+    } else {
+        y = lm_ggml_mul_mat(ctx, lhs, rhs);
+    }
     if (y == nullptr) {
         return nullptr;
     }
@@ -83,6 +98,11 @@ static lm_ggml_tensor * codec_conv1d_depthwise_impl(
         return nullptr;
     }
 
+    // The depthwise weight lands as mul_mat's src[1], which must be F32/F16
+    if (lm_ggml_is_quantized(w->type)) {
+        w = lm_ggml_cast(ctx, w, LM_GGML_TYPE_F32);
+    }
+
     lm_ggml_tensor * x4 = lm_ggml_reshape_4d(ctx, x, x->ne[0], 1, x->ne[1], x->ne[2]);
     const lm_ggml_type im2col_type = w->type == LM_GGML_TYPE_F16 ? LM_GGML_TYPE_F16 : LM_GGML_TYPE_F32;
     lm_ggml_tensor * im2col = lm_ggml_im2col(ctx, w, x4, stride, 0, padding, 0, dilation, 0, false, im2col_type);
@@ -123,16 +123,17 @@ lm_ggml_tensor * codec_op_linear(lm_ggml_context * ctx, lm_ggml_tensor * x, lm_g
         return nullptr;
     }
 
-    // Cast weight to F32 to preserve numerical parity with the legacy
-    // dequant-into-graph-buffer path. lm_ggml_mul_mat itself supports quantized
-    // weights natively, but mixing Q8_0 weight + F32 activations introduces
-    // additional per-block quantization on the activation side.
-    lm_ggml_tensor * w_f32 = codec_graph_cast_f32(ctx, w);
+    // Cast F16/BF16 weights to F32 to preserve numerical parity with the
+    // legacy dequant-into-graph-buffer path.  Block-quantized weights feed
+    // lm_ggml_mul_mat natively when codec_graph_native_quant accepts them:
+    // dequantizing them every execution costs more than the per-block
+    // quantization of the activation side.
+    lm_ggml_tensor * w_lhs = codec_graph_native_quant(w) ? w : codec_graph_cast_f32(ctx, w);
     lm_ggml_tensor * b_f32 = codec_graph_cast_f32(ctx, b);
 
-    lm_ggml_tensor * y = lm_ggml_mul_mat(ctx, w_f32, x);
+    lm_ggml_tensor * y = lm_ggml_mul_mat(ctx, w_lhs, x);
     if (b_f32 != nullptr) {
-        lm_ggml_tensor * b2 = lm_ggml_reshape_2d(ctx, b_f32, w_f32->ne[1], 1);
+        lm_ggml_tensor * b2 = lm_ggml_reshape_2d(ctx, b_f32, w_lhs->ne[1], 1);
         y = lm_ggml_add(ctx, y, lm_ggml_repeat(ctx, b2, y));
     }
     return y;
@@ -310,7 +310,9 @@ lm_ggml_tensor * codec_op_lm_per_pos_linear(
         // Casting the weight to F32 keeps both operands F32 (no activation
         // downcast); LM_GGML_PREC_F32 alone does not prevent the src[1] cast.
         // codec_graph_cast_f32 is a no-op for weights already F32.
-        lm_ggml_tensor * w_lhs = codec_graph_cast_f32(ctx, w);
+        // Block-quantized weights are the exception: their vec_dot
+        // quantizes src[1] with per-block scales, so nothing overflows.
+        lm_ggml_tensor * w_lhs = codec_graph_native_quant(w) ? w : codec_graph_cast_f32(ctx, w);
         lm_ggml_tensor * y     = lm_ggml_mul_mat(ctx, w_lhs, x_2d);
         lm_ggml_mul_mat_set_prec(y, LM_GGML_PREC_F32);
         return y;
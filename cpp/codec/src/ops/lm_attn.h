@@ -81,8 +81,9 @@ lm_ggml_tensor * codec_op_lm_attn_rel_key_dth(
 //     batched mul_mat (with the input as the LHS operand because
 //     ggml's batch-broadcast rule only lets `a` broadcast).
 //
-// Casts `w` to F32 internally if it isn't already; the caller can pass
-// the raw GGUF weight tensor.  Used by codec_lm depth-decoder graphs
+// Casts `w` to F32 internally unless it is F32 already or a shared weight
+// codec_graph_native_quant accepts; the caller can pass the raw GGUF
+// weight tensor.  Used by codec_lm depth-decoder graphs
 // to keep the shared and flexible runtime paths on one helper.
 lm_ggml_tensor * codec_op_lm_per_pos_linear(
     lm_ggml_context * ctx,
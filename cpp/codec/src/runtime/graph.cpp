@@ -6,15 +6,6 @@
 #include <cstdlib>
 #include <cstring>
 
-static bool codec_graph_key_equal(const codec_graph_cache_key & a, const codec_graph_cache_key & b) {
-    return a.kind == b.kind &&
-           a.n_frames == b.n_frames &&
-           a.n_q == b.n_q &&
-           a.hop == b.hop &&
-           a.n_in == b.n_in &&
-           a.latent_dim == b.latent_dim;
-}
-
 struct codec_graph_count_state {
     std::vector<lm_ggml_tensor *> visited;
     size_t n_nodes = 0;
@@ -126,6 +117,52 @@ static bool codec_graph_ensure_eval_arena(codec_context * ctx, size_t required_s
 // and is wasteful if a future backend pre-faults arena pages.
 static constexpr size_t kCodecGraphDefaultArenaBytes = (size_t) 128 * 1024 * 1024;
 
+// Entries only hold build metadata (user_data bytes + graph sizes), so the
+// bound is about not growing forever across arbitrary input lengths rather
+// than about memory; callers that bucket their shapes stay well below it.
+static constexpr size_t kCodecGraphCacheMaxEntries = 32;
+
+// Frame counts up to this many round up to a power of two, longer ones to a
+// multiple of it: at most 2x padding for short streaming chunks, at most one
+// step for long-form decodes.
+static constexpr int32_t kCodecGraphBucketStep = 64;
+
+int32_t codec_graph_bucket_frames(int32_t n_frames) {
+    static const bool enabled = [] {
+        const char * env = std::getenv("CODEC_GRAPH_BUCKET");
+        return env == nullptr || std::strcmp(env, "0") != 0;
+    }();
+    if (!enabled || n_frames <= 0) {
+        return n_frames;
+    }
+    if (n_frames <= kCodecGraphBucketStep) {
+        int32_t b = 1;
+        while (b < n_frames) {
+            b <<= 1;
+        }
+        return b;
+    }
+    return (n_frames + kCodecGraphBucketStep - 1) / kCodecGraphBucketStep * kCodecGraphBucketStep;
+}
+
+static void codec_graph_cache_evict(codec_context * ctx) {
+    while (ctx->graph_cache.size() >= kCodecGraphCacheMaxEntries) {
+        auto lru = ctx->graph_cache.end();
+        for (auto it = ctx->graph_cache.begin(); it != ctx->graph_cache.end(); ++it) {
+            if (&it->second == ctx->eval_entry) {
+                continue;
+            }
+            if (lru == ctx->graph_cache.end() || it->second.last_used < lru->second.last_used) {
+                lru = it;
+            }
+        }
+        if (lru == ctx->graph_cache.end()) {
+            return;
+        }
+        ctx->graph_cache.erase(lru);
+    }
+}
+
 bool codec_graph_cache_get_or_build(
     codec_context * ctx,
     codec_graph_cache_key key,
@@ -156,11 +193,10 @@ bool codec_graph_cache_get_or_build(
     }
 
     codec_graph_cache_entry * cached = nullptr;
-    for (codec_graph_cache_entry & entry : ctx->graph_cache) {
-        if (codec_graph_key_equal(entry.key, key)) {
-            cached = &entry;
-            break;
-        }
+    auto found = ctx->graph_cache.find(key);
+    if (found != ctx->graph_cache.end()) {
+        cached = &found->second;
+        cached->last_used = ++ctx->graph_cache_tick;
     }
 
     // Consecutive-call fast path: if the resolved entry is the exact same entry
@@ -193,18 +229,19 @@ bool codec_graph_cache_get_or_build(
     codec_graph_release(ctx);
 
     if (cached == nullptr) {
-        codec_graph_cache_entry entry;
+        codec_graph_cache_evict(ctx);
+        codec_graph_cache_entry & entry = ctx->graph_cache[key];
         entry.key = key;
         entry.required_mem_size = kCodecGraphDefaultArenaBytes;
         entry.build_fn = build_fn;
         entry.last_graph_size = 0;
         entry.last_sched_graph_size = 0;
+        entry.last_used = ++ctx->graph_cache_tick;
         if (user_data_size > 0) {
             const uint8_t * src = static_cast<const uint8_t *>(user_data);
             entry.build_user_data.assign(src, src + user_data_size);
         }
-        ctx->graph_cache.push_back(entry);
-        cached = &ctx->graph_cache.back();
+        cached = &entry;
     } else if (user_data_size > 0) {
         // Existing entry, but the user_data bytes differ (or were never stored):
         // refresh the stored copy so the rebuilt graph uses the current inputs
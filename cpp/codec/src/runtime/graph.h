@@ -77,6 +77,14 @@ bool codec_graph_prepare_io(
     std::string * error);
 
 void codec_graph_release(codec_context * ctx);
+
+// Frame count a shape-bucketed graph is built for: n_frames rounded up to a
+// power of two (short inputs) or a fixed step (long inputs), so nearby lengths
+// share one cache entry and, with a persisting eval guard, one allocation.
+// Only models whose outputs for the first n_frames do not depend on later
+// frames (fully causal stacks) may pad to it; they trim the output back.
+// CODEC_GRAPH_BUCKET=0 disables bucketing (returns n_frames).
+int32_t codec_graph_bucket_frames(int32_t n_frames);
 lm_ggml_tensor * codec_graph_get_tensor(codec_context * ctx, codec_graph_cache_entry * entry, const char * name);
 
 // RAII cleanup for the per-call eval graph.  By default the guard releases the
@@ -102,4 +110,29 @@ struct codec_graph_eval_guard {
     bool persist;
 };
 
+// Lease on the context's shared compute arena (params.compute_arena), held for
+// a whole public encode/decode call: graph allocation, input upload, compute
+// and output read-back all happen inside it.  When another arena user ran in
+// between, a persisted eval graph points at overwritten (or freed) memory, so
+// it is released and the next call re-plans its allocation.  No-op without an
+// arena.
+struct codec_arena_lease {
+    explicit codec_arena_lease(codec_context * ctx_)
+        : ctx(ctx_), arena(ctx_->params.compute_arena) {
+        if (arena != nullptr && lm_ggml_backend_arena_acquire(arena, ctx)) {
+            codec_graph_release(ctx);
+        }
+    }
+    ~codec_arena_lease() {
+        if (arena != nullptr) {
+            if (ctx->sched != nullptr) {
+                lm_ggml_backend_sched_synchronize(ctx->sched);
+            }
+            lm_ggml_backend_arena_release(arena);
+        }
+    }
+    codec_context * ctx;
+    lm_ggml_backend_arena_t arena;
+};
+
 #endif
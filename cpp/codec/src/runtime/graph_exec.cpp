@@ -225,8 +225,16 @@ static bool codec_sched_ensure_capacity(codec_context * ctx, int32_t required, s
         n_backends = 2;
     }
 
+    // with a shared compute arena, the CPU compute buffer is a view of the arena
+    std::array<lm_ggml_backend_buffer_type_t, 2> bufts = { nullptr, nullptr };
+    for (int i = 0; i < n_backends; ++i) {
+        bufts[i] = ctx->params.compute_arena != nullptr && codec_backend_is_cpu(backends[i])
+            ? lm_ggml_backend_arena_buffer_type(ctx->params.compute_arena)
+            : lm_ggml_backend_get_default_buffer_type(backends[i]);
+    }
+
     const bool op_offload = std::getenv("CODEC_NO_OP_OFFLOAD") == nullptr;
-    ctx->sched = lm_ggml_backend_sched_new(backends.data(), nullptr, n_backends, target, false, op_offload);
+    ctx->sched = lm_ggml_backend_sched_new(backends.data(), bufts.data(), n_backends, target, false, op_offload);
     if (ctx->sched == nullptr) {
         if (error != nullptr) {
             *error = "failed to recreate backend scheduler";
@@ -261,6 +269,18 @@ bool codec_runtime_init(codec_context * ctx, std::string * error) {
         return false;
     }
 
+    if (ctx->params.own_backend) {
+        lm_ggml_backend_dev_t dev = lm_ggml_backend_get_device(ctx->backend);
+        ctx->owned_backend = dev != nullptr ? lm_ggml_backend_dev_init(dev, nullptr) : nullptr;
+        if (ctx->owned_backend == nullptr) {
+            if (error != nullptr) {
+                *error = "failed to init context backend";
+            }
+            return false;
+        }
+        ctx->backend = ctx->owned_backend;
+    }
+
     std::array<lm_ggml_backend_t, 2> backends = { ctx->backend, nullptr };
     int n_backends = 1;
 
@@ -397,4 +417,10 @@ void codec_runtime_free(codec_context * ctx) {
         lm_ggml_backend_free(ctx->cpu_backend);
         ctx->cpu_backend = nullptr;
     }
+
+    if (ctx->owned_backend != nullptr) {
+        lm_ggml_backend_free(ctx->owned_backend);
+        ctx->owned_backend = nullptr;
+        ctx->backend = ctx->model != nullptr ? ctx->model->backend : nullptr;
+    }
 }
@@ -55,6 +55,30 @@ bool codec_runtime_read_tensor(lm_ggml_tensor * t, void * data, size_t n_bytes,
     return true;
 }
 
+bool codec_runtime_read_tensor_head(lm_ggml_tensor * t, void * data, size_t n_bytes, std::string * error) {
+    if (t == nullptr || data == nullptr) {
+        if (error != nullptr) {
+            *error = "invalid tensor get arguments";
+        }
+        return false;
+    }
+    if (n_bytes > lm_ggml_nbytes(t) || !lm_ggml_is_contiguous(t)) {
+        if (error != nullptr) {
+            *error = "tensor head get size mismatch";
+        }
+        return false;
+    }
+    if (t->buffer == nullptr) {
+        if (error != nullptr) {
+            const char * name = t->name[0] != '\0' ? t->name : "<unnamed>";
+            *error = std::string("tensor buffer not set: ") + name;
+        }
+        return false;
+    }
+    lm_ggml_backend_tensor_get(t, data, 0, n_bytes);
+    return true;
+}
+
 bool codec_runtime_read_tensor_i32_2d_tq(lm_ggml_tensor * t, std::vector<int32_t> * out, std::string * error) {
     if (t == nullptr || out == nullptr) {
         if (error != nullptr) {
@@ -114,6 +138,20 @@ lm_ggml_tensor * codec_graph_cast_f32(lm_ggml_context * ctx_eval, lm_ggml_tensor
     return lm_ggml_cast(ctx_eval, t, LM_GGML_TYPE_F32);
 }
 
+// block-quantized types whose native matmul is covered by the codec parity test
+// (simple_test "Codec Quantized Matmul": conv1d, linear and per-pos linear)
+static bool codec_graph_native_quant_type(lm_ggml_type type) {
+    return type == LM_GGML_TYPE_Q8_0;
+}
+
+bool codec_graph_native_quant(const lm_ggml_tensor * w) {
+    static const bool enabled = [] {
+        const char * env = std::getenv("CODEC_MAT_NATIVE_QUANT");
+        return env == nullptr || std::strcmp(env, "0") != 0;
+    }();
+    return enabled && w != nullptr && codec_graph_native_quant_type(w->type);
+}
+
 lm_ggml_tensor * codec_graph_mat_lhs(lm_ggml_context * ctx_eval, lm_ggml_tensor * t) {
     // Pass-through for the dtypes lm_ggml_mul_mat consumes natively as
     // src[0] without an extra dequant pass — see header comment for
@@ -127,6 +165,9 @@ lm_ggml_tensor * codec_graph_mat_lhs(lm_ggml_context * ctx_eval, lm_ggml_tensor
         case LM_GGML_TYPE_BF16:
             return t;
         default:
+            if (codec_graph_native_quant(t)) {
+                return t;
+            }
             return lm_ggml_cast(ctx_eval, t, LM_GGML_TYPE_F32);
     }
 }
@@ -164,22 +205,12 @@ lm_ggml_tensor * codec_graph_weight_mat(lm_ggml_context * ctx_eval, const codec_
     // time (30% of compute — the matmuls themselves are tiny), see Phase-4
     // profiling.
     //
-    // Block-quantized types (Q8_0, …) are cast to F32 here on purpose.  The
-    // alternative — native quantized mul_mat — re-quantizes the F32 activation
-    // to the block type per matmul, which measurably degrades CFM parity
-    // (Q8 e2e audio corr 0.99979 -> 0.99809, below the parity gate).  Set
-    // CODEC_MAT_NATIVE_QUANT=1 to opt into the faster-but-lossy native path
-    // (~8x on Vulkan for this graph); default keeps parity.  Note an F16 GGUF
-    // on GPU is both faster than cast-Q8 and bit-parity, so Q8 is off the
-    // critical config on UMA hardware.
-    if (w->type == LM_GGML_TYPE_F32 || w->type == LM_GGML_TYPE_F16 || w->type == LM_GGML_TYPE_BF16) {
-        return w;
-    }
-    static const bool native_quant = std::getenv("CODEC_MAT_NATIVE_QUANT") != nullptr;
-    if (native_quant && lm_ggml_is_quantized(w->type)) {
-        return w;
-    }
-    return lm_ggml_cast(ctx_eval, w, LM_GGML_TYPE_F32);
+    // Q8_0 weights feed it natively as well (see codec_graph_native_quant),
+    // other block-quantized types are cast to F32.  CODEC_MAT_NATIVE_QUANT=0
+    // casts Q8_0 too, for bit parity with the reference: the native path
+    // re-quantizes the activation (BlueMagpie CFM Q8 e2e audio corr
+    // 0.99979 -> 0.99809).
+    return codec_graph_mat_lhs(ctx_eval, w);
 }
 
 lm_ggml_tensor * codec_graph_weight_mat(lm_ggml_context * ctx_eval, const codec_model * model, const std::string & name) {
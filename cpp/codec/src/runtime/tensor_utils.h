@@ -5,6 +5,8 @@
 
 bool codec_runtime_write_tensor(lm_ggml_tensor * t, const void * data, size_t n_bytes, std::string * error);
 bool codec_runtime_read_tensor(lm_ggml_tensor * t, void * data, size_t n_bytes, std::string * error);
+// Reads only the first n_bytes of a contiguous tensor (trimming a padded, shape-bucketed output).
+bool codec_runtime_read_tensor_head(lm_ggml_tensor * t, void * data, size_t n_bytes, std::string * error);
 bool codec_runtime_read_tensor_i32_2d_tq(lm_ggml_tensor * t, std::vector<int32_t> * out, std::string * error);
 
 // Returns the raw loaded GGUF weight tensor for `name` (no graph cast). Returns
@@ -28,6 +30,14 @@ lm_ggml_tensor * codec_graph_weight_or_null(lm_ggml_context * ctx_eval, const co
 // Cast a tensor to F32 in the graph if it isn't already.
 lm_ggml_tensor * codec_graph_cast_f32(lm_ggml_context * ctx_eval, lm_ggml_tensor * t);
 
+// Whether a block-quantized weight feeds lm_ggml_mul_mat as-is.
+// The mul_mat kernel then quantizes the F32 activation to the weight's
+// vec_dot type per block instead of the graph dequantizing the whole weight
+// on every execution.  On for the types the codec parity test covers (Q8_0);
+// CODEC_MAT_NATIVE_QUANT=0 opts out (read once) and casts every quantized
+// weight to F32, which keeps bit parity with the reference models.
+bool codec_graph_native_quant(const lm_ggml_tensor * w);
+
 // Pass-through wrapper intended for tensors that will land as the LHS
 // (src[0], the weight side) of lm_ggml_mul_mat.  lm_ggml_mul_mat handles F32 /
 // F16 / BF16 src[0] with an F32 src[1] natively via fused vec_dot
@@ -35,17 +45,15 @@ lm_ggml_tensor * codec_graph_cast_f32(lm_ggml_context * ctx_eval, lm_ggml_tensor
 // extra dequant op into the graph that runs every execution, wasting
 // memory bandwidth proportional to the weight size.
 //
-// Truly quantized types (Q4_K, Q5_K, Q8_0, …) still get cast to F32
-// because the on-the-fly per-block re-quant of the F32 activation
-// inside their mul_mat kernel adds enough compute that an explicit
-// cast (which can be tiled / fused) is the lesser evil.  Most codec_lm
-// GGUFs ship F16 weights, so this is the hot path.
+// Truly quantized types pass through too when codec_graph_native_quant
+// accepts them, otherwise they are cast to F32.
 lm_ggml_tensor * codec_graph_mat_lhs(lm_ggml_context * ctx_eval, lm_ggml_tensor * t);
 
 // Fetch a matmul weight (src[0] side) for the graph WITHOUT the F16→F32 dequant
 // CPY that codec_graph_weight bakes in: F16/BF16 weights pass through untouched
-// (lm_ggml_mul_mat consumes them natively), quantized types are cast.  Use this for
-// every tensor that lands as the LHS of lm_ggml_mul_mat in a hot per-step graph.
+// (lm_ggml_mul_mat consumes them natively), quantized types follow
+// codec_graph_native_quant.  Use this for every tensor that lands as the LHS of
+// lm_ggml_mul_mat in a hot per-step graph.
 lm_ggml_tensor * codec_graph_weight_mat(lm_ggml_context * ctx_eval, const codec_model * model, const char * name);
 lm_ggml_tensor * codec_graph_weight_mat(lm_ggml_context * ctx_eval, const codec_model * model, const std::string & name);
 
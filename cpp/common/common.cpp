@@ -1222,8 +1222,8 @@ struct common_init_result::impl {
 
     // note: the order in which model, context, etc. are declared matters because their destructors will be called bottom-to-top
 
-    llama_model_ptr   model;
-    llama_context_ptr context;
+    std::shared_ptr<llama_model> model;
+    llama_context_ptr            context;
 
     std::vector<llama_adapter_lora_ptr> lora;
 
@@ -1231,7 +1231,7 @@ struct common_init_result::impl {
     std::vector<llama_sampler_seq_config> samplers_seq_config;
 };
 
-common_init_result::common_init_result(common_params & params, bool model_only) :
+common_init_result::common_init_result(common_params & params, bool model_only, std::shared_ptr<llama_model> shared_model) :
     pimpl(new impl{}) {
     auto mparams = common_model_params_to_llama(params);
     auto cparams = common_context_params_to_llama(params);
@@ -1239,20 +1239,34 @@ common_init_result::common_init_result(common_params & params, bool model_only)
     if (params.fit_params) {
         COM_TRC("%s", "fitting params to device memory ...\n");
         COM_TRC("%s", "(for bugs during this step try to reproduce them with -fit off, or provide --verbose logs if the bug only occurs with -fit on)\n");
-        common_fit_params(params.model.path.c_str(), &mparams, &cparams,
-            params.tensor_split,
-            params.tensor_buft_overrides.data(),
-            params.fit_params_target.data(),
-            params.fit_params_min_ctx,
-            params.verbosity >= LOG_LEVEL_DEBUG ? LM_GGML_LOG_LEVEL_DEBUG : LM_GGML_LOG_LEVEL_ERROR);
+        if (shared_model != nullptr) {
+            // the shared weights are already resident: only the context params of this context are fitted next to them
+            common_fit_context_params(params.model.path.c_str(), &mparams, &cparams,
+                params.fit_params_target.data(),
+                params.fit_params_min_ctx,
+                params.verbosity >= LOG_LEVEL_DEBUG ? LM_GGML_LOG_LEVEL_DEBUG : LM_GGML_LOG_LEVEL_ERROR);
+        } else {
+            common_fit_params(params.model.path.c_str(), &mparams, &cparams,
+                params.tensor_split,
+                params.tensor_buft_overrides.data(),
+                params.fit_params_target.data(),
+                params.fit_params_min_ctx,
+                params.verbosity >= LOG_LEVEL_DEBUG ? LM_GGML_LOG_LEVEL_DEBUG : LM_GGML_LOG_LEVEL_ERROR);
+        }
     }
 
-    llama_model * model = llama_model_load_from_file(params.model.path.c_str(), mparams);
-    if (model == NULL) {
-        return;
+    if (shared_model != nullptr) {
+        pimpl->model = std::move(shared_model);
+    } else {
+        llama_model * loaded = llama_model_load_from_file(params.model.path.c_str(), mparams);
+        if (loaded == NULL) {
+            return;
+        }
+
+        pimpl->model.reset(loaded, llama_model_free);
     }
 
-    pimpl->model.reset(model);
+    llama_model * model = pimpl->model.get();
 
     if (model_only) {
         return;
@@ -1333,6 +1347,10 @@ llama_context * common_init_result::context() {
     return pimpl->context.get();
 }
 
+std::shared_ptr<llama_model> common_init_result::shared_model() {
+    return pimpl->model;
+}
+
 common_sampler * common_init_result::sampler(llama_seq_id seq_id) {
     if (seq_id < 0 || seq_id >= (int) pimpl->samplers.size()) {
         return nullptr;
@@ -1350,8 +1368,8 @@ std::vector<llama_adapter_lora_ptr> & common_init_result::lora() {
     return pimpl->lora;
 }
 
-common_init_result_ptr common_init_from_params(common_params & params, bool model_only) {
-    common_init_result_ptr res(new common_init_result(params, model_only));
+common_init_result_ptr common_init_from_params(common_params & params, bool model_only, std::shared_ptr<llama_model> shared_model) {
+    common_init_result_ptr res(new common_init_result(params, model_only, std::move(shared_model)));
 
     llama_model * model = res->model();
     if (model == NULL) {
@@ -1611,6 +1629,10 @@ struct llama_model_params common_model_params_to_llama(common_params & params) {
     mparams.use_extra_bufts = !params.no_extra_bufts;
     mparams.no_host         = params.no_host;
 
+    if (!params.repack_cache_dir.empty()) {
+        mparams.repack_cache_dir = params.repack_cache_dir.c_str();
+    }
+
     if (params.kv_overrides.empty()) {
         mparams.kv_overrides = NULL;
     } else {
@@ -1660,6 +1682,7 @@ struct llama_context_params common_context_params_to_llama(const common_params &
     cparams.yarn_beta_fast    = params.yarn_beta_fast;
     cparams.yarn_beta_slow    = params.yarn_beta_slow;
     cparams.yarn_orig_ctx     = params.yarn_orig_ctx;
+    cparams.defrag_thold      = params.defrag_thold;
     cparams.pooling_type      = params.pooling_type;
     cparams.attention_type    = params.attention_type;
     cparams.flash_attn_type   = params.flash_attn_type;
@@ -1670,9 +1693,11 @@ struct llama_context_params common_context_params_to_llama(const common_params &
     cparams.op_offload        = !params.no_op_offload;
     cparams.swa_full          = params.swa_full;
     cparams.kv_unified        = params.kv_unified;
+    cparams.compute_arena     = params.compute_arena;
 
     cparams.type_k = params.cache_type_k;
     cparams.type_v = params.cache_type_v;
+    cparams.n_kv_hot = std::max(0, params.cache_n_hot);
 
     return cparams;
 }
@@ -1728,27 +1753,29 @@ std::vector<llama_token> common_tokenize(
   const struct llama_context * ctx,
            const std::string & text,
                         bool   add_special,
-                        bool   parse_special) {
+                        bool   parse_special,
+                     int32_t   n_threads) {
     const llama_model * model = llama_get_model(ctx);
     const llama_vocab * vocab = llama_model_get_vocab(model);
-    return common_tokenize(vocab, text, add_special, parse_special);
+    return common_tokenize(vocab, text, add_special, parse_special, n_threads);
 }
 
 std::vector<llama_token> common_tokenize(
     const struct llama_vocab * vocab,
            const std::string & text,
                         bool   add_special,
-                        bool   parse_special) {
+                        bool   parse_special,
+                     int32_t   n_threads) {
     // upper limit for the number of tokens
     int n_tokens = text.length() + 2 * add_special;
     std::vector<llama_token> result(n_tokens);
-    n_tokens = llama_tokenize(vocab, text.data(), text.length(), result.data(), result.size(), add_special, parse_special);
+    n_tokens = llama_tokenize_parallel(vocab, text.data(), text.length(), result.data(), result.size(), add_special, parse_special, n_threads);
     if (n_tokens == std::numeric_limits<int32_t>::min()) {
         throw std::runtime_error("Tokenization failed: input text too large, tokenization result exceeds int32_t limit");
     }
     if (n_tokens < 0) {
         result.resize(-n_tokens);
-        int check = llama_tokenize(vocab, text.data(), text.length(), result.data(), result.size(), add_special, parse_special);
+        int check = llama_tokenize_parallel(vocab, text.data(), text.length(), result.data(), result.size(), add_special, parse_special, n_threads);
         LM_GGML_ASSERT(check == -n_tokens);
     } else {
         result.resize(n_tokens);
@@ -367,6 +367,17 @@ struct common_params_speculative_ngram_cache {
     std::string lookup_cache_dynamic; // path of dynamic ngram cache file for lookup decoding
 };
 
+struct common_params_speculative_tree {
+    int32_t n_branch = 0;  // max branches verified per step, each under its own sequence id (0 = linear drafts)
+    int32_t n_nodes  = 16; // max draft tokens in the tree
+};
+
+struct common_params_speculative_adaptive {
+    bool    enabled = false; // pick the draft length from live acceptance and cost statistics
+    float   decay   = 0.9f;  // weight of the history in the rolling statistics
+    int32_t n_probe = 16;    // steps to skip while drafting does not pay off, before probing again
+};
+
 struct common_params_speculative {
     std::vector<enum common_speculative_type> types = { COMMON_SPECULATIVE_TYPE_NONE };
 
@@ -380,6 +391,10 @@ struct common_params_speculative {
 
     common_params_speculative_ngram_cache ngram_cache;
 
+    common_params_speculative_tree tree;
+
+    common_params_speculative_adaptive adaptive;
+
     bool has_dft() const {
         return !draft.mparams.empty();
     }
@@ -445,6 +460,8 @@ struct common_params {
     int32_t n_batch               =  2048; // logical batch size for prompt processing (must be >=32 to use BLAS)
     int32_t n_ubatch              =   512; // physical batch size for prompt processing (must be >=32 to use BLAS)
     int32_t n_keep                =     0; // number of tokens to keep from initial prompt
+    int32_t n_sink                =     0; // attention-sink streaming on context shift: leading tokens always kept (0 = halve the context past n_keep)
+    int32_t n_sink_evict          =    64; // attention-sink streaming: tokens evicted from the recent window per shift
     int32_t n_chunks              =    -1; // max number of chunks to process (-1 = unlimited)
     int32_t n_parallel            =     1; // number of parallel sequences to decode
     int32_t n_sequences           =     1; // number of sequences to decode
@@ -460,6 +477,7 @@ struct common_params {
     float   yarn_beta_fast        = -1.0f; // YaRN low correction dim
     float   yarn_beta_slow        = -1.0f; // YaRN high correction dim
     int32_t yarn_orig_ctx         =     0; // YaRN original context length
+    float   defrag_thold          = -1.0f; // KV cache compaction threshold (holes/used range), <= 0 disabled
 
     // offload params
     std::vector<lm_ggml_backend_dev_t> devices; // devices to use for offloading
@@ -574,6 +592,11 @@ struct common_params {
     bool no_extra_bufts    = false; // disable extra buffer types (used for weight repacking)
     bool no_host           = false; // bypass host buffer allowing extra buffers to be used
 
+    std::string repack_cache_dir = ""; // directory for the repacked weight cache, empty = disabled  // NOLINT
+
+    bool shared_compute_arena = false; // one host compute buffer for the model, multimodal projector and vocoder
+    lm_ggml_backend_arena_t compute_arena = nullptr; // the arena for shared_compute_arena, owned by the caller
+
     bool single_turn       = false; // single turn chat conversation
 
     llama_progress_callback progress_callback = nullptr;
@@ -581,6 +604,7 @@ struct common_params {
 
     lm_ggml_type cache_type_k = LM_GGML_TYPE_F16; // KV cache data type for the K
     lm_ggml_type cache_type_v = LM_GGML_TYPE_F16; // KV cache data type for the V
+    int32_t   cache_n_hot  = 0;                // most recent keys per sequence kept in F16 with a quantized K cache (0 = disabled)
 
     common_conversation_mode conversation_mode = COMMON_CONVERSATION_MODE_AUTO;
 
@@ -913,12 +937,16 @@ struct common_sampler;
 
 // note: defines the model, context, samplers, ets. lifetimes
 struct common_init_result {
-    common_init_result(common_params & params, bool model_only = false);
+    // if shared_model is set, it is used instead of loading the model from params (only the context params are fitted)
+    common_init_result(common_params & params, bool model_only = false, std::shared_ptr<llama_model> shared_model = nullptr);
     ~common_init_result();
 
     llama_model * model();
     llama_context * context();
 
+    // shared ownership of the model, e.g. to create more contexts that outlive this one
+    std::shared_ptr<llama_model> shared_model();
+
     common_sampler * sampler(llama_seq_id seq_id);
     void reset_samplers();
 
@@ -931,7 +959,7 @@ private:
 
 using common_init_result_ptr = std::unique_ptr<common_init_result>;
 
-common_init_result_ptr common_init_from_params(common_params & params, bool model_only = false);
+common_init_result_ptr common_init_from_params(common_params & params, bool model_only = false, std::shared_ptr<llama_model> shared_model = nullptr);
 
 struct llama_model_params     common_model_params_to_llama  (      common_params & params);
 struct llama_context_params   common_context_params_to_llama(const common_params & params);
@@ -1010,17 +1038,20 @@ bool common_replay_last_token(struct llama_context * ctx, llama_token last_token
 
 // tokenizes a string into a vector of tokens
 // should work similar to Python's `tokenizer.encode`
+// n_threads > 1 tokenizes long texts in parallel with the same result (see llama_tokenize_parallel)
 std::vector<llama_token> common_tokenize(
   const struct llama_context * ctx,
            const std::string & text,
                         bool   add_special,
-                        bool   parse_special = false);
+                        bool   parse_special = false,
+                     int32_t   n_threads     = 1);
 
 std::vector<llama_token> common_tokenize(
     const struct llama_vocab * vocab,
            const std::string & text,
                         bool   add_special,
-                        bool   parse_special = false);
+                        bool   parse_special = false,
+                     int32_t   n_threads     = 1);
 
 // tokenizes a token into a piece, optionally renders special/control tokens
 // should work similar to Python's `tokenizer.id_to_piece`
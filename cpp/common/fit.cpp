@@ -34,7 +34,8 @@ static std::vector<llama_device_memory_data> common_get_device_memory_data_impl(
         uint32_t & hp_ngl,
         uint32_t & hp_n_ctx_train,
         uint32_t & hp_n_expert,
-        lm_ggml_log_level log_level) {
+        lm_ggml_log_level log_level,
+        bool model_resident = false) {
     struct user_data_t {
         struct {
             lm_ggml_log_callback callback;
@@ -96,6 +97,13 @@ static std::vector<llama_device_memory_data> common_get_device_memory_data_impl(
         }
     }
 
+    if (model_resident) {
+        // the weights of a model that is already loaded are no longer part of the free device memory
+        for (size_t i = 0; i < nd; i++) {
+            ret[i].mb.model = 0;
+        }
+    }
+
     {
         lm_ggml_backend_dev_t cpu_dev = lm_ggml_backend_dev_by_type(LM_GGML_BACKEND_DEVICE_TYPE_CPU);
         if (cpu_dev == nullptr) {
@@ -178,7 +186,7 @@ common_device_memory_data_vec common_get_device_memory_data(
 static void common_params_fit_impl(
         const char * path_model, struct llama_model_params * mparams, struct llama_context_params * cparams,
         float * tensor_split, struct llama_model_tensor_buft_override * tensor_buft_overrides,
-        size_t * margins_s, uint32_t n_ctx_min, enum lm_ggml_log_level log_level) {
+        size_t * margins_s, uint32_t n_ctx_min, enum lm_ggml_log_level log_level, bool model_resident) {
     if (mparams->split_mode == LLAMA_SPLIT_MODE_TENSOR) {
         throw common_params_fit_exception("llama_params_fit is not implemented for SPLIT_MODE_TENSOR, abort");
     }
@@ -194,7 +202,7 @@ static void common_params_fit_impl(
     // step 1: get data for default parameters and check whether any changes are necessary in the first place
 
     LOG_TRC("%s: getting device memory data for initial parameters:\n", __func__);
-    const dmds_t dmds_full = common_get_device_memory_data_impl(path_model, mparams, cparams, devs, hp_ngl, hp_nct, hp_nex, log_level);
+    const dmds_t dmds_full = common_get_device_memory_data_impl(path_model, mparams, cparams, devs, hp_ngl, hp_nct, hp_nex, log_level, model_resident);
     const size_t nd = devs.size(); // number of devices
 
     std::vector<int64_t> margins; // this function uses int64_t rather than size_t for memory sizes to more conveniently handle deficits
@@ -329,7 +337,7 @@ static void common_params_fit_impl(
 
                     int64_t sum_projected_used_min_ctx = 0;
                     cparams->n_ctx = n_ctx_min;
-                    const dmds_t dmds_min_ctx = common_get_device_memory_data_impl(path_model, mparams, cparams, devs, hp_ngl, hp_nct, hp_nex, log_level);
+                    const dmds_t dmds_min_ctx = common_get_device_memory_data_impl(path_model, mparams, cparams, devs, hp_ngl, hp_nct, hp_nex, log_level, model_resident);
                     if (nd == 0) {
                         sum_projected_used_min_ctx = dmds_min_ctx.back().mb.total();
                     } else {
@@ -373,6 +381,9 @@ static void common_params_fit_impl(
     if (nd == 0) {
         throw common_params_fit_exception("was unable to fit model into system memory by reducing context, abort");
     }
+    if (model_resident) {
+        throw common_params_fit_exception("was unable to fit context next to the loaded model by reducing context, abort");
+    }
 
     if (mparams->n_gpu_layers != default_mparams.n_gpu_layers) {
         throw common_params_fit_exception("n_gpu_layers already set by user to " + std::to_string(mparams->n_gpu_layers) + ", abort");
@@ -788,7 +799,7 @@ static void common_params_fit_impl(
     set_ngl_tensor_split_tbo(ngl_per_device, overflow_bufts, *mparams);
 }
 
-enum common_params_fit_status common_fit_params(
+static enum common_params_fit_status common_fit_params_status(
         const char * path_model,
         llama_model_params * mparams,
         llama_context_params * cparams,
@@ -796,11 +807,12 @@ enum common_params_fit_status common_fit_params(
         llama_model_tensor_buft_override * tensor_buft_overrides,
         size_t * margins,
         uint32_t n_ctx_min,
-        lm_ggml_log_level log_level) {
+        lm_ggml_log_level log_level,
+        bool model_resident) {
     const int64_t t0_us = llama_time_us();
     common_params_fit_status status = COMMON_PARAMS_FIT_STATUS_SUCCESS;
     try {
-        common_params_fit_impl(path_model, mparams, cparams, tensor_split, tensor_buft_overrides, margins, n_ctx_min, log_level);
+        common_params_fit_impl(path_model, mparams, cparams, tensor_split, tensor_buft_overrides, margins, n_ctx_min, log_level, model_resident);
         LOG_TRC("%s: successfully fit params to free device memory\n", __func__);
     } catch (const common_params_fit_exception & e) {
         LOG_WRN("%s: failed to fit params to free device memory: %s\n", __func__, e.what());
@@ -814,6 +826,32 @@ enum common_params_fit_status common_fit_params(
     return status;
 }
 
+enum common_params_fit_status common_fit_params(
+        const char * path_model,
+        llama_model_params * mparams,
+        llama_context_params * cparams,
+        float * tensor_split,
+        llama_model_tensor_buft_override * tensor_buft_overrides,
+        size_t * margins,
+        uint32_t n_ctx_min,
+        lm_ggml_log_level log_level) {
+    return common_fit_params_status(path_model, mparams, cparams, tensor_split, tensor_buft_overrides, margins, n_ctx_min, log_level,
+        /*model_resident =*/ false);
+}
+
+enum common_params_fit_status common_fit_context_params(
+        const char * path_model,
+        const llama_model_params * mparams,
+        llama_context_params * cparams,
+        size_t * margins,
+        uint32_t n_ctx_min,
+        lm_ggml_log_level log_level) {
+    // the model params only describe the placement of the loaded model, they are never written
+    llama_model_params mparams_copy = *mparams;
+    return common_fit_params_status(path_model, &mparams_copy, cparams, nullptr, nullptr, margins, n_ctx_min, log_level,
+        /*model_resident =*/ true);
+}
+
 void common_memory_breakdown_print(const struct llama_context * ctx) {
     //const auto & devices = ctx->get_model().devices;
     const auto * model = llama_get_model(ctx);
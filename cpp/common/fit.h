@@ -26,6 +26,17 @@ common_params_fit_status common_fit_params(
                            uint32_t   n_ctx_min,             // minimum context size to set when trying to reduce memory use
                      lm_ggml_log_level   log_level);            // minimum log level to print during fitting, lower levels go to debug log
 
+// fits only cparams to free device memory next to a model that is already loaded with mparams
+//   - the weights of that model are resident and no longer counted, so only the context size can change
+//   - same rules for the context size as common_fit_params
+common_params_fit_status common_fit_context_params(
+                         const char * path_model,
+           const llama_model_params * mparams,
+               llama_context_params * cparams,
+                             size_t * margins,               // margins of memory to leave per device in bytes
+                           uint32_t   n_ctx_min,             // minimum context size to set when trying to reduce memory use
+                     lm_ggml_log_level   log_level);            // minimum log level to print during fitting, lower levels go to debug log
+
 // print estimated memory to stdout
 void common_fit_print(
                          const char * path_model,
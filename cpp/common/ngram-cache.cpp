@@ -1,16 +1,281 @@
 #include "ngram-cache.h"
 #include "common.h"
 #include "log.h"
+#include "llama-mmap.h"
 
 #include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <stdexcept>
 #include <thread>
 #include <algorithm>
 
+// On-disk layout: header followed by the raw bucket array, so that a saved cache can be mapped directly.
+#define LLAMA_NGRAM_CACHE_MAGIC   0x4e474331u // "NGC1"
+#define LLAMA_NGRAM_CACHE_VERSION 1
+
+struct common_ngram_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ngram_max;
+    uint32_t n_next;
+    uint64_t n_buckets;
+    uint64_t n_used;
+};
+
+void common_ngram_cache_entry::add(llama_token token, int32_t n) {
+    sum += n;
+
+    int i_min = 0;
+    for (int i = 0; i < LLAMA_NGRAM_NEXT; ++i) {
+        if (count[i] > 0 && next[i] == token) {
+            count[i] += n;
+            return;
+        }
+        if (count[i] < count[i_min]) {
+            i_min = i;
+        }
+    }
+
+    // replace the weakest (or an unused) candidate; it keeps its count as the error bound
+    next [i_min]  = token;
+    count[i_min] += n;
+}
+
+common_ngram_cache::common_ngram_cache(const common_ngram_cache & other)
+    : entries(other.entries)
+    , mapping(other.mapping)
+    , buckets(other.mapping ? other.buckets : entries.data())
+    , n_buckets(other.n_buckets)
+    , n_used(other.n_used) {
+}
+
+common_ngram_cache::common_ngram_cache(common_ngram_cache && other) noexcept
+    : entries(std::move(other.entries))
+    , mapping(std::move(other.mapping))
+    , buckets(other.buckets)
+    , n_buckets(other.n_buckets)
+    , n_used(other.n_used) {
+    other.buckets   = nullptr;
+    other.n_buckets = 0;
+    other.n_used    = 0;
+}
+
+common_ngram_cache & common_ngram_cache::operator=(common_ngram_cache other) noexcept {
+    std::swap(entries,   other.entries);
+    std::swap(mapping,   other.mapping);
+    std::swap(buckets,   other.buckets);
+    std::swap(n_buckets, other.n_buckets);
+    std::swap(n_used,    other.n_used);
+    return *this;
+}
+
+const common_ngram_cache_entry * common_ngram_cache::find(const common_ngram & ngram) const {
+    if (n_used == 0) {
+        return nullptr;
+    }
+
+    // a table without empty buckets (possible only for a damaged file) must not make the probe spin
+    const size_t mask = n_buckets - 1;
+    size_t i = common_ngram_hash(ngram) & mask;
+    for (size_t n_probe = 0; n_probe < n_buckets; ++n_probe, i = (i + 1) & mask) {
+        const common_ngram_cache_entry & entry = buckets[i];
+        if (entry.sum == 0) {
+            return nullptr;
+        }
+        if (entry.ngram == ngram) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+common_ngram_cache_entry & common_ngram_cache::insert(const common_ngram & ngram) {
+    make_owned();
+
+    // keep the load factor at or below 1/2 so probe sequences stay short
+    if (2*(n_used + 1) > n_buckets) {
+        reserve(std::max<size_t>(64, 2*n_buckets));
+    }
+
+    const size_t mask = n_buckets - 1;
+    for (size_t i = common_ngram_hash(ngram) & mask; ; i = (i + 1) & mask) {
+        common_ngram_cache_entry & entry = entries[i];
+        if (entry.sum == 0) {
+            entry.ngram = ngram;
+            n_used++;
+            return entry;
+        }
+        if (entry.ngram == ngram) {
+            return entry;
+        }
+    }
+}
+
+void common_ngram_cache::add(const common_ngram & ngram, llama_token token, int32_t n) {
+    LM_GGML_ASSERT(n > 0);
+    insert(ngram).add(token, n);
+}
+
+void common_ngram_cache::merge(const common_ngram_cache & other) {
+    if (&other == this) {
+        return;
+    }
+
+    for (const common_ngram_cache_entry & entry_add : other) {
+        if (entry_add.sum == 0) {
+            continue;
+        }
+
+        common_ngram_cache_entry & entry = insert(entry_add.ngram);
+        int32_t n_added = 0;
+        for (int i = 0; i < LLAMA_NGRAM_NEXT; ++i) {
+            if (entry_add.count[i] > 0) {
+                entry.add(entry_add.next[i], entry_add.count[i]);
+                n_added += entry_add.count[i];
+            }
+        }
+        // observations of continuations that were not tracked still count towards the sample size
+        entry.sum += std::max(0, entry_add.sum - n_added);
+    }
+}
+
+void common_ngram_cache::clear() {
+    entries.clear();
+    mapping.reset();
+    buckets   = nullptr;
+    n_buckets = 0;
+    n_used    = 0;
+}
+
+void common_ngram_cache::reserve(size_t n_buckets_new) {
+    LM_GGML_ASSERT((n_buckets_new & (n_buckets_new - 1)) == 0);
+
+    std::vector<common_ngram_cache_entry> entries_new(n_buckets_new);
+
+    const size_t mask = n_buckets_new - 1;
+    for (size_t j = 0; j < n_buckets; ++j) {
+        const common_ngram_cache_entry & entry = buckets[j];
+        if (entry.sum == 0) {
+            continue;
+        }
+        size_t i = common_ngram_hash(entry.ngram) & mask;
+        while (entries_new[i].sum != 0) {
+            i = (i + 1) & mask;
+        }
+        entries_new[i] = entry;
+    }
+
+    entries   = std::move(entries_new);
+    mapping.reset();
+    buckets   = entries.data();
+    n_buckets = n_buckets_new;
+}
+
+void common_ngram_cache::make_owned() {
+    if (!mapping) {
+        return;
+    }
+    entries.assign(buckets, buckets + n_buckets);
+    mapping.reset();
+    buckets = entries.data();
+}
+
+void common_ngram_cache::save(const std::string & filename) const {
+    std::ofstream file_out(filename, std::ios::binary);
+    if (!file_out) {
+        throw std::runtime_error("Unable to open file " + filename);
+    }
+
+    const common_ngram_cache_header header = {
+        /* .magic     = */ LLAMA_NGRAM_CACHE_MAGIC,
+        /* .version   = */ LLAMA_NGRAM_CACHE_VERSION,
+        /* .ngram_max = */ LLAMA_NGRAM_MAX,
+        /* .n_next    = */ LLAMA_NGRAM_NEXT,
+        /* .n_buckets = */ n_buckets,
+        /* .n_used    = */ n_used,
+    };
+    file_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file_out.write(reinterpret_cast<const char *>(buckets), n_buckets*sizeof(common_ngram_cache_entry));
+    if (!file_out) {
+        throw std::runtime_error("Failed to write file " + filename);
+    }
+}
+
+void common_ngram_cache::load(const std::string & filename) {
+    clear();
+
+    llama_file file(filename.c_str(), "rb");
+    const size_t file_size = file.size();
+
+    common_ngram_cache_header header = {};
+    if (file_size >= sizeof(header)) {
+        file.read_raw(&header, sizeof(header));
+    }
+
+    if (header.magic != LLAMA_NGRAM_CACHE_MAGIC) {
+        // older stream format: n-gram, number of continuations, then (token, count) pairs
+        file.seek(0, SEEK_SET);
+        while (file.tell() < file_size) {
+            common_ngram ngram;
+            file.read_raw(&ngram, sizeof(ngram));
+            const int32_t ntokens = (int32_t) file.read_u32();
+            LM_GGML_ASSERT(ntokens > 0);
+            for (int32_t i = 0; i < ntokens; ++i) {
+                const llama_token token = (llama_token) file.read_u32();
+                const int32_t     count = (int32_t) file.read_u32();
+                LM_GGML_ASSERT(count > 0);
+                add(ngram, token, count);
+            }
+        }
+        return;
+    }
+
+    if (header.version != LLAMA_NGRAM_CACHE_VERSION || header.ngram_max != LLAMA_NGRAM_MAX || header.n_next != LLAMA_NGRAM_NEXT) {
+        throw std::runtime_error("Incompatible ngram cache file " + filename);
+    }
+    // bound n_buckets by the file before multiplying, a crafted count could wrap the table size
+    if ((header.n_buckets & (header.n_buckets - 1)) != 0 || header.n_used > header.n_buckets/2 ||
+        header.n_buckets > (file_size - sizeof(header))/sizeof(common_ngram_cache_entry) ||
+        file_size != sizeof(header) + header.n_buckets*sizeof(common_ngram_cache_entry)) {
+        throw std::runtime_error("Corrupted ngram cache file " + filename);
+    }
+    if (header.n_buckets == 0) {
+        return;
+    }
+
+    if (llama_mmap::SUPPORTED) {
+        // the table is used in place instead of being copied into memory
+        mapping   = std::make_shared<llama_mmap>(&file, 0);
+        buckets   = reinterpret_cast<const common_ngram_cache_entry *>(
+            static_cast<const uint8_t *>(mapping->addr()) + sizeof(header));
+    } else {
+        entries.resize(header.n_buckets);
+        file.read_raw(entries.data(), header.n_buckets*sizeof(common_ngram_cache_entry));
+        buckets   = entries.data();
+    }
+    n_buckets = header.n_buckets;
+    n_used    = header.n_used;
+
+    // the header must agree with the table, otherwise lookups and inserts cannot rely on the load factor
+    size_t n_used_table = 0;
+    for (const common_ngram_cache_entry & entry : *this) {
+        if (entry.sum < 0) {
+            n_used_table = SIZE_MAX;
+            break;
+        }
+        n_used_table += entry.sum != 0;
+    }
+    if (n_used_table != n_used) {
+        clear();
+        throw std::runtime_error("Corrupted ngram cache file " + filename);
+    }
+}
+
 void common_ngram_cache_update(common_ngram_cache & ngram_cache, int ngram_min, int ngram_max,
-                              std::vector<llama_token> & inp, int nnew, bool print_progress) {
+                              const std::vector<llama_token> & inp, int nnew, bool print_progress) {
     const int64_t t_start_ms = lm_ggml_time_ms();
     const int64_t inp_size = inp.size();
 
@@ -24,19 +289,7 @@ void common_ngram_cache_update(common_ngram_cache & ngram_cache, int ngram_min,
             common_ngram ngram(&inp[ngram_start], ngram_size);
             const llama_token token = inp[i];
 
-            common_ngram_cache::iterator part_it = ngram_cache.find(ngram);
-            if (part_it == ngram_cache.end()) {
-                common_ngram_cache_part part;
-                part.emplace(token, 1);
-                ngram_cache.emplace(ngram, part);
-            } else {
-                common_ngram_cache_part::iterator token_count_it = part_it->second.find(token);
-                if (token_count_it == part_it->second.end()) {
-                    part_it->second.emplace(token, 1);
-                } else {
-                    token_count_it->second++;
-                }
-            }
+            ngram_cache.add(ngram, token);
             ++n_done;
 
             if (print_progress && n_done % 10000000 == 0) {
@@ -63,26 +316,23 @@ constexpr int draft_min_sample_size_strict[LLAMA_NGRAM_MAX] = { 4,  3,  2,  2};
 constexpr int     draft_min_percent_strict[LLAMA_NGRAM_MAX] = {75, 66, 66, 66};
 
 // Helper function that tries to draft a token from only the static ngram cache:
-static llama_token try_draft(common_ngram_cache & nc_static, const common_ngram ngram_static) {
-    common_ngram_cache::iterator part_static_it = nc_static.find(ngram_static);
-    if (part_static_it == nc_static.end()) {
+static llama_token try_draft(const common_ngram_cache & nc_static, const common_ngram ngram_static) {
+    const common_ngram_cache_entry * part_static = nc_static.find(ngram_static);
+    if (part_static == nullptr) {
         return LLAMA_TOKEN_NULL;
     }
-    const common_ngram_cache_part part_static = part_static_it->second;
 
     int max_count_static  = 0;
-    int sum_count_static  = 0;
+    int sum_count_static  = part_static->sum;
     llama_token max_token = LLAMA_TOKEN_NULL;
 
-    for (std::pair<llama_token, int> token_count_static : part_static) {
-        const llama_token token = token_count_static.first;
-        const int32_t count_static  = token_count_static.second;
+    for (int j = 0; j < LLAMA_NGRAM_NEXT; ++j) {
+        const int32_t count_static = part_static->count[j];
 
         if (count_static > max_count_static) {
-            max_token        = token;
+            max_token        = part_static->next[j];
             max_count_static = count_static;
         }
-        sum_count_static += count_static;
     }
 
     if (sum_count_static < draft_min_sample_size_lax[LLAMA_NGRAM_STATIC-1]) {
@@ -96,46 +346,44 @@ static llama_token try_draft(common_ngram_cache & nc_static, const common_ngram
 
 // Try to draft a token from primary cache (context/dynamic), validate with static cache:
 static llama_token try_draft(
-    common_ngram_cache & nc_primary, const std::vector<common_ngram> & ngrams_primary, common_ngram_cache_part & part_static,
-    const int * min_sample_size, const int * min_percent) {
+    const common_ngram_cache & nc_primary, const common_ngram * ngrams_primary, const int n_ngrams_primary,
+    const common_ngram_cache_entry * part_static, const int * min_sample_size, const int * min_percent) {
 
     llama_token drafted_token = LLAMA_TOKEN_NULL;
 
-    for (int i = ngrams_primary.size()-1; i >= 0 && drafted_token == LLAMA_TOKEN_NULL; --i) {
-        const common_ngram ngram_primary = ngrams_primary[i];
-
-        common_ngram_cache::iterator part_primary_it = nc_primary.find(ngram_primary);
-        if (part_primary_it == nc_primary.end()) {
+    for (int i = n_ngrams_primary-1; i >= 0 && drafted_token == LLAMA_TOKEN_NULL; --i) {
+        const common_ngram_cache_entry * part_primary = nc_primary.find(ngrams_primary[i]);
+        if (part_primary == nullptr) {
             continue;
         }
-        const common_ngram_cache_part part_primary = part_primary_it->second;
 
         int max_count_primary = 0;
         int max_count_static  = 0;
-        int sum_count_primary = 0;
+        int sum_count_primary = part_primary->sum;
         llama_token max_token = LLAMA_TOKEN_NULL;
 
-        for (std::pair<llama_token, int> token_count_primary : part_primary) {
-            const llama_token token = token_count_primary.first;
-
-            common_ngram_cache_part::iterator token_count_static_it = part_static.find(token);
+        for (int j = 0; j < LLAMA_NGRAM_NEXT; ++j) {
+            const int32_t count_primary = part_primary->count[j];
+            if (count_primary == 0) {
+                continue;
+            }
+            const llama_token token = part_primary->next[j];
 
-            const int32_t count_primary = token_count_primary.second;
-            const int32_t count_static  = token_count_static_it != part_static.end() ? 100*token_count_static_it->second : 1;
+            const int32_t token_count_static = part_static != nullptr ? part_static->get(token) : 0;
+            const int32_t count_static       = token_count_static > 0 ? 100*token_count_static : 1;
 
             if (count_primary*count_static > max_count_primary*max_count_static) {
                 max_token         = token;
                 max_count_primary = count_primary;
                 max_count_static  = count_static;
             }
-            sum_count_primary += count_primary;
         }
 
         if (sum_count_primary < min_sample_size[i]) {
             continue;
         }
         if (100*max_count_primary < min_percent[i]*sum_count_primary) {
-            continue;;
+            continue;
         }
         drafted_token = max_token;
     }
@@ -144,10 +392,11 @@ static llama_token try_draft(
 }
 
 void common_ngram_cache_draft(
-    std::vector<llama_token> & inp, std::vector<llama_token> & draft, int n_draft, int ngram_min, int ngram_max,
-    common_ngram_cache & nc_context, common_ngram_cache & nc_dynamic, common_ngram_cache & nc_static
+    const std::vector<llama_token> & inp, std::vector<llama_token> & draft, int n_draft, int ngram_min, int ngram_max,
+    const common_ngram_cache & nc_context, const common_ngram_cache & nc_dynamic, const common_ngram_cache & nc_static
 ) {
     LM_GGML_ASSERT(draft.size() == 1);
+    LM_GGML_ASSERT(ngram_max <= LLAMA_NGRAM_MAX);
     const int inp_size = inp.size();
 
     if (inp_size < LLAMA_NGRAM_STATIC) {
@@ -162,27 +411,26 @@ void common_ngram_cache_draft(
         for (int j = ngram_start_static; j < ngram_start_static + LLAMA_NGRAM_STATIC; ++j) {
             ngram_static.tokens[j-ngram_start_static] = get_token(inp, draft, j);
         }
-        common_ngram_cache::iterator part_static_it = nc_static.find(ngram_static);
-        common_ngram_cache_part part_static;
-        if (part_static_it != nc_static.end()) {
-            part_static = part_static_it->second;
-        }
+        const common_ngram_cache_entry * part_static = nc_static.find(ngram_static);
 
         // cd = context + dynamic
-        std::vector<common_ngram> ngrams_cd;
+        common_ngram ngrams_cd[LLAMA_NGRAM_MAX];
+        int n_ngrams_cd = 0;
         for (int ngram_size_cd = ngram_min; ngram_size_cd <= ngram_max; ++ngram_size_cd) {
             const int ngram_start_cd = inp_size-ngram_size_cd + draft.size()-1;
-            common_ngram ngram_cd;
+            if (ngram_start_cd < 0) {
+                break;
+            }
+            common_ngram & ngram_cd = ngrams_cd[n_ngrams_cd++];
             for (int j = ngram_start_cd; j < ngram_start_cd + ngram_size_cd; ++j) {
                 ngram_cd.tokens[j-ngram_start_cd] = get_token(inp, draft, j);
             }
-            ngrams_cd.push_back(ngram_cd);
         }
         if (drafted_token == LLAMA_TOKEN_NULL) {
-            drafted_token = try_draft(nc_context, ngrams_cd, part_static, draft_min_sample_size_lax, draft_min_percent_lax);
+            drafted_token = try_draft(nc_context, ngrams_cd, n_ngrams_cd, part_static, draft_min_sample_size_lax, draft_min_percent_lax);
         }
         if (drafted_token == LLAMA_TOKEN_NULL) {
-            drafted_token = try_draft(nc_dynamic, ngrams_cd, part_static, draft_min_sample_size_strict, draft_min_percent_strict);
+            drafted_token = try_draft(nc_dynamic, ngrams_cd, n_ngrams_cd, part_static, draft_min_sample_size_strict, draft_min_percent_strict);
         }
         if (drafted_token == LLAMA_TOKEN_NULL) {
             drafted_token = try_draft(nc_static, ngram_static);
@@ -197,89 +445,16 @@ void common_ngram_cache_draft(
     }
 }
 
-void common_ngram_cache_save(common_ngram_cache & ngram_cache, const std::string & filename) {
-    std::ofstream file_out(filename, std::ios::binary);
-    for (std::pair<common_ngram, common_ngram_cache_part> item : ngram_cache) {
-        const common_ngram      ngram        = item.first;
-        common_ngram_cache_part token_counts = item.second;
-        LM_GGML_ASSERT(!token_counts.empty());
-        const int32_t ntokens = token_counts.size();
-        LM_GGML_ASSERT(ntokens > 0);
-
-        file_out.write(reinterpret_cast<const char *>(&ngram),   sizeof(common_ngram));
-        file_out.write(reinterpret_cast<const char *>(&ntokens), sizeof(int32_t));
-        for (std::pair<llama_token, int32_t> item2 : token_counts) {
-            const llama_token token = item2.first;
-            const int32_t     count = item2.second;
-            LM_GGML_ASSERT(count > 0);
-
-            file_out.write(reinterpret_cast<const char *>(&token), sizeof(llama_token));
-            file_out.write(reinterpret_cast<const char *>(&count), sizeof(int32_t));
-        }
-    }
+void common_ngram_cache_save(const common_ngram_cache & ngram_cache, const std::string & filename) {
+    ngram_cache.save(filename);
 }
 
 common_ngram_cache common_ngram_cache_load(const std::string & filename) {
-    std::ifstream hashmap_file(filename, std::ios::binary);
-    if (!hashmap_file) {
-        throw std::ifstream::failure("Unable to open file " + filename);
-    }
     common_ngram_cache ngram_cache;
-
-    common_ngram ngram;
-    int32_t     ntokens;
-    llama_token token;
-    int32_t     count;
-
-    char * ngramc   = reinterpret_cast<char*>(&ngram);
-    char * ntokensc = reinterpret_cast<char*>(&ntokens);
-    char * tokenc   = reinterpret_cast<char*>(&token);
-    char * countc   = reinterpret_cast<char*>(&count);
-    while(hashmap_file.read(ngramc, sizeof(common_ngram))) {
-        LM_GGML_ASSERT(!hashmap_file.eof());
-        LM_GGML_ASSERT(hashmap_file.read(ntokensc, sizeof(int32_t)));
-        LM_GGML_ASSERT(ntokens > 0);
-        common_ngram_cache_part token_counts;
-
-        for (int i = 0; i < ntokens; ++i) {
-            LM_GGML_ASSERT(!hashmap_file.eof());
-            LM_GGML_ASSERT(hashmap_file.read(tokenc, sizeof(llama_token)));
-            LM_GGML_ASSERT(!hashmap_file.eof());
-            LM_GGML_ASSERT(hashmap_file.read(countc, sizeof(int32_t)));
-            LM_GGML_ASSERT(count > 0);
-            token_counts.emplace(token, count);
-        }
-
-        ngram_cache.emplace(ngram, token_counts);
-    }
-    LM_GGML_ASSERT(hashmap_file.eof());
-
+    ngram_cache.load(filename);
     return ngram_cache;
 }
 
-void common_ngram_cache_merge(common_ngram_cache & ngram_cache_target, common_ngram_cache & ngram_cache_add) {
-    for (std::pair<common_ngram, common_ngram_cache_part> ngram_part : ngram_cache_add) {
-        const common_ngram      ngram = ngram_part.first;
-        common_ngram_cache_part  part = ngram_part.second;
-
-        common_ngram_cache::iterator part_merged_it = ngram_cache_target.find(ngram);
-        if (part_merged_it == ngram_cache_target.end()) {
-            ngram_cache_target.emplace(ngram, part);
-            continue;
-        }
-
-        for (std::pair<llama_token, int32_t> token_count : part) {
-            const llama_token token = token_count.first;
-            const int32_t     count = token_count.second;
-            LM_GGML_ASSERT(count > 0);
-
-            common_ngram_cache_part::iterator token_count_merged_it = part_merged_it->second.find(token);
-            if (token_count_merged_it == part_merged_it->second.end()) {
-                part_merged_it->second.emplace(token, count);
-                continue;
-            }
-
-            token_count_merged_it->second += count;
-        }
-    }
+void common_ngram_cache_merge(common_ngram_cache & ngram_cache_target, const common_ngram_cache & ngram_cache_add) {
+    ngram_cache_target.merge(ngram_cache_add);
 }
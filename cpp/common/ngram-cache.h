@@ -2,13 +2,17 @@
 
 #include "llama.h"
 
-#include <unordered_map>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 #define LLAMA_NGRAM_MIN    1
 #define LLAMA_NGRAM_MAX    4
 #define LLAMA_NGRAM_STATIC 2
+#define LLAMA_NGRAM_NEXT   4 // candidate continuations tracked per n-gram
+
+struct llama_mmap;
 
 // Data structures to map n-grams to empirical token probabilities:
 
@@ -37,28 +41,84 @@ struct common_ngram {
     }
 };
 
-struct common_token_hash_function {
-    size_t operator()(const llama_token token) const {
-        // see https://probablydance.com/2018/06/16/fibonacci-hashing-the-optimization-that-the-world-forgot-or-a-better-alternative-to-integer-modulo/
-        return token * 11400714819323198485llu;
+// Order-aware hash: each token is mixed into the running state, so permutations of an n-gram hash differently.
+// Fixed-width so that saved caches are portable between 32 and 64 bit builds.
+inline uint64_t common_ngram_hash(const common_ngram & ngram) {
+    uint64_t hash = 0;
+    for (int i = 0; i < LLAMA_NGRAM_MAX; ++i) {
+        hash = (hash ^ (uint32_t) ngram.tokens[i]) * 11400714819323198485llu;
+        hash ^= hash >> 29;
     }
-};
+    return hash;
+}
 
 struct common_ngram_hash_function {
     size_t operator()(const common_ngram & ngram) const {
-        size_t hash = common_token_hash_function{}(ngram.tokens[0]);
-        for (int i = 1; i < LLAMA_NGRAM_MAX; ++i) {
-            hash ^= common_token_hash_function{}(ngram.tokens[i]);
+        return (size_t) common_ngram_hash(ngram);
+    }
+};
+
+// One bucket of the flat n-gram table: the n-gram and its most frequent continuations.
+// Continuations beyond LLAMA_NGRAM_NEXT replace the weakest candidate (space-saving counting),
+// while sum keeps the exact number of observations. A bucket with sum == 0 is empty.
+struct common_ngram_cache_entry {
+    common_ngram ngram;
+    int32_t      sum;
+    llama_token  next [LLAMA_NGRAM_NEXT];
+    int32_t      count[LLAMA_NGRAM_NEXT];
+
+    // count for a continuation, 0 if it is not tracked
+    int32_t get(llama_token token) const {
+        for (int i = 0; i < LLAMA_NGRAM_NEXT; ++i) {
+            if (count[i] > 0 && next[i] == token) {
+                return count[i];
+            }
         }
-        return hash;
+        return 0;
     }
+
+    void add(llama_token token, int32_t n);
 };
 
-// token -> number of times token has been seen
-typedef std::unordered_map<llama_token, int32_t> common_ngram_cache_part;
+// n-gram -> empirical distribution of following tokens, stored as a flat open-addressing table.
+// The buckets either live in memory or are mapped read-only from a file saved with common_ngram_cache_save;
+// a mapped cache is copied into memory on the first modification.
+struct common_ngram_cache {
+    common_ngram_cache() = default;
+    common_ngram_cache(const common_ngram_cache & other);
+    common_ngram_cache(common_ngram_cache && other) noexcept;
+    common_ngram_cache & operator=(common_ngram_cache other) noexcept;
+
+    const common_ngram_cache_entry * find(const common_ngram & ngram) const;
 
-// n-gram -> empirical distribution of following tokens
-typedef std::unordered_map<common_ngram, common_ngram_cache_part, common_ngram_hash_function> common_ngram_cache;
+    // record n observations of token following ngram
+    void add(const common_ngram & ngram, llama_token token, int32_t n = 1);
+
+    // add all observations of other to this cache
+    void merge(const common_ngram_cache & other);
+
+    size_t size()  const { return n_used; }
+    bool   empty() const { return n_used == 0; }
+    void   clear();
+
+    const common_ngram_cache_entry * begin() const { return buckets; }
+    const common_ngram_cache_entry * end()   const { return buckets + n_buckets; }
+
+    void load(const std::string & filename);
+    void save(const std::string & filename) const;
+
+private:
+    common_ngram_cache_entry & insert(const common_ngram & ngram);
+    void reserve(size_t n_buckets_new);
+    void make_owned();
+
+    std::vector<common_ngram_cache_entry> entries; // in-memory buckets
+    std::shared_ptr<llama_mmap>           mapping; // file-backed buckets (shared between copies)
+
+    const common_ngram_cache_entry * buckets = nullptr;
+    size_t n_buckets = 0; // always 0 or a power of 2
+    size_t n_used    = 0;
+};
 
 
 // Update an ngram cache with tokens.
@@ -70,11 +130,12 @@ typedef std::unordered_map<common_ngram, common_ngram_cache_part, common_ngram_h
 //
 // In order to get correct results inp_data can ONLY BE APPENDED TO.
 // Changes in the middle need a complete rebuild.
+// Only the last nnew tokens are visited; the ngram_max tokens before them are used as context only.
 void common_ngram_cache_update(
-    common_ngram_cache & ngram_cache, int ngram_min, int ngram_max, std::vector<llama_token> & inp_data, int nnew, bool print_progress);
+    common_ngram_cache & ngram_cache, int ngram_min, int ngram_max, const std::vector<llama_token> & inp_data, int nnew, bool print_progress);
 
 // Try to draft tokens from ngram caches.
-// inp:                the tokens generated so far.
+// inp:                the tokens generated so far. Only the last LLAMA_NGRAM_MAX tokens are used.
 // draft:              the token sequence to draft. Expected to initially contain the previously sampled token.
 // n_draft:            maximum number of tokens to add to draft.
 // ngram_min/gram_max: the min/max size of the ngrams in nc_context and nc_dynamic.
@@ -82,15 +143,16 @@ void common_ngram_cache_update(
 // nc_dynamic:         ngram cache based on previous user generations.
 // nc_static:          ngram cache generated from a large text corpus, used for validation.
 void common_ngram_cache_draft(
-    std::vector<llama_token> & inp, std::vector<llama_token> & draft, int n_draft, int ngram_min, int ngram_max,
-    common_ngram_cache & nc_context, common_ngram_cache & nc_dynamic, common_ngram_cache & nc_static);
+    const std::vector<llama_token> & inp, std::vector<llama_token> & draft, int n_draft, int ngram_min, int ngram_max,
+    const common_ngram_cache & nc_context, const common_ngram_cache & nc_dynamic, const common_ngram_cache & nc_static);
 
 // Save an ngram cache to a file.
 // ngram_cache: the ngram cache to save.
 // filename:    the path under which to save the ngram cache.
-void common_ngram_cache_save(common_ngram_cache & ngram_cache, const std::string & filename);
+void common_ngram_cache_save(const common_ngram_cache & ngram_cache, const std::string & filename);
 
 // Load an ngram cache saved with common_ngram_cache_save.
+// The file is memory-mapped where supported; caches in the older stream format are converted on load.
 // filename: the path from which to load the ngram cache.
 // returns:  an ngram cache containing the information saved to filename.
 common_ngram_cache common_ngram_cache_load(const std::string & filename);
@@ -98,4 +160,4 @@ common_ngram_cache common_ngram_cache_load(const std::string & filename);
 // Merge two ngram caches.
 // ngram_cache_target: the ngram cache to which to add the information from ngram_cache_add.
 // ngram_cache_add:    the ngram cache to add to ngram_cache_target.
-void common_ngram_cache_merge(common_ngram_cache & ngram_cache_target, common_ngram_cache & ngram_cache_add);
+void common_ngram_cache_merge(common_ngram_cache & ngram_cache_target, const common_ngram_cache & ngram_cache_add);
@@ -4,6 +4,7 @@
 #include "fit.h"
 #include "log.h"
 #include "reasoning-budget.h"
+#include "speculative.h"
 
 #include "ggml.h"
 
@@ -724,6 +725,32 @@ std::vector<llama_token> common_sampler_sample_and_accept_n(struct common_sample
     return common_sampler_sample_and_accept_n(gsmpl, ctx, idxs, draft, grammar_first);
 }
 
+std::vector<llama_token> common_sampler_sample_and_accept_tree(struct common_sampler * gsmpl, struct llama_context * ctx, const std::vector<int> & idxs, const struct common_speculative_tree & tree, std::vector<int32_t> & path, bool grammar_first) {
+    LM_GGML_ASSERT(idxs.size() == tree.size() + 1 && "idxs.size() must be tree.size() + 1");
+
+    std::vector<llama_token> result;
+
+    path.clear();
+
+    int32_t node = -1;
+    while (true) {
+        const llama_token id = common_sampler_sample(gsmpl, ctx, idxs[node + 1], grammar_first);
+
+        common_sampler_accept(gsmpl, id, true);
+
+        result.push_back(id);
+
+        node = tree.child(node, id);
+        if (node < 0) {
+            break;
+        }
+
+        path.push_back(node);
+    }
+
+    return result;
+}
+
 uint32_t common_sampler_get_seed(const struct common_sampler * gsmpl) {
     return llama_sampler_get_seed(gsmpl->chain);
 }
@@ -33,6 +33,7 @@
 //
 
 struct common_sampler;
+struct common_speculative_tree;
 
 // llama_sampler API overloads
 
@@ -88,6 +89,17 @@ std::vector<llama_token> common_sampler_sample_and_accept_n(struct common_sample
 // assume idxs == [ 0, 1, 2, ..., draft.size() ]
 std::vector<llama_token> common_sampler_sample_and_accept_n(struct common_sampler * gsmpl, struct llama_context * ctx, const llama_tokens & draft, bool grammar_first = false);
 
+// tree version of common_sampler_sample_and_accept_n
+//
+// walks the tree from the last accepted token: samples at the current node and descends into the child
+// drafting the sampled token, until no child matches
+//
+// requires: idxs.size() == tree.size() + 1, with idxs[0] the row of the last accepted token and idxs[1 + i] the row of node i
+//
+// returns the accepted tokens, path receives the nodes of the accepted tokens (all but the last token)
+//
+std::vector<llama_token> common_sampler_sample_and_accept_tree(struct common_sampler * gsmpl, struct llama_context * ctx, const std::vector<int> & idxs, const struct common_speculative_tree & tree, std::vector<int32_t> & path, bool grammar_first = false);
+
 uint32_t common_sampler_get_seed(const struct common_sampler * gsmpl);
 
 // force the reasoning budget sampler (if any) to begin forcing its end sequence now.
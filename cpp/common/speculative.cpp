@@ -13,9 +13,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstring>
 #include <iomanip>
 #include <map>
+#include <queue>
 #include <cinttypes>
 
 #define SPC_DBG(fmt, ...) LOG_DBG("spec %12.*s: " fmt, 12, __func__, __VA_ARGS__)
@@ -1994,12 +1996,15 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
     bool save_dynamic;
     bool save_static;
 
+    // read-only corpus statistics (memory-mapped) and n-grams of finished generations, shared by all sequences
+    common_ngram_cache ngram_cache_static;
+    common_ngram_cache ngram_cache_dynamic;
+
     struct seq_info {
-        size_t cache_size = 0; // number of tokens in n-gram cache
+        llama_tokens tokens;   // tokens counted in ngram_cache_context
+        size_t       n_merged = 0; // leading tokens whose n-grams are already in the dynamic cache
 
         common_ngram_cache ngram_cache_context;
-        common_ngram_cache ngram_cache_dynamic;
-        common_ngram_cache ngram_cache_static;
     };
 
     std::vector<seq_info> sinfos;
@@ -2028,11 +2033,7 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
 
         if (!path_static.empty()) {
             try {
-                auto ngram_cache_static = common_ngram_cache_load(path_static);
-
-                for (auto & sinfo : sinfos) {
-                    sinfo.ngram_cache_static = ngram_cache_static;
-                }
+                ngram_cache_static = common_ngram_cache_load(path_static);
             } catch (...) {
                 SPC_ERR("failed to open static lookup cache: %s", path_static.c_str());
                 LM_GGML_ABORT("Couldn't read static lookup cache");
@@ -2041,11 +2042,7 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
 
         if (!path_dynamic.empty()) {
             try {
-                auto ngram_cache_dynamic = common_ngram_cache_load(path_dynamic);
-
-                for (auto & sinfo : sinfos) {
-                    sinfo.ngram_cache_dynamic = ngram_cache_dynamic;
-                }
+                ngram_cache_dynamic = common_ngram_cache_load(path_dynamic);
             } catch (...) {
                 SPC_ERR("failed to open dynamic lookup cache: %s", path_dynamic.c_str());
                 LM_GGML_ABORT("Couldn't read dynamic lookup cache");
@@ -2053,8 +2050,45 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
         }
     }
 
-    void begin(llama_seq_id /*seq_id*/, const llama_tokens & /*prompt*/) override {
-        // noop
+    // the history diverged after its first n_keep tokens: n-gram counts cannot be taken back out of the
+    // context cache, so it is dropped as a whole and draft_one() recounts the entire prompt
+    static void rewind(seq_info & sinfo, size_t n_keep) {
+        if (n_keep >= sinfo.tokens.size()) {
+            return;
+        }
+        sinfo.ngram_cache_context.clear();
+        sinfo.tokens.clear();
+        sinfo.n_merged = std::min(sinfo.n_merged, n_keep);
+    }
+
+    void begin(llama_seq_id seq_id, const llama_tokens & prompt) override {
+        auto & sinfo = sinfos[seq_id];
+
+        // a new generation starts: fold the tokens added since the last merge into the dynamic cache,
+        // so that a conversation that keeps growing is counted only once
+        if (sinfo.tokens.size() > sinfo.n_merged) {
+            const size_t i_first = sinfo.n_merged > LLAMA_NGRAM_MAX ? sinfo.n_merged - LLAMA_NGRAM_MAX : 0;
+            const llama_tokens tokens_new(sinfo.tokens.begin() + i_first, sinfo.tokens.end());
+
+            common_ngram_cache ngram_cache_new;
+            common_ngram_cache_update(
+                    ngram_cache_new,
+                    LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX,
+                    tokens_new, sinfo.tokens.size() - sinfo.n_merged, false);
+            common_ngram_cache_merge(ngram_cache_dynamic, ngram_cache_new);
+            sinfo.n_merged = sinfo.tokens.size();
+
+            if (save_dynamic && !params.lookup_cache_dynamic.empty()) {
+                common_ngram_cache_save(ngram_cache_dynamic, params.lookup_cache_dynamic);
+            }
+        }
+
+        // the context cache carries over as long as the new prompt continues the counted history
+        size_t n_common = 0;
+        while (n_common < sinfo.tokens.size() && n_common < prompt.size() && sinfo.tokens[n_common] == prompt[n_common]) {
+            n_common++;
+        }
+        rewind(sinfo, n_common);
     }
 
     void draft_one(
@@ -2064,28 +2098,38 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
         auto & result = *dparams.result;
 
         const auto & prompt = *dparams.prompt;
+        const size_t n_tokens = prompt.size() + 1; // prompt + id_last
 
-        if (sinfo.cache_size < prompt.size() + 1) {
-            llama_tokens tokens_new;
-            tokens_new.reserve(prompt.size() + 1 - sinfo.cache_size);
-            for (size_t j = sinfo.cache_size; j < prompt.size(); ++j) {
-                tokens_new.push_back(prompt[j]);
+        if (sinfo.tokens.size() > n_tokens) {
+            // the history was rewound without begin(), rebuild
+            size_t n_common = 0;
+            while (n_common < prompt.size() && sinfo.tokens[n_common] == prompt[n_common]) {
+                n_common++;
             }
-            tokens_new.push_back(dparams.id_last); // add the last token
+            rewind(sinfo, n_common);
+        }
+
+        const size_t n_cached = sinfo.tokens.size();
+        if (n_cached < n_tokens) {
+            // only the new tokens are counted, the ones before them just complete the n-grams
+            const size_t i_first = n_cached > LLAMA_NGRAM_MAX ? n_cached - LLAMA_NGRAM_MAX : 0;
+
+            llama_tokens tokens_new(prompt.begin() + i_first, prompt.end());
+            tokens_new.push_back(dparams.id_last);
 
-            // Update context ngram cache with new dparams.prompt:
             common_ngram_cache_update(
                     sinfo.ngram_cache_context,
                     LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX,
-                    tokens_new, tokens_new.size(), false);
-            sinfo.cache_size = prompt.size() + 1;
-        }
+                    tokens_new, n_tokens - n_cached, false);
 
-        llama_tokens inp;
-        inp.reserve(prompt.size() + 1);
-        for (size_t j = 0; j < prompt.size(); ++j) {
-            inp.push_back(prompt[j]);
+            sinfo.tokens.insert(sinfo.tokens.end(), prompt.begin() + n_cached, prompt.end());
+            sinfo.tokens.push_back(dparams.id_last);
         }
+
+        // drafting only looks at the trailing n-grams
+        const size_t n_tail = std::min<size_t>(prompt.size(), LLAMA_NGRAM_MAX - 1);
+
+        llama_tokens inp(prompt.end() - n_tail, prompt.end());
         inp.push_back(dparams.id_last);
 
         result.push_back(dparams.id_last);
@@ -2093,8 +2137,8 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
         common_ngram_cache_draft(
                 inp, result, n_draft, LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX,
                 sinfo.ngram_cache_context,
-                sinfo.ngram_cache_dynamic,
-                sinfo.ngram_cache_static);
+                ngram_cache_dynamic,
+                ngram_cache_static);
 
         if (result.size() > 0) {
             // delete first token in result (which is the id_last token)
@@ -2129,6 +2173,99 @@ struct common_speculative_impl_ngram_cache : public common_speculative_impl {
     }
 };
 
+// rolling acceptance of the drafts of one sequence
+struct common_speculative_adaptive_seq {
+    double  n_acc   = 1.0; // accepted draft tokens (prior: p_accept = 0.5)
+    double  n_check = 2.0; // draft tokens that were checked by the target
+
+    int32_t n_draft  = -1; // length of the last draft
+    int32_t n_paused = 0;  // steps skipped since drafting was paused
+};
+
+// rolling cost model: a draft token costs t_draft, and a target decode of n tokens costs t_verify + n*t_verify_token
+// the decode cost is fitted by exponentially weighted least squares on the observed (n, t) pairs
+struct common_speculative_adaptive {
+    common_params_speculative_adaptive params;
+
+    int32_t n_max = 0; // configured draft limit
+
+    std::vector<common_speculative_adaptive_seq> seqs;
+
+    double draft_t = 0.0; // weighted draft time, ms
+    double draft_n = 0.0; // weighted drafted tokens
+
+    double dec_w  = 0.0; // weighted sums of 1, n, t, n*n, n*t over the decodes
+    double dec_n  = 0.0;
+    double dec_t  = 0.0;
+    double dec_nn = 0.0;
+    double dec_nt = 0.0;
+
+    double t_draft_token() const {
+        return draft_n > 0.0 ? draft_t / draft_n : 0.0;
+    }
+
+    void t_verify(double & t_step, double & t_token) const {
+        t_step  = 0.0;
+        t_token = 0.0;
+
+        if (dec_w <= 0.0) {
+            return;
+        }
+
+        const double mean_n = dec_n / dec_w;
+        const double mean_t = dec_t / dec_w;
+        const double var_n  = dec_nn / dec_w - mean_n*mean_n;
+        const double cov_nt = dec_nt / dec_w - mean_n*mean_t;
+
+        // with batches of (nearly) one size the slope is unknown, the whole cost is then treated as fixed
+        t_token = var_n > 0.25 ? std::max(0.0, cov_nt / var_n) : 0.0;
+        t_step  = std::max(0.0, mean_t - t_token*mean_n);
+    }
+
+    double p_accept(llama_seq_id seq_id) const {
+        const auto & seq = seqs[seq_id];
+        return std::min(0.99, seq.n_acc / seq.n_check);
+    }
+
+    // the expected target tokens per second with a draft of n tokens
+    double tokens_per_second(llama_seq_id seq_id, int32_t n) const {
+        double t_step;
+        double t_token;
+        t_verify(t_step, t_token);
+
+        const double t_ms = t_step + (n + 1)*t_token + n*t_draft_token();
+        if (t_ms <= 0.0) {
+            return 0.0;
+        }
+
+        // each draft token is only reached if all the previous ones were accepted
+        const double p = p_accept(seq_id);
+        const double n_tokens = (1.0 - std::pow(p, n + 1)) / (1.0 - p);
+
+        return 1e3 * n_tokens / t_ms;
+    }
+
+    // the draft length that maximizes the expected tokens per second, 0 if drafting does not pay off
+    int32_t choose(llama_seq_id seq_id, int32_t n_limit) const {
+        if (dec_w <= 0.0) {
+            // nothing measured yet
+            return n_limit;
+        }
+
+        int32_t n_best   = 0;
+        double  tps_best = tokens_per_second(seq_id, 0);
+        for (int32_t n = 1; n <= n_limit; ++n) {
+            const double tps = tokens_per_second(seq_id, n);
+            if (tps > tps_best) {
+                n_best   = n;
+                tps_best = tps;
+            }
+        }
+
+        return n_best;
+    }
+};
+
 struct common_speculative {
     common_speculative_draft_params_vec dparams;
 
@@ -2137,6 +2274,9 @@ struct common_speculative {
 
     // which implementaion was used for a given seq_id
     std::vector<common_speculative_impl *> impl_last;
+
+    // draft length controller, null unless enabled
+    std::unique_ptr<common_speculative_adaptive> adaptive;
 };
 
 static common_ngram_map get_common_ngram_map(
@@ -2511,9 +2651,17 @@ common_speculative * common_speculative_init(common_params_speculative & params,
     auto * result = new common_speculative {
         /* .dparams   = */ common_speculative_draft_params_vec(n_seq),
         /* .impls     = */ std::move(impls),
-        /* .impl_last = */ std::vector<common_speculative_impl *>(n_seq, nullptr)
+        /* .impl_last = */ std::vector<common_speculative_impl *>(n_seq, nullptr),
+        /* .adaptive  = */ nullptr,
     };
 
+    if (params.adaptive.enabled) {
+        result->adaptive = std::make_unique<common_speculative_adaptive>();
+        result->adaptive->params = params.adaptive;
+        result->adaptive->n_max  = common_speculative_n_max(&params);
+        result->adaptive->seqs.resize(n_seq);
+    }
+
     return result;
 }
 
@@ -2611,6 +2759,44 @@ void common_speculative_draft(common_speculative * spec) {
         }
     }
 
+    // sequences whose draft length was chosen by the controller in this call
+    std::vector<llama_seq_id> seqs_adaptive;
+
+    auto * adaptive = spec->adaptive.get();
+    if (adaptive) {
+        for (llama_seq_id seq_id = 0; seq_id < (llama_seq_id) dparams.size(); ++seq_id) {
+            auto & dp = dparams[seq_id];
+            if (!dp.drafting) {
+                continue;
+            }
+
+            auto & seq = adaptive->seqs[seq_id];
+
+            const int32_t n_limit = dp.n_max > 0 ? std::min(dp.n_max, adaptive->n_max) : adaptive->n_max;
+
+            int32_t n_draft = adaptive->choose(seq_id, n_limit);
+            if (n_draft == 0) {
+                // a paused sequence drafts a single token now and then, to notice when acceptance recovers
+                if (++seq.n_paused < adaptive->params.n_probe) {
+                    dp.drafting  = false;
+                    seq.n_draft = 0;
+                    continue;
+                }
+                n_draft = std::min(1, n_limit);
+            }
+
+            seq.n_paused = 0;
+            dp.n_max = n_draft;
+            seqs_adaptive.push_back(seq_id);
+        }
+
+        if (seqs_adaptive.empty()) {
+            return;
+        }
+    }
+
+    const int64_t t_start_us = lm_ggml_time_us();
+
     for (auto & impl : spec->impls) {
         {
             common_time_meas tm(impl->t_draft_us, !impl->gen_perf);
@@ -2667,9 +2853,35 @@ void common_speculative_draft(common_speculative * spec) {
             dp.drafting = false;
         }
     }
+
+    if (adaptive) {
+        const float decay = adaptive->params.decay;
+
+        int32_t n_drafted = 0;
+        for (const llama_seq_id seq_id : seqs_adaptive) {
+            const int32_t n = dparams[seq_id].result->size();
+            adaptive->seqs[seq_id].n_draft = n;
+            n_drafted += n;
+        }
+
+        if (n_drafted > 0) {
+            adaptive->draft_t = decay*adaptive->draft_t + (lm_ggml_time_us() - t_start_us) / 1e3;
+            adaptive->draft_n = decay*adaptive->draft_n + n_drafted;
+        }
+    }
 }
 
 void common_speculative_accept(common_speculative * spec, llama_seq_id seq_id, uint16_t n_accepted) {
+    if (spec->adaptive) {
+        auto & seq = spec->adaptive->seqs[seq_id];
+        if (seq.n_draft > 0) {
+            // the draft tokens up to the first rejected one were checked
+            const float decay = spec->adaptive->params.decay;
+            seq.n_acc   = decay*seq.n_acc   + n_accepted;
+            seq.n_check = decay*seq.n_check + std::min<int32_t>(n_accepted + 1, seq.n_draft);
+        }
+    }
+
     common_speculative_impl * impl = spec->impl_last[seq_id];
 
     LM_GGML_ASSERT(impl);
@@ -2702,6 +2914,39 @@ void common_speculative_accept(common_speculative * spec, llama_seq_id seq_id, u
     }
 }
 
+void common_speculative_observe_decode(common_speculative * spec, double t_ms, int32_t n_tokens) {
+    if (spec == nullptr || !spec->adaptive || t_ms <= 0.0 || n_tokens <= 0) {
+        return;
+    }
+
+    auto & ad = *spec->adaptive;
+    const double decay = ad.params.decay;
+
+    ad.dec_w  = decay*ad.dec_w  + 1.0;
+    ad.dec_n  = decay*ad.dec_n  + n_tokens;
+    ad.dec_t  = decay*ad.dec_t  + t_ms;
+    ad.dec_nn = decay*ad.dec_nn + (double) n_tokens*n_tokens;
+    ad.dec_nt = decay*ad.dec_nt + (double) n_tokens*t_ms;
+}
+
+common_speculative_adaptive_stats common_speculative_get_adaptive_stats(const common_speculative * spec, llama_seq_id seq_id) {
+    common_speculative_adaptive_stats stats;
+
+    if (spec == nullptr || !spec->adaptive || seq_id < 0 || seq_id >= (llama_seq_id) spec->adaptive->seqs.size()) {
+        return stats;
+    }
+
+    const auto & ad = *spec->adaptive;
+
+    stats.n_draft              = std::max(0, ad.seqs[seq_id].n_draft);
+    stats.p_accept             = ad.p_accept(seq_id);
+    stats.t_draft_per_token_ms = ad.t_draft_token();
+    ad.t_verify(stats.t_verify_ms, stats.t_verify_per_token_ms);
+    stats.expected_per_second  = ad.tokens_per_second(seq_id, stats.n_draft);
+
+    return stats;
+}
+
 // TODO: support the case of more than one speculative implementations having a state
 bool common_speculative_get_state(common_speculative * spec, llama_seq_id seq_id, std::vector<uint8_t> & data) {
     if (spec == nullptr) {
@@ -2772,3 +3017,244 @@ void common_speculative_print_stats(const common_speculative * spec) {
                 str_perf.c_str());
     }
 }
+
+//
+// token trees
+//
+
+void common_speculative_tree::clear() {
+    tokens.clear();
+    parent.clear();
+    depth.clear();
+}
+
+void common_speculative_tree::resize(size_t n) {
+    n = std::min(n, size());
+
+    tokens.resize(n);
+    parent.resize(n);
+    depth.resize(n);
+}
+
+int32_t common_speculative_tree::child(int32_t node, llama_token token) const {
+    for (size_t i = node + 1; i < size(); ++i) {
+        if (parent[i] == node && tokens[i] == token) {
+            return (int32_t) i;
+        }
+    }
+
+    return -1;
+}
+
+int32_t common_speculative_tree::add(int32_t node, llama_token token) {
+    const int32_t existing = child(node, token);
+    if (existing >= 0) {
+        return existing;
+    }
+
+    tokens.push_back(token);
+    parent.push_back(node);
+    depth.push_back(node < 0 ? 1 : depth[node] + 1);
+
+    return (int32_t) size() - 1;
+}
+
+int32_t common_speculative_tree::n_leaves() const {
+    std::vector<bool> has_child(size(), false);
+    for (const int32_t p : parent) {
+        if (p >= 0) {
+            has_child[p] = true;
+        }
+    }
+
+    int32_t n = 0;
+    for (size_t i = 0; i < size(); ++i) {
+        n += !has_child[i];
+    }
+
+    return std::max(1, n);
+}
+
+std::vector<std::vector<int32_t>> common_speculative_tree::branches() const {
+    std::vector<bool> has_child(size(), false);
+    for (const int32_t p : parent) {
+        if (p >= 0) {
+            has_child[p] = true;
+        }
+    }
+
+    std::vector<std::vector<int32_t>> res(size());
+
+    int32_t n = 0;
+    for (size_t i = 0; i < size(); ++i) {
+        if (has_child[i]) {
+            continue;
+        }
+        for (int32_t node = (int32_t) i; node >= 0; node = parent[node]) {
+            res[node].push_back(n);
+        }
+        n++;
+    }
+
+    return res;
+}
+
+void common_speculative_tree_draft_ngram(
+        common_speculative_tree & tree, const llama_tokens & inp, const llama_tokens & draft,
+        const common_ngram_cache & cache, int32_t n_nodes, int32_t n_branch, int32_t n_depth) {
+    // continuations below this probability are rarely accepted and only cost batch rows
+    const float p_min = 0.1f;
+
+    struct candidate {
+        float       p;
+        int32_t     node;
+        llama_token token;
+
+        bool operator<(const candidate & other) const {
+            return p < other.p;
+        }
+    };
+
+    std::priority_queue<candidate> queue;
+
+    // queue the continuations of node seen after any n-gram that ends at it,
+    // a token seen after several of them takes the estimate of the longest
+    auto expand = [&](int32_t node, float p_node) {
+        if ((node < 0 ? 0 : tree.depth[node]) >= n_depth) {
+            return;
+        }
+
+        llama_tokens ctx_tokens;
+        for (int32_t cur = node; cur >= 0 && (int) ctx_tokens.size() < LLAMA_NGRAM_MAX; cur = tree.parent[cur]) {
+            ctx_tokens.push_back(tree.tokens[cur]);
+        }
+        for (size_t i = inp.size(); i > 0 && (int) ctx_tokens.size() < LLAMA_NGRAM_MAX; --i) {
+            ctx_tokens.push_back(inp[i - 1]);
+        }
+        std::reverse(ctx_tokens.begin(), ctx_tokens.end());
+
+        llama_tokens seen;
+        for (int ngram_size = std::min<int>(LLAMA_NGRAM_MAX, ctx_tokens.size()); ngram_size >= LLAMA_NGRAM_MIN; --ngram_size) {
+            const common_ngram ngram(ctx_tokens.data() + ctx_tokens.size() - ngram_size, ngram_size);
+            const common_ngram_cache_entry * entry = cache.find(ngram);
+            if (entry == nullptr) {
+                continue;
+            }
+
+            for (int j = 0; j < LLAMA_NGRAM_NEXT; ++j) {
+                if (entry->count[j] <= 0 || std::find(seen.begin(), seen.end(), entry->next[j]) != seen.end()) {
+                    continue;
+                }
+                seen.push_back(entry->next[j]);
+
+                const float p = p_node * (float) entry->count[j] / (float) entry->sum;
+                if (p >= p_min) {
+                    queue.push({ p, node, entry->next[j] });
+                }
+            }
+        }
+    };
+
+    auto has_children = [&](int32_t node) {
+        return node < 0 ? !tree.empty() : std::find(tree.parent.begin(), tree.parent.end(), node) != tree.parent.end();
+    };
+
+    tree.clear();
+
+    // the linear draft is the first branch
+    int32_t node = -1;
+    for (size_t i = 0; i < draft.size() && (int32_t) tree.size() < std::min(n_nodes, n_depth); ++i) {
+        node = tree.add(node, draft[i]);
+    }
+
+    int32_t n_leaf = 1;
+
+    expand(-1, 1.0f);
+    for (size_t i = 0; i < tree.size(); ++i) {
+        expand((int32_t) i, 1.0f);
+    }
+
+    // best-first: a node is added only after its parent, so parents precede their children
+    while (!queue.empty() && (int32_t) tree.size() < n_nodes) {
+        const candidate cur = queue.top();
+        queue.pop();
+
+        if (tree.child(cur.node, cur.token) >= 0) {
+            continue;
+        }
+
+        const bool new_branch = has_children(cur.node);
+        if (new_branch && n_leaf >= n_branch) {
+            continue;
+        }
+
+        const int32_t added = tree.add(cur.node, cur.token);
+        n_leaf += new_branch;
+
+        expand(added, cur.p);
+    }
+}
+
+void common_speculative_tree_prepare(llama_context * ctx, const std::vector<llama_seq_id> & seq_ids) {
+    auto * mem = llama_get_memory(ctx);
+
+    for (size_t i = 1; i < seq_ids.size(); ++i) {
+        llama_memory_seq_rm(mem, seq_ids[i], -1, -1);
+        llama_memory_seq_cp(mem, seq_ids[0], seq_ids[i], -1, -1);
+    }
+}
+
+void common_speculative_tree_add(
+        llama_batch & batch, int32_t i_last, const common_speculative_tree & tree,
+        const std::vector<llama_seq_id> & seq_ids, std::vector<int> & idxs) {
+    const int32_t n_leaf = tree.n_leaves();
+    LM_GGML_ASSERT((int32_t) seq_ids.size() >= n_leaf && "not enough sequence ids for the tree branches");
+
+    // the last accepted token is an ancestor of every branch
+    batch.n_seq_id[i_last] = n_leaf;
+    for (int32_t b = 0; b < n_leaf; ++b) {
+        batch.seq_id[i_last][b] = seq_ids[b];
+    }
+
+    idxs.clear();
+    idxs.push_back(i_last);
+
+    const llama_pos pos = batch.pos[i_last];
+    const auto branches = tree.branches();
+
+    std::vector<llama_seq_id> node_seq_ids;
+    for (size_t i = 0; i < tree.size(); ++i) {
+        // the first sequence of a token decides what it attends to: the history of its own branch
+        node_seq_ids.clear();
+        for (const int32_t b : branches[i]) {
+            node_seq_ids.push_back(seq_ids[b]);
+        }
+
+        common_batch_add(batch, tree.tokens[i], pos + tree.depth[i], node_seq_ids, true);
+        idxs.push_back(batch.n_tokens - 1);
+    }
+}
+
+void common_speculative_tree_commit(
+        llama_context * ctx, const common_speculative_tree & tree, const std::vector<int32_t> & path,
+        llama_pos pos, const std::vector<llama_seq_id> & seq_ids) {
+    auto * mem = llama_get_memory(ctx);
+
+    const llama_seq_id seq_tgt = seq_ids[0];
+    const llama_pos    pos_end = pos + (llama_pos) path.size();
+
+    if (!path.empty()) {
+        // any branch through the last accepted node holds the whole accepted path
+        const int32_t b = tree.branches()[path.back()][0];
+        if (b != 0) {
+            llama_memory_seq_rm(mem, seq_tgt, pos, -1);
+            llama_memory_seq_cp(mem, seq_ids[b], seq_tgt, pos, pos_end);
+        }
+    }
+
+    llama_memory_seq_rm(mem, seq_tgt, pos_end, -1);
+
+    for (size_t i = 1; i < seq_ids.size(); ++i) {
+        llama_memory_seq_rm(mem, seq_ids[i], -1, -1);
+    }
+}
@@ -4,6 +4,7 @@
 #include "common.h"
 
 struct common_speculative;
+struct common_ngram_cache;
 
 // comma separated list the provided types
 std::string common_speculative_type_name_str(const std::vector<enum common_speculative_type> & types);
@@ -79,6 +80,88 @@ void common_speculative_draft(common_speculative * spec);
 // informs the speculative context that n_accepted tokens were accepted by the target model
 void common_speculative_accept(common_speculative * spec, llama_seq_id, uint16_t n_accepted);
 
+//
+// token trees
+//
+// A tree drafts several alternative continuations of the last accepted token at once. All branches are
+// verified by a single target decode: every branch is decoded under its own sequence id, so the
+// attention mask lets each node see only its ancestors, and the KV of the accepted path is kept.
+// This requires a unified KV cache (all sequences share one cell buffer) and spare sequence ids.
+//
+
+struct common_speculative_tree {
+    llama_tokens         tokens; // token of each node
+    std::vector<int32_t> parent; // parent node, -1 for the children of the last accepted token
+    std::vector<int32_t> depth;  // distance from the last accepted token, starting at 1
+
+    // nodes are stored in insertion order, so a parent always precedes its children
+
+    size_t size()  const { return tokens.size(); }
+    bool   empty() const { return tokens.empty(); }
+    void   clear();
+
+    // keep the first n nodes
+    void resize(size_t n);
+
+    // child of node (-1 for the last accepted token) with the given token, -1 if there is none
+    int32_t child(int32_t node, llama_token token) const;
+
+    // add a child to node, reusing an existing child with the same token
+    int32_t add(int32_t node, llama_token token);
+
+    // number of root-to-leaf paths (1 for an empty tree)
+    int32_t n_leaves() const;
+
+    // the branches passing through each node in increasing order, with branches numbered by their leaf in node order
+    std::vector<std::vector<int32_t>> branches() const;
+};
+
+// grow a tree from an n-gram cache, expanding the most probable continuations first
+// inp:      the tokens so far, ending with the last accepted token
+// draft:    an optional linear draft that is added as the first branch
+// n_nodes:  maximum number of nodes
+// n_branch: maximum number of leaves
+// n_depth:  maximum depth
+void common_speculative_tree_draft_ngram(
+        common_speculative_tree & tree, const llama_tokens & inp, const llama_tokens & draft,
+        const common_ngram_cache & cache, int32_t n_nodes, int32_t n_branch, int32_t n_depth);
+
+// give each branch sequence seq_ids[i] (i > 0) the history of seq_ids[0], the target sequence
+// must be called before the tree is decoded
+void common_speculative_tree_prepare(llama_context * ctx, const std::vector<llama_seq_id> & seq_ids);
+
+// add the tree behind the last accepted token, which must already be in the batch at row i_last
+// branch i is decoded as seq_ids[i] and the last accepted token is extended to all of them
+// idxs receives the batch rows: idxs[0] = i_last, idxs[1 + i] for node i
+void common_speculative_tree_add(
+        llama_batch & batch, int32_t i_last, const common_speculative_tree & tree,
+        const std::vector<llama_seq_id> & seq_ids, std::vector<int> & idxs);
+
+// keep the KV of the accepted path (as returned by common_sampler_sample_and_accept_tree) in seq_ids[0]
+// and clear the branch sequences
+// pos: the position of the first tree level
+void common_speculative_tree_commit(
+        llama_context * ctx, const common_speculative_tree & tree, const std::vector<int32_t> & path,
+        llama_pos pos, const std::vector<llama_seq_id> & seq_ids);
+
+// report the cost of a target decode that verified drafts
+// t_ms:     wall-clock time measured by the caller from submitting the decode until its outputs were read
+// n_tokens: number of tokens in the decoded batch
+// only used when common_params_speculative_adaptive is enabled
+void common_speculative_observe_decode(common_speculative * spec, double t_ms, int32_t n_tokens);
+
+// live statistics of the adaptive draft length
+struct common_speculative_adaptive_stats {
+    int32_t n_draft               = -1;  // draft length of the last step (0 = drafting paused, -1 = not adaptive)
+    double  p_accept              = 0.0; // rolling probability that a draft token is accepted
+    double  t_draft_per_token_ms  = 0.0; // rolling time to draft one token
+    double  t_verify_ms           = 0.0; // rolling fixed time of a target decode
+    double  t_verify_per_token_ms = 0.0; // rolling time per token of a target decode
+    double  expected_per_second   = 0.0; // expected tokens per second at n_draft
+};
+
+common_speculative_adaptive_stats common_speculative_get_adaptive_stats(const common_speculative * spec, llama_seq_id seq_id);
+
 // (optional) get/set internal state
 bool common_speculative_get_state(common_speculative * spec, llama_seq_id seq_id, std::vector<uint8_t> & data);
 void common_speculative_set_state(common_speculative * spec, llama_seq_id seq_id, const std::vector<uint8_t> & data);
@@ -20,6 +20,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <vector>
 
 #ifdef __APPLE__
@@ -2429,3 +2432,196 @@ lm_ggml_backend_buffer_t lm_ggml_backend_cpu_buffer_from_ptr(void * ptr, size_t
     LM_GGML_ASSERT((uintptr_t)ptr % TENSOR_ALIGNMENT == 0 && "buffer pointer must be aligned");
     return lm_ggml_backend_buffer_init(lm_ggml_backend_cpu_buffer_from_ptr_type(), lm_ggml_backend_cpu_buffer_from_ptr_i, ptr, size);
 }
+
+// Compute arena
+
+struct lm_ggml_backend_arena {
+    struct lm_ggml_backend_buffer_type buft;     // buffer type of the views
+    lm_ggml_backend_buffer_type_t      mem_buft; // buffer type of the backing memory
+    std::string                     name;
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+
+    lm_ggml_backend_buffer_t              mem = nullptr;
+    std::vector<lm_ggml_backend_buffer_t> views;
+
+    bool         leased = false;
+    // owner of the current or last lease, nullptr after the backing memory was reallocated
+    const void * owner  = nullptr;
+};
+
+static size_t lm_ggml_backend_arena_required_size(const lm_ggml_backend_arena * arena) {
+    size_t size = 0;
+    for (lm_ggml_backend_buffer_t view : arena->views) {
+        size = std::max(size, view->size);
+    }
+    return size;
+}
+
+// (re)allocates the backing memory to exactly `size` bytes, must be called with the mutex held
+static bool lm_ggml_backend_arena_resize(lm_ggml_backend_arena * arena, size_t size) {
+    const size_t cur_size = arena->mem ? lm_ggml_backend_buffer_get_size(arena->mem) : 0;
+    if (cur_size == size) {
+        return true;
+    }
+
+    lm_ggml_backend_buffer_free(arena->mem);
+    arena->mem   = nullptr;
+    arena->owner = nullptr;
+
+    if (size == 0) {
+        return true;
+    }
+
+    arena->mem = lm_ggml_backend_buft_alloc_buffer(arena->mem_buft, size);
+    if (arena->mem == nullptr) {
+        LM_GGML_LOG_ERROR("%s: failed to allocate %s buffer of size %zu\n", __func__, arena->name.c_str(), size);
+        return false;
+    }
+    lm_ggml_backend_buffer_set_usage(arena->mem, LM_GGML_BACKEND_BUFFER_USAGE_COMPUTE);
+    return true;
+}
+
+static void lm_ggml_backend_arena_buffer_free_buffer(lm_ggml_backend_buffer_t buffer) {
+    auto * arena = (lm_ggml_backend_arena *) buffer->context;
+
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    arena->views.erase(std::find(arena->views.begin(), arena->views.end(), buffer));
+    if (arena->views.empty() && !arena->leased) {
+        lm_ggml_backend_arena_resize(arena, 0);
+    }
+}
+
+static void * lm_ggml_backend_arena_buffer_get_base(lm_ggml_backend_buffer_t buffer) {
+    auto * arena = (lm_ggml_backend_arena *) buffer->context;
+
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    LM_GGML_ASSERT(arena->leased && "compute arena accessed without a lease");
+
+    // a view registered during the current lease may need more memory than the arena was sized for
+    const size_t cur_size = arena->mem ? lm_ggml_backend_buffer_get_size(arena->mem) : 0;
+    if (cur_size < buffer->size) {
+        const void * owner = arena->owner;
+        if (!lm_ggml_backend_arena_resize(arena, lm_ggml_backend_arena_required_size(arena))) {
+            LM_GGML_ABORT("%s: failed to grow the compute arena", __func__);
+        }
+        // the lease holder allocates its graph in the new memory
+        arena->owner = owner;
+    }
+
+    return lm_ggml_backend_buffer_get_base(arena->mem);
+}
+
+static void lm_ggml_backend_arena_buffer_clear(lm_ggml_backend_buffer_t buffer, uint8_t value) {
+    memset(lm_ggml_backend_arena_buffer_get_base(buffer), value, buffer->size);
+}
+
+static const struct lm_ggml_backend_buffer_i lm_ggml_backend_arena_buffer_i = {
+    /* .free_buffer     = */ lm_ggml_backend_arena_buffer_free_buffer,
+    /* .get_base        = */ lm_ggml_backend_arena_buffer_get_base,
+    /* .init_tensor     = */ NULL, // no initialization required
+    /* .memset_tensor   = */ lm_ggml_backend_cpu_buffer_memset_tensor,
+    /* .set_tensor      = */ lm_ggml_backend_cpu_buffer_set_tensor,
+    /* .get_tensor      = */ lm_ggml_backend_cpu_buffer_get_tensor,
+    /* .set_tensor_2d   = */ NULL,
+    /* .get_tensor_2d   = */ NULL,
+    /* .cpy_tensor      = */ lm_ggml_backend_cpu_buffer_cpy_tensor,
+    /* .clear           = */ lm_ggml_backend_arena_buffer_clear,
+    /* .reset           = */ NULL,
+};
+
+static const char * lm_ggml_backend_arena_buffer_type_get_name(lm_ggml_backend_buffer_type_t buft) {
+    return ((lm_ggml_backend_arena *) buft->context)->name.c_str();
+}
+
+static lm_ggml_backend_buffer_t lm_ggml_backend_arena_buffer_type_alloc_buffer(lm_ggml_backend_buffer_type_t buft, size_t size) {
+    auto * arena = (lm_ggml_backend_arena *) buft->context;
+
+    // views only register their size: the memory is (re)sized when the arena is next leased,
+    // so that reserving a context never moves the memory under the current lease holder
+    lm_ggml_backend_buffer_t buffer = lm_ggml_backend_buffer_init(buft, lm_ggml_backend_arena_buffer_i, arena, size);
+
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    arena->views.push_back(buffer);
+    return buffer;
+}
+
+static size_t lm_ggml_backend_arena_buffer_type_get_alignment(lm_ggml_backend_buffer_type_t buft) {
+    return lm_ggml_backend_buft_get_alignment(((lm_ggml_backend_arena *) buft->context)->mem_buft);
+}
+
+static size_t lm_ggml_backend_arena_buffer_type_get_alloc_size(lm_ggml_backend_buffer_type_t buft, const struct lm_ggml_tensor * tensor) {
+    return lm_ggml_backend_buft_get_alloc_size(((lm_ggml_backend_arena *) buft->context)->mem_buft, tensor);
+}
+
+static bool lm_ggml_backend_arena_buffer_type_is_host(lm_ggml_backend_buffer_type_t buft) {
+    return true;
+
+    LM_GGML_UNUSED(buft);
+}
+
+lm_ggml_backend_arena_t lm_ggml_backend_arena_new(lm_ggml_backend_buffer_type_t buft) {
+    LM_GGML_ASSERT(buft && lm_ggml_backend_buft_is_host(buft) && "compute arena requires a host buffer type");
+
+    auto * arena = new lm_ggml_backend_arena;
+    arena->mem_buft = buft;
+    arena->name     = std::string(lm_ggml_backend_buft_name(buft)) + "_Arena";
+    arena->buft     = {
+        /* .iface   = */ {
+            /* .get_name         = */ lm_ggml_backend_arena_buffer_type_get_name,
+            /* .alloc_buffer     = */ lm_ggml_backend_arena_buffer_type_alloc_buffer,
+            /* .get_alignment    = */ lm_ggml_backend_arena_buffer_type_get_alignment,
+            /* .get_max_size     = */ NULL, // one chunk per allocator: chunks of the same allocator must not alias
+            /* .get_alloc_size   = */ lm_ggml_backend_arena_buffer_type_get_alloc_size,
+            /* .is_host          = */ lm_ggml_backend_arena_buffer_type_is_host,
+        },
+        /* .device  = */ buft->device,
+        /* .context = */ arena,
+    };
+    return arena;
+}
+
+void lm_ggml_backend_arena_free(lm_ggml_backend_arena_t arena) {
+    if (arena == nullptr) {
+        return;
+    }
+    LM_GGML_ASSERT(arena->views.empty() && !arena->leased && "compute arena freed while still in use");
+    lm_ggml_backend_buffer_free(arena->mem);
+    delete arena;
+}
+
+lm_ggml_backend_buffer_type_t lm_ggml_backend_arena_buffer_type(lm_ggml_backend_arena_t arena) {
+    return &arena->buft;
+}
+
+bool lm_ggml_backend_arena_acquire(lm_ggml_backend_arena_t arena, const void * owner) {
+    std::unique_lock<std::mutex> lock(arena->mutex);
+    LM_GGML_ASSERT(!(arena->leased && arena->owner == owner) && "compute arena lease is not recursive");
+    arena->cv.wait(lock, [arena] { return !arena->leased; });
+
+    arena->leased = true;
+    // on failure the memory stays unallocated and the first access aborts
+    lm_ggml_backend_arena_resize(arena, lm_ggml_backend_arena_required_size(arena));
+
+    const bool clobbered = arena->owner != owner;
+    arena->owner = owner;
+    return clobbered;
+}
+
+void lm_ggml_backend_arena_release(lm_ggml_backend_arena_t arena) {
+    {
+        std::lock_guard<std::mutex> lock(arena->mutex);
+        LM_GGML_ASSERT(arena->leased);
+        arena->leased = false;
+        if (arena->views.empty()) {
+            lm_ggml_backend_arena_resize(arena, 0);
+        }
+    }
+    arena->cv.notify_one();
+}
+
+size_t lm_ggml_backend_arena_get_size(lm_ggml_backend_arena_t arena) {
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    return arena->mem ? lm_ggml_backend_buffer_get_size(arena->mem) : 0;
+}
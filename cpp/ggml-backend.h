@@ -223,6 +223,8 @@ extern "C" {
         const char * value;
     };
     typedef struct lm_ggml_backend_feature * (*lm_ggml_backend_get_features_t)(lm_ggml_backend_reg_t reg);
+    // Wrap memory that already holds repacked weights in the CPU backend's repack buffer type
+    typedef lm_ggml_backend_buffer_t (*lm_ggml_backend_cpu_repack_buffer_from_ptr_t)(void * ptr, size_t size);
 
     //
     // Backend registry
@@ -432,6 +434,31 @@ extern "C" {
     LM_GGML_API lm_ggml_backend_buffer_t      lm_ggml_backend_cpu_buffer_from_ptr(void * ptr, size_t size);
     LM_GGML_API lm_ggml_backend_buffer_type_t lm_ggml_backend_cpu_buffer_type(void);
 
+    //
+    // Compute arena
+    //
+
+    // A host buffer shared by the compute buffers of schedulers that never compute at the same time.
+    // Buffers allocated from the arena buffer type do not own memory: they register their size and
+    // view the arena, which is sized to the largest registered buffer when it is leased.
+    // Tensors allocated in these buffers are only valid while the lease is held: acquire the arena
+    // before allocating a graph and release it once the outputs have been read back.
+    typedef struct lm_ggml_backend_arena * lm_ggml_backend_arena_t;
+
+    // buft: host buffer type of the backing memory
+    LM_GGML_API lm_ggml_backend_arena_t          lm_ggml_backend_arena_new(lm_ggml_backend_buffer_type_t buft);
+    // all buffers allocated from the arena must have been freed
+    LM_GGML_API void                          lm_ggml_backend_arena_free(lm_ggml_backend_arena_t arena);
+    LM_GGML_API lm_ggml_backend_buffer_type_t lm_ggml_backend_arena_buffer_type(lm_ggml_backend_arena_t arena);
+
+    // Blocks until the arena is free. Returns true if another owner used the arena or its memory
+    // moved since the last lease of `owner`: graphs allocated by `owner` before must be re-allocated.
+    LM_GGML_API bool                          lm_ggml_backend_arena_acquire(lm_ggml_backend_arena_t arena, const void * owner);
+    LM_GGML_API void                          lm_ggml_backend_arena_release(lm_ggml_backend_arena_t arena);
+
+    // size of the backing memory, 0 while no buffers are registered
+    LM_GGML_API size_t                        lm_ggml_backend_arena_get_size(lm_ggml_backend_arena_t arena);
+
 #ifdef  __cplusplus
 }
 #endif
@@ -32,8 +32,10 @@ struct lm_ggml_backend_deleter        { void operator()(lm_ggml_backend_t backen
 struct lm_ggml_backend_buffer_deleter { void operator()(lm_ggml_backend_buffer_t buffer) { lm_ggml_backend_buffer_free(buffer); } };
 struct lm_ggml_backend_event_deleter  { void operator()(lm_ggml_backend_event_t event)   { lm_ggml_backend_event_free(event); } };
 struct lm_ggml_backend_sched_deleter  { void operator()(lm_ggml_backend_sched_t sched)   { lm_ggml_backend_sched_free(sched); } };
+struct lm_ggml_backend_arena_deleter  { void operator()(lm_ggml_backend_arena_t arena)   { lm_ggml_backend_arena_free(arena); } };
 
 typedef std::unique_ptr<lm_ggml_backend,        lm_ggml_backend_deleter>        lm_ggml_backend_ptr;
 typedef std::unique_ptr<lm_ggml_backend_buffer, lm_ggml_backend_buffer_deleter> lm_ggml_backend_buffer_ptr;
 typedef std::unique_ptr<lm_ggml_backend_event,  lm_ggml_backend_event_deleter>  lm_ggml_backend_event_ptr;
 typedef std::unique_ptr<lm_ggml_backend_sched,  lm_ggml_backend_sched_deleter>  lm_ggml_backend_sched_ptr;
+typedef std::unique_ptr<lm_ggml_backend_arena,  lm_ggml_backend_arena_deleter>  lm_ggml_backend_arena_ptr;
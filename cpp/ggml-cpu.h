@@ -7,6 +7,9 @@
 extern "C" {
 #endif
 
+    // per-op profiler, see lm_ggml_cpu_profiler_new()
+    struct lm_ggml_cpu_profiler;
+
     // the compute plan that needs to be prepared for lm_ggml_graph_compute()
     // since https://github.com/ggml-org/ggml/issues/287
     struct lm_ggml_cplan {
@@ -22,6 +25,9 @@ extern "C" {
 
         // use only reference implementations
         bool use_ref;
+
+        // record per-op timings into this profiler (NULL = disabled)
+        struct lm_ggml_cpu_profiler * profiler;
     };
 
     // numa strategies
@@ -61,6 +67,36 @@ extern "C" {
     LM_GGML_BACKEND_API void                          lm_ggml_threadpool_pause         (struct lm_ggml_threadpool * threadpool);
     LM_GGML_BACKEND_API void                          lm_ggml_threadpool_resume        (struct lm_ggml_threadpool * threadpool);
 
+    //
+    // per-op profiler
+    //
+    // attach to a cplan (or a CPU backend) to record the time spent in each graph node
+    // stats are aggregated across graph computations by op and tensor name
+    //
+
+    struct lm_ggml_cpu_profile_stat {
+        const char * op;                     // lm_ggml_op_desc() of the node
+        char         name[LM_GGML_MAX_NAME];    // tensor name
+        int64_t      n_calls;
+        int64_t      n_bytes;                // bytes of dst and srcs, summed over calls
+        int64_t      t_wall_ns;              // wall time, incl. the barrier that closes the node
+        int64_t      t_busy_ns;              // compute time, summed over threads
+        int64_t      t_wait_ns;              // barrier wait time, summed over threads
+    };
+
+    LM_GGML_BACKEND_API struct lm_ggml_cpu_profiler * lm_ggml_cpu_profiler_new  (void);
+    LM_GGML_BACKEND_API void                       lm_ggml_cpu_profiler_free (struct lm_ggml_cpu_profiler * prof);
+    LM_GGML_BACKEND_API void                       lm_ggml_cpu_profiler_reset(struct lm_ggml_cpu_profiler * prof);
+
+    // copies up to n_max stats into stats and returns the total number of stats (pass NULL, 0 to only count)
+    // the getters lock the profiler, so they are safe to call while a graph is being computed
+    LM_GGML_BACKEND_API int  lm_ggml_cpu_profiler_get_stats(const struct lm_ggml_cpu_profiler * prof, struct lm_ggml_cpu_profile_stat * stats, int n_max);
+
+    // per-thread totals over all recorded nodes, for ith < lm_ggml_cpu_profiler_n_threads()
+    LM_GGML_BACKEND_API int  lm_ggml_cpu_profiler_n_threads (const struct lm_ggml_cpu_profiler * prof);
+    LM_GGML_BACKEND_API void lm_ggml_cpu_profiler_get_thread(const struct lm_ggml_cpu_profiler * prof, int ith, int64_t * t_busy_ns, int64_t * t_wait_ns);
+    LM_GGML_BACKEND_API void lm_ggml_cpu_profiler_get_totals(const struct lm_ggml_cpu_profiler * prof, int64_t * n_graphs, int64_t * t_graph_ns);
+
     // lm_ggml_graph_plan() has to be called before lm_ggml_graph_compute()
     // when plan.work_size > 0, caller must allocate memory for plan.work_data
     LM_GGML_BACKEND_API struct lm_ggml_cplan lm_ggml_graph_plan(
@@ -138,6 +174,10 @@ extern "C" {
 
     LM_GGML_BACKEND_API void lm_ggml_backend_cpu_set_use_ref(lm_ggml_backend_t backend_cpu, bool use_ref);
 
+    // the profiler is not owned by the backend, pass NULL to detach it
+    // blocks until a graph that is computing with the current profiler is done, so the old one can be freed afterwards
+    LM_GGML_BACKEND_API void lm_ggml_backend_cpu_set_profiler(lm_ggml_backend_t backend_cpu, struct lm_ggml_cpu_profiler * profiler);
+
     LM_GGML_BACKEND_API lm_ggml_backend_reg_t lm_ggml_backend_cpu_reg(void);
 
     LM_GGML_BACKEND_API void lm_ggml_cpu_fp32_to_fp32(const float *,       float *, int64_t);
@@ -42,6 +42,8 @@
 #define lm_ggml_gemv_q4_0_4x4_q8_0_generic lm_ggml_gemv_q4_0_4x4_q8_0
 #define lm_ggml_gemv_q4_0_4x8_q8_0_generic lm_ggml_gemv_q4_0_4x8_q8_0
 #define lm_ggml_gemv_q4_0_8x8_q8_0_generic lm_ggml_gemv_q4_0_8x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemv_q4_K_8x4_q8_K_generic lm_ggml_gemv_q4_K_8x4_q8_K
 #define lm_ggml_gemv_q4_K_8x8_q8_K_generic lm_ggml_gemv_q4_K_8x8_q8_K
@@ -58,6 +60,8 @@
 #define lm_ggml_gemm_q4_0_4x4_q8_0_generic lm_ggml_gemm_q4_0_4x4_q8_0
 #define lm_ggml_gemm_q4_0_4x8_q8_0_generic lm_ggml_gemm_q4_0_4x8_q8_0
 #define lm_ggml_gemm_q4_0_8x8_q8_0_generic lm_ggml_gemm_q4_0_8x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #define lm_ggml_gemm_q4_K_8x4_q8_K_generic lm_ggml_gemm_q4_K_8x4_q8_K
 #define lm_ggml_gemm_q4_K_8x8_q8_K_generic lm_ggml_gemm_q4_K_8x8_q8_K
@@ -77,9 +81,13 @@
 #define lm_ggml_quantize_mat_q8_K_4x8_generic lm_ggml_quantize_mat_q8_K_4x8
 #define lm_ggml_gemv_iq4_nl_8x8_q8_0_generic lm_ggml_gemv_iq4_nl_8x8_q8_0
 #define lm_ggml_gemv_mxfp4_8x8_q8_0_generic lm_ggml_gemv_mxfp4_8x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemm_iq4_nl_8x8_q8_0_generic lm_ggml_gemm_iq4_nl_8x8_q8_0
 #define lm_ggml_gemm_mxfp4_8x8_q8_0_generic lm_ggml_gemm_mxfp4_8x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #elif defined(__x86_64__) || defined(__i386__) || defined(_M_IX86) || defined(_M_X64)
 // quants.c
@@ -127,6 +135,8 @@
 #define lm_ggml_gemv_q4_0_4x4_q8_0_generic lm_ggml_gemv_q4_0_4x4_q8_0
 #define lm_ggml_gemv_q4_0_4x8_q8_0_generic lm_ggml_gemv_q4_0_4x8_q8_0
 #define lm_ggml_gemv_q4_0_8x8_q8_0_generic lm_ggml_gemv_q4_0_8x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemv_q4_K_8x4_q8_K_generic lm_ggml_gemv_q4_K_8x4_q8_K
 #define lm_ggml_gemv_q4_K_8x8_q8_K_generic lm_ggml_gemv_q4_K_8x8_q8_K
@@ -143,6 +153,8 @@
 #define lm_ggml_gemm_q4_0_4x4_q8_0_generic lm_ggml_gemm_q4_0_4x4_q8_0
 #define lm_ggml_gemm_q4_0_4x8_q8_0_generic lm_ggml_gemm_q4_0_4x8_q8_0
 #define lm_ggml_gemm_q4_0_8x8_q8_0_generic lm_ggml_gemm_q4_0_8x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #define lm_ggml_gemm_q4_K_8x4_q8_K_generic lm_ggml_gemm_q4_K_8x4_q8_K
 #define lm_ggml_gemm_q4_K_8x8_q8_K_generic lm_ggml_gemm_q4_K_8x8_q8_K
@@ -174,6 +186,8 @@
 #define lm_ggml_gemv_q4_0_4x4_q8_0_generic lm_ggml_gemv_q4_0_4x4_q8_0
 #define lm_ggml_gemv_q4_0_4x8_q8_0_generic lm_ggml_gemv_q4_0_4x8_q8_0
 #define lm_ggml_gemv_q4_0_8x8_q8_0_generic lm_ggml_gemv_q4_0_8x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemv_q4_K_8x4_q8_K_generic lm_ggml_gemv_q4_K_8x4_q8_K
 #define lm_ggml_gemv_q4_K_8x8_q8_K_generic lm_ggml_gemv_q4_K_8x8_q8_K
@@ -190,6 +204,8 @@
 #define lm_ggml_gemm_q4_0_4x4_q8_0_generic lm_ggml_gemm_q4_0_4x4_q8_0
 #define lm_ggml_gemm_q4_0_4x8_q8_0_generic lm_ggml_gemm_q4_0_4x8_q8_0
 #define lm_ggml_gemm_q4_0_8x8_q8_0_generic lm_ggml_gemm_q4_0_8x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #define lm_ggml_gemm_q4_K_8x4_q8_K_generic lm_ggml_gemm_q4_K_8x4_q8_K
 #define lm_ggml_gemm_q4_K_8x8_q8_K_generic lm_ggml_gemm_q4_K_8x8_q8_K
@@ -215,6 +231,8 @@
 #define lm_ggml_quantize_mat_q8_K_4x8_generic lm_ggml_quantize_mat_q8_K_4x8
 #define lm_ggml_gemv_q4_0_4x4_q8_0_generic lm_ggml_gemv_q4_0_4x4_q8_0
 #define lm_ggml_gemv_q4_0_4x8_q8_0_generic lm_ggml_gemv_q4_0_4x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemv_q4_K_8x4_q8_K_generic lm_ggml_gemv_q4_K_8x4_q8_K
 #define lm_ggml_gemv_q4_K_8x8_q8_K_generic lm_ggml_gemv_q4_K_8x8_q8_K
@@ -230,6 +248,8 @@
 #define lm_ggml_gemv_q8_0_4x8_q8_0_generic lm_ggml_gemv_q8_0_4x8_q8_0
 #define lm_ggml_gemm_q4_0_4x4_q8_0_generic lm_ggml_gemm_q4_0_4x4_q8_0
 #define lm_ggml_gemm_q4_0_4x8_q8_0_generic lm_ggml_gemm_q4_0_4x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #define lm_ggml_gemm_q4_K_8x4_q8_K_generic lm_ggml_gemm_q4_K_8x4_q8_K
 #define lm_ggml_gemm_q4_K_8x8_q8_K_generic lm_ggml_gemm_q4_K_8x8_q8_K
@@ -267,6 +287,8 @@
 #define lm_ggml_gemv_q4_0_4x4_q8_0_generic lm_ggml_gemv_q4_0_4x4_q8_0
 #define lm_ggml_gemv_q4_0_4x8_q8_0_generic lm_ggml_gemv_q4_0_4x8_q8_0
 #define lm_ggml_gemv_q4_0_8x8_q8_0_generic lm_ggml_gemv_q4_0_8x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemv_q4_K_8x4_q8_K_generic lm_ggml_gemv_q4_K_8x4_q8_K
 #define lm_ggml_gemv_q4_K_8x8_q8_K_generic lm_ggml_gemv_q4_K_8x8_q8_K
@@ -283,6 +305,8 @@
 #define lm_ggml_gemm_q4_0_4x4_q8_0_generic lm_ggml_gemm_q4_0_4x4_q8_0
 #define lm_ggml_gemm_q4_0_4x8_q8_0_generic lm_ggml_gemm_q4_0_4x8_q8_0
 #define lm_ggml_gemm_q4_0_8x8_q8_0_generic lm_ggml_gemm_q4_0_8x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #define lm_ggml_gemm_q4_K_8x4_q8_K_generic lm_ggml_gemm_q4_K_8x4_q8_K
 #define lm_ggml_gemm_q4_K_8x8_q8_K_generic lm_ggml_gemm_q4_K_8x8_q8_K
@@ -321,6 +345,8 @@
 #define lm_ggml_gemv_q4_0_4x4_q8_0_generic lm_ggml_gemv_q4_0_4x4_q8_0
 #define lm_ggml_gemv_q4_0_4x8_q8_0_generic lm_ggml_gemv_q4_0_4x8_q8_0
 #define lm_ggml_gemv_q4_0_8x8_q8_0_generic lm_ggml_gemv_q4_0_8x8_q8_0
+#define lm_ggml_gemv_q4_1_8x8_q8_0_generic lm_ggml_gemv_q4_1_8x8_q8_0
+#define lm_ggml_gemv_q5_0_8x8_q8_0_generic lm_ggml_gemv_q5_0_8x8_q8_0
 #define lm_ggml_gemv_q2_K_8x8_q8_K_generic lm_ggml_gemv_q2_K_8x8_q8_K
 #define lm_ggml_gemv_q4_K_8x4_q8_K_generic lm_ggml_gemv_q4_K_8x4_q8_K
 #define lm_ggml_gemv_q4_K_8x8_q8_K_generic lm_ggml_gemv_q4_K_8x8_q8_K
@@ -337,6 +363,8 @@
 #define lm_ggml_gemm_q4_0_4x4_q8_0_generic lm_ggml_gemm_q4_0_4x4_q8_0
 #define lm_ggml_gemm_q4_0_4x8_q8_0_generic lm_ggml_gemm_q4_0_4x8_q8_0
 #define lm_ggml_gemm_q4_0_8x8_q8_0_generic lm_ggml_gemm_q4_0_8x8_q8_0
+#define lm_ggml_gemm_q4_1_8x8_q8_0_generic lm_ggml_gemm_q4_1_8x8_q8_0
+#define lm_ggml_gemm_q5_0_8x8_q8_0_generic lm_ggml_gemm_q5_0_8x8_q8_0
 #define lm_ggml_gemm_q2_K_8x8_q8_K_generic lm_ggml_gemm_q2_K_8x8_q8_K
 #define lm_ggml_gemm_q4_K_8x4_q8_K_generic lm_ggml_gemm_q4_K_8x4_q8_K
 #define lm_ggml_gemm_q4_K_8x8_q8_K_generic lm_ggml_gemm_q4_K_8x8_q8_K
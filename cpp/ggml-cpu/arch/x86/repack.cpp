@@ -1445,6 +1445,200 @@ static void gemm_q4_b32_8x8_q8_0_lut_avx(int n, float * LM_GGML_RESTRICT s, size
 
 #endif // defined(__AVX2__) || defined(__AVX512F__)
 
+#if defined(__AVX2__)
+
+// Unpack the 8 x 32 quants of a block_q4_1x8 / block_q5_0x8 to bytes, in the lane order used by
+// gemv_q4_b32_8x8_q8_0_lut_avx: rhs_0123[g] holds values 8g..8g+7 of columns 0-3, rhs_4567[g] of columns 4-7.
+// q4_1 quants stay unsigned (0..15), q5_0 quants get their 5-th bit and are centered to -16..15
+template<typename block_tx8>
+static inline void unpack_b32_8x8_avx2(const block_tx8 & b, __m256i * rhs_0123, __m256i * rhs_4567) {
+    static_assert(
+            std::is_same_v<block_tx8, block_q4_1x8> ||
+            std::is_same_v<block_tx8, block_q5_0x8>,
+            "Unsupported block type");
+
+    const __m256i m4b = _mm256_set1_epi8(0x0F);
+
+    const __m256i raw_0123_0 = _mm256_loadu_si256((const __m256i *)(b.qs));
+    const __m256i raw_4567_0 = _mm256_loadu_si256((const __m256i *)(b.qs) + 1);
+    const __m256i raw_0123_1 = _mm256_loadu_si256((const __m256i *)(b.qs) + 2);
+    const __m256i raw_4567_1 = _mm256_loadu_si256((const __m256i *)(b.qs) + 3);
+
+    rhs_0123[0] = _mm256_and_si256(raw_0123_0, m4b);
+    rhs_4567[0] = _mm256_and_si256(raw_4567_0, m4b);
+    rhs_0123[1] = _mm256_and_si256(raw_0123_1, m4b);
+    rhs_4567[1] = _mm256_and_si256(raw_4567_1, m4b);
+    rhs_0123[2] = _mm256_and_si256(_mm256_srli_epi16(raw_0123_0, 4), m4b);
+    rhs_4567[2] = _mm256_and_si256(_mm256_srli_epi16(raw_4567_0, 4), m4b);
+    rhs_0123[3] = _mm256_and_si256(_mm256_srli_epi16(raw_0123_1, 4), m4b);
+    rhs_4567[3] = _mm256_and_si256(_mm256_srli_epi16(raw_4567_1, 4), m4b);
+
+    if constexpr (std::is_same_v<block_tx8, block_q5_0x8>) {
+        // byte c*8 + i of group g needs bit 8g + i of the qh of column c, i.e. bit i of byte g
+        const __m256i qh_0123 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(b.qh)));
+        const __m256i qh_4567 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(b.qh) + 1));
+        const __m256i bit_mask = _mm256_set1_epi64x(0x8040201008040201LL);
+        const __m256i m16 = _mm256_set1_epi8(16);
+
+        for (int g = 0; g < 4; g++) {
+            const __m256i shuf = _mm256_setr_epi8(
+                    g,      g,      g,      g,      g,      g,      g,      g,
+                    g + 4,  g + 4,  g + 4,  g + 4,  g + 4,  g + 4,  g + 4,  g + 4,
+                    g + 8,  g + 8,  g + 8,  g + 8,  g + 8,  g + 8,  g + 8,  g + 8,
+                    g + 12, g + 12, g + 12, g + 12, g + 12, g + 12, g + 12, g + 12);
+
+            __m256i hb_0123 = _mm256_and_si256(_mm256_shuffle_epi8(qh_0123, shuf), bit_mask);
+            __m256i hb_4567 = _mm256_and_si256(_mm256_shuffle_epi8(qh_4567, shuf), bit_mask);
+            hb_0123 = _mm256_and_si256(_mm256_cmpeq_epi8(hb_0123, bit_mask), m16);
+            hb_4567 = _mm256_and_si256(_mm256_cmpeq_epi8(hb_4567, bit_mask), m16);
+
+            rhs_0123[g] = _mm256_sub_epi8(_mm256_or_si256(rhs_0123[g], hb_0123), m16);
+            rhs_4567[g] = _mm256_sub_epi8(_mm256_or_si256(rhs_4567[g], hb_4567), m16);
+        }
+    }
+}
+
+// Dot products of the unpacked columns with one row of 32 activations, same scheme as gemv_q4_b32_8x8_q8_0_lut_avx.
+// lhs_vec_0 / lhs_vec_1 hold activations 0-15 / 16-31 in both lanes; the result is in B0 B4 B1 B5 B2 B6 B3 B7 order
+static inline __m256i dot_b32_8x8_avx2(const __m256i * rhs_0123, const __m256i * rhs_4567, __m256i lhs_vec_0, __m256i lhs_vec_1) {
+    __m256i iacc = _mm256_setzero_si256();
+
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(rhs_0123[0], _mm256_shuffle_epi32(rhs_4567[0], 177), 170), _mm256_shuffle_epi32(lhs_vec_0, 0));
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(_mm256_shuffle_epi32(rhs_0123[0], 177), rhs_4567[0], 170), _mm256_shuffle_epi32(lhs_vec_0, 85));
+
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(rhs_0123[1], _mm256_shuffle_epi32(rhs_4567[1], 177), 170), _mm256_shuffle_epi32(lhs_vec_0, 170));
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(_mm256_shuffle_epi32(rhs_0123[1], 177), rhs_4567[1], 170), _mm256_shuffle_epi32(lhs_vec_0, 255));
+
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(rhs_0123[2], _mm256_shuffle_epi32(rhs_4567[2], 177), 170), _mm256_shuffle_epi32(lhs_vec_1, 0));
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(_mm256_shuffle_epi32(rhs_0123[2], 177), rhs_4567[2], 170), _mm256_shuffle_epi32(lhs_vec_1, 85));
+
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(rhs_0123[3], _mm256_shuffle_epi32(rhs_4567[3], 177), 170), _mm256_shuffle_epi32(lhs_vec_1, 170));
+    iacc = mul_sum_i8_pairs_acc_int32x8(iacc, _mm256_blend_epi32(_mm256_shuffle_epi32(rhs_0123[3], 177), rhs_4567[3], 170), _mm256_shuffle_epi32(lhs_vec_1, 255));
+
+    return iacc;
+}
+
+// sum of 32 int8 activations, broadcast to all lanes
+static inline __m256 sum_i8_32_avx2(__m256i a) {
+    __m256i s = _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_set1_epi8(1), a), _mm256_set1_epi16(1));
+    s = _mm256_add_epi32(s, _mm256_permute2x128_si256(s, s, 1));
+    s = _mm256_add_epi32(s, _mm256_shuffle_epi32(s, 0x4E));
+    s = _mm256_add_epi32(s, _mm256_shuffle_epi32(s, 0xB1));
+    return _mm256_cvtepi32_ps(s);
+}
+
+template<typename block_tx8>
+static void gemv_b32_8x8_q8_0_avx2(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+
+    const __m256i finalpermutemask = _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0);
+    const __m128i changemask = _mm_set_epi8(15, 14, 7, 6, 13, 12, 5, 4, 11, 10, 3, 2, 9, 8, 1, 0);
+
+    const block_tx8  * b_ptr_start = (const block_tx8  *)vx;
+    const block_q8_0 * a_ptr_start = (const block_q8_0 *)vy;
+
+    __m256i rhs_0123[4];
+    __m256i rhs_4567[4];
+
+    for (int64_t y = 0; y < nr; y++) {
+        const block_q8_0 * a_ptr = a_ptr_start + (y * nb);
+
+        for (int64_t x = 0; x < nc / 8; x++) {
+            const block_tx8 * b_ptr = b_ptr_start + (x * nb);
+
+            __m256 acc_row = _mm256_setzero_ps();
+
+            for (int64_t b = 0; b < nb; b++) {
+                unpack_b32_8x8_avx2(b_ptr[b], rhs_0123, rhs_4567);
+
+                const __m256i lhs_vec_0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(a_ptr[b].qs)));
+                const __m256i lhs_vec_1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(a_ptr[b].qs + 16)));
+
+                const __m256i iacc = dot_b32_8x8_avx2(rhs_0123, rhs_4567, lhs_vec_0, lhs_vec_1);
+
+                const __m256 col_scale_f32 = LM_GGML_F32Cx8_REARRANGE_LOAD(b_ptr[b].d, changemask);
+                const __m256 row_scale_f32 = _mm256_set1_ps(LM_GGML_CPU_FP16_TO_FP32(a_ptr[b].d));
+
+                acc_row = _mm256_fmadd_ps(_mm256_cvtepi32_ps(iacc), _mm256_mul_ps(col_scale_f32, row_scale_f32), acc_row);
+
+                if constexpr (std::is_same_v<block_tx8, block_q4_1x8>) {
+                    // + m * d_a * sum(a)
+                    const __m256 col_min_f32 = LM_GGML_F32Cx8_REARRANGE_LOAD(b_ptr[b].m, changemask);
+                    const __m256 row_sum_f32 = _mm256_mul_ps(row_scale_f32, sum_i8_32_avx2(_mm256_loadu_si256((const __m256i *)(a_ptr[b].qs))));
+                    acc_row = _mm256_fmadd_ps(col_min_f32, row_sum_f32, acc_row);
+                }
+            }
+
+            acc_row = _mm256_permutevar8x32_ps(acc_row, finalpermutemask);
+            _mm256_storeu_ps(s + (y * bs + x * 8), acc_row);
+        }
+    }
+}
+
+// The activations come as block_q8_0x4 interleaved in 8 bytes: bytes 8*(4k + m) .. 8*(4k + m) + 7 are
+// values 8k..8k+7 of row m. The unpacked weights of a block are reused for the 4 rows
+template<typename block_tx8>
+static void gemm_b32_8x8_q8_0_avx2(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+
+    const __m256i finalpermutemask = _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0);
+    const __m128i changemask = _mm_set_epi8(15, 14, 7, 6, 13, 12, 5, 4, 11, 10, 3, 2, 9, 8, 1, 0);
+
+    const block_tx8    * b_ptr_start = (const block_tx8    *)vx;
+    const block_q8_0x4 * a_ptr_start = (const block_q8_0x4 *)vy;
+
+    __m256i rhs_0123[4];
+    __m256i rhs_4567[4];
+
+    for (int64_t y = 0; y < nr / 4; y++) {
+        const block_q8_0x4 * a_ptr = a_ptr_start + (y * nb);
+
+        for (int64_t x = 0; x < nc / 8; x++) {
+            const block_tx8 * b_ptr = b_ptr_start + (x * nb);
+
+            __m256 acc_rows[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+
+            for (int64_t b = 0; b < nb; b++) {
+                unpack_b32_8x8_avx2(b_ptr[b], rhs_0123, rhs_4567);
+
+                const __m256 col_scale_f32 = LM_GGML_F32Cx8_REARRANGE_LOAD(b_ptr[b].d, changemask);
+                __m256 col_min_f32 = _mm256_setzero_ps();
+                if constexpr (std::is_same_v<block_tx8, block_q4_1x8>) {
+                    col_min_f32 = LM_GGML_F32Cx8_REARRANGE_LOAD(b_ptr[b].m, changemask);
+                }
+
+                const int8_t * qs = a_ptr[b].qs;
+                for (int m = 0; m < 4; m++) {
+                    const __m128i lhs_0 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(qs + 8 * m)),
+                                                             _mm_loadl_epi64((const __m128i *)(qs + 8 * (4 + m))));
+                    const __m128i lhs_1 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(qs + 8 * (8 + m))),
+                                                             _mm_loadl_epi64((const __m128i *)(qs + 8 * (12 + m))));
+
+                    const __m256i iacc = dot_b32_8x8_avx2(rhs_0123, rhs_4567,
+                            _mm256_broadcastsi128_si256(lhs_0), _mm256_broadcastsi128_si256(lhs_1));
+
+                    const __m256 row_scale_f32 = _mm256_set1_ps(LM_GGML_CPU_FP16_TO_FP32(a_ptr[b].d[m]));
+
+                    acc_rows[m] = _mm256_fmadd_ps(_mm256_cvtepi32_ps(iacc), _mm256_mul_ps(col_scale_f32, row_scale_f32), acc_rows[m]);
+
+                    if constexpr (std::is_same_v<block_tx8, block_q4_1x8>) {
+                        const __m256i lhs = _mm256_inserti128_si256(_mm256_castsi128_si256(lhs_0), lhs_1, 1);
+                        acc_rows[m] = _mm256_fmadd_ps(col_min_f32, _mm256_mul_ps(row_scale_f32, sum_i8_32_avx2(lhs)), acc_rows[m]);
+                    }
+                }
+            }
+
+            for (int m = 0; m < 4; m++) {
+                _mm256_storeu_ps(s + ((y * 4 + m) * bs + x * 8), _mm256_permutevar8x32_ps(acc_rows[m], finalpermutemask));
+            }
+        }
+    }
+}
+
+#endif // defined(__AVX2__)
+
 void lm_ggml_gemv_q4_0_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
 #if defined(__AVX2__) || defined(__AVX512F__)
     {
@@ -1461,6 +1655,24 @@ void lm_ggml_gemv_q4_0_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, co
     lm_ggml_gemv_q4_0_8x8_q8_0_generic(n, s, bs, vx, vy, nr, nc);
 }
 
+void lm_ggml_gemv_q4_1_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+#if defined(__AVX2__)
+    gemv_b32_8x8_q8_0_avx2<block_q4_1x8>(n, s, bs, vx, vy, nr, nc);
+    return;
+#endif
+
+    lm_ggml_gemv_q4_1_8x8_q8_0_generic(n, s, bs, vx, vy, nr, nc);
+}
+
+void lm_ggml_gemv_q5_0_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+#if defined(__AVX2__)
+    gemv_b32_8x8_q8_0_avx2<block_q5_0x8>(n, s, bs, vx, vy, nr, nc);
+    return;
+#endif
+
+    lm_ggml_gemv_q5_0_8x8_q8_0_generic(n, s, bs, vx, vy, nr, nc);
+}
+
 void lm_ggml_gemv_q4_K_8x8_q8_K(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK_K;
     const int nb = n / qk;
@@ -2039,6 +2251,24 @@ void lm_ggml_gemm_q4_0_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, co
     lm_ggml_gemm_q4_0_8x8_q8_0_generic(n, s, bs, vx, vy, nr, nc);
 }
 
+void lm_ggml_gemm_q4_1_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+#if defined(__AVX2__)
+    gemm_b32_8x8_q8_0_avx2<block_q4_1x8>(n, s, bs, vx, vy, nr, nc);
+    return;
+#endif
+
+    lm_ggml_gemm_q4_1_8x8_q8_0_generic(n, s, bs, vx, vy, nr, nc);
+}
+
+void lm_ggml_gemm_q5_0_8x8_q8_0(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+#if defined(__AVX2__)
+    gemm_b32_8x8_q8_0_avx2<block_q5_0x8>(n, s, bs, vx, vy, nr, nc);
+    return;
+#endif
+
+    lm_ggml_gemm_q5_0_8x8_q8_0_generic(n, s, bs, vx, vy, nr, nc);
+}
+
 void lm_ggml_gemm_q4_K_8x8_q8_K(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK_K;
     const int nb = n / qk;
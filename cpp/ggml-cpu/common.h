@@ -9,6 +9,9 @@
 #define LM_GGML_FA_TILE_Q  64
 #define LM_GGML_FA_TILE_KV 64
 
+// max number of query rows per head (n_tokens*n_stream) for the split-KV decode path
+#define LM_GGML_FA_SPLIT_KV_Q 16
+
 #ifdef __cplusplus
 
 #include <utility>
@@ -2945,7 +2945,9 @@ struct lm_ggml_cplan lm_ggml_graph_plan(
                     } break;
                 case LM_GGML_OP_FLASH_ATTN_EXT:
                     {
+                        const int64_t neq1 = node->src[0]->ne[1]; // number of query rows
                         const int64_t neq2 = node->src[0]->ne[2]; // number of query heads
+                        const int64_t neq3 = node->src[0]->ne[3]; // number of streams
                         const int64_t DK = node->src[1]->ne[0];
                         const int64_t DV = node->src[2]->ne[0];
 
@@ -2955,8 +2957,10 @@ struct lm_ggml_cplan lm_ggml_graph_plan(
 
                         // Decode path: n_kv_chunks = n_tasks (one chunk per thread)
                         // Per-thread: VKQ accmulator (DV), partial M, partial S + intra-thread scratch for V, Q and VKQ
+                        // Partials are only needed when the query rows are few enough for the split-KV path
                         size_t n_chunks = n_tasks;
-                        size_t decode   = sizeof(float)*(neq2*n_chunks*(2+DV) + n_tasks*(DK + 2*DV));
+                        size_t n_rows   = neq1*neq3 <= LM_GGML_FA_SPLIT_KV_Q ? neq1*neq2*neq3 : 0;
+                        size_t decode   = sizeof(float)*(n_rows*n_chunks*(2+DV) + n_tasks*(DK + 2*DV));
 
                         cur += MAX(prefill, decode);
                     } break;
@@ -3057,6 +3061,261 @@ static int lm_ggml_cpu_try_fuse_ops(
     return 0;
 }
 
+//
+// per-op profiler
+//
+// opt-in: the compute loop only takes timestamps when a profiler is attached to the cplan
+// raw per-node timings of the current graph are folded into stats keyed by (op, tensor name) once the graph is done
+// the aggregated stats and totals are guarded by a mutex so they can be read while another thread computes
+//
+
+struct lm_ggml_cpu_profiler {
+    // raw timings of the graph being computed, [n_nodes] and [n_nodes][n_threads]
+    int64_t * t_wall;
+    int64_t * t_busy;
+    int64_t * t_wait;
+    int       n_nodes_max;
+    int       n_threads_max;
+    int       n_nodes;
+    int       n_threads;
+
+    // aggregated stats, indexed by an open-addressing hash table
+    struct lm_ggml_cpu_profile_stat * stats;
+    int       n_stats;
+    int       n_stats_max;
+    int32_t * table;
+    int       table_size; // power of 2
+
+    // per-thread totals
+    int64_t   thread_busy_ns[LM_GGML_MAX_N_THREADS];
+    int64_t   thread_wait_ns[LM_GGML_MAX_N_THREADS];
+    int       n_threads_seen;
+
+    int64_t   n_graphs;
+    int64_t   t_graph_ns;
+
+    // guards the aggregated stats, the per-thread totals and the graph totals
+    lm_ggml_mutex_t mutex;
+};
+
+static inline int64_t lm_ggml_cpu_profiler_time_ns(void) {
+#if defined(_WIN32)
+    return lm_ggml_time_us()*1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec*1000000000 + (int64_t)ts.tv_nsec;
+#endif
+}
+
+struct lm_ggml_cpu_profiler * lm_ggml_cpu_profiler_new(void) {
+    struct lm_ggml_cpu_profiler * prof = (struct lm_ggml_cpu_profiler *) calloc(1, sizeof(struct lm_ggml_cpu_profiler));
+    LM_GGML_ASSERT(prof != NULL);
+    lm_ggml_mutex_init(&prof->mutex);
+    return prof;
+}
+
+void lm_ggml_cpu_profiler_free(struct lm_ggml_cpu_profiler * prof) {
+    if (prof == NULL) {
+        return;
+    }
+    free(prof->t_wall);
+    free(prof->t_busy);
+    free(prof->t_wait);
+    free(prof->stats);
+    free(prof->table);
+    lm_ggml_mutex_destroy(&prof->mutex);
+    free(prof);
+}
+
+void lm_ggml_cpu_profiler_reset(struct lm_ggml_cpu_profiler * prof) {
+    lm_ggml_mutex_lock(&prof->mutex);
+    prof->n_stats = 0;
+    if (prof->table) {
+        memset(prof->table, -1, prof->table_size*sizeof(int32_t));
+    }
+    memset(prof->thread_busy_ns, 0, sizeof(prof->thread_busy_ns));
+    memset(prof->thread_wait_ns, 0, sizeof(prof->thread_wait_ns));
+    prof->n_threads_seen = 0;
+    prof->n_graphs       = 0;
+    prof->t_graph_ns     = 0;
+    lm_ggml_mutex_unlock(&prof->mutex);
+}
+
+// the getters only read, but take the mutex of the (logically const) profiler
+static inline lm_ggml_mutex_t * lm_ggml_cpu_profiler_mutex(const struct lm_ggml_cpu_profiler * prof) {
+    return (lm_ggml_mutex_t *) &prof->mutex;
+}
+
+int lm_ggml_cpu_profiler_get_stats(const struct lm_ggml_cpu_profiler * prof, struct lm_ggml_cpu_profile_stat * stats, int n_max) {
+    lm_ggml_mutex_lock(lm_ggml_cpu_profiler_mutex(prof));
+    const int n_stats = prof->n_stats;
+    if (stats != NULL && n_max > 0) {
+        memcpy(stats, prof->stats, sizeof(struct lm_ggml_cpu_profile_stat)*MIN(n_stats, n_max));
+    }
+    lm_ggml_mutex_unlock(lm_ggml_cpu_profiler_mutex(prof));
+    return n_stats;
+}
+
+int lm_ggml_cpu_profiler_n_threads(const struct lm_ggml_cpu_profiler * prof) {
+    lm_ggml_mutex_lock(lm_ggml_cpu_profiler_mutex(prof));
+    const int n_threads = prof->n_threads_seen;
+    lm_ggml_mutex_unlock(lm_ggml_cpu_profiler_mutex(prof));
+    return n_threads;
+}
+
+void lm_ggml_cpu_profiler_get_thread(const struct lm_ggml_cpu_profiler * prof, int ith, int64_t * t_busy_ns, int64_t * t_wait_ns) {
+    LM_GGML_ASSERT(ith >= 0 && ith < LM_GGML_MAX_N_THREADS);
+    lm_ggml_mutex_lock(lm_ggml_cpu_profiler_mutex(prof));
+    *t_busy_ns = prof->thread_busy_ns[ith];
+    *t_wait_ns = prof->thread_wait_ns[ith];
+    lm_ggml_mutex_unlock(lm_ggml_cpu_profiler_mutex(prof));
+}
+
+void lm_ggml_cpu_profiler_get_totals(const struct lm_ggml_cpu_profiler * prof, int64_t * n_graphs, int64_t * t_graph_ns) {
+    lm_ggml_mutex_lock(lm_ggml_cpu_profiler_mutex(prof));
+    *n_graphs   = prof->n_graphs;
+    *t_graph_ns = prof->t_graph_ns;
+    lm_ggml_mutex_unlock(lm_ggml_cpu_profiler_mutex(prof));
+}
+
+// called before the worker threads start
+static void lm_ggml_cpu_profiler_begin(struct lm_ggml_cpu_profiler * prof, int n_nodes, int n_threads) {
+    if (n_nodes > prof->n_nodes_max || n_threads > prof->n_threads_max) {
+        prof->n_nodes_max   = MAX(n_nodes,   prof->n_nodes_max);
+        prof->n_threads_max = MAX(n_threads, prof->n_threads_max);
+
+        free(prof->t_wall);
+        free(prof->t_busy);
+        free(prof->t_wait);
+
+        prof->t_wall = (int64_t *) malloc(sizeof(int64_t)*prof->n_nodes_max);
+        prof->t_busy = (int64_t *) malloc(sizeof(int64_t)*prof->n_nodes_max*prof->n_threads_max);
+        prof->t_wait = (int64_t *) malloc(sizeof(int64_t)*prof->n_nodes_max*prof->n_threads_max);
+        LM_GGML_ASSERT(prof->t_wall && prof->t_busy && prof->t_wait);
+    }
+
+    prof->n_nodes   = n_nodes;
+    prof->n_threads = n_threads;
+
+    // t_wall < 0 marks nodes that were not computed (NOPs, fused into the previous node)
+    memset(prof->t_wall, -1, sizeof(int64_t)*n_nodes);
+    memset(prof->t_busy,  0, sizeof(int64_t)*n_nodes*n_threads);
+    memset(prof->t_wait,  0, sizeof(int64_t)*n_nodes*n_threads);
+}
+
+// called by every worker thread after a node (or fused group of nodes) and its barrier
+static inline void lm_ggml_cpu_profiler_record(struct lm_ggml_cpu_profiler * prof, int node_n, int ith, int64_t t0, int64_t t1, int64_t t2) {
+    prof->t_busy[node_n*prof->n_threads + ith] = t1 - t0;
+    prof->t_wait[node_n*prof->n_threads + ith] = t2 - t1;
+    if (ith == 0) {
+        prof->t_wall[node_n] = t2 - t0;
+    }
+}
+
+static uint32_t lm_ggml_cpu_profiler_hash(const char * op, const char * name) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (const char * c = op; *c; ++c) {
+        h = (h ^ (uint8_t) *c) * 16777619u;
+    }
+    h = (h ^ 0xff) * 16777619u;
+    for (const char * c = name; *c; ++c) {
+        h = (h ^ (uint8_t) *c) * 16777619u;
+    }
+    return h;
+}
+
+static struct lm_ggml_cpu_profile_stat * lm_ggml_cpu_profiler_find_or_add(struct lm_ggml_cpu_profiler * prof, const char * op, const char * name) {
+    if (2*(prof->n_stats + 1) > prof->table_size) {
+        const int table_size = prof->table_size ? 2*prof->table_size : 256;
+        int32_t * table = (int32_t *) malloc(sizeof(int32_t)*table_size);
+        LM_GGML_ASSERT(table != NULL);
+        memset(table, -1, sizeof(int32_t)*table_size);
+        for (int i = 0; i < prof->n_stats; ++i) {
+            uint32_t j = lm_ggml_cpu_profiler_hash(prof->stats[i].op, prof->stats[i].name) & (table_size - 1);
+            while (table[j] >= 0) {
+                j = (j + 1) & (table_size - 1);
+            }
+            table[j] = i;
+        }
+        free(prof->table);
+        prof->table      = table;
+        prof->table_size = table_size;
+    }
+
+    uint32_t j = lm_ggml_cpu_profiler_hash(op, name) & (prof->table_size - 1);
+    while (prof->table[j] >= 0) {
+        struct lm_ggml_cpu_profile_stat * stat = &prof->stats[prof->table[j]];
+        if (strcmp(stat->op, op) == 0 && strncmp(stat->name, name, LM_GGML_MAX_NAME) == 0) {
+            return stat;
+        }
+        j = (j + 1) & (prof->table_size - 1);
+    }
+
+    if (prof->n_stats == prof->n_stats_max) {
+        prof->n_stats_max = prof->n_stats_max ? 2*prof->n_stats_max : 128;
+        prof->stats = (struct lm_ggml_cpu_profile_stat *) realloc(prof->stats, sizeof(struct lm_ggml_cpu_profile_stat)*prof->n_stats_max);
+        LM_GGML_ASSERT(prof->stats != NULL);
+    }
+
+    struct lm_ggml_cpu_profile_stat * stat = &prof->stats[prof->n_stats];
+    memset(stat, 0, sizeof(*stat));
+    stat->op = op;
+    snprintf(stat->name, sizeof(stat->name), "%s", name);
+
+    prof->table[j] = prof->n_stats++;
+
+    return stat;
+}
+
+// called after the worker threads are done
+static void lm_ggml_cpu_profiler_end(struct lm_ggml_cpu_profiler * prof, const struct lm_ggml_cgraph * cgraph, int n_threads) {
+    int64_t t_graph = 0;
+
+    lm_ggml_mutex_lock(&prof->mutex);
+
+    for (int i = 0; i < prof->n_nodes; ++i) {
+        if (prof->t_wall[i] < 0) {
+            continue;
+        }
+
+        const struct lm_ggml_tensor * node = cgraph->nodes[i];
+
+        struct lm_ggml_cpu_profile_stat * stat = lm_ggml_cpu_profiler_find_or_add(prof, lm_ggml_op_desc(node), node->name);
+
+        int64_t n_bytes = lm_ggml_nbytes(node);
+        for (int j = 0; j < LM_GGML_MAX_SRC; ++j) {
+            if (node->src[j]) {
+                n_bytes += lm_ggml_nbytes(node->src[j]);
+            }
+        }
+
+        stat->n_calls   += 1;
+        stat->n_bytes   += n_bytes;
+        stat->t_wall_ns += prof->t_wall[i];
+
+        for (int ith = 0; ith < n_threads; ++ith) {
+            const int64_t t_busy = prof->t_busy[i*prof->n_threads + ith];
+            const int64_t t_wait = prof->t_wait[i*prof->n_threads + ith];
+
+            stat->t_busy_ns += t_busy;
+            stat->t_wait_ns += t_wait;
+
+            prof->thread_busy_ns[ith] += t_busy;
+            prof->thread_wait_ns[ith] += t_wait;
+        }
+
+        t_graph += prof->t_wall[i];
+    }
+
+    prof->n_threads_seen = MAX(prof->n_threads_seen, n_threads);
+    prof->n_graphs      += 1;
+    prof->t_graph_ns    += t_graph;
+
+    lm_ggml_mutex_unlock(&prof->mutex);
+}
+
 static thread_ret_t lm_ggml_graph_compute_thread(void * data) {
     struct lm_ggml_compute_state * state = (struct lm_ggml_compute_state *) data;
     struct lm_ggml_threadpool    * tp    = state->threadpool;
@@ -3064,6 +3323,8 @@ static thread_ret_t lm_ggml_graph_compute_thread(void * data) {
     const struct lm_ggml_cgraph * cgraph = tp->cgraph;
     const struct lm_ggml_cplan  * cplan  = tp->cplan;
 
+    struct lm_ggml_cpu_profiler * prof = cplan->profiler;
+
 #ifdef LM_GGML_USE_CPU_RISCV64_SPACEMIT
     lm_ggml_backend_cpu_riscv64_spacemit_set_numa_thread_affinity(state->ith);
 #else
@@ -3097,6 +3358,9 @@ static thread_ret_t lm_ggml_graph_compute_thread(void * data) {
             continue;
         }
 
+        const int     node_start = node_n;
+        const int64_t t0 = prof ? lm_ggml_cpu_profiler_time_ns() : 0;
+
         // TODO: move fused-op detection into lm_ggml_graph_plan so fusion decisions are made once at planning time
         // Try fused ops, fall back to normal compute
         const int n_fused = lm_ggml_cpu_try_fuse_ops(cgraph, node_n, &params, cplan);
@@ -3106,6 +3370,8 @@ static thread_ret_t lm_ggml_graph_compute_thread(void * data) {
             lm_ggml_compute_forward(&params, node);
         }
 
+        const int64_t t1 = prof ? lm_ggml_cpu_profiler_time_ns() : 0;
+
         if (state->ith == 0 && cplan->abort_callback &&
                 cplan->abort_callback(cplan->abort_callback_data)) {
             atomic_store_explicit(&tp->abort, node_n + 1, memory_order_relaxed);
@@ -3115,6 +3381,10 @@ static thread_ret_t lm_ggml_graph_compute_thread(void * data) {
         if (node_n + 1 < cgraph->n_nodes) {
             lm_ggml_barrier(state->threadpool);
         }
+
+        if (prof) {
+            lm_ggml_cpu_profiler_record(prof, node_start, state->ith, t0, t1, lm_ggml_cpu_profiler_time_ns());
+        }
     }
 
 #ifdef LM_GGML_USE_OPENMP
@@ -3359,6 +3629,10 @@ enum lm_ggml_status lm_ggml_graph_compute(struct lm_ggml_cgraph * cgraph, struct
 
     bool disposable_threadpool = false;
 
+    if (cplan->profiler) {
+        lm_ggml_cpu_profiler_begin(cplan->profiler, cgraph->n_nodes, n_threads);
+    }
+
     if (threadpool == NULL) {
         //LM_GGML_PRINT_DEBUG("Threadpool is not specified. Will create a disposable threadpool : n_threads %d\n", n_threads);
         disposable_threadpool = true;
@@ -3415,6 +3689,10 @@ enum lm_ggml_status lm_ggml_graph_compute(struct lm_ggml_cgraph * cgraph, struct
     // don't leave affinity set on the main thread
     clear_numa_thread_affinity();
 
+    if (cplan->profiler) {
+        lm_ggml_cpu_profiler_end(cplan->profiler, cgraph, n_threads);
+    }
+
     enum lm_ggml_status ret = threadpool->ec;
 
     if (disposable_threadpool) {
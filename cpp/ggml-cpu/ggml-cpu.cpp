@@ -7,6 +7,7 @@
 #include "amx/amx.h"
 
 #include <cctype>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -107,6 +108,10 @@ struct lm_ggml_backend_cpu_context {
     void *              abort_callback_data;
 
     bool                use_ref;  // use reference implementation
+
+    // held by graphs that compute with the profiler, so detaching it waits for them to finish
+    struct lm_ggml_cpu_profiler * profiler;
+    std::mutex                 profiler_mutex;
 };
 
 static const char * lm_ggml_backend_cpu_get_name(lm_ggml_backend_t backend) {
@@ -146,6 +151,7 @@ static lm_ggml_backend_graph_plan_t lm_ggml_backend_cpu_graph_plan_create(lm_ggm
     cpu_plan->cplan.abort_callback      = cpu_ctx->abort_callback;
     cpu_plan->cplan.abort_callback_data = cpu_ctx->abort_callback_data;
     cpu_plan->cplan.use_ref             = cpu_ctx->use_ref;
+    cpu_plan->cplan.profiler            = NULL; // set by lm_ggml_backend_cpu_graph_plan_compute
 
     return cpu_plan;
 }
@@ -160,11 +166,16 @@ static void lm_ggml_backend_cpu_graph_plan_free(lm_ggml_backend_t backend, lm_gg
 }
 
 static enum lm_ggml_status lm_ggml_backend_cpu_graph_plan_compute(lm_ggml_backend_t backend, lm_ggml_backend_graph_plan_t plan) {
+    struct lm_ggml_backend_cpu_context * cpu_ctx = (struct lm_ggml_backend_cpu_context *)backend->context;
     struct lm_ggml_backend_plan_cpu * cpu_plan = (struct lm_ggml_backend_plan_cpu *)plan;
 
-    return lm_ggml_graph_compute(&cpu_plan->cgraph, &cpu_plan->cplan);
+    std::unique_lock<std::mutex> lock(cpu_ctx->profiler_mutex);
+    cpu_plan->cplan.profiler = cpu_ctx->profiler;
+    if (cpu_plan->cplan.profiler == NULL) {
+        lock.unlock();
+    }
 
-    LM_GGML_UNUSED(backend);
+    return lm_ggml_graph_compute(&cpu_plan->cgraph, &cpu_plan->cplan);
 }
 
 static enum lm_ggml_status lm_ggml_backend_cpu_graph_compute(lm_ggml_backend_t backend, struct lm_ggml_cgraph * cgraph) {
@@ -187,6 +198,12 @@ static enum lm_ggml_status lm_ggml_backend_cpu_graph_compute(lm_ggml_backend_t b
     cplan.abort_callback_data = cpu_ctx->abort_callback_data;
     cplan.use_ref             = cpu_ctx->use_ref;
 
+    std::unique_lock<std::mutex> lock(cpu_ctx->profiler_mutex);
+    cplan.profiler = cpu_ctx->profiler;
+    if (cplan.profiler == NULL) {
+        lock.unlock();
+    }
+
     return lm_ggml_graph_compute(cgraph, &cplan);
 }
 
@@ -230,6 +247,7 @@ lm_ggml_backend_t lm_ggml_backend_cpu_init(void) {
     ctx->abort_callback      = NULL;
     ctx->abort_callback_data = NULL;
     ctx->use_ref             = false;
+    ctx->profiler            = NULL;
 
     lm_ggml_backend_t cpu_backend = new lm_ggml_backend {
         /* .guid    = */ lm_ggml_backend_cpu_guid(),
@@ -284,6 +302,14 @@ void lm_ggml_backend_cpu_set_use_ref(lm_ggml_backend_t backend_cpu, bool use_ref
     ctx->use_ref = use_ref;
 }
 
+void lm_ggml_backend_cpu_set_profiler(lm_ggml_backend_t backend_cpu, struct lm_ggml_cpu_profiler * profiler) {
+    LM_GGML_ASSERT(lm_ggml_backend_is_cpu(backend_cpu));
+
+    struct lm_ggml_backend_cpu_context * ctx = (struct lm_ggml_backend_cpu_context *)backend_cpu->context;
+    std::lock_guard<std::mutex> lock(ctx->profiler_mutex);
+    ctx->profiler = profiler;
+}
+
 // CPU backend - device
 
 struct lm_ggml_backend_cpu_device_context {
@@ -658,6 +684,12 @@ static void * lm_ggml_backend_cpu_get_proc_address(lm_ggml_backend_reg_t reg, co
     if (strcmp(name, "lm_ggml_backend_get_features") == 0) {
         return (void *)lm_ggml_backend_cpu_get_features;
     }
+#ifdef LM_GGML_USE_CPU_REPACK
+    if (strcmp(name, "lm_ggml_backend_cpu_repack_buffer_from_ptr") == 0) {
+        lm_ggml_backend_cpu_repack_buffer_from_ptr_t fct = lm_ggml_backend_cpu_repack_buffer_from_ptr;
+        return (void *)fct;
+    }
+#endif
     if (strcmp(name, "lm_ggml_backend_set_abort_callback") == 0) {
         return (void *)lm_ggml_backend_cpu_set_abort_callback;
     }
@@ -670,6 +702,9 @@ static void * lm_ggml_backend_cpu_get_proc_address(lm_ggml_backend_reg_t reg, co
     if (strcmp(name, "lm_ggml_backend_cpu_set_use_ref") == 0) {
         return (void *)lm_ggml_backend_cpu_set_use_ref;
     }
+    if (strcmp(name, "lm_ggml_backend_cpu_set_profiler") == 0) {
+        return (void *)lm_ggml_backend_cpu_set_profiler;
+    }
 
     // threadpool - TODO:  move to ggml-base
     if (strcmp(name, "lm_ggml_threadpool_new") == 0) {
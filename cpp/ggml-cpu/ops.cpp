@@ -8992,7 +8992,7 @@ static void lm_ggml_compute_forward_flash_attn_ext_tiled(
 }
 
 // Reduction function: combines partial results across KV chunks
-// Partials layout in wdata: [n_q_heads][n_chunks][2 + DV]
+// Partials layout in wdata: [n_q_rows][n_chunks][2 + DV], rows ordered as (iq1, iq2, iq3)
 static void lm_ggml_flash_attn_ext_reduce_partials(
         const lm_ggml_compute_params * params,
         lm_ggml_tensor * dst,
@@ -9006,7 +9006,9 @@ static void lm_ggml_flash_attn_ext_reduce_partials(
     const int64_t DK        = k->ne[0];
     const int64_t DV        = v->ne[0];
     const int64_t nek1      = k->ne[1];
-    const int64_t n_q_heads = q->ne[2];
+    const int64_t neq1      = q->ne[1];
+    const int64_t neq2      = q->ne[2];
+    const int64_t n_q_rows  = q->ne[1]*q->ne[2]*q->ne[3];
 
     const int ith = params->ith;
     const int nth = params->nth;
@@ -9023,8 +9025,8 @@ static void lm_ggml_flash_attn_ext_reduce_partials(
     const int64_t ne2 = dst->ne[2];
     const size_t  nb1 = dst->nb[1];
 
-    // Each thread reduces a subset of query heads
-    for (int64_t q_head = ith; q_head < n_q_heads; q_head += nth) {
+    // Each thread reduces a subset of query rows
+    for (int64_t ir = ith; ir < n_q_rows; ir += nth) {
         float   M_final   = -INFINITY;
         float   S_final   = 0.0f;
         float * VKQ_final = thread_wdata;
@@ -9035,7 +9037,7 @@ static void lm_ggml_flash_attn_ext_reduce_partials(
             const int64_t ic_start = chunk_idx * chunk_size;
             if (ic_start >= nek1) continue;
 
-            const float * partial   = partials_base + (q_head * n_chunks + chunk_idx) * partial_size;
+            const float * partial   = partials_base + (ir * n_chunks + chunk_idx) * partial_size;
             const float   M_chunk   = partial[0];
             const float   S_chunk   = partial[1];
             const float * VKQ_chunk = partial + 2;
@@ -9058,8 +9060,13 @@ static void lm_ggml_flash_attn_ext_reduce_partials(
             const float S_inv = 1.0f / S_final;
             lm_ggml_vec_scale_f32(DV, VKQ_final, S_inv);
         }
-        // iq1=0, iq3=0 for decode
-        memcpy((char *) dst->data + (0*ne2*ne1 + q_head + 0*ne1)*nb1, VKQ_final, nb1);
+
+        const int64_t iq3 = ir/(neq2*neq1);
+        const int64_t iq2 = (ir - iq3*neq2*neq1)/neq1;
+        const int64_t iq1 = (ir - iq3*neq2*neq1 - iq2*neq1);
+
+        // permute(0, 2, 1, 3)
+        memcpy((char *) dst->data + (iq3*ne2*ne1 + iq2 + iq1*ne1)*nb1, VKQ_final, nb1);
     }
 }
 
@@ -9112,12 +9119,19 @@ static void lm_ggml_compute_forward_flash_attn_ext_f16(
     const bool use_ref = params->use_ref;
 
     const bool kv_is_f32_or_f16 = (k->type == LM_GGML_TYPE_F32 || k->type == LM_GGML_TYPE_F16);
-    const bool use_split_kv_path = !use_ref && (neq1 == 1 && neq3 == 1) && kv_is_f32_or_f16 && (k->type == v->type) && q->type == LM_GGML_TYPE_F32 && nek1 >= 512;
+
+    // split the KV sequence across threads when there are only a few query rows per head (single-token decode,
+    // a handful of parallel sequences or streams): parallelizing over heads alone leaves threads idle on long contexts
+    // any K/V type supported by the one_chunk kernel can be used, incl. quantized caches
+    const bool use_split_kv_path = !use_ref && nth > 1 && (neq1*neq3 <= LM_GGML_FA_SPLIT_KV_Q) && q->type == LM_GGML_TYPE_F32 && nek1 >= 512;
 
     if (use_split_kv_path) {
         const int64_t chunk_size = (nek1 + nth - 1) / nth;
 
-        // Partials buffer layout: [q_head][kv_chunk][M, S, VKQ]
+        // total rows in q
+        const int64_t nr = neq1*neq2*neq3;
+
+        // Partials buffer layout: [q_row][kv_chunk][M, S, VKQ]
         const int64_t partial_size  = 2 + DV;
         float *       partials_base = (float *) params->wdata + nth * (DK + 2*DV + CACHE_LINE_SIZE_F32);
 
@@ -9128,14 +9142,12 @@ static void lm_ggml_compute_forward_flash_attn_ext_f16(
         float *       chunk_partials = partials_base + ith * partial_size;
 
         if (ic_start < nek1) {
-            for (int64_t q_head = 0; q_head < neq2; q_head++) {
-                lm_ggml_compute_forward_flash_attn_ext_f16_one_chunk(
-                    params, dst, q_head, q_head + 1, ic_start, ic_end,
-                    chunk_partials, partial_stride);
-            }
+            lm_ggml_compute_forward_flash_attn_ext_f16_one_chunk(
+                params, dst, 0, nr, ic_start, ic_end,
+                chunk_partials, partial_stride);
         } else {
-            for (int64_t q_head = 0; q_head < neq2; q_head++) {
-                float * q_partials = chunk_partials + q_head * partial_stride;
+            for (int64_t ir = 0; ir < nr; ir++) {
+                float * q_partials = chunk_partials + ir * partial_stride;
                 q_partials[0] = -INFINITY;  // M
                 q_partials[1] = 0.0f;       // S
             }
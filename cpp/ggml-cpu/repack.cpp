@@ -884,6 +884,88 @@ void lm_ggml_gemv_q4_0_8x8_q8_0_generic(int n, float * LM_GGML_RESTRICT s, size_
     }
 }
 
+void lm_ggml_gemv_q4_1_8x8_q8_0_generic(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    UNUSED(bs);
+    UNUSED(nr);
+
+    float sumf[8];
+
+    const block_q8_0 * a_ptr = (const block_q8_0 *) vy;
+    for (int x = 0; x < nc / ncols_interleaved; x++) {
+        const block_q4_1x8 * b_ptr = (const block_q4_1x8 *) vx + (x * nb);
+
+        for (int j = 0; j < ncols_interleaved; j++) sumf[j] = 0.0;
+        for (int l = 0; l < nb; l++) {
+            // the mins multiply the plain sum of the activations
+            int suma = 0;
+            for (int i = 0; i < qk; i++) {
+                suma += a_ptr[l].qs[i];
+            }
+            const float da = LM_GGML_CPU_FP16_TO_FP32(a_ptr[l].d);
+            for (int j = 0; j < ncols_interleaved; j++) {
+                int sumi = 0;
+                for (int k = 0; k < (qk / (2 * blocklen)); k++) {
+                    for (int i = 0; i < blocklen; ++i) {
+                        const uint8_t q = b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i];
+                        sumi += (q & 0x0F) * a_ptr[l].qs[k * blocklen + i] + (q >> 4) * a_ptr[l].qs[k * blocklen + i + qk / 2];
+                    }
+                }
+                sumf[j] += da * (sumi * LM_GGML_CPU_FP16_TO_FP32(b_ptr[l].d[j]) + suma * LM_GGML_CPU_FP16_TO_FP32(b_ptr[l].m[j]));
+            }
+        }
+        for (int j = 0; j < ncols_interleaved; j++) s[x * ncols_interleaved + j] = sumf[j];
+    }
+}
+
+void lm_ggml_gemv_q5_0_8x8_q8_0_generic(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    UNUSED(bs);
+    UNUSED(nr);
+
+    float sumf[8];
+
+    const block_q8_0 * a_ptr = (const block_q8_0 *) vy;
+    for (int x = 0; x < nc / ncols_interleaved; x++) {
+        const block_q5_0x8 * b_ptr = (const block_q5_0x8 *) vx + (x * nb);
+
+        for (int j = 0; j < ncols_interleaved; j++) sumf[j] = 0.0;
+        for (int l = 0; l < nb; l++) {
+            for (int j = 0; j < ncols_interleaved; j++) {
+                uint32_t qh;
+                memcpy(&qh, &b_ptr[l].qh[j * 4], sizeof(qh));
+
+                int sumi = 0;
+                for (int k = 0; k < (qk / (2 * blocklen)); k++) {
+                    for (int i = 0; i < blocklen; ++i) {
+                        const uint8_t q  = b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i];
+                        const int     iv = k * blocklen + i;
+                        const int     v0 = ((q & 0x0F) | (((qh >> iv)            & 1) << 4)) - 16;
+                        const int     v1 = ((q >> 4)   | (((qh >> (iv + qk / 2)) & 1) << 4)) - 16;
+                        sumi += v0 * a_ptr[l].qs[iv] + v1 * a_ptr[l].qs[iv + qk / 2];
+                    }
+                }
+                sumf[j] += sumi * LM_GGML_CPU_FP16_TO_FP32(b_ptr[l].d[j]) * LM_GGML_CPU_FP16_TO_FP32(a_ptr[l].d);
+            }
+        }
+        for (int j = 0; j < ncols_interleaved; j++) s[x * ncols_interleaved + j] = sumf[j];
+    }
+}
+
 void lm_ggml_gemv_q4_K_8x4_q8_K_generic(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK_K;
     const int nb = n / qk;
@@ -1819,6 +1901,103 @@ void lm_ggml_gemm_q4_0_8x8_q8_0_generic(int n, float * LM_GGML_RESTRICT s, size_
     }
 }
 
+void lm_ggml_gemm_q4_1_8x8_q8_0_generic(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nr % 4 == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    float sumf[4][8];
+
+    for (int y = 0; y < nr / 4; y++) {
+        const block_q8_0x4 * a_ptr = (const block_q8_0x4 *) vy + (y * nb);
+        for (int x = 0; x < nc / ncols_interleaved; x++) {
+            const block_q4_1x8 * b_ptr = (const block_q4_1x8 *) vx + (x * nb);
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++) sumf[m][j] = 0.0;
+            }
+            for (int l = 0; l < nb; l++) {
+                for (int m = 0; m < 4; m++) {
+                    int suma = 0;
+                    for (int k = 0; k < qk / blocklen; k++) {
+                        for (int i = 0; i < blocklen; i++) {
+                            suma += a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i];
+                        }
+                    }
+                    const float da = LM_GGML_CPU_FP16_TO_FP32(a_ptr[l].d[m]);
+                    for (int j = 0; j < ncols_interleaved; j++) {
+                        int sumi = 0;
+                        for (int k = 0; k < (qk / (2 * blocklen)); k++) {
+                            for (int i = 0; i < blocklen; ++i) {
+                                const uint8_t q = b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i];
+                                sumi += (q & 0x0F) * a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i] +
+                                        (q >> 4)   * a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i + qk / 2 * 4];
+                            }
+                        }
+                        sumf[m][j] += da * (sumi * LM_GGML_CPU_FP16_TO_FP32(b_ptr[l].d[j]) + suma * LM_GGML_CPU_FP16_TO_FP32(b_ptr[l].m[j]));
+                    }
+                }
+            }
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++)
+                    s[(y * 4 + m) * bs + x * ncols_interleaved + j] = sumf[m][j];
+            }
+        }
+    }
+}
+
+void lm_ggml_gemm_q5_0_8x8_q8_0_generic(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nr % 4 == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    float sumf[4][8];
+
+    for (int y = 0; y < nr / 4; y++) {
+        const block_q8_0x4 * a_ptr = (const block_q8_0x4 *) vy + (y * nb);
+        for (int x = 0; x < nc / ncols_interleaved; x++) {
+            const block_q5_0x8 * b_ptr = (const block_q5_0x8 *) vx + (x * nb);
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++) sumf[m][j] = 0.0;
+            }
+            for (int l = 0; l < nb; l++) {
+                for (int j = 0; j < ncols_interleaved; j++) {
+                    uint32_t qh;
+                    memcpy(&qh, &b_ptr[l].qh[j * 4], sizeof(qh));
+
+                    for (int m = 0; m < 4; m++) {
+                        int sumi = 0;
+                        for (int k = 0; k < (qk / (2 * blocklen)); k++) {
+                            for (int i = 0; i < blocklen; ++i) {
+                                const uint8_t q  = b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i];
+                                const int     iv = k * blocklen + i;
+                                const int     v0 = ((q & 0x0F) | (((qh >> iv)            & 1) << 4)) - 16;
+                                const int     v1 = ((q >> 4)   | (((qh >> (iv + qk / 2)) & 1) << 4)) - 16;
+                                sumi += v0 * a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i] +
+                                        v1 * a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i + qk / 2 * 4];
+                            }
+                        }
+                        sumf[m][j] += sumi * LM_GGML_CPU_FP16_TO_FP32(b_ptr[l].d[j]) * LM_GGML_CPU_FP16_TO_FP32(a_ptr[l].d[m]);
+                    }
+                }
+            }
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++)
+                    s[(y * 4 + m) * bs + x * ncols_interleaved + j] = sumf[m][j];
+            }
+        }
+    }
+}
+
 void lm_ggml_gemm_q4_K_8x4_q8_K_generic(int n, float * LM_GGML_RESTRICT s, size_t bs, const void * LM_GGML_RESTRICT vx, const void * LM_GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK_K;
     const int nb = n / qk;
@@ -2833,6 +3012,46 @@ static block_q4_0x16 make_block_q4_0x16(block_q4_0 * in, unsigned int blck_size_
     return out;
 }
 
+// same interleaving as make_block_q4_0x8, the nibbles stay unsigned
+static block_q4_1x8 make_block_q4_1x8(const block_q4_1 * in, unsigned int blck_size_interleave) {
+    block_q4_1x8 out;
+
+    for (int i = 0; i < 8; i++) {
+        out.d[i] = in[i].LM_GGML_COMMON_AGGR_U.LM_GGML_COMMON_AGGR_S.d;
+        out.m[i] = in[i].LM_GGML_COMMON_AGGR_U.LM_GGML_COMMON_AGGR_S.m;
+    }
+
+    const int end = QK4_1 * 4 / blck_size_interleave;
+    for (int i = 0; i < end; ++i) {
+        int src_id = i % 8;
+        int src_offset = (i / 8) * blck_size_interleave;
+        int dst_offset = i * blck_size_interleave;
+        memcpy(&out.qs[dst_offset], &in[src_id].qs[src_offset], blck_size_interleave);
+    }
+
+    return out;
+}
+
+// low nibbles interleaved like make_block_q4_0x8, the 5-th bits kept per source block
+static block_q5_0x8 make_block_q5_0x8(const block_q5_0 * in, unsigned int blck_size_interleave) {
+    block_q5_0x8 out;
+
+    for (int i = 0; i < 8; i++) {
+        out.d[i] = in[i].d;
+        memcpy(&out.qh[i * 4], in[i].qh, 4);
+    }
+
+    const int end = QK5_0 * 4 / blck_size_interleave;
+    for (int i = 0; i < end; ++i) {
+        int src_id = i % 8;
+        int src_offset = (i / 8) * blck_size_interleave;
+        int dst_offset = i * blck_size_interleave;
+        memcpy(&out.qs[dst_offset], &in[src_id].qs[src_offset], blck_size_interleave);
+    }
+
+    return out;
+}
+
 static block_q4_Kx8 make_block_q4_Kx8(block_q4_K * in, unsigned int blck_size_interleave) {
     block_q4_Kx8 out;
     //Delta(scale) and dmin values of the eight Q4_K structures are copied onto the output interleaved structure
@@ -3477,6 +3696,68 @@ static int repack_q4_0_to_q4_0_8_bl(struct lm_ggml_tensor * t, int interleave_bl
     LM_GGML_UNUSED(data_size);
 }
 
+static int repack_q4_1_to_q4_1_8_bl(struct lm_ggml_tensor * t, int interleave_block, const void * LM_GGML_RESTRICT data, size_t data_size) {
+    LM_GGML_ASSERT(t->type == LM_GGML_TYPE_Q4_1);
+    LM_GGML_ASSERT(interleave_block == 8);
+    constexpr int nrows_interleaved = 8;
+
+    block_q4_1x8 * dst = (block_q4_1x8 *) t->data;
+    const block_q4_1 * src = (const block_q4_1 *) data;
+    block_q4_1 dst_tmp[8];
+    int nrow = lm_ggml_nrows(t);
+    int nblocks = t->ne[0] / QK4_1;
+
+    LM_GGML_ASSERT(data_size == nrow * nblocks * sizeof(block_q4_1));
+
+    if (t->ne[1] % nrows_interleaved != 0 || t->ne[0] % 8 != 0) {
+        return -1;
+    }
+
+    for (int b = 0; b < nrow; b += nrows_interleaved) {
+        for (int64_t x = 0; x < nblocks; x++) {
+            for (int i = 0; i < nrows_interleaved; i++) {
+                dst_tmp[i] = src[x + i * nblocks];
+            }
+            *dst++ = make_block_q4_1x8(dst_tmp, interleave_block);
+        }
+        src += nrows_interleaved * nblocks;
+    }
+    return 0;
+
+    LM_GGML_UNUSED(data_size);
+}
+
+static int repack_q5_0_to_q5_0_8_bl(struct lm_ggml_tensor * t, int interleave_block, const void * LM_GGML_RESTRICT data, size_t data_size) {
+    LM_GGML_ASSERT(t->type == LM_GGML_TYPE_Q5_0);
+    LM_GGML_ASSERT(interleave_block == 8);
+    constexpr int nrows_interleaved = 8;
+
+    block_q5_0x8 * dst = (block_q5_0x8 *) t->data;
+    const block_q5_0 * src = (const block_q5_0 *) data;
+    block_q5_0 dst_tmp[8];
+    int nrow = lm_ggml_nrows(t);
+    int nblocks = t->ne[0] / QK5_0;
+
+    LM_GGML_ASSERT(data_size == nrow * nblocks * sizeof(block_q5_0));
+
+    if (t->ne[1] % nrows_interleaved != 0 || t->ne[0] % 8 != 0) {
+        return -1;
+    }
+
+    for (int b = 0; b < nrow; b += nrows_interleaved) {
+        for (int64_t x = 0; x < nblocks; x++) {
+            for (int i = 0; i < nrows_interleaved; i++) {
+                dst_tmp[i] = src[x + i * nblocks];
+            }
+            *dst++ = make_block_q5_0x8(dst_tmp, interleave_block);
+        }
+        src += nrows_interleaved * nblocks;
+    }
+    return 0;
+
+    LM_GGML_UNUSED(data_size);
+}
+
 static int repack_q8_0_to_q8_0_4_bl(struct lm_ggml_tensor *       t,
                                     int                        interleave_block,
                                     const void * LM_GGML_RESTRICT data,
@@ -3877,6 +4158,14 @@ template <> int repack<block_q4_0, 8, 8>(struct lm_ggml_tensor * t, const void *
     return repack_q4_0_to_q4_0_8_bl(t, 8, data, data_size);
 }
 
+template <> int repack<block_q4_1, 8, 8>(struct lm_ggml_tensor * t, const void * data, size_t data_size) {
+    return repack_q4_1_to_q4_1_8_bl(t, 8, data, data_size);
+}
+
+template <> int repack<block_q5_0, 8, 8>(struct lm_ggml_tensor * t, const void * data, size_t data_size) {
+    return repack_q5_0_to_q5_0_8_bl(t, 8, data, data_size);
+}
+
 template <> int repack<block_q4_K, 8, 8>(struct lm_ggml_tensor * t, const void * data, size_t data_size) {
     return repack_q4_K_to_q4_K_8_bl(t, 8, data, data_size);
 }
@@ -3972,6 +4261,14 @@ template <> void gemv<block_q4_0, 8, 8, LM_GGML_TYPE_Q8_0>(int n, float * s, siz
     lm_ggml_gemv_q4_0_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
 }
 
+template <> void gemv<block_q4_1, 8, 8, LM_GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    lm_ggml_gemv_q4_1_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemv<block_q5_0, 8, 8, LM_GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    lm_ggml_gemv_q5_0_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
+}
+
 template <>
 void gemv<block_q2_K, 8, 8, LM_GGML_TYPE_Q8_K>(int          n,
                                             float *      s,
@@ -4076,6 +4373,14 @@ void gemm<block_q4_0, 8, 8, LM_GGML_TYPE_Q8_0>(int          n,
     lm_ggml_gemm_q4_0_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
 }
 
+template <> void gemm<block_q4_1, 8, 8, LM_GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    lm_ggml_gemm_q4_1_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemm<block_q5_0, 8, 8, LM_GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    lm_ggml_gemm_q5_0_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
+}
+
 template <> void gemm<block_q2_K, 8, 8, LM_GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
     lm_ggml_gemm_q2_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
 }
@@ -4531,6 +4836,12 @@ static const ggml::cpu::tensor_traits * lm_ggml_repack_get_optimal_repack_type(c
     static const ggml::cpu::repack::tensor_traits<block_q4_0, 8, 4, LM_GGML_TYPE_Q8_0> q4_0_4x8_q8_0;
     static const ggml::cpu::repack::tensor_traits<block_q4_0, 8, 8, LM_GGML_TYPE_Q8_0> q4_0_8x8_q8_0;
 
+    // instance for Q4_1
+    static const ggml::cpu::repack::tensor_traits<block_q4_1, 8, 8, LM_GGML_TYPE_Q8_0> q4_1_8x8_q8_0;
+
+    // instance for Q5_0
+    static const ggml::cpu::repack::tensor_traits<block_q5_0, 8, 8, LM_GGML_TYPE_Q8_0> q5_0_8x8_q8_0;
+
     // instance for Q4_K
     static const ggml::cpu::repack::tensor_traits<block_q4_K, 4, 8, LM_GGML_TYPE_Q8_K> q4_K_8x4_q8_K;
     static const ggml::cpu::repack::tensor_traits<block_q4_K, 8, 8, LM_GGML_TYPE_Q8_K> q4_K_8x8_q8_K;
@@ -4597,6 +4908,18 @@ static const ggml::cpu::tensor_traits * lm_ggml_repack_get_optimal_repack_type(c
             }
             #endif
         }
+    } else if (cur->type == LM_GGML_TYPE_Q4_1) {
+        if (lm_ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &q4_1_8x8_q8_0;
+            }
+        }
+    } else if (cur->type == LM_GGML_TYPE_Q5_0) {
+        if (lm_ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &q5_0_8x8_q8_0;
+            }
+        }
     } else if (cur->type == LM_GGML_TYPE_Q4_K) {
         if (lm_ggml_cpu_has_avx2()) {
             if (cur->ne[1] % 8 == 0) {
@@ -4763,6 +5086,24 @@ static lm_ggml_backend_buffer_t lm_ggml_backend_cpu_repack_buffer_type_alloc_buf
     return buffer;
 }
 
+lm_ggml_backend_buffer_t lm_ggml_backend_cpu_repack_buffer_from_ptr(void * ptr, size_t size) {
+    lm_ggml_backend_buffer_t buffer = lm_ggml_backend_cpu_buffer_from_ptr(ptr, size);
+
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    // contents are already in the repacked layout and the memory may be read-only,
+    // so nothing may write to it after the tensors are placed
+    buffer->buft                = lm_ggml_backend_cpu_repack_buffer_type();
+    buffer->iface.init_tensor   = lm_ggml_backend_cpu_repack_buffer_init_tensor;
+    buffer->iface.memset_tensor = nullptr;
+    buffer->iface.set_tensor    = nullptr;
+    buffer->iface.get_tensor    = nullptr;
+    buffer->iface.cpy_tensor    = nullptr;
+    return buffer;
+}
+
 static size_t lm_ggml_backend_cpu_repack_buffer_type_get_alignment(lm_ggml_backend_buffer_type_t buft) {
     return TENSOR_ALIGNMENT;
 
@@ -213,6 +213,16 @@ namespace rnllama_jsi {
         timingsObj.setProperty(runtime, "predicted_per_token_ms", predicted_per_token_ms);
         timingsObj.setProperty(runtime, "predicted_per_second", predicted_per_second);
 
+        const auto draft_stats = common_speculative_get_adaptive_stats(ctx->completion->spec, 0);
+        if (draft_stats.n_draft >= 0) {
+            timingsObj.setProperty(runtime, "draft_n", (double)draft_stats.n_draft);
+            timingsObj.setProperty(runtime, "draft_acceptance", draft_stats.p_accept);
+            timingsObj.setProperty(runtime, "draft_per_token_ms", draft_stats.t_draft_per_token_ms);
+            timingsObj.setProperty(runtime, "verify_ms", draft_stats.t_verify_ms);
+            timingsObj.setProperty(runtime, "verify_per_token_ms", draft_stats.t_verify_per_token_ms);
+            timingsObj.setProperty(runtime, "draft_expected_per_second", draft_stats.expected_per_second);
+        }
+
         res.setProperty(runtime, "timings", timingsObj);
 
         return res;
@@ -267,6 +277,14 @@ namespace rnllama_jsi {
         timingsObj.setProperty(runtime, "predicted_ms", (double)timings.predicted_ms);
         timingsObj.setProperty(runtime, "predicted_per_token_ms", (double)timings.predicted_per_token_ms);
         timingsObj.setProperty(runtime, "predicted_per_second", (double)timings.predicted_per_second);
+        if (timings.draft_n >= 0) {
+            timingsObj.setProperty(runtime, "draft_n", (double)timings.draft_n);
+            timingsObj.setProperty(runtime, "draft_acceptance", (double)timings.draft_acceptance);
+            timingsObj.setProperty(runtime, "draft_per_token_ms", (double)timings.draft_per_token_ms);
+            timingsObj.setProperty(runtime, "verify_ms", (double)timings.verify_ms);
+            timingsObj.setProperty(runtime, "verify_per_token_ms", (double)timings.verify_per_token_ms);
+            timingsObj.setProperty(runtime, "draft_expected_per_second", (double)timings.draft_expected_per_second);
+        }
         res.setProperty(runtime, "timings", timingsObj);
 
         return res;
@@ -401,6 +419,14 @@ namespace rnllama_jsi {
         timings.setProperty(runtime, "predicted_ms", result.timings.predicted_ms);
         timings.setProperty(runtime, "predicted_per_token_ms", result.timings.predicted_per_token_ms);
         timings.setProperty(runtime, "predicted_per_second", result.timings.predicted_per_second);
+        if (result.timings.draft_n >= 0) {
+            timings.setProperty(runtime, "draft_n", (double)result.timings.draft_n);
+            timings.setProperty(runtime, "draft_acceptance", result.timings.draft_acceptance);
+            timings.setProperty(runtime, "draft_per_token_ms", result.timings.draft_per_token_ms);
+            timings.setProperty(runtime, "verify_ms", result.timings.verify_ms);
+            timings.setProperty(runtime, "verify_per_token_ms", result.timings.verify_per_token_ms);
+            timings.setProperty(runtime, "draft_expected_per_second", result.timings.draft_expected_per_second);
+        }
         res.setProperty(runtime, "timings", timings);
 
         return res;
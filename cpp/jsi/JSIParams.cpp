@@ -261,6 +261,30 @@ namespace rnllama_jsi {
                             applySpeculativeDraftOptions(runtime, draftValue.asObject(runtime), cparams.speculative.draft);
                         }
                     }
+                    if (speculative.hasProperty(runtime, "tree")) {
+                        auto treeValue = speculative.getProperty(runtime, "tree");
+                        if (treeValue.isObject()) {
+                            auto tree = treeValue.asObject(runtime);
+                            cparams.speculative.tree.n_branch = getPropertyAsInt(
+                                runtime, tree, "n_branch", cparams.speculative.tree.n_branch);
+                            cparams.speculative.tree.n_nodes = getPropertyAsInt(
+                                runtime, tree, "n_nodes", cparams.speculative.tree.n_nodes);
+                        }
+                    }
+                    if (speculative.hasProperty(runtime, "adaptive")) {
+                        auto adaptiveValue = speculative.getProperty(runtime, "adaptive");
+                        if (adaptiveValue.isBool()) {
+                            cparams.speculative.adaptive.enabled = adaptiveValue.getBool();
+                        } else if (adaptiveValue.isObject()) {
+                            auto adaptive = adaptiveValue.asObject(runtime);
+                            cparams.speculative.adaptive.enabled = getPropertyAsBool(
+                                runtime, adaptive, "enabled", true);
+                            cparams.speculative.adaptive.decay = getPropertyAsFloat(
+                                runtime, adaptive, "decay", cparams.speculative.adaptive.decay);
+                            cparams.speculative.adaptive.n_probe = getPropertyAsInt(
+                                runtime, adaptive, "n_probe", cparams.speculative.adaptive.n_probe);
+                        }
+                    }
                 }
             }
         }
@@ -287,6 +311,12 @@ namespace rnllama_jsi {
             runtime, params, "draft_model", cparams.speculative.draft.mparams.path);
         cparams.speculative.draft.n_gpu_layers = getPropertyAsInt(
             runtime, params, "spec_draft_n_gpu_layers", cparams.speculative.draft.n_gpu_layers);
+        cparams.speculative.tree.n_branch = getPropertyAsInt(
+            runtime, params, "spec_tree_n_branch", cparams.speculative.tree.n_branch);
+        cparams.speculative.tree.n_nodes = getPropertyAsInt(
+            runtime, params, "spec_tree_n_nodes", cparams.speculative.tree.n_nodes);
+        cparams.speculative.adaptive.enabled = getPropertyAsBool(
+            runtime, params, "spec_adaptive", cparams.speculative.adaptive.enabled);
 
         std::string draftCacheTypeK = getPropertyAsString(runtime, params, "spec_draft_cache_type_k");
         if (!draftCacheTypeK.empty()) {
@@ -371,6 +401,8 @@ namespace rnllama_jsi {
             cparams.load_mode = LLAMA_LOAD_MODE_NONE;
         }
         cparams.no_extra_bufts = getPropertyAsBool(runtime, params, "no_extra_bufts", cparams.no_extra_bufts);
+        cparams.repack_cache_dir = getPropertyAsString(runtime, params, "repack_cache_dir");
+        cparams.shared_compute_arena = getPropertyAsBool(runtime, params, "shared_compute_arena", cparams.shared_compute_arena);
 
         if (params.hasProperty(runtime, "flash_attn")) {
             bool fa = getPropertyAsBool(runtime, params, "flash_attn", false);
@@ -387,9 +419,14 @@ namespace rnllama_jsi {
         std::string cv = getPropertyAsString(runtime, params, "cache_type_v");
         if (!cv.empty()) cparams.cache_type_v = rnllama::kv_cache_type_from_str(cv);
 
+        cparams.cache_n_hot = getPropertyAsInt(runtime, params, "cache_n_hot", cparams.cache_n_hot);
+
         cparams.ctx_shift = getPropertyAsBool(runtime, params, "ctx_shift", cparams.ctx_shift);
+        cparams.n_sink = getPropertyAsInt(runtime, params, "n_sink", cparams.n_sink);
+        cparams.n_sink_evict = getPropertyAsInt(runtime, params, "n_sink_evict", cparams.n_sink_evict);
         cparams.kv_unified = getPropertyAsBool(runtime, params, "kv_unified", cparams.kv_unified);
         cparams.swa_full = getPropertyAsBool(runtime, params, "swa_full", cparams.swa_full);
+        cparams.defrag_thold = getPropertyAsFloat(runtime, params, "defrag_thold", cparams.defrag_thold);
 
         if (params.hasProperty(runtime, "embedding") && getPropertyAsBool(runtime, params, "embedding")) {
             cparams.embedding = true;
@@ -460,6 +497,8 @@ namespace rnllama_jsi {
         sparams.seed = getPropertyAsInt(runtime, params, "seed", -1);
         ctx->params.n_predict = getPropertyAsInt(runtime, params, "n_predict", ctx->params.n_predict);
         ctx->params.sampling.ignore_eos = getPropertyAsBool(runtime, params, "ignore_eos", ctx->params.sampling.ignore_eos);
+        ctx->params.n_sink = getPropertyAsInt(runtime, params, "n_sink", ctx->params.n_sink);
+        ctx->params.n_sink_evict = getPropertyAsInt(runtime, params, "n_sink_evict", ctx->params.n_sink_evict);
         ctx->params.embedding = getPropertyAsBool(runtime, params, "embedding", false);
         llama_set_embeddings(ctx->ctx, ctx->params.embedding);
         applySpeculativeOptions(runtime, params, ctx->params);
@@ -1244,12 +1244,16 @@ namespace rnllama_jsi {
                 bool enabled = getPropertyAsBool(runtime, params, "enabled", true);
                 int nParallel = getPropertyAsInt(runtime, params, "n_parallel", 2);
                 int nBatch = getPropertyAsInt(runtime, params, "n_batch", 512);
+                int spillMaxEntries = getPropertyAsInt(runtime, params, "spill_max_entries", 0);
+                double spillIdleMs = getPropertyAsDouble(runtime, params, "spill_idle_ms", 0);
+                std::string spillDir = getPropertyAsString(runtime, params, "spill_dir");
 
-                return createPromiseTask(runtime, callInvoker, [contextId, enabled, nParallel, nBatch]() -> PromiseResultGenerator {
+                return createPromiseTask(runtime, callInvoker, [contextId, enabled, nParallel, nBatch, spillMaxEntries, spillIdleMs, spillDir]() -> PromiseResultGenerator {
                     auto ctx = getContextOrThrow(contextId);
                     if (enabled) {
                         ctx->enableParallelMode(nParallel, nBatch);
                         if (ctx->slot_manager) {
+                            ctx->slot_manager->set_spill_config(spillMaxEntries, (int64_t) spillIdleMs, spillDir);
                             ctx->slot_manager->start_processing_loop();
                         }
                     } else {
@@ -2090,6 +2094,45 @@ namespace rnllama_jsi {
         );
         runtime.global().setProperty(runtime, "llamaDecodeAudioTokens", decodeAudioTokens);
 
+        auto decodeAudioTokensBatch = jsi::Function::createFromHostFunction(runtime,
+            jsi::PropNameID::forAscii(runtime, "llamaDecodeAudioTokensBatch"),
+            2,
+            [callInvoker](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments, size_t count) -> jsi::Value {
+                int contextId = (int)arguments[0].asNumber();
+                jsi::Array seqsArr = arguments[1].asObject(runtime).asArray(runtime);
+                std::vector<std::vector<llama_token>> tokens(seqsArr.size(runtime));
+                for (size_t k = 0; k < tokens.size(); k++) {
+                    jsi::Array tokensArr = seqsArr.getValueAtIndex(runtime, k).asObject(runtime).asArray(runtime);
+                    for (size_t i = 0; i < tokensArr.size(runtime); i++) {
+                        tokens[k].push_back((llama_token)tokensArr.getValueAtIndex(runtime, i).asNumber());
+                    }
+                }
+
+                return createPromiseTask(runtime, callInvoker, [contextId, tokens]() -> PromiseResultGenerator {
+                    auto ctx = getContextOrThrow(contextId);
+                    if (!ctx->isVocoderEnabled()) throw std::runtime_error("Vocoder is not enabled");
+
+                    try {
+                        auto audio_data = ctx->tts_wrapper->decodeAudioTokensBatch(ctx, tokens);
+                        return [audio_data](jsi::Runtime& rt) {
+                            jsi::Array out(rt, audio_data.size());
+                            for (size_t k = 0; k < audio_data.size(); k++) {
+                                jsi::Array res(rt, audio_data[k].size());
+                                for (size_t i = 0; i < audio_data[k].size(); i++) {
+                                    res.setValueAtIndex(rt, i, (double)audio_data[k][i]);
+                                }
+                                out.setValueAtIndex(rt, k, res);
+                            }
+                            return out;
+                        };
+                    } catch (const std::exception &e) {
+                        throw std::runtime_error(e.what());
+                    }
+                }, contextId);
+            }
+        );
+        runtime.global().setProperty(runtime, "llamaDecodeAudioTokensBatch", decodeAudioTokensBatch);
+
         // generateAudioCodes — drives the backbone + codec_lm AR loop for
         // codec_lm-flow models (CSM, etc.).  Args:
         //   (contextId, optsJson, onFrame?)
@@ -2176,6 +2219,153 @@ namespace rnllama_jsi {
         );
         runtime.global().setProperty(runtime, "llamaGenerateAudioCodes", generateAudioCodes);
 
+        // generateAudioCodesBatch — several utterances decoded as parallel
+        // backbone sequences.  Args: (contextId, optsJson) where optsJson is
+        // an array of generateAudioCodes option objects (no onFrame).
+        // Returns one result object per entry, in order.
+        auto generateAudioCodesBatch = jsi::Function::createFromHostFunction(runtime,
+            jsi::PropNameID::forAscii(runtime, "llamaGenerateAudioCodesBatch"),
+            2,
+            [callInvoker](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments, size_t count) -> jsi::Value {
+                int contextId = (int)arguments[0].asNumber();
+                std::string optsJson = arguments[1].asString(runtime).utf8(runtime);
+
+                return createPromiseTask(runtime, callInvoker, [contextId, optsJson]() -> PromiseResultGenerator {
+                    auto ctx = getContextOrThrow(contextId);
+                    if (!ctx->isVocoderEnabled()) throw std::runtime_error("Vocoder is not enabled");
+
+                    std::vector<rnllama::llama_rn_audio_codes_options> opts;
+                    try {
+                        auto arr = nlohmann::ordered_json::parse(optsJson);
+                        for (const auto & j : arr) {
+                            rnllama::llama_rn_audio_codes_options o;
+                            o.prompt      = j.value("prompt", std::string());
+                            o.max_frames  = j.value("maxFrames",   500);
+                            o.temperature = j.value("temperature", 0.9f);
+                            o.top_p       = j.value("topP",        0.95f);
+                            o.top_k       = j.value("topK",        50);
+                            o.seed        = j.value("seed",        0u);
+                            opts.push_back(std::move(o));
+                        }
+                    } catch (const std::exception &e) {
+                        throw std::runtime_error(std::string("invalid options JSON: ") + e.what());
+                    }
+                    for (const auto & o : opts) {
+                        if (o.prompt.empty()) {
+                            throw std::runtime_error("generateAudioCodesBatch: prompt is empty");
+                        }
+                    }
+
+                    try {
+                        auto results = ctx->tts_wrapper->generateAudioCodesBatch(ctx, opts);
+                        return [results](jsi::Runtime& rt) {
+                            jsi::Array out(rt, results.size());
+                            for (size_t k = 0; k < results.size(); ++k) {
+                                const auto & r = results[k];
+                                jsi::Object obj(rt);
+                                jsi::Array arr(rt, r.codes.size());
+                                for (size_t i = 0; i < r.codes.size(); ++i) {
+                                    arr.setValueAtIndex(rt, i, (double) r.codes[i]);
+                                }
+                                obj.setProperty(rt, "codes", arr);
+                                obj.setProperty(rt, "nCodebook",     jsi::Value((double) r.n_codebook));
+                                obj.setProperty(rt, "nFrames",       jsi::Value((double) r.n_frames));
+                                obj.setProperty(rt, "stoppedOnEos",  jsi::Value(r.stopped_on_eos));
+                                obj.setProperty(rt, "aborted",       jsi::Value(r.aborted));
+                                out.setValueAtIndex(rt, k, obj);
+                            }
+                            return out;
+                        };
+                    } catch (const std::exception &e) {
+                        throw std::runtime_error(e.what());
+                    }
+                }, contextId);
+            }
+        );
+        runtime.global().setProperty(runtime, "llamaGenerateAudioCodesBatch", generateAudioCodesBatch);
+
+        // synthesizeLongForm — sentence-segmented TTS with decode overlapped
+        // with generation.  Args: (contextId, optsJson, onChunk?)
+        // optsJson: { text?, segments?, speakerJson?, speakerId?, maxSegmentChars?,
+        //             nPredict?, temperature?, topP?, topK?, seed?, decodeThreads? }
+        // onChunk:  optional (segment:number, pcm:number[]) => void, fired in
+        //           segment order as each segment's audio is decoded.
+        // Returns { nSegments, nSamples, sampleRate, aborted }.
+        auto synthesizeLongForm = jsi::Function::createFromHostFunction(runtime,
+            jsi::PropNameID::forAscii(runtime, "llamaSynthesizeLongForm"),
+            3,
+            [callInvoker](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments, size_t count) -> jsi::Value {
+                int contextId = (int)arguments[0].asNumber();
+                std::string optsJson = arguments[1].asString(runtime).utf8(runtime);
+
+                std::shared_ptr<jsi::Function> onChunk;
+                if (count >= 3 && arguments[2].isObject() &&
+                    arguments[2].asObject(runtime).isFunction(runtime)) {
+                    onChunk = std::make_shared<jsi::Function>(
+                        arguments[2].asObject(runtime).asFunction(runtime));
+                }
+                jsi::Runtime * runtimePtr = &runtime;
+
+                return createPromiseTask(runtime, callInvoker, [contextId, optsJson, onChunk, runtimePtr, callInvoker]() -> PromiseResultGenerator {
+                    auto ctx = getContextOrThrow(contextId);
+                    if (!ctx->isVocoderEnabled()) throw std::runtime_error("Vocoder is not enabled");
+                    throwIfContextBusy(ctx);
+
+                    rnllama::llama_rn_long_form_tts_options opts;
+                    try {
+                        auto j = nlohmann::ordered_json::parse(optsJson);
+                        opts.text              = j.value("text", std::string());
+                        opts.segments          = j.value("segments", std::vector<std::string>());
+                        opts.speaker_json      = j.value("speakerJson", std::string());
+                        opts.speaker_id        = j.value("speakerId",       -1);
+                        opts.max_segment_chars = j.value("maxSegmentChars", 300);
+                        opts.n_predict         = j.value("nPredict",        -1);
+                        opts.temperature       = j.value("temperature",     0.9f);
+                        opts.top_p             = j.value("topP",            0.95f);
+                        opts.top_k             = j.value("topK",            50);
+                        opts.seed              = j.value("seed",            0u);
+                        opts.decode_threads    = j.value("decodeThreads",   0);
+                    } catch (const std::exception &e) {
+                        throw std::runtime_error(std::string("invalid options JSON: ") + e.what());
+                    }
+                    if (opts.text.empty() && opts.segments.empty()) {
+                        throw std::runtime_error("synthesizeLongForm: text is empty");
+                    }
+
+                    rnllama::llama_rn_audio_chunk_cb cb;
+                    if (onChunk) {
+                        cb = [onChunk, runtimePtr, callInvoker](int segment, const std::vector<float> &pcm) -> bool {
+                            std::vector<float> pcm_copy = pcm;
+                            callInvoker->invokeAsync([onChunk, runtimePtr, segment, pcm_copy]() {
+                                auto &rt = *runtimePtr;
+                                jsi::Array arr(rt, pcm_copy.size());
+                                for (size_t i = 0; i < pcm_copy.size(); ++i) {
+                                    arr.setValueAtIndex(rt, i, (double) pcm_copy[i]);
+                                }
+                                onChunk->call(rt, jsi::Value((double) segment), arr);
+                            });
+                            return true;
+                        };
+                    }
+
+                    try {
+                        auto r = ctx->tts_wrapper->synthesizeLongForm(ctx, opts, cb);
+                        return [r](jsi::Runtime& rt) {
+                            jsi::Object obj(rt);
+                            obj.setProperty(rt, "nSegments",  jsi::Value((double) r.n_segments));
+                            obj.setProperty(rt, "nSamples",   jsi::Value((double) r.n_samples));
+                            obj.setProperty(rt, "sampleRate", jsi::Value((double) r.sample_rate));
+                            obj.setProperty(rt, "aborted",    jsi::Value(r.aborted));
+                            return obj;
+                        };
+                    } catch (const std::exception &e) {
+                        throw std::runtime_error(e.what());
+                    }
+                }, contextId);
+            }
+        );
+        runtime.global().setProperty(runtime, "llamaSynthesizeLongForm", synthesizeLongForm);
+
         // llamaCreateSpeaker(ctxId, optsJson)
         //   optsJson: { pcm: number[], inputSampleRate: number, refText: string,
         //               bake: boolean, emotion?: number }
@@ -2293,6 +2483,87 @@ namespace rnllama_jsi {
         );
         runtime.global().setProperty(runtime, "llamaReleaseSpeaker", releaseSpeaker);
 
+        // llamaSaveSpeaker(ctxId, speakerId, path, includePcm)
+        // Bakes the speaker if needed and writes it as a speaker file.
+        // Resolves: boolean
+        auto saveSpeaker = jsi::Function::createFromHostFunction(runtime,
+            jsi::PropNameID::forAscii(runtime, "llamaSaveSpeaker"),
+            4,
+            [callInvoker](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments, size_t count) -> jsi::Value {
+                int contextId = (int)arguments[0].asNumber();
+                int speakerId = (int)arguments[1].asNumber();
+                std::string path = arguments[2].asString(runtime).utf8(runtime);
+                bool includePcm = count > 3 && arguments[3].isBool() && arguments[3].getBool();
+
+                return createPromiseTask(runtime, callInvoker, [contextId, speakerId, path, includePcm]() -> PromiseResultGenerator {
+                    auto ctx = getContextOrThrow(contextId);
+                    if (!ctx->isVocoderEnabled()) throw std::runtime_error("Vocoder is not enabled");
+
+                    const bool ok = ctx->tts_wrapper->saveSpeaker(ctx, speakerId, path, includePcm);
+
+                    return [ok](jsi::Runtime& rt) { return jsi::Value(ok); };
+                }, contextId);
+            }
+        );
+        runtime.global().setProperty(runtime, "llamaSaveSpeaker", saveSpeaker);
+
+        // llamaLoadSpeaker(ctxId, path)
+        // Registers a speaker file as a new baked speaker.
+        // Resolves: { id: number, family: string, rows: number, baked: boolean }
+        auto loadSpeaker = jsi::Function::createFromHostFunction(runtime,
+            jsi::PropNameID::forAscii(runtime, "llamaLoadSpeaker"),
+            2,
+            [callInvoker](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments, size_t count) -> jsi::Value {
+                int contextId = (int)arguments[0].asNumber();
+                std::string path = arguments[1].asString(runtime).utf8(runtime);
+
+                return createPromiseTask(runtime, callInvoker, [contextId, path]() -> PromiseResultGenerator {
+                    auto ctx = getContextOrThrow(contextId);
+                    if (!ctx->isVocoderEnabled()) throw std::runtime_error("Vocoder is not enabled");
+
+                    const int speakerId = ctx->tts_wrapper->loadSpeaker(ctx, path);
+                    if (speakerId < 0) {
+                        throw std::runtime_error("loadSpeaker: cannot load speaker file " + path);
+                    }
+                    std::string family = ctx->tts_wrapper->getTTSCapabilities(ctx).family;
+                    const rnllama::rn_speaker * spk = ctx->tts_wrapper->getSpeaker(speakerId);
+                    int rows = spk ? spk->rows : 0;
+
+                    return [speakerId, family, rows](jsi::Runtime& rt) {
+                        jsi::Object obj(rt);
+                        obj.setProperty(rt, "id",     jsi::Value((double) speakerId));
+                        obj.setProperty(rt, "family", jsi::String::createFromUtf8(rt, family));
+                        obj.setProperty(rt, "rows",   jsi::Value((double) rows));
+                        obj.setProperty(rt, "baked",  jsi::Value(true));
+                        return obj;
+                    };
+                }, contextId);
+            }
+        );
+        runtime.global().setProperty(runtime, "llamaLoadSpeaker", loadSpeaker);
+
+        // llamaSetSpeakerCacheDir(ctxId, dir)
+        // Directory bakeSpeaker reads / writes cached speaker files in; '' disables.
+        // Resolves: void
+        auto setSpeakerCacheDir = jsi::Function::createFromHostFunction(runtime,
+            jsi::PropNameID::forAscii(runtime, "llamaSetSpeakerCacheDir"),
+            2,
+            [callInvoker](jsi::Runtime& runtime, const jsi::Value& thisValue, const jsi::Value* arguments, size_t count) -> jsi::Value {
+                int contextId = (int)arguments[0].asNumber();
+                std::string dir = arguments[1].asString(runtime).utf8(runtime);
+
+                return createPromiseTask(runtime, callInvoker, [contextId, dir]() -> PromiseResultGenerator {
+                    auto ctx = getContextOrThrow(contextId);
+                    if (!ctx->isVocoderEnabled()) throw std::runtime_error("Vocoder is not enabled");
+
+                    ctx->tts_wrapper->speaker_cache_dir = dir;
+
+                    return [](jsi::Runtime& rt) { return jsi::Value::undefined(); };
+                }, contextId);
+            }
+        );
+        runtime.global().setProperty(runtime, "llamaSetSpeakerCacheDir", setSpeakerCacheDir);
+
         auto decodeAudioEmbeddings = jsi::Function::createFromHostFunction(runtime,
             jsi::PropNameID::forAscii(runtime, "llamaDecodeAudioEmbeddings"),
             3,
@@ -114,6 +114,7 @@ llama_context::llama_context(
     cparams.yarn_attn_factor        = params.yarn_attn_factor >= 0.0f ? params.yarn_attn_factor : hparams.yarn_attn_factor;
     cparams.yarn_beta_fast          = params.yarn_beta_fast   >= 0.0f ? params.yarn_beta_fast   : hparams.yarn_beta_fast;
     cparams.yarn_beta_slow          = params.yarn_beta_slow   >= 0.0f ? params.yarn_beta_slow   : hparams.yarn_beta_slow;
+    cparams.defrag_thold            = params.defrag_thold;
     cparams.embeddings              = params.embeddings;
     cparams.embeddings_nextn        = false;
     cparams.embeddings_nextn_masked = false;
@@ -141,6 +142,8 @@ llama_context::llama_context(
 
     cparams.ctx_other = nullptr;
 
+    compute_arena = params.compute_arena;
+
     // TODO: more generic
     if (model.arch == LLM_ARCH_GEMMA4_ASSISTANT) {
         if (params.ctx_other == nullptr) {
@@ -387,6 +390,7 @@ llama_context::llama_context(
         llama_memory_params params_mem = {
             /*.type_k    =*/ params.type_k,
             /*.type_v    =*/ params.type_v,
+            /*.n_kv_hot  =*/ params.n_kv_hot,
             /*.swa_full  =*/ params.swa_full,
             /*.ctx_type  =*/ cparams.ctx_type,
             /*.mem_other =*/ llama_get_memory(cparams.ctx_other),
@@ -416,6 +420,10 @@ llama_context::llama_context(
                 }
             }
 
+            if (backend_type == LM_GGML_BACKEND_DEVICE_TYPE_CPU && compute_arena) {
+                buft = lm_ggml_backend_arena_buffer_type(compute_arena);
+            }
+
             backend_buft.push_back(buft);
             backend_ptrs.push_back(backend.get());
             backend_buf_exp_size.push_back(0);
@@ -702,6 +710,30 @@ void llama_context::sched_reserve() {
             __func__, (t_end_us - t_start_us)/1000.0, lm_ggml_backend_sched_get_n_copies(sched.get()));
 }
 
+void llama_context::arena_acquire() {
+    if (!compute_arena) {
+        return;
+    }
+
+    if (lm_ggml_backend_arena_acquire(compute_arena, this) && gf_res_prev) {
+        // the previous graph's tensors were overwritten or moved by another arena user
+        gf_res_prev->reset();
+    }
+}
+
+void llama_context::arena_release() {
+    if (!compute_arena) {
+        return;
+    }
+
+    // outputs are read back before the next arena user may overwrite the compute buffer
+    if (sched) {
+        lm_ggml_backend_sched_synchronize(sched.get());
+    }
+
+    lm_ggml_backend_arena_release(compute_arena);
+}
+
 void llama_context::synchronize() {
     if (!sched) {
         return;
@@ -1150,6 +1182,20 @@ void llama_context::set_abort_callback(bool (*abort_callback)(void * data), void
     }
 }
 
+void llama_context::set_cpu_profiler(lm_ggml_cpu_profiler * profiler) {
+    LLAMA_LOG_DEBUG("%s: call\n", __func__);
+
+    if (backend_cpu == nullptr) {
+        return;
+    }
+
+    auto * reg = lm_ggml_backend_dev_backend_reg(lm_ggml_backend_get_device(backend_cpu));
+    auto * set_profiler_fn = (decltype(lm_ggml_backend_cpu_set_profiler) *) lm_ggml_backend_reg_get_proc_address(reg, "lm_ggml_backend_cpu_set_profiler");
+    if (set_profiler_fn) {
+        set_profiler_fn(backend_cpu, profiler);
+    }
+}
+
 void llama_context::set_embeddings(bool value) {
     LLAMA_LOG_DEBUG("%s: value = %d\n", __func__, value);
 
@@ -3255,6 +3301,9 @@ llama_memory_breakdown llama_context::memory_breakdown() const {
         for (const auto & [buft, size] : memory->memory_breakdown()) {
             ret[buft].context += size;
         }
+        for (const auto & [buft, size] : memory->memory_breakdown_frag()) {
+            ret[buft].context_frag += size;
+        }
     }
     if (model.hparams.no_alloc) {
         for (size_t i = 0; i < backends.size(); ++i) {
@@ -3533,6 +3582,8 @@ llama_context_params llama_context_default_params() {
         /*.sampler                     =*/ nullptr,
         /*.n_sampler                   =*/ 0,
         /*.ctx_other                   =*/ nullptr,
+        /*.n_kv_hot                    =*/ 0,
+        /*.compute_arena               =*/ nullptr,
     };
 
     return result;
@@ -3577,6 +3628,21 @@ llama_context * llama_init_from_model(
         return nullptr;
     }
 
+    // the two tiers of the K cache are attended separately and merged before the softmax, which needs the non-FA path
+    // only K is tiered: a quantized V cache needs flash attention, so it rules the hot window out
+    if (params.n_kv_hot > 0) {
+        if (!lm_ggml_is_quantized(params.type_k) || lm_ggml_is_quantized(params.type_v) || model->hparams.is_mla()) {
+            LLAMA_LOG_WARN("%s: n_kv_hot requires a quantized K cache with a non-quantized V cache - disabling\n", __func__);
+            params.n_kv_hot = 0;
+        } else if (params.flash_attn_type == LLAMA_FLASH_ATTN_TYPE_ENABLED) {
+            LLAMA_LOG_WARN("%s: n_kv_hot is not compatible with flash_attn - disabling\n", __func__);
+            params.n_kv_hot = 0;
+        } else if (params.flash_attn_type == LLAMA_FLASH_ATTN_TYPE_AUTO) {
+            LLAMA_LOG_WARN("%s: n_kv_hot is not compatible with flash_attn - disabling flash_attn (set it to enabled to keep it instead)\n", __func__);
+            params.flash_attn_type = LLAMA_FLASH_ATTN_TYPE_DISABLED;
+        }
+    }
+
     if (lm_ggml_is_quantized(params.type_v) && params.flash_attn_type != LLAMA_FLASH_ATTN_TYPE_ENABLED) {
         if (params.flash_attn_type == LLAMA_FLASH_ATTN_TYPE_AUTO) {
             LLAMA_LOG_INFO("%s: enabling flash_attn since it is required for quantized V cache\n", __func__);
@@ -3704,6 +3770,10 @@ void llama_set_abort_callback(llama_context * ctx, bool (*abort_callback)(void *
     ctx->set_abort_callback(abort_callback, abort_callback_data);
 }
 
+void llama_set_cpu_profiler(llama_context * ctx, lm_ggml_cpu_profiler * profiler) {
+    ctx->set_cpu_profiler(profiler);
+}
+
 void llama_set_embeddings(llama_context * ctx, bool embeddings) {
     ctx->set_embeddings(embeddings);
 }
@@ -3984,6 +4054,37 @@ bool llama_memory_can_shift(llama_memory_t mem) {
     return mem->get_can_shift();
 }
 
+llama_pos llama_memory_seq_evict_sink(
+        llama_memory_t mem,
+          llama_seq_id seq_id,
+             llama_pos n_sink,
+             llama_pos n_recent) {
+    if (!mem || !mem->get_can_shift()) {
+        return -1;
+    }
+
+    n_sink   = std::max<llama_pos>(0, n_sink);
+    n_recent = std::max<llama_pos>(0, n_recent);
+
+    const llama_pos p_max = mem->seq_pos_max(seq_id);
+
+    // first position of the recent window
+    const llama_pos p_recent = p_max + 1 - n_recent;
+    if (p_recent <= n_sink) {
+        return 0;
+    }
+
+    const llama_pos n_evict = p_recent - n_sink;
+
+    if (!mem->seq_rm(seq_id, n_sink, p_recent)) {
+        return -1;
+    }
+
+    mem->seq_add(seq_id, p_recent, -1, -n_evict);
+
+    return n_evict;
+}
+
 // llama state API
 
 // deprecated
@@ -4103,9 +4204,18 @@ size_t llama_state_seq_load_file(llama_context * ctx, const char * filepath, lla
 
 ///
 
+// holds the context's compute arena lease for the duration of a call
+struct llama_arena_lease {
+    explicit llama_arena_lease(llama_context * ctx) : ctx(ctx) { ctx->arena_acquire(); }
+    ~llama_arena_lease() { ctx->arena_release(); }
+
+    llama_context * ctx;
+};
+
 int32_t llama_encode(
         llama_context * ctx,
           llama_batch   batch) {
+    llama_arena_lease lease(ctx);
     const int ret = ctx->encode(batch);
     if (ret != 0) {
         LLAMA_LOG_ERROR("%s: failed to encode, ret = %d\n", __func__, ret);
@@ -4117,6 +4227,7 @@ int32_t llama_encode(
 int32_t llama_decode(
         llama_context * ctx,
           llama_batch   batch) {
+    llama_arena_lease lease(ctx);
     const int ret = ctx->decode(batch);
     if (ret != 0 && ret != 1) {
         LLAMA_LOG_ERROR("%s: failed to decode, ret = %d\n", __func__, ret);
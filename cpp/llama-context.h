@@ -112,6 +112,8 @@ struct llama_context {
 
     void set_abort_callback(bool (*abort_callback)(void * data), void * abort_callback_data);
 
+    void set_cpu_profiler(lm_ggml_cpu_profiler * profiler);
+
     void set_embeddings (bool value);
     void set_embeddings_nextn(bool value, bool masked);
     void set_embeddings_layer_inp(uint32_t lid, bool enable);
@@ -143,6 +145,10 @@ struct llama_context {
     int encode(const llama_batch & batch_inp);
     int decode(const llama_batch & batch_inp);
 
+    // lease on the shared compute arena (no-op without one), held by llama_encode/llama_decode
+    void arena_acquire();
+    void arena_release();
+
     //
     // state save/load
     //
@@ -364,6 +370,9 @@ private:
     std::vector<lm_ggml_backend_buffer_type_t> backend_buft;
     std::vector<size_t>                     backend_buf_exp_size; // expected buffer sizes
 
+    // shared host compute arena replacing the CPU compute buffer (not owned)
+    lm_ggml_backend_arena_t compute_arena = nullptr;
+
     llm_graph_result_ptr gf_res_prev;
     llm_graph_result_ptr gf_res_reserve;
 
@@ -32,6 +32,8 @@ struct llama_cparams {
     float yarn_beta_fast;
     float yarn_beta_slow;
 
+    float defrag_thold;
+
     bool embeddings;
     bool embeddings_nextn;        // also extract the hidden state before the final output norm
     bool embeddings_nextn_masked; // extract for only rows where batch.logits != 0
@@ -8,6 +8,8 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <vector>
 
 // Reserve a new compute graph. It is valid until the next call to llama_graph_reserve.
 LLAMA_API struct lm_ggml_cgraph * llama_graph_reserve(
@@ -59,6 +61,42 @@ LLAMA_API void llama_quant_compute_types(
         lm_ggml_type * result_types,
         size_t n_tensors);
 
+//
+// repacked weight cache (llama_model_params.repack_cache_dir)
+//
+
+struct llama_mmap;
+
+// Write the tensors of ctx, allocated in buf, as a cache image for key. Returns false on failure.
+LLAMA_API bool llama_repack_cache_save(
+        const char * path,
+          uint64_t key,
+        struct lm_ggml_context * ctx,
+        lm_ggml_backend_buffer_t buf);
+
+// Map a cache image written for key and place every tensor of ctx in a buffer of buft wrapping it.
+// The mapping is appended to mappings and must outlive the buffer. Returns NULL on any mismatch.
+LLAMA_API lm_ggml_backend_buffer_t llama_repack_cache_load(
+        const char * path,
+          uint64_t key,
+        struct lm_ggml_context * ctx,
+        lm_ggml_backend_buffer_type_t buft,
+        std::vector<std::unique_ptr<llama_mmap>> & mappings);
+
+//
+// memory policies
+//
+
+// StreamingLLM-style eviction ("attention sinks"): keep the first n_sink positions and the most recent
+// n_recent positions of the sequence, drop the positions in between and re-base the recent window so that
+// it directly follows the sinks. The RoPE of the moved keys is corrected by the K-shift on the next decode.
+// Returns the number of evicted positions (0 if the sequence already fits), or -1 if the memory cannot shift.
+LLAMA_API llama_pos llama_memory_seq_evict_sink(
+        llama_memory_t mem,
+          llama_seq_id seq_id,
+             llama_pos n_sink,
+             llama_pos n_recent);
+
 //
 // device memory querying
 //
@@ -69,6 +107,8 @@ struct llama_memory_breakdown_data {
     size_t context = 0; // memory allocated for the context
     size_t compute = 0; // memory allocated for temporary compute buffers
 
+    size_t context_frag = 0; // part of `context` held by KV holes below the highest used cell
+
     size_t total() const {
         return model + context + compute;
     }
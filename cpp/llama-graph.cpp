@@ -2506,7 +2506,8 @@ lm_ggml_tensor * llm_graph_context::build_attn_mha(
          lm_ggml_tensor * sinks,
          lm_ggml_tensor * v_mla,
                float   kq_scale,
-                 int   il) const {
+                 int   il,
+         lm_ggml_tensor * k_cold) const {
     const bool v_trans = v->nb[1] > v->nb[2];
 
     // split the batch into streams if needed
@@ -2523,6 +2524,7 @@ lm_ggml_tensor * llm_graph_context::build_attn_mha(
     const bool use_flash_attn = cparams.flash_attn && kq_b == nullptr;
     if (use_flash_attn) {
         LM_GGML_ASSERT(kq_b == nullptr && "Flash attention does not support KQ bias yet");
+        LM_GGML_ASSERT(k_cold == nullptr && "Flash attention does not support a two-tier KV cache");
 
         if (v_trans) {
             v = lm_ggml_transpose(ctx0, v);
@@ -2570,6 +2572,17 @@ lm_ggml_tensor * llm_graph_context::build_attn_mha(
         //       while for some models F16 is enough, for others it is not, so we default to F32 here
         lm_ggml_mul_mat_set_prec(kq, LM_GGML_PREC_F32);
 
+        // [TAG_KV_CACHE_TIERS] the quantized keys are read in place, the scores of both tiers are joined in cell order
+        if (k_cold) {
+            k_cold = lm_ggml_permute(ctx0, k_cold, 0, 2, 1, 3);
+
+            lm_ggml_tensor * kq_cold = lm_ggml_mul_mat(ctx0, k_cold, q);
+            lm_ggml_mul_mat_set_prec(kq_cold, LM_GGML_PREC_F32);
+
+            kq = lm_ggml_concat(ctx0, kq, kq_cold, 0);
+            cb(kq, "kq_tiers", il);
+        }
+
         if (arch == LLM_ARCH_GROK) {
             // need to do the following:
             // multiply by attn_output_multiplier
@@ -2782,6 +2795,11 @@ lm_ggml_tensor * llm_graph_context::build_attn(
 
         lm_ggml_build_forward_expand(gf, mctx_cur->cpy_k(ctx0, k_cur, k_idxs, il));
         lm_ggml_build_forward_expand(gf, mctx_cur->cpy_v(ctx0, v_cur, v_idxs, il));
+
+        // two-tier cache: the new keys of the hot cells go to the F16 tier
+        if (auto * k_hot = mctx_cur->cpy_k_hot(ctx0, k_cur, k_idxs, il)) {
+            lm_ggml_build_forward_expand(gf, k_hot);
+        }
     }
 
     lm_ggml_tensor * kq_mask = inp->get_kq_mask();
@@ -2790,7 +2808,9 @@ lm_ggml_tensor * llm_graph_context::build_attn(
     lm_ggml_tensor * k = mctx_cur->get_k(ctx0, il);
     lm_ggml_tensor * v = mctx_cur->get_v(ctx0, il);
 
-    lm_ggml_tensor * cur = build_attn_mha(q, k, v, kq_b, kq_mask, sinks, v_mla, kq_scale, il);
+    lm_ggml_tensor * k_cold = mctx_cur->get_k_cold(ctx0, il);
+
+    lm_ggml_tensor * cur = build_attn_mha(q, k, v, kq_b, kq_mask, sinks, v_mla, kq_scale, il, k_cold);
     cb(cur, "kqv_out", il);
 
     if (inp->self_v_rot) {
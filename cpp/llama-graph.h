@@ -1138,7 +1138,8 @@ struct llm_graph_context {
             lm_ggml_tensor * sinks,   // [n_head_q]
             lm_ggml_tensor * v_mla,   // [n_embd_head_v_mla, n_embd_head_v, n_head_v]
                   float   kq_scale,
-                    int   il) const;
+                    int   il,
+            lm_ggml_tensor * k_cold = nullptr) const; // two-tier KV cache: the keys of the cells after k
 
     llm_graph_input_attn_no_cache * build_attn_inp_no_cache() const;
 
@@ -156,6 +156,14 @@ std::map<lm_ggml_backend_buffer_type_t, size_t> llama_kv_cache_iswa::memory_brea
     return mb;
 }
 
+std::map<lm_ggml_backend_buffer_type_t, size_t> llama_kv_cache_iswa::memory_breakdown_frag() const {
+    std::map<lm_ggml_backend_buffer_type_t, size_t> mb = kv_base->memory_breakdown_frag();
+    for (const auto & buft_size : kv_swa->memory_breakdown_frag()) {
+        mb[buft_size.first] += buft_size.second;
+    }
+    return mb;
+}
+
 llama_memory_context_ptr llama_kv_cache_iswa::init_batch(llama_batch_allocr & balloc, uint32_t n_ubatch, bool embd_all) {
     LM_GGML_UNUSED(embd_all);
 
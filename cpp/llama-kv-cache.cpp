@@ -9,6 +9,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <functional>
 #include <limits>
 #include <map>
 #include <stdexcept>
@@ -77,7 +78,8 @@ llama_kv_cache::llama_kv_cache(
            llama_memory_t   mem_other,
     const layer_filter_cb & filter,
     const  layer_reuse_cb & reuse,
-    const  layer_share_cb & share) :
+    const  layer_share_cb & share,
+                 uint32_t   n_hot_seq) :
     model(model), hparams(hparams), v_trans(v_trans),
     n_seq_max(n_seq_max), n_stream(unified ? 1 : n_seq_max), n_pad(n_pad), n_swa(n_swa), swa_type(swa_type),
     other(static_cast<llama_kv_cache *>(mem_other)),
@@ -97,6 +99,34 @@ llama_kv_cache::llama_kv_cache(
 
     LM_GGML_ASSERT(kv_size % n_pad == 0);
 
+    // [TAG_KV_CACHE_TIERS]
+    if (other) {
+        // the cells are shared, so the hot range must match the source cache
+        n_hot     = other->n_hot;
+        n_hot_win = other->n_hot_win;
+        n_hot_mig = other->n_hot_mig;
+    } else if (n_hot_seq > 0 && lm_ggml_is_quantized(type_k)) {
+        const uint32_t n_seq_stream = unified ? n_seq_max : 1;
+
+        // leave room for a migration batch on top of the per-sequence windows
+        n_hot_win = n_hot_seq;
+        n_hot_mig = std::max(32u, n_hot_seq/8);
+        n_hot     = LM_GGML_PAD(n_hot_seq*n_seq_stream + n_hot_mig, 256u);
+
+        // the tiers are attended separately and merged before the softmax, which flash attention cannot do
+        if (!v_trans || hparams.is_mla()) {
+            LLAMA_LOG_WARN("%s: the hot window requires non-FA attention without MLA - using a single tier\n", __func__);
+            n_hot     = 0;
+            n_hot_win = 0;
+            n_hot_mig = 0;
+        } else if (n_hot >= kv_size) {
+            LLAMA_LOG_WARN("%s: hot window (%u cells) covers the whole cache - using a single tier\n", __func__, n_hot);
+            n_hot     = 0;
+            n_hot_win = 0;
+            n_hot_mig = 0;
+        }
+    }
+
     const uint32_t n_layer = hparams.n_layer_all;
 
     // define a comparator for the buft -> ctx map to ensure that the order is well-defined:
@@ -112,7 +142,7 @@ llama_kv_cache::llama_kv_cache(
         auto it = ctx_map.find(buft);
         if (it == ctx_map.end()) {
             lm_ggml_init_params params = {
-                /*.mem_size   =*/ size_t(2u*(1 + n_stream)*n_layer*lm_ggml_tensor_overhead()),
+                /*.mem_size   =*/ size_t((n_hot > 0 ? 3u : 2u)*(1 + n_stream)*n_layer*lm_ggml_tensor_overhead()),
                 /*.mem_buffer =*/ NULL,
                 /*.no_alloc   =*/ true,
             };
@@ -228,7 +258,7 @@ llama_kv_cache::llama_kv_cache(
         const bool has_k = true;
         const bool has_v = !is_mla;
 
-        lm_ggml_tensor * k = has_k ? lm_ggml_new_tensor_3d(ctx, type_k, n_embd_k_gqa, kv_size, n_stream) : nullptr;
+        lm_ggml_tensor * k = has_k ? lm_ggml_new_tensor_3d(ctx, type_k, n_embd_k_gqa, k_rows(),  n_stream) : nullptr;
         lm_ggml_tensor * v = has_v ? lm_ggml_new_tensor_3d(ctx, type_v, n_embd_v_gqa, kv_size, n_stream) : nullptr;
 
         has_k && lm_ggml_format_name(k, "cache_k_l%d", il);
@@ -238,13 +268,28 @@ llama_kv_cache::llama_kv_cache(
         std::vector<lm_ggml_tensor *> v_stream;
 
         for (uint32_t s = 0; s < n_stream; ++s) {
-            k_stream.push_back(has_k ? lm_ggml_view_2d(ctx, k, n_embd_k_gqa, kv_size, k->nb[1], s*k->nb[2]) : nullptr);
+            k_stream.push_back(has_k ? lm_ggml_view_2d(ctx, k, n_embd_k_gqa, k_rows(),  k->nb[1], s*k->nb[2]) : nullptr);
             v_stream.push_back(has_v ? lm_ggml_view_2d(ctx, v, n_embd_v_gqa, kv_size, v->nb[1], s*v->nb[2]) : nullptr);
         }
 
+        // [TAG_KV_CACHE_TIERS]
+        // the keys of the hot cells live in the F16 tensor only, the quantized tensor holds the other cells - each
+        // tensor has one extra scratch row per stream that receives the tokens placed in the other tier
+        const bool has_k_hot = has_k && n_hot > 0;
+
+        lm_ggml_tensor * k_hot = has_k_hot ? lm_ggml_new_tensor_3d(ctx, LM_GGML_TYPE_F16, n_embd_k_gqa, n_hot + 1, n_stream) : nullptr;
+
+        has_k_hot && lm_ggml_format_name(k_hot, "cache_k_hot_l%d", il);
+
+        std::vector<lm_ggml_tensor *> k_hot_stream;
+
+        for (uint32_t s = 0; s < n_stream; ++s) {
+            k_hot_stream.push_back(has_k_hot ? lm_ggml_view_2d(ctx, k_hot, n_embd_k_gqa, n_hot + 1, k_hot->nb[1], s*k_hot->nb[2]) : nullptr);
+        }
+
         map_layer_ids[il] = layers.size();
 
-        layers.push_back({ il, k, v, k_stream, v_stream, });
+        layers.push_back({ il, k, v, k_stream, v_stream, k_hot, k_hot_stream, });
     }
 
     if (reuse) {
@@ -300,6 +345,10 @@ llama_kv_cache::llama_kv_cache(
                 (float)(memory_size_k + memory_size_v) / (1024.0f * 1024.0f), kv_size, (int) layers.size(), n_seq_max, n_stream,
                 lm_ggml_type_name(type_k), (float)memory_size_k / (1024.0f * 1024.0f),
                 lm_ggml_type_name(type_v), (float)memory_size_v / (1024.0f * 1024.0f));
+
+        if (n_hot > 0) {
+            LLAMA_LOG_INFO("%s: hot tier = %u cells (F16), migration batch = %u cells\n", __func__, n_hot, n_hot_mig);
+        }
     }
 
     // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
@@ -736,12 +785,45 @@ llama_memory_context_ptr llama_kv_cache::init_full() {
     return std::make_unique<llama_kv_cache_context>(this);
 }
 
-llama_memory_context_ptr llama_kv_cache::init_update(llama_context * lctx, bool optimize) {
-    LM_GGML_UNUSED(optimize);
+std::map<lm_ggml_backend_buffer_type_t, size_t> llama_kv_cache::memory_breakdown_frag() const {
+    std::map<lm_ggml_backend_buffer_type_t, size_t> ret;
+
+    // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
+    if (other) {
+        return ret;
+    }
 
+    // the cells of all streams have the same size, so the holes map proportionally onto the buffers
+    uint64_t n_holes = 0;
+    for (uint32_t s = 0; s < n_stream; ++s) {
+        const auto & cells = v_cells[s];
+
+        n_holes += std::max(cells.used_max_p1(), n_hot) - n_hot - get_used_cold(s);
+    }
+
+    if (n_holes == 0) {
+        return ret;
+    }
+
+    const uint64_t n_cells = (uint64_t) get_size()*n_stream;
+
+    for (const auto & [buft, size] : memory_breakdown()) {
+        ret[buft] += (size_t) ((uint64_t) size*n_holes/n_cells);
+    }
+
+    return ret;
+}
+
+llama_memory_context_ptr llama_kv_cache::init_update(llama_context * lctx, bool optimize) {
     bool do_shift = get_has_shift();
 
-    return std::make_unique<llama_kv_cache_context>(this, lctx, do_shift, std::move(sc_info));
+    // migrating the hot cells also fills the holes at the start of the quantized cells, so compact only if idle
+    defrag_info dinfo = tier_prepare(lctx);
+    if (dinfo.empty()) {
+        dinfo = defrag_prepare(lctx, optimize);
+    }
+
+    return std::make_unique<llama_kv_cache_context>(this, lctx, do_shift, std::move(dinfo), std::move(sc_info));
 }
 
 llama_kv_cache::slot_info_vec_t llama_kv_cache::prepare(const std::vector<llama_ubatch> & ubatches) {
@@ -810,7 +892,7 @@ llama_kv_cache::slot_info_vec_t llama_kv_cache::prepare(const std::vector<llama_
     return res;
 }
 
-bool llama_kv_cache::update(llama_context * lctx, bool do_shift, const stream_copy_info & sc_info) {
+bool llama_kv_cache::update(llama_context * lctx, bool do_shift, const defrag_info & dinfo, const stream_copy_info & sc_info) {
     // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
     if (other) {
         return true;
@@ -846,6 +928,10 @@ bool llama_kv_cache::update(llama_context * lctx, bool do_shift, const stream_co
                 if (layer.v_stream[ssrc]) {
                     lm_ggml_backend_tensor_copy(layer.v_stream[ssrc], layer.v_stream[sdst]);
                 }
+
+                if (layer.k_hot) {
+                    lm_ggml_backend_tensor_copy(layer.k_hot_stream[ssrc], layer.k_hot_stream[sdst]);
+                }
             }
         }
     }
@@ -888,9 +974,313 @@ bool llama_kv_cache::update(llama_context * lctx, bool do_shift, const stream_co
         }
     }
 
+    if (!dinfo.empty()) {
+        LLAMA_LOG_DEBUG("%s: compacting KV cells (%zu moves)\n", __func__, dinfo.moves.size());
+
+        lm_ggml_backend_sched_reset(sched);
+
+        auto * res = lctx->get_gf_res_reserve();
+
+        res->reset();
+
+        auto * gf = build_graph_defrag(res, dinfo);
+        if (!lm_ggml_backend_sched_alloc_graph(sched, gf)) {
+            LLAMA_LOG_ERROR("%s: failed to allocate compute graph for KV compaction\n", __func__);
+            return updated;
+        }
+
+        if (lctx->graph_compute(gf, false) != LM_GGML_STATUS_SUCCESS) {
+            LLAMA_LOG_ERROR("%s: failed to compute KV compaction\n", __func__);
+            return updated;
+        }
+
+        // the data is in place - move the cell meta data along with it
+        for (const auto & mv : dinfo.moves) {
+            auto & cells = v_cells[mv.strm];
+
+            for (uint32_t j = 0; j < mv.len; ++j) {
+                cells.mv(mv.src + j, mv.dst + j);
+            }
+
+            // the holes are now at the end of the used range - restart the slot search from the beginning
+            v_heads[mv.strm] = 0;
+        }
+
+        updated = true;
+    }
+
     return updated;
 }
 
+float llama_kv_cache::get_fragmentation() const {
+    float res = 0.0f;
+
+    for (uint32_t s = 0; s < n_stream; ++s) {
+        const auto & cells = v_cells[s];
+
+        // [TAG_KV_CACHE_TIERS] only the quantized cells of a two-tier cache count, see defrag_prepare()
+        const uint32_t n_kv = cells.used_max_p1();
+        if (n_kv <= n_hot) {
+            continue;
+        }
+
+        res = std::max(res, 1.0f - float(get_used_cold(s))/(n_kv - n_hot));
+    }
+
+    return res;
+}
+
+uint32_t llama_kv_cache::get_used_cold(uint32_t strm) const {
+    const auto & cells = v_cells[strm];
+
+    uint32_t n_used_hot = 0;
+    for (uint32_t i = 0; i < n_hot; ++i) {
+        n_used_hot += !cells.is_empty(i);
+    }
+
+    return cells.get_used() - n_used_hot;
+}
+
+llama_kv_cache::defrag_info llama_kv_cache::defrag_prepare(const llama_context * lctx, bool force) const {
+    defrag_info res;
+
+    // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
+    //       a cache that shares its cells with another cache cannot move them without moving the other's data too
+    if (other || v_cells_impl.use_count() > 1) {
+        return res;
+    }
+
+    const float thold = lctx->get_cparams().defrag_thold;
+    if (!force && (thold <= 0.0f || get_fragmentation() <= thold)) {
+        return res;
+    }
+
+    // holes are worth reclaiming only if they would shrink the padded n_kv (see get_n_kv())
+    const uint32_t n_pad_cur = std::max(n_pad, 256u);
+
+    const uint32_t max_moves = defrag_max_moves(lctx);
+
+    // cap the number of cells moved per update so that compaction of a large cache is spread over several decodes
+    const uint32_t max_cells = force ? get_size() : std::max(n_pad_cur, get_size()/8);
+
+    for (uint32_t s = 0; s < n_stream && res.moves.size() < max_moves; ++s) {
+        const auto & cells = v_cells[s];
+
+        // [TAG_KV_CACHE_TIERS] the quantized cells of a two-tier cache are compacted among themselves - the free hot
+        // cells are not holes, they receive the next tokens, and moving old cells into them would undo the tiering
+        const uint32_t i_beg = n_hot;
+
+        const uint32_t n_kv = cells.used_max_p1();
+        if (n_kv <= i_beg) {
+            continue;
+        }
+
+        // end of the compacted range
+        const uint32_t n_used = i_beg + get_used_cold(s);
+
+        if (n_kv == n_used) {
+            continue;
+        }
+
+        if (!force) {
+            const float frag = 1.0f - float(n_used - i_beg)/(n_kv - i_beg);
+
+            if (n_kv - n_used < n_pad_cur || frag <= thold) {
+                continue;
+            }
+        }
+
+        // planned occupancy of the cells [0, n_kv)
+        std::vector<bool> occ(n_kv);
+        for (uint32_t i = 0; i < n_kv; ++i) {
+            occ[i] = !cells.is_empty(i);
+        }
+
+        uint32_t n_cells = 0;
+
+        // fill the holes in [i_beg, n_used) with blocks taken from the end of the used range
+        uint32_t i0 = i_beg;
+        uint32_t i1 = n_kv - 1;
+
+        while (res.moves.size() < max_moves && n_cells < max_cells) {
+            while (i0 < n_used && occ[i0]) {
+                i0++;
+            }
+
+            if (i0 >= n_used) {
+                break;
+            }
+
+            while (!occ[i1]) {
+                i1--;
+            }
+
+            // the number of holes below n_used always matches the number of used cells above it
+            LM_GGML_ASSERT(i1 >= n_used && "KV compaction bug: no used cell above the hole");
+
+            uint32_t len = 1;
+            while (i0 + len < n_used && !occ[i0 + len] && i1 - len >= n_used && occ[i1 - len] && n_cells + len < max_cells) {
+                len++;
+            }
+
+            const uint32_t src = i1 - len + 1;
+
+            res.moves.push_back({ s, src, i0, len });
+
+            for (uint32_t j = 0; j < len; ++j) {
+                occ[src + j] = false;
+                occ[i0  + j] = true;
+            }
+
+            n_cells += len;
+
+            i0 += len;
+            i1  = src - 1;
+        }
+
+        LLAMA_LOG_DEBUG("%s: stream[%d]: n_kv = %u, used = %u, moving %u cells\n", __func__, s, n_kv, n_used, n_cells);
+    }
+
+    return res;
+}
+
+uint32_t llama_kv_cache::defrag_max_moves(const llama_context * lctx) const {
+    // each move requires 6 tensors per layer (src view, dst view and copy for both K and V)
+    // with two tiers, a K move is split in up to 3 parts at the end of the hot range, each with a possible cast
+    const uint32_t n_per_move = n_hot > 0 ? 15 : 6;
+
+    const uint32_t n_layer = layers.size();
+    const int64_t  n_nodes = lctx->get_gf_res_reserve()->get_max_nodes() - 2*n_layer;
+
+    return n_layer > 0 && n_nodes > 0 ? n_nodes/(n_per_move*n_layer) : 0;
+}
+
+llama_kv_cache::defrag_info llama_kv_cache::tier_prepare(const llama_context * lctx) const {
+    defrag_info res;
+
+    // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
+    if (n_hot == 0 || other || v_cells_impl.use_count() > 1) {
+        return res;
+    }
+
+    const uint32_t max_moves = defrag_max_moves(lctx);
+
+    // coalesce the runs of consecutive cells into a single move
+    auto add_moves = [&](uint32_t s, const std::vector<uint32_t> & src, const std::vector<uint32_t> & dst) {
+        for (uint32_t j = 0; j < src.size() && res.moves.size() < max_moves; ) {
+            uint32_t len = 1;
+            while (j + len < src.size() && src[j + len] == src[j] + len && dst[j + len] == dst[j] + len) {
+                len++;
+            }
+
+            res.moves.push_back({ s, src[j], dst[j], len });
+
+            j += len;
+        }
+    };
+
+    // the n_mig cells with the smallest (asc) or largest (!asc) age, in cell order
+    auto pick = [](std::vector<std::pair<llama_pos, uint32_t>> & cand, uint32_t n_mig, bool asc) {
+        if (asc) {
+            std::partial_sort(cand.begin(), cand.begin() + n_mig, cand.end());
+        } else {
+            std::partial_sort(cand.begin(), cand.begin() + n_mig, cand.end(), std::greater<>());
+        }
+
+        std::vector<uint32_t> idxs(n_mig);
+        for (uint32_t j = 0; j < n_mig; ++j) {
+            idxs[j] = cand[j].second;
+        }
+        std::sort(idxs.begin(), idxs.end());
+
+        return idxs;
+    };
+
+    for (uint32_t s = 0; s < n_stream && res.moves.size() < max_moves; ++s) {
+        const auto & cells = v_cells[s];
+
+        // age of a cell = distance to the last position of its most recent sequence
+        auto age = [&](uint32_t i) {
+            const llama_pos pos = cells.pos_get(i);
+
+            if (cells.seq_count(i) == 1) {
+                return cells.seq_pos_max(cells.seq_get(i)) - pos;
+            }
+
+            llama_pos a = std::numeric_limits<llama_pos>::max();
+            for (llama_seq_id seq_id = 0; seq_id < LLAMA_MAX_SEQ; ++seq_id) {
+                if (cells.seq_has(i, seq_id)) {
+                    a = std::min(a, cells.seq_pos_max(seq_id) - pos);
+                }
+            }
+
+            return a;
+        };
+
+        // the hot cells that left the window of their sequences
+        std::vector<std::pair<llama_pos, uint32_t>> hot_old;
+        std::vector<uint32_t> hot_free;
+
+        for (uint32_t i = 0; i < n_hot; ++i) {
+            if (cells.is_empty(i)) {
+                hot_free.push_back(i);
+            } else if (const llama_pos a = age(i); a >= (llama_pos) n_hot_win) {
+                hot_old.emplace_back(a, i);
+            }
+        }
+
+        // the quantized cells inside the window - the tokens that find_slot() could not place in a hot cell
+        std::vector<std::pair<llama_pos, uint32_t>> cold_new;
+
+        for (uint32_t i = n_hot; i < cells.used_max_p1(); ++i) {
+            if (cells.is_empty(i)) {
+                continue;
+            }
+
+            if (const llama_pos a = age(i); a < (llama_pos) n_hot_win) {
+                cold_new.emplace_back(a, i);
+            }
+        }
+
+        // the newest of them move up into the free hot cells (their keys were quantized once on the way)
+        const uint32_t n_up = std::min(hot_free.size(), cold_new.size());
+
+        std::vector<uint32_t> up_src = pick(cold_new, n_up, true);
+        std::vector<uint32_t> up_dst(hot_free.begin(), hot_free.begin() + n_up);
+
+        // the oldest hot cells move down in batches, so that the graphs are not rebuilt on every token
+        // note: a plan never reuses a cell that it frees, so all moves of a stream can go into the same graph
+        const uint32_t n_free = hot_free.size() - n_up;
+
+        std::vector<uint32_t> down_src;
+        std::vector<uint32_t> down_dst;
+
+        if (n_free < n_hot_mig && !hot_old.empty()) {
+            for (uint32_t i = n_hot; i < cells.size() && n_free + down_dst.size() < 2*n_hot_mig; ++i) {
+                if (cells.is_empty(i)) {
+                    down_dst.push_back(i);
+                }
+            }
+
+            const uint32_t n_down = std::min(down_dst.size(), hot_old.size());
+
+            down_src = pick(hot_old, n_down, false);
+            down_dst.resize(n_down);
+        }
+
+        if (up_src.empty() && down_src.empty()) {
+            continue;
+        }
+
+        add_moves(s, down_src, down_dst);
+        add_moves(s, up_src,   up_dst);
+
+        LLAMA_LOG_DEBUG("%s: stream[%d]: hot free = %zu, moving %zu cells down and %zu cells up\n", __func__, s, hot_free.size(), down_src.size(), up_src.size());
+    }
+
+    return res;
+}
+
 llama_kv_cache::slot_info llama_kv_cache::find_slot(const llama_ubatch & ubatch, bool cont) const {
 
     if (debug > 0) {
@@ -1009,14 +1399,34 @@ llama_kv_cache::slot_info llama_kv_cache::find_slot(const llama_ubatch & ubatch,
 
         uint32_t n_tested = 0;
 
+        // [TAG_KV_CACHE_TIERS] the free hot cells take the newest tokens of the ubatch (the tokens of a sequence come
+        // in position order) and the search below places the others in the quantized cells
+        std::vector<uint32_t> idxs_hot;
+
+        uint32_t i_min = 0;
+
+        if (n_hot > 0 && !cont) {
+            for (uint32_t idx = 0; idx < n_hot && idxs_hot.size() < n_tokens; ++idx) {
+                if (cells.is_empty(idx)) {
+                    idxs_hot.push_back(idx);
+                }
+            }
+
+            i_min    = n_hot;
+            n_tested = n_hot;
+            head_cur = std::max(head_cur, n_hot);
+        }
+
+        const uint32_t n_want = n_tokens - idxs_hot.size();
+
         // for continuous slots, we test that all tokens in the ubatch fit, starting from the current head
         // for non-continuous slots, we test the tokens one by one
         const uint32_t n_test = cont ? n_tokens : 1;
 
-        while (true) {
+        while (res.idxs[s].size() < n_want) {
             if (head_cur + n_test > cells.size()) {
                 n_tested += cells.size() - head_cur;
-                head_cur = 0;
+                head_cur = i_min;
                 continue;
             }
 
@@ -1065,7 +1475,7 @@ llama_kv_cache::slot_info llama_kv_cache::find_slot(const llama_ubatch & ubatch,
                 }
             }
 
-            if (res.idxs[s].size() == n_tokens) {
+            if (res.idxs[s].size() == n_want) {
                 break;
             }
 
@@ -1079,6 +1489,8 @@ llama_kv_cache::slot_info llama_kv_cache::find_slot(const llama_ubatch & ubatch,
             }
         }
 
+        res.idxs[s].insert(res.idxs[s].end(), idxs_hot.begin(), idxs_hot.end());
+
         // we didn't find a suitable slot - return empty result
         if (res.idxs[s].size() < n_tokens) {
             return { };
@@ -1258,6 +1670,16 @@ lm_ggml_tensor * llama_kv_cache::get_k(lm_ggml_context * ctx, int32_t il, uint32
 
     const uint32_t ns = sinfo.s1 - sinfo.s0 + 1;
 
+    // [TAG_KV_CACHE_TIERS] the F16 cells come first, see get_k_cold() for the rest
+    if (auto * k_hot = layers[ikv].k_hot) {
+        return lm_ggml_view_4d(ctx, k_hot,
+                hparams.n_embd_head_k(il), hparams.n_head_kv(il), std::min(n_kv, n_hot), ns,
+                lm_ggml_row_size(k_hot->type, hparams.n_embd_head_k(il)),
+                k_hot->nb[1],
+                k_hot->nb[2],
+                k_hot->nb[2]*sinfo.s0);
+    }
+
     return lm_ggml_view_4d(ctx, k,
             hparams.n_embd_head_k(il), hparams.n_head_kv(il), n_kv, ns,
             lm_ggml_row_size(k->type, hparams.n_embd_head_k(il)),
@@ -1266,6 +1688,26 @@ lm_ggml_tensor * llama_kv_cache::get_k(lm_ggml_context * ctx, int32_t il, uint32
             lm_ggml_row_size(k->type, n_embd_k_gqa*kv_size)*sinfo.s0);
 }
 
+lm_ggml_tensor * llama_kv_cache::get_k_cold(lm_ggml_context * ctx, int32_t il, uint32_t n_kv, const slot_info & sinfo) const {
+    const int32_t ikv = map_layer_ids.at(il);
+
+    if (!layers[ikv].k_hot || n_kv <= n_hot) {
+        return nullptr;
+    }
+
+    auto * k = layers[ikv].k;
+
+    const uint32_t ns = sinfo.s1 - sinfo.s0 + 1;
+
+    // row 0 of the quantized tensor holds cell n_hot
+    return lm_ggml_view_4d(ctx, k,
+            hparams.n_embd_head_k(il), hparams.n_head_kv(il), n_kv - n_hot, ns,
+            lm_ggml_row_size(k->type, hparams.n_embd_head_k(il)),
+            k->nb[1],
+            k->nb[2],
+            k->nb[2]*sinfo.s0);
+}
+
 lm_ggml_tensor * llama_kv_cache::get_v(lm_ggml_context * ctx, int32_t il, uint32_t n_kv, const slot_info & sinfo) const {
     const int32_t ikv = map_layer_ids.at(il);
 
@@ -1320,13 +1762,18 @@ lm_ggml_tensor * llama_kv_cache::cpy_k(lm_ggml_context * ctx, lm_ggml_tensor * k
     const int64_t n_stream = k->ne[2];
 
     if (n_stream > 1) {
-        const int64_t kv_size = get_size();
+        const int64_t n_rows = k_rows();
 
         assert(n_embd_gqa == k->ne[0]);
-        assert(kv_size    == k->ne[1]);
+        assert(n_rows     == k->ne[1]);
 
         // merge the buffer across all streams because the idxs are global
-        k = lm_ggml_reshape_2d(ctx, k, n_embd_gqa, kv_size*n_stream);
+        k = lm_ggml_reshape_2d(ctx, k, n_embd_gqa, n_rows*n_stream);
+    }
+
+    // [TAG_KV_CACHE_TIERS] the second row of the idxs addresses the hot tier (see cpy_k_hot())
+    if (k_idxs->ne[1] > 1) {
+        k_idxs = lm_ggml_view_1d(ctx, k_idxs, k_idxs->ne[0], 0);
     }
 
     // store the current K values into the cache
@@ -1389,10 +1836,37 @@ lm_ggml_tensor * llama_kv_cache::cpy_v(lm_ggml_context * ctx, lm_ggml_tensor * v
     return lm_ggml_set_rows(ctx, v_view, v_cur, v_idxs);
 }
 
+lm_ggml_tensor * llama_kv_cache::cpy_k_hot(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il) const {
+    const int32_t ikv = map_layer_ids.at(il);
+
+    lm_ggml_tensor * k_hot = layers[ikv].k_hot;
+    if (!k_hot) {
+        return nullptr;
+    }
+
+    const int64_t n_embd_head = k_cur->ne[0];
+    const int64_t n_head      = k_cur->ne[1];
+    const int64_t n_tokens    = k_cur->ne[2];
+
+    LM_GGML_ASSERT(lm_ggml_row_size(k_cur->type, n_embd_head) == k_cur->nb[1]);
+    LM_GGML_ASSERT(k_idxs->ne[1] == 2);
+
+    k_cur = lm_ggml_view_2d(ctx, k_cur, n_embd_head*n_head, n_tokens, k_cur->nb[2], 0);
+
+    // merge the buffer across all streams - the hot idxs are global too
+    k_hot = lm_ggml_reshape_2d(ctx, k_hot, k_hot->ne[0], k_hot->ne[1]*k_hot->ne[2]);
+
+    // the tokens that are not placed in a hot cell are written to the scratch row of their stream
+    k_idxs = lm_ggml_view_1d(ctx, k_idxs, k_idxs->ne[0], k_idxs->nb[1]);
+
+    return lm_ggml_set_rows(ctx, k_hot, k_cur, k_idxs);
+}
+
 lm_ggml_tensor * llama_kv_cache::build_input_k_idxs(lm_ggml_context * ctx, const llama_ubatch & ubatch) const {
     const uint32_t n_tokens = ubatch.n_tokens;
 
-    lm_ggml_tensor * k_idxs = lm_ggml_new_tensor_1d(ctx, LM_GGML_TYPE_I64, n_tokens);
+    // [TAG_KV_CACHE_TIERS] with a hot tier, the second row holds the destinations in the F16 tensors
+    lm_ggml_tensor * k_idxs = lm_ggml_new_tensor_2d(ctx, LM_GGML_TYPE_I64, n_tokens, n_hot > 0 ? 2 : 1);
 
     lm_ggml_set_input(k_idxs);
 
@@ -1464,12 +1938,16 @@ void llama_kv_cache::set_input_k_idxs(lm_ggml_tensor * dst, const llama_ubatch *
     int64_t * data = (int64_t *) dst->data;
 
     for (uint32_t s = 0; s < sinfo.n_stream(); ++s) {
-        const int64_t offs = sinfo.strm[s]*get_size();
+        const int64_t offs = sinfo.strm[s]*k_rows();
 
         for (uint32_t i = 0; i < sinfo.size(); ++i) {
-            data[s*sinfo.size() + i] = offs + sinfo.idxs[s][i];
+            data[s*sinfo.size() + i] = offs + k_row(sinfo.idxs[s][i]);
         }
     }
+
+    if (dst->ne[1] > 1) {
+        set_input_idxs_hot(data + dst->ne[0], sinfo);
+    }
 }
 
 void llama_kv_cache::set_input_v_idxs(lm_ggml_tensor * dst, const llama_ubatch * ubatch, const slot_info & sinfo) const {
@@ -1505,16 +1983,35 @@ void llama_kv_cache::set_input_v_idxs(lm_ggml_tensor * dst, const llama_ubatch *
     }
 }
 
-void llama_kv_cache::set_input_k_shift(lm_ggml_tensor * dst) const {
+void llama_kv_cache::set_input_idxs_hot(int64_t * data, const slot_info & sinfo) const {
+    for (uint32_t s = 0; s < sinfo.n_stream(); ++s) {
+        const int64_t offs = sinfo.strm[s]*(n_hot + 1);
+
+        for (uint32_t i = 0; i < sinfo.size(); ++i) {
+            // row n_hot is the scratch row of the stream
+            data[s*sinfo.size() + i] = offs + std::min(sinfo.idxs[s][i], n_hot);
+        }
+    }
+}
+
+void llama_kv_cache::set_input_k_shift(lm_ggml_tensor * dst, bool hot) const {
     LM_GGML_ASSERT(lm_ggml_backend_buffer_is_host(dst->buffer));
 
     int32_t * data = (int32_t *) dst->data;
 
+    // the number of rows per stream is k_rows(), or n_hot + 1 for the hot tier
+    const int64_t n_rows = lm_ggml_nelements(dst)/n_stream;
+
+    // [TAG_KV_CACHE_TIERS] row i of the quantized tier holds cell n_hot + i, the scratch rows map past the last cell
+    const uint32_t i0 = hot ? 0 : n_hot;
+
     for (uint32_t s = 0; s < n_stream; ++s) {
         const auto & cells = v_cells[s];
 
-        for (uint32_t i = 0; i < cells.size(); ++i) {
-            data[s*cells.size() + i] = cells.is_empty(i) ? 0 : cells.get_shift(i);
+        for (uint32_t i = 0; i < n_rows; ++i) {
+            const uint32_t idx = i0 + i;
+
+            data[s*n_rows + i] = idx >= cells.size() || (hot && idx >= n_hot) || cells.is_empty(idx) ? 0 : cells.get_shift(idx);
         }
     }
 }
@@ -1818,6 +2315,7 @@ size_t llama_kv_cache::size_k_bytes() const {
 
     for (const auto & layer : layers) {
         size_k_bytes += lm_ggml_nbytes(layer.k);
+        size_k_bytes += layer.k_hot ? lm_ggml_nbytes(layer.k_hot) : 0;
     }
 
     return size_k_bytes;
@@ -1833,6 +2331,18 @@ size_t llama_kv_cache::size_v_bytes() const {
     return size_v_bytes;
 }
 
+uint32_t llama_kv_cache::k_rows() const {
+    return n_hot > 0 ? get_size() - n_hot + 1 : get_size();
+}
+
+uint32_t llama_kv_cache::k_row(uint32_t idx) const {
+    if (n_hot == 0) {
+        return idx;
+    }
+
+    return idx >= n_hot ? idx - n_hot : get_size() - n_hot;
+}
+
 lm_ggml_tensor * llama_kv_cache::build_rope_shift(
         const llama_cparams & cparams,
                lm_ggml_context * ctx,
@@ -1842,7 +2352,8 @@ lm_ggml_tensor * llama_kv_cache::build_rope_shift(
                 lm_ggml_tensor * factors,
                       float   freq_base,
                       float   freq_scale,
-                   uint32_t   il) const {
+                   uint32_t   il,
+                       bool   rotated) const {
     const auto & n_ctx_orig = cparams.n_ctx_orig_yarn;
 
     const auto & yarn_ext_factor  = cparams.yarn_ext_factor;
@@ -1860,7 +2371,8 @@ lm_ggml_tensor * llama_kv_cache::build_rope_shift(
                                 : hparams.rope_type;
     lm_ggml_tensor * tmp;
 
-    if (lm_ggml_is_quantized(cur->type)) {
+    // note: the F16 tier of a two-tier cache holds rotated keys as well
+    if (lm_ggml_is_quantized(cur->type) || rotated) {
         // dequantize to f32 -> RoPE -> quantize back
         tmp = lm_ggml_cast(ctx, cur, LM_GGML_TYPE_F32);
 
@@ -1892,7 +2404,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
-    lm_ggml_tensor * k_shift; // I32 [kv_size*n_stream]
+    lm_ggml_tensor * k_shift;               // I32 [kv_size*n_stream]
+    lm_ggml_tensor * k_shift_hot = nullptr; // I32 [(n_hot + 1)*n_stream]
 
     // note: assumes k_rot^2 == I
     lm_ggml_tensor * k_rot = nullptr;
@@ -1907,6 +2420,10 @@ void llm_graph_input_k_shift::set_input(const llama_ubatch * ubatch) {
         kv_self->set_input_k_shift(k_shift);
     }
 
+    if (k_shift_hot) {
+        kv_self->set_input_k_shift(k_shift_hot, true);
+    }
+
     if (k_rot) {
         kv_self->set_input_k_rot(k_rot);
     }
@@ -1921,9 +2438,14 @@ lm_ggml_cgraph * llama_kv_cache::build_graph_shift(llm_graph_result * res, llama
 
     auto inp = std::make_unique<llm_graph_input_k_shift>(this);
 
-    inp->k_shift = lm_ggml_new_tensor_1d(ctx, LM_GGML_TYPE_I32, (int64_t) get_size()*n_stream);
+    inp->k_shift = lm_ggml_new_tensor_1d(ctx, LM_GGML_TYPE_I32, (int64_t) k_rows()*n_stream);
     lm_ggml_set_input(inp->k_shift);
 
+    if (n_hot > 0) {
+        inp->k_shift_hot = lm_ggml_new_tensor_1d(ctx, LM_GGML_TYPE_I32, (int64_t) (n_hot + 1)*n_stream);
+        lm_ggml_set_input(inp->k_shift_hot);
+    }
+
     inp->k_rot = build_input_k_rot(ctx);
 
     const auto & cparams = lctx->get_cparams();
@@ -1949,7 +2471,7 @@ lm_ggml_cgraph * llama_kv_cache::build_graph_shift(llm_graph_result * res, llama
 
         lm_ggml_tensor * k =
             lm_ggml_view_3d(ctx, layer.k,
-                n_rot, n_head_kv, get_size()*n_stream,
+                n_rot, n_head_kv, layer.k->ne[1]*n_stream,
                 lm_ggml_row_size(layer.k->type, n_embd_head_k),
                 lm_ggml_row_size(layer.k->type, n_embd_k_gqa),
                 lm_ggml_row_size(layer.k->type, n_embd_nope));
@@ -1957,6 +2479,19 @@ lm_ggml_cgraph * llama_kv_cache::build_graph_shift(llm_graph_result * res, llama
         lm_ggml_tensor * cur = build_rope_shift(cparams, ctx, k, inp->k_shift, inp->k_rot, rope_factors, freq_base_l, freq_scale_l, il);
 
         lm_ggml_build_forward_expand(gf, cur);
+
+        if (layer.k_hot) {
+            lm_ggml_tensor * k_hot =
+                lm_ggml_view_3d(ctx, layer.k_hot,
+                    n_rot, n_head_kv, (n_hot + 1)*n_stream,
+                    lm_ggml_row_size(layer.k_hot->type, n_embd_head_k),
+                    lm_ggml_row_size(layer.k_hot->type, n_embd_k_gqa),
+                    lm_ggml_row_size(layer.k_hot->type, n_embd_nope));
+
+            cur = build_rope_shift(cparams, ctx, k_hot, inp->k_shift_hot, inp->k_rot, rope_factors, freq_base_l, freq_scale_l, il, attn_rot_k);
+
+            lm_ggml_build_forward_expand(gf, cur);
+        }
     }
 
     res->add_input(std::move(inp));
@@ -1964,6 +2499,88 @@ lm_ggml_cgraph * llama_kv_cache::build_graph_shift(llm_graph_result * res, llama
     return gf;
 }
 
+lm_ggml_cgraph * llama_kv_cache::build_graph_defrag(llm_graph_result * res, const defrag_info & dinfo) const {
+    // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
+    LM_GGML_ASSERT(!other);
+
+    auto * ctx = res->get_ctx();
+    auto * gf  = res->get_gf();
+
+    const uint32_t kv_size = get_size();
+
+    for (const auto & layer : layers) {
+        auto * k = layer.k;
+        auto * v = layer.v;
+
+        for (const auto & mv : dinfo.moves) {
+            // note: the source and destination ranges never overlap - the destination cells are empty
+            if (!layer.k_hot) {
+                lm_ggml_tensor * k_src = lm_ggml_view_2d(ctx, k, k->ne[0], mv.len, k->nb[1], mv.strm*k->nb[2] + mv.src*k->nb[1]);
+                lm_ggml_tensor * k_dst = lm_ggml_view_2d(ctx, k, k->ne[0], mv.len, k->nb[1], mv.strm*k->nb[2] + mv.dst*k->nb[1]);
+
+                lm_ggml_build_forward_expand(gf, lm_ggml_cpy(ctx, k_src, k_dst));
+            } else {
+                // [TAG_KV_CACHE_TIERS] split the move where either side crosses the end of the hot range
+                auto view_k = [&](uint32_t idx, uint32_t len) {
+                    lm_ggml_tensor * t = idx < n_hot ? layer.k_hot : k;
+                    const uint32_t row = idx < n_hot ? idx : idx - n_hot;
+
+                    return lm_ggml_view_2d(ctx, t, t->ne[0], len, t->nb[1], mv.strm*t->nb[2] + row*t->nb[1]);
+                };
+
+                for (uint32_t j = 0; j < mv.len; ) {
+                    const uint32_t src = mv.src + j;
+                    const uint32_t dst = mv.dst + j;
+
+                    uint32_t len = mv.len - j;
+                    if (src < n_hot) {
+                        len = std::min(len, n_hot - src);
+                    }
+                    if (dst < n_hot) {
+                        len = std::min(len, n_hot - dst);
+                    }
+
+                    lm_ggml_tensor * k_src = view_k(src, len);
+                    lm_ggml_tensor * k_dst = view_k(dst, len);
+
+                    // quantized rows are dequantized on their way into the F16 tier
+                    if (lm_ggml_is_quantized(k_src->type) && !lm_ggml_is_quantized(k_dst->type)) {
+                        k_src = lm_ggml_cast(ctx, k_src, LM_GGML_TYPE_F32);
+                    }
+
+                    lm_ggml_build_forward_expand(gf, lm_ggml_cpy(ctx, k_src, k_dst));
+
+                    j += len;
+                }
+            }
+
+            if (!v) {
+                continue;
+            }
+
+            lm_ggml_tensor * v_src;
+            lm_ggml_tensor * v_dst;
+
+            if (!v_trans) {
+                v_src = lm_ggml_view_2d(ctx, v, v->ne[0], mv.len, v->nb[1], mv.strm*v->nb[2] + mv.src*v->nb[1]);
+                v_dst = lm_ggml_view_2d(ctx, v, v->ne[0], mv.len, v->nb[1], mv.strm*v->nb[2] + mv.dst*v->nb[1]);
+            } else {
+                // the V cache is transposed - each of the n_embd_v_gqa rows holds all cells of the stream
+                v_src = lm_ggml_view_2d(ctx, v, mv.len, v->ne[0],
+                        lm_ggml_row_size(v->type, kv_size),
+                        mv.strm*v->nb[2] + lm_ggml_row_size(v->type, mv.src));
+                v_dst = lm_ggml_view_2d(ctx, v, mv.len, v->ne[0],
+                        lm_ggml_row_size(v->type, kv_size),
+                        mv.strm*v->nb[2] + lm_ggml_row_size(v->type, mv.dst));
+            }
+
+            lm_ggml_build_forward_expand(gf, lm_ggml_cpy(ctx, v_src, v_dst));
+        }
+    }
+
+    return gf;
+}
+
 void llama_kv_cache::state_write(llama_io_write_i & io, llama_seq_id seq_id, llama_state_seq_flags flags) const {
     // TODO: refactor [TAG_KV_CACHE_SHARE_CELLS]
     if (other) {
@@ -2143,9 +2760,7 @@ void llama_kv_cache::state_write_data(llama_io_write_i & io, const cell_ranges_t
 
         // Read each range of cells of k_size length and write out
         for (const auto & range : cr.data) {
-            const size_t range_size = range.second - range.first;
-            const size_t buf_size = range_size * k_size_row;
-            io.write_tensor(k, range.first * k_size_row, buf_size);
+            state_write_k(io, layer, cr.strm, range.first, range.second - range.first);
         }
     }
 
@@ -2386,12 +3001,11 @@ bool llama_kv_cache::state_read_data(llama_io_read_i & io, uint32_t strm, uint32
         if (cell_count) {
             if (sinfo.is_contiguous()) {
                 // Fast path: contiguous cells, single memcpy
-                io.read_tensor(k, sinfo.head() * k_size_row, cell_count * k_size_row);
+                state_read_k(io, layer, strm, sinfo.head(), cell_count);
             } else {
                 // Slow path: scatter to non-contiguous positions
                 for (uint32_t i = 0; i < cell_count; ++i) {
-                    const size_t dst_offset = sinfo.idxs[0][i] * k_size_row;
-                    io.read_tensor(k, dst_offset, k_size_row);
+                    state_read_k(io, layer, strm, sinfo.idxs[0][i], 1);
                 }
             }
         }
@@ -2501,6 +3115,78 @@ bool llama_kv_cache::state_read_data(llama_io_read_i & io, uint32_t strm, uint32
     return true;
 }
 
+void llama_kv_cache::state_write_k(llama_io_write_i & io, const kv_layer & layer, uint32_t strm, uint32_t idx, uint32_t n) const {
+    auto * k = layer.k_stream[strm];
+
+    const int64_t n_embd   = k->ne[0];
+    const size_t  size_row = lm_ggml_row_size(k->type, n_embd);
+
+    if (!layer.k_hot) {
+        io.write_tensor(k, idx*size_row, n*size_row);
+        return;
+    }
+
+    // [TAG_KV_CACHE_TIERS] the state always holds type_k rows, so it does not depend on the hot window
+    if (idx >= n_hot) {
+        io.write_tensor(k, (idx - n_hot)*size_row, n*size_row);
+        return;
+    }
+
+    const uint32_t n_cur = std::min(n, n_hot - idx);
+
+    auto * k_hot = layer.k_hot_stream[strm];
+
+    std::vector<lm_ggml_fp16_t> f16(n_cur*n_embd);
+    std::vector<float>          f32(n_cur*n_embd);
+    std::vector<uint8_t>        buf(n_cur*size_row);
+
+    lm_ggml_backend_tensor_get(k_hot, f16.data(), idx*k_hot->nb[1], n_cur*k_hot->nb[1]);
+    lm_ggml_fp16_to_fp32_row(f16.data(), f32.data(), f16.size());
+    lm_ggml_quantize_chunk(k->type, f32.data(), buf.data(), 0, n_cur, n_embd, nullptr);
+
+    io.write(buf.data(), buf.size());
+
+    if (n_cur < n) {
+        state_write_k(io, layer, strm, idx + n_cur, n - n_cur);
+    }
+}
+
+void llama_kv_cache::state_read_k(llama_io_read_i & io, const kv_layer & layer, uint32_t strm, uint32_t idx, uint32_t n) {
+    auto * k = layer.k_stream[strm];
+
+    const int64_t n_embd   = k->ne[0];
+    const size_t  size_row = lm_ggml_row_size(k->type, n_embd);
+
+    if (!layer.k_hot) {
+        io.read_tensor(k, idx*size_row, n*size_row);
+        return;
+    }
+
+    // [TAG_KV_CACHE_TIERS]
+    if (idx >= n_hot) {
+        io.read_tensor(k, (idx - n_hot)*size_row, n*size_row);
+        return;
+    }
+
+    const uint32_t n_cur = std::min(n, n_hot - idx);
+
+    auto * k_hot = layer.k_hot_stream[strm];
+
+    std::vector<uint8_t>        buf(n_cur*size_row);
+    std::vector<float>          f32(n_cur*n_embd);
+    std::vector<lm_ggml_fp16_t> f16(n_cur*n_embd);
+
+    io.read(buf.data(), buf.size());
+
+    lm_ggml_get_type_traits(k->type)->to_float(buf.data(), f32.data(), f32.size());
+    lm_ggml_fp32_to_fp16_row(f32.data(), f16.data(), f16.size());
+    lm_ggml_backend_tensor_set(k_hot, f16.data(), idx*k_hot->nb[1], n_cur*k_hot->nb[1]);
+
+    if (n_cur < n) {
+        state_read_k(io, layer, strm, idx + n_cur, n - n_cur);
+    }
+}
+
 //
 // llama_kv_cache_context
 //
@@ -2528,8 +3214,9 @@ llama_kv_cache_context::llama_kv_cache_context(
         llama_kv_cache * kv,
         llama_context * lctx,
         bool do_shift,
-        stream_copy_info sc_info) : status(LLAMA_MEMORY_STATUS_SUCCESS), kv(kv), lctx(lctx), do_shift(do_shift), sc_info(std::move(sc_info)) {
-    if (!do_shift && this->sc_info.empty()) {
+        defrag_info dinfo,
+        stream_copy_info sc_info) : status(LLAMA_MEMORY_STATUS_SUCCESS), kv(kv), lctx(lctx), do_shift(do_shift), dinfo(std::move(dinfo)), sc_info(std::move(sc_info)) {
+    if (!do_shift && this->dinfo.empty() && this->sc_info.empty()) {
         status = LLAMA_MEMORY_STATUS_NO_UPDATE;
     }
 }
@@ -2557,7 +3244,7 @@ bool llama_kv_cache_context::apply() {
 
     // no ubatches -> this is a KV cache update
     if (ubatches.empty()) {
-        kv->update(lctx, do_shift, sc_info);
+        kv->update(lctx, do_shift, dinfo, sc_info);
 
         return true;
     }
@@ -2598,6 +3285,10 @@ lm_ggml_tensor * llama_kv_cache_context::get_v(lm_ggml_context * ctx, int32_t il
     return kv->get_v(ctx, il, n_kv, sinfos[i_cur]);
 }
 
+lm_ggml_tensor * llama_kv_cache_context::get_k_cold(lm_ggml_context * ctx, int32_t il) const {
+    return kv->get_k_cold(ctx, il, n_kv, sinfos[i_cur]);
+}
+
 lm_ggml_tensor * llama_kv_cache_context::cpy_k(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il) const {
     return kv->cpy_k(ctx, k_cur, k_idxs, il, sinfos[i_cur]);
 }
@@ -2606,6 +3297,10 @@ lm_ggml_tensor * llama_kv_cache_context::cpy_v(lm_ggml_context * ctx, lm_ggml_te
     return kv->cpy_v(ctx, v_cur, v_idxs, il, sinfos[i_cur]);
 }
 
+lm_ggml_tensor * llama_kv_cache_context::cpy_k_hot(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il) const {
+    return kv->cpy_k_hot(ctx, k_cur, k_idxs, il);
+}
+
 lm_ggml_tensor * llama_kv_cache_context::build_input_k_idxs(lm_ggml_context * ctx, const llama_ubatch & ubatch) const {
     return kv->build_input_k_idxs(ctx, ubatch);
 }
@@ -29,6 +29,22 @@ public:
         std::vector<uint32_t> sdst;
     };
 
+    // incremental compaction plan: each move relocates a contiguous block of used cells into a hole
+    struct defrag_info {
+        struct move {
+            uint32_t strm;
+            uint32_t src;
+            uint32_t dst;
+            uint32_t len;
+        };
+
+        bool empty() const {
+            return moves.empty();
+        }
+
+        std::vector<move> moves;
+    };
+
     // for each ubatch, create a slot_info that contains information about where the ubatch should be inserted in the
     //   KV cells. for example, cell indices for each token, such that: token[i] -> goes to cells[idxs[i]]
     struct slot_info {
@@ -112,7 +128,8 @@ public:
                llama_memory_t   mem_other,
         const layer_filter_cb & filter,
         const  layer_reuse_cb & reuse,
-        const  layer_share_cb & share);
+        const  layer_share_cb & share,
+                     uint32_t   n_hot_seq = 0);
 
     ~llama_kv_cache() = default;
 
@@ -143,6 +160,7 @@ public:
     llama_pos seq_pos_max(llama_seq_id seq_id) const override;
 
     std::map<lm_ggml_backend_buffer_type_t, size_t> memory_breakdown() const override;
+    std::map<lm_ggml_backend_buffer_type_t, size_t> memory_breakdown_frag() const override;
 
     // state write/load
 
@@ -158,6 +176,10 @@ public:
 
     bool get_has_shift() const;
 
+    // fraction of the cells below the highest used cell that are empty, worst stream
+    // with a two-tier cache, only the quantized cells count
+    float get_fragmentation() const;
+
     lm_ggml_type type_k() const;
     lm_ggml_type type_v() const;
 
@@ -173,13 +195,21 @@ public:
     uint32_t get_n_kv(const slot_info & sinfo) const;
 
     // get views of the current state of the cache
+    // with a two-tier cache, get_k() views the F16 cells only (see get_k_cold())
     lm_ggml_tensor * get_k(lm_ggml_context * ctx, int32_t il, uint32_t n_kv, const slot_info & sinfo) const;
     lm_ggml_tensor * get_v(lm_ggml_context * ctx, int32_t il, uint32_t n_kv, const slot_info & sinfo) const;
 
+    // view of the quantized cells of a two-tier cache, which follow the F16 cells returned by get_k()
+    // nullptr if the cache has a single tier or all n_kv cells are in the F16 tier
+    lm_ggml_tensor * get_k_cold(lm_ggml_context * ctx, int32_t il, uint32_t n_kv, const slot_info & sinfo) const;
+
     // store k_cur and v_cur in the cache based on the provided head location
     lm_ggml_tensor * cpy_k(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il, const slot_info & sinfo) const;
     lm_ggml_tensor * cpy_v(lm_ggml_context * ctx, lm_ggml_tensor * v_cur, lm_ggml_tensor * v_idxs, int32_t il, const slot_info & sinfo) const;
 
+    // store k_cur in the F16 tier of a two-tier cache, nullptr if the layer has a single tier
+    lm_ggml_tensor * cpy_k_hot(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il) const;
+
     //
     // preparation API
     //
@@ -188,7 +218,7 @@ public:
     // return empty vector on failure
     slot_info_vec_t prepare(const std::vector<llama_ubatch> & ubatches);
 
-    bool update(llama_context * lctx, bool do_shift, const stream_copy_info & sc_info);
+    bool update(llama_context * lctx, bool do_shift, const defrag_info & dinfo, const stream_copy_info & sc_info);
 
     // find a slot of kv cells that can hold the ubatch
     // if cont == true, then the slot must be continuous
@@ -211,7 +241,8 @@ public:
     void set_input_k_idxs(lm_ggml_tensor * dst, const llama_ubatch * ubatch, const slot_info & sinfo) const;
     void set_input_v_idxs(lm_ggml_tensor * dst, const llama_ubatch * ubatch, const slot_info & sinfo) const;
 
-    void set_input_k_shift(lm_ggml_tensor * dst) const;
+    // the shift of each row of the K tensors (hot = the F16 tier of a two-tier cache)
+    void set_input_k_shift(lm_ggml_tensor * dst, bool hot = false) const;
 
     void set_input_kq_mask   (lm_ggml_tensor * dst, const llama_ubatch * ubatch, bool causal_attn) const;
     void set_input_pos_bucket(lm_ggml_tensor * dst, const llama_ubatch * ubatch) const;
@@ -220,6 +251,9 @@ public:
     void set_input_v_rot(lm_ggml_tensor * dst) const;
 
 private:
+    // fill the hot tier destinations (second row of the k idxs) of a two-tier cache
+    void set_input_idxs_hot(int64_t * data, const slot_info & sinfo) const;
+
     const llama_model & model;
     const llama_hparams & hparams;
 
@@ -233,6 +267,11 @@ private:
 
         std::vector<lm_ggml_tensor *> k_stream;
         std::vector<lm_ggml_tensor *> v_stream;
+
+        // two-tier cache: the F16 cells [0, n_hot) of each stream plus one scratch row, k then holds the other cells
+        lm_ggml_tensor * k_hot = nullptr;
+
+        std::vector<lm_ggml_tensor *> k_hot_stream;
     };
 
     bool v_trans = true;  // the value tensor is transposed
@@ -246,6 +285,16 @@ private:
     // SWA
     const uint32_t n_swa = 0;
 
+    // two-tier cache: the keys of the cells [0, n_hot) of each stream are stored in F16 only, the keys of the
+    // other cells with type_k only. find_slot() places new tokens in the free hot cells first, tier_prepare()
+    // moves the hot cells that fall out of the last n_hot_win positions of their sequences to the quantized cells
+    // in batches, and the quantized cells inside the window (a prompt that did not fit) up into the hot cells
+    // note: V is not tiered - without flash attention it is stored transposed, and a quantized block would span 32
+    //       cells, so neither set_rows nor a migration could write a single cell of it
+    uint32_t n_hot     = 0;
+    uint32_t n_hot_win = 0; // most recent positions per sequence kept in the hot cells
+    uint32_t n_hot_mig = 0; // number of hot cells freed per migration
+
     // env: LLAMA_ATTN_ROT_DISABLE
     bool attn_rot_k = false;
     bool attn_rot_v = false;
@@ -294,6 +343,14 @@ private:
     size_t size_k_bytes() const;
     size_t size_v_bytes() const;
 
+    // number of used cells of a stream outside the hot cells of a two-tier cache
+    uint32_t get_used_cold(uint32_t strm) const;
+
+    // rows per stream of the K tensors, and the row of a cell in them
+    // with a two-tier cache, the last row is the scratch row that receives the tokens placed in the F16 tier
+    uint32_t k_rows() const;
+    uint32_t k_row(uint32_t idx) const;
+
     lm_ggml_tensor * build_rope_shift(
             const llama_cparams & cparams,
                    lm_ggml_context * ctx,
@@ -303,12 +360,28 @@ private:
                     lm_ggml_tensor * factors,
                           float   freq_base,
                           float   freq_scale,
-                       uint32_t   il) const;
+                       uint32_t   il,
+                           bool   rotated = false) const;
 
     lm_ggml_cgraph * build_graph_shift(
                llm_graph_result * res,
                   llama_context * lctx) const;
 
+    // plan the next compaction step - returns an empty plan if the cache is not fragmented enough
+    // the number of moves is bounded by the graph size, so large caches are compacted over several updates
+    defrag_info defrag_prepare(const llama_context * lctx, bool force) const;
+
+    // plan the moves between the tiers of a two-tier cache that keep the last n_hot_win positions of each sequence
+    // in the hot cells - returns an empty plan while they are there and enough hot cells are free
+    defrag_info tier_prepare(const llama_context * lctx) const;
+
+    // max number of moves in a single compaction graph
+    uint32_t defrag_max_moves(const llama_context * lctx) const;
+
+    lm_ggml_cgraph * build_graph_defrag(
+               llm_graph_result * res,
+            const defrag_info & dinfo) const;
+
     struct cell_ranges_t {
         uint32_t strm;
 
@@ -320,6 +393,11 @@ private:
 
     bool state_read_meta(llama_io_read_i & io, uint32_t strm, uint32_t cell_count,       slot_info & sinfo, llama_seq_id dest_seq_id = -1);
     bool state_read_data(llama_io_read_i & io, uint32_t strm, uint32_t cell_count, const slot_info & sinfo);
+
+    // the K rows of the cells [idx, idx + n) in the type_k format of the state, the F16 cells of a two-tier cache
+    // are quantized on write and dequantized on read
+    void state_write_k(llama_io_write_i & io, const kv_layer & layer, uint32_t strm, uint32_t idx, uint32_t n) const;
+    void state_read_k (llama_io_read_i  & io, const kv_layer & layer, uint32_t strm, uint32_t idx, uint32_t n);
 };
 
 class llama_kv_cache_context : public llama_memory_context_i {
@@ -327,6 +405,7 @@ public:
     // some shorthands
     using slot_info_vec_t  = llama_kv_cache::slot_info_vec_t;
     using stream_copy_info = llama_kv_cache::stream_copy_info;
+    using defrag_info      = llama_kv_cache::defrag_info;
 
     // used for errors
     llama_kv_cache_context(llama_memory_status status);
@@ -340,6 +419,7 @@ public:
             llama_kv_cache * kv,
             llama_context * lctx,
             bool do_shift,
+            defrag_info dinfo,
             stream_copy_info sc_info);
 
     // used to create a batch processing context from a batch
@@ -373,15 +453,22 @@ public:
     lm_ggml_tensor * get_k(lm_ggml_context * ctx, int32_t il) const;
     lm_ggml_tensor * get_v(lm_ggml_context * ctx, int32_t il) const;
 
+    // with a two-tier cache, get_k() views the F16 cells and get_k_cold() the quantized cells after them
+    // (nullptr with a single tier or when all cells are in the F16 tier)
+    lm_ggml_tensor * get_k_cold(lm_ggml_context * ctx, int32_t il) const;
+
     // store k_cur and v_cur in the cache based on the provided head location
     // note: the heads in k_cur and v_cur should be laid out contiguously in memory
     //   - k_cur  [n_embd_head_k, n_head_k, n_tokens]
-    //   - k_idxs [n_tokens]
+    //   - k_idxs [n_tokens] or [n_tokens, 2] with a two-tier cache
     //   - v_cur  [n_embd_head_v, n_head_v, n_tokens]
     //   - v_idxs [n_tokens] or [n_tokens*n_embd_v_gqa] depending if V cache is transposed
     lm_ggml_tensor * cpy_k(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il) const;
     lm_ggml_tensor * cpy_v(lm_ggml_context * ctx, lm_ggml_tensor * v_cur, lm_ggml_tensor * v_idxs, int32_t il) const;
 
+    // with a two-tier cache, the keys of the hot cells are stored in F16 - returns nullptr otherwise
+    lm_ggml_tensor * cpy_k_hot(lm_ggml_context * ctx, lm_ggml_tensor * k_cur, lm_ggml_tensor * k_idxs, int32_t il) const;
+
     // create destination indices for each head of the current batch for where it would be written in the KV cache
     // the indices address the global KV cache (not per stream) - this is not relevant for the user of this API, but
     //   helps understand the implementation logic of cpy_k and cpy_v
@@ -413,6 +500,8 @@ private:
 
     bool do_shift = false;
 
+    defrag_info dinfo;
+
     stream_copy_info sc_info;
 
     //
@@ -192,6 +192,10 @@ std::map<lm_ggml_backend_buffer_type_t, size_t> llama_memory_hybrid_iswa::memory
     return mb;
 }
 
+std::map<lm_ggml_backend_buffer_type_t, size_t> llama_memory_hybrid_iswa::memory_breakdown_frag() const {
+    return mem_attn->memory_breakdown_frag();
+}
+
 void llama_memory_hybrid_iswa::state_write(llama_io_write_i & io, llama_seq_id seq_id, llama_state_seq_flags flags) const {
     mem_attn->state_write(io, seq_id, flags);
     mem_recr->state_write(io, seq_id, flags);
@@ -70,6 +70,7 @@ public:
     llama_pos seq_pos_max(llama_seq_id seq_id) const override;
 
     std::map<lm_ggml_backend_buffer_type_t, size_t> memory_breakdown() const override;
+    std::map<lm_ggml_backend_buffer_type_t, size_t> memory_breakdown_frag() const override;
 
     // state write/load
 
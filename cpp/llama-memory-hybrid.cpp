@@ -187,6 +187,10 @@ std::map<lm_ggml_backend_buffer_type_t, size_t> llama_memory_hybrid::memory_brea
     return mb;
 }
 
+std::map<lm_ggml_backend_buffer_type_t, size_t> llama_memory_hybrid::memory_breakdown_frag() const {
+    return mem_attn->memory_breakdown_frag();
+}
+
 void llama_memory_hybrid::state_write(llama_io_write_i & io, llama_seq_id seq_id, llama_state_seq_flags flags) const {
     if ((flags & LLAMA_STATE_SEQ_FLAGS_PARTIAL_ONLY) == 0) {
         mem_attn->state_write(io, seq_id, flags);
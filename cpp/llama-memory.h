@@ -19,6 +19,9 @@ struct llama_memory_params {
     lm_ggml_type type_k;
     lm_ggml_type type_v;
 
+    // number of most recent cells per sequence kept in F16 when type_k/type_v are quantized
+    uint32_t n_kv_hot;
+
     // use full-size SWA cache
     bool swa_full;
 
@@ -118,6 +121,12 @@ struct llama_memory_i {
 
     virtual std::map<lm_ggml_backend_buffer_type_t, size_t> memory_breakdown() const = 0;
 
+    // the part of memory_breakdown() that is held by unused cells below the highest used cell
+    // (i.e. memory that compaction would hand back to the attention window)
+    virtual std::map<lm_ggml_backend_buffer_type_t, size_t> memory_breakdown_frag() const {
+        return {};
+    }
+
     //
     // state write/read
     //
@@ -8,11 +8,17 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring>
-#include <future>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
 #include <regex>
+#include <thread>
 
 static const size_t kiB = 1024;
 static const size_t MiB = 1024*kiB;
@@ -1410,6 +1416,141 @@ void llama_model_loader::load_data_for(struct lm_ggml_tensor * cur) const {
     }
 }
 
+void llama_model_loader::read_tensor_data(const llama_tensor_weight & w, size_t offs, void * dst, size_t size) const {
+    if (use_mmap) {
+        const auto & mapping = mappings.at(w.idx);
+        memcpy(dst, (const uint8_t *)mapping->addr() + w.offs + offs, size);
+    } else {
+        const auto & file = files.at(w.idx);
+        file->seek(w.offs + offs, SEEK_SET);
+        file->read_raw(dst, size);
+    }
+}
+
+//
+// load workers
+//
+// the CPU side of loading a tensor - paging in mmapped data, the copy or repack done by set_tensor and
+// row validation - runs on a small pool while the loading thread keeps issuing file reads and device
+// uploads. jobs are bounded both in count and in staged bytes so memory stays flat on large models
+//
+
+struct llama_load_workers {
+    llama_load_workers(int n_threads, size_t max_staged) : max_jobs(2 * n_threads), max_staged(max_staged) {
+        for (int i = 0; i < n_threads; ++i) {
+            threads.emplace_back([this] { run(); });
+        }
+    }
+
+    ~llama_load_workers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.clear(); // only reached early on cancellation or error
+            stop = true;
+        }
+        cv_work.notify_all();
+        for (auto & t : threads) {
+            t.join();
+        }
+    }
+
+    // blocks while the queue is full; n_staged is the size of any buffer owned by fn
+    void submit(size_t n_size, size_t n_staged, std::function<void()> fn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        // a job larger than the budget is still admitted once nothing else is staged
+        cv_done.wait(lock, [&] {
+            return n_jobs < max_jobs && (staged == 0 || staged + n_staged <= max_staged);
+        });
+        n_jobs++;
+        staged += n_staged;
+        jobs.push_back({ n_size, n_staged, std::move(fn) });
+        cv_work.notify_one();
+    }
+
+    // bytes of tensor data whose jobs have finished
+    size_t size_done() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return done;
+    }
+
+    // waits for all submitted jobs and rethrows the first error
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_done.wait(lock, [&] { return n_jobs == 0; });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct job {
+        size_t n_size;
+        size_t n_staged;
+        std::function<void()> fn;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv_work.wait(lock, [&] { return stop || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job j = std::move(jobs.front());
+            jobs.pop_front();
+
+            lock.unlock();
+            std::exception_ptr err;
+            if (!failed.load(std::memory_order_acquire)) {
+                try {
+                    j.fn();
+                } catch (...) {
+                    err = std::current_exception();
+                }
+            }
+            j.fn = nullptr; // release staged data before accounting for it
+            lock.lock();
+
+            if (err && !error) {
+                error = err;
+                failed.store(true, std::memory_order_release);
+            }
+            n_jobs--;
+            staged -= j.n_staged;
+            done   += j.n_size;
+            cv_done.notify_all();
+        }
+    }
+
+    const size_t max_jobs;
+    const size_t max_staged;
+
+    std::mutex mutex;
+    std::condition_variable cv_work;
+    std::condition_variable cv_done;
+    std::deque<job> jobs;
+    std::vector<std::thread> threads;
+
+    size_t n_jobs = 0;
+    size_t staged = 0;
+    size_t done   = 0;
+    bool   stop   = false;
+    std::exception_ptr error;          // guarded by mutex
+    std::atomic<bool>  failed{false};  // set with error, lets workers skip jobs without taking the lock
+};
+
+// tensors whose set_tensor is plain CPU work (memcpy, repack or conversion) that can run concurrently
+static bool llama_tensor_set_is_cpu(const lm_ggml_tensor * t) {
+    if (t->buffer == nullptr) {
+        return false;
+    }
+    if (lm_ggml_backend_buffer_is_host(t->buffer)) {
+        return true;
+    }
+    auto * dev = lm_ggml_backend_buft_get_device(lm_ggml_backend_buffer_get_type(t->buffer));
+    return dev && lm_ggml_backend_dev_type(dev) == LM_GGML_BACKEND_DEVICE_TYPE_CPU;
+}
+
 bool llama_model_loader::load_all_data(
         struct lm_ggml_context * ctx,
         llama_buf_map & bufs,
@@ -1425,7 +1566,15 @@ bool llama_model_loader::load_all_data(
     LM_GGML_ASSERT(size_data != 0 && "call init_mappings() first");
 
     std::vector<no_init<uint8_t>> read_buf;
-    std::vector<std::future<std::pair<lm_ggml_tensor *, bool>>> validation_result;
+
+    std::mutex invalid_mutex;
+    std::vector<const lm_ggml_tensor *> invalid_tensors;
+    auto validate = [&](const lm_ggml_tensor * t, const void * data, size_t n_size) {
+        if (!lm_ggml_validate_row_data(t->type, data, n_size)) {
+            std::lock_guard<std::mutex> lock(invalid_mutex);
+            invalid_tensors.push_back(t);
+        }
+    };
 
     // 4 staging buffers for async uploads, each sized 1MB seems to be a good default for single NVMe drives.
     // NVMe raid configurations might require more / larger buffers.
@@ -1518,6 +1667,32 @@ bool llama_model_loader::load_all_data(
         return backend;
     }(__func__);
 
+    // free the async upload resources on every way out, including an error rethrown by the workers;
+    // declared before the workers so that they are joined first
+    struct upload_resources_guard {
+        std::vector<lm_ggml_backend_event_t> & events;
+        std::vector<lm_ggml_backend_buffer_t> & host_buffers;
+        lm_ggml_backend_t backend;
+
+        void release() {
+            for (auto * event : events) {
+                lm_ggml_backend_event_synchronize(event);
+                lm_ggml_backend_event_free(event);
+            }
+            for (auto * buf : host_buffers) {
+                lm_ggml_backend_buffer_free(buf);
+            }
+            lm_ggml_backend_free(backend);
+            events.clear();
+            host_buffers.clear();
+            backend = nullptr;
+        }
+
+        ~upload_resources_guard() {
+            release();
+        }
+    } upload_guard { events, host_buffers, upload_backend };
+
     if (upload_backend) {
         LLAMA_LOG_DEBUG("%s: using async uploads for device %s, buffer type %s, backend %s\n", __func__,
             lm_ggml_backend_dev_name(lm_ggml_backend_get_device(upload_backend)),
@@ -1525,6 +1700,16 @@ bool llama_model_loader::load_all_data(
             lm_ggml_backend_name(upload_backend));
     }
 
+    const bool preloaded = ctxs_preloaded.count(ctx) > 0;
+
+    // reads and device uploads stay on this thread, CPU-side work goes to the pool
+    const int n_workers = std::min<int>(std::thread::hardware_concurrency(), 16);
+    std::unique_ptr<llama_load_workers> workers;
+    if (n_workers > 1 && !preloaded) {
+        workers = std::make_unique<llama_load_workers>(n_workers, 256*MiB);
+    }
+    size_t size_submitted = 0; // bytes handed to the pool, accounted in size_done once it drains
+
     for (struct lm_ggml_tensor * cur = lm_ggml_get_first_tensor(ctx); cur != NULL; cur = lm_ggml_get_next_tensor(ctx, cur)) {
         const auto * weight = get_weight(lm_ggml_get_name(cur));
         if (weight == nullptr) {
@@ -1533,13 +1718,19 @@ bool llama_model_loader::load_all_data(
         }
 
         if (progress_callback) {
-            if (!progress_callback((float) size_done / size_data, progress_callback_user_data)) {
+            const size_t size_workers = workers ? workers->size_done() : 0;
+            if (!progress_callback((float) (size_done + size_workers) / size_data, progress_callback_user_data)) {
                 return false;
             }
         }
 
         size_t n_size = lm_ggml_nbytes(cur);
 
+        if (preloaded) {
+            size_done += n_size;
+            continue;
+        }
+
         if (use_mmap) {
             const auto & mapping = mappings.at(weight->idx);
             lm_ggml_backend_buffer_t buf_mmap = nullptr;
@@ -1548,14 +1739,16 @@ bool llama_model_loader::load_all_data(
             }
             uint8_t * data = (uint8_t *) mapping->addr() + weight->offs;
 
-            if (check_tensors) {
-                validation_result.emplace_back(std::async(std::launch::async, [cur, data, n_size] {
-                    return std::make_pair(cur, lm_ggml_validate_row_data(cur->type, data, n_size));
-                }));
-            }
-
             LM_GGML_ASSERT(buf_mmap || cur->data); // either we have a buffer to allocate the tensor in, or it is already allocated
             if (buf_mmap && cur->data == nullptr) {
+                if (check_tensors) {
+                    if (workers) {
+                        workers->submit(0, 0, [&validate, cur, data, n_size] { validate(cur, data, n_size); });
+                    } else {
+                        validate(cur, data, n_size);
+                    }
+                }
+
                 lm_ggml_backend_tensor_alloc(buf_mmap, cur, data);
                 if (lmlocks) {
                     const auto & lmlock = lmlocks->at(weight->idx);
@@ -1565,7 +1758,20 @@ bool llama_model_loader::load_all_data(
                 auto & mmap_used = mmaps_used[weight->idx];
                 mmap_used.first  = std::min(mmap_used.first,  weight->offs);
                 mmap_used.second = std::max(mmap_used.second, weight->offs + n_size);
+            } else if (workers && llama_tensor_set_is_cpu(cur)) {
+                // page-in and copy/repack happen together on the worker
+                workers->submit(n_size, 0, [&validate, cur, data, n_size, check = check_tensors] {
+                    if (check) {
+                        validate(cur, data, n_size);
+                    }
+                    lm_ggml_backend_tensor_set(cur, data, 0, n_size);
+                });
+                size_submitted += n_size;
+                continue;
             } else {
+                if (check_tensors) {
+                    validate(cur, data, n_size);
+                }
                 lm_ggml_backend_tensor_set(cur, data, 0, n_size);
             }
         } else {
@@ -1575,9 +1781,11 @@ bool llama_model_loader::load_all_data(
                 file->seek(weight->offs, SEEK_SET);
                 file->read_raw(cur->data, n_size);
                 if (check_tensors) {
-                    validation_result.emplace_back(std::async(std::launch::async, [cur, n_size] {
-                        return std::make_pair(cur, lm_ggml_validate_row_data(cur->type, cur->data, n_size));
-                    }));
+                    if (workers) {
+                        workers->submit(0, 0, [&validate, cur, n_size] { validate(cur, cur->data, n_size); });
+                    } else {
+                        validate(cur, cur->data, n_size);
+                    }
                 }
             } else {
                 // If upload_backend is valid load the tensor in chunks to pinned memory and upload the buffers asynchronously to the GPU.
@@ -1633,13 +1841,26 @@ bool llama_model_loader::load_all_data(
                         ++buffer_idx;
                         buffer_idx %= n_buffers;
                     }
+                } else if (workers && llama_tensor_set_is_cpu(cur)) {
+                    // read into a staging buffer owned by the job so the next read can start right away
+                    auto staging = std::make_shared<std::vector<no_init<uint8_t>>>(n_size);
+                    file->seek(weight->offs, SEEK_SET);
+                    file->read_raw(staging->data(), n_size);
+                    workers->submit(n_size, n_size, [&validate, cur, staging, n_size, check = check_tensors] {
+                        lm_ggml_backend_tensor_set(cur, staging->data(), 0, n_size);
+                        if (check) {
+                            validate(cur, staging->data(), n_size);
+                        }
+                    });
+                    size_submitted += n_size;
+                    continue;
                 } else {
                     read_buf.resize(n_size);
                     file->seek(weight->offs, SEEK_SET);
                     file->read_raw(read_buf.data(), n_size);
                     lm_ggml_backend_tensor_set(cur, read_buf.data(), 0, n_size);
-                    if (check_tensors && !lm_ggml_validate_row_data(cur->type, read_buf.data(), n_size)) {
-                        throw std::runtime_error(format("tensor '%s' has invalid data", lm_ggml_get_name(cur)));
+                    if (check_tensors) {
+                        validate(cur, read_buf.data(), n_size);
                     }
                 }
             }
@@ -1648,26 +1869,20 @@ bool llama_model_loader::load_all_data(
         size_done += n_size;
     }
 
-    // free temporary resources used for async uploads
-    for (auto * event : events) {
-        lm_ggml_backend_event_synchronize(event);
-        lm_ggml_backend_event_free(event);
+    if (workers) {
+        workers->wait();
+        workers.reset();
+        size_done += size_submitted;
     }
-    for (auto * buf : host_buffers) {
-        lm_ggml_backend_buffer_free(buf);
-    }
-    lm_ggml_backend_free(upload_backend);
+
+    // free temporary resources used for async uploads
+    upload_guard.release();
 
     // check validation results
-    bool validation_failed = false;
-    for (auto & future : validation_result) {
-        auto result = future.get();
-        if (!result.second) {
-            LLAMA_LOG_ERROR("%s: tensor '%s' has invalid data\n", __func__, lm_ggml_get_name(result.first));
-            validation_failed = true;
-        }
+    for (const auto * t : invalid_tensors) {
+        LLAMA_LOG_ERROR("%s: tensor '%s' has invalid data\n", __func__, lm_ggml_get_name(t));
     }
-    if (validation_failed) {
+    if (!invalid_tensors.empty()) {
         throw std::runtime_error("found tensors with invalid data");
     }
 
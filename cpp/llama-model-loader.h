@@ -12,6 +12,7 @@
 #include <cstddef>
 #include <cstring>
 #include <map>
+#include <set>
 #include <stdexcept>
 #include <unordered_map>
 
@@ -105,6 +106,10 @@ struct llama_model_loader {
     size_t size_data = 0;
     std::vector<std::pair<size_t, size_t>> mmaps_used;
 
+    // contexts whose tensor data was supplied without reading the model (e.g. from the repacked weight cache)
+    // load_all_data only accounts for their size, so that progress and the final cleanup stay correct
+    std::set<const lm_ggml_context *> ctxs_preloaded;
+
     // define a comparator for the buft -> ctx map to ensure that the order is well-defined:
     struct lm_ggml_backend_buft_comparator {
         bool operator()(const lm_ggml_backend_buffer_type_t & lhs, const lm_ggml_backend_buffer_type_t & rhs) const {
@@ -197,6 +202,9 @@ struct llama_model_loader {
     // for backwards compatibility, does not support ggml-backend
     void load_data_for(struct lm_ggml_tensor * cur) const;
 
+    // copy size bytes at offset offs of a tensor's data in the model file into dst
+    void read_tensor_data(const llama_tensor_weight & w, size_t offs, void * dst, size_t size) const;
+
     // Returns false if cancelled by progress_callback
     bool load_all_data(
             struct lm_ggml_context * ctx,
@@ -26,9 +26,12 @@
 #include <algorithm>
 #include <cassert>
 #include <cfloat>
+#include <cinttypes>
 #include <cstdint>
+#include <chrono>
 #include <cstring>
 #include <cmath>
+#include <filesystem>
 #include <functional>
 #include <map>
 #include <numeric>
@@ -1263,6 +1266,282 @@ void llama_model_base::load_vocab(llama_model_loader & ml) {
     vocab.load(ml, kv);
 }
 
+//
+// repacked weight cache
+//
+// tensors placed in the CPU_REPACK buffer type are converted to an interleaved layout while loading,
+// which costs CPU time on every start and keeps a second, unshared copy of those weights in memory.
+// the result only depends on the weights, the CPU features and the repack code, so when a cache
+// directory is given the finished buffer is written there once and mmapped on later loads
+//
+
+#define LLAMA_REPACK_CACHE_MAGIC   0x4b50524cu // "LRPK"
+#define LLAMA_REPACK_CACHE_VERSION 1
+#define LLAMA_REPACK_CACHE_ALIGN   65536 // data section alignment, covers 4K/16K/64K pages
+#define LLAMA_REPACK_CACHE_MAX_FILES 4   // least recently used cache files beyond this are deleted
+
+struct llama_repack_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t n_tensors;
+    uint64_t data_offset; // start of the buffer image, LLAMA_REPACK_CACHE_ALIGN aligned
+    uint64_t data_size;
+};
+// followed by n_tensors entries: u32 name length, name, u64 offset in the buffer image, u64 size
+
+static bool llama_buft_is_cpu_repack(lm_ggml_backend_buffer_type_t buft) {
+    return strcmp(lm_ggml_backend_buft_name(buft), "CPU_REPACK") == 0;
+}
+
+static uint64_t llama_fnv1a(uint64_t h, const void * data, size_t n) {
+    const uint8_t * p = (const uint8_t *) data;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// identifies the repacked image of a context: repack code version, CPU features, tensor shapes and
+// placement, and a sample of each tensor's bytes so that models with the same layout do not collide
+static uint64_t llama_repack_cache_key(const llama_model_loader & ml, lm_ggml_context * ctx, lm_ggml_backend_buffer_type_t buft) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    const uint32_t version = LLAMA_REPACK_CACHE_VERSION;
+    h = llama_fnv1a(h, &version, sizeof(version));
+    const char * buft_name = lm_ggml_backend_buft_name(buft);
+    h = llama_fnv1a(h, buft_name, strlen(buft_name));
+
+    lm_ggml_backend_dev_t dev = lm_ggml_backend_buft_get_device(buft);
+    lm_ggml_backend_reg_t reg = dev ? lm_ggml_backend_dev_backend_reg(dev) : nullptr;
+    auto get_features_fn = reg ? (lm_ggml_backend_get_features_t)
+        lm_ggml_backend_reg_get_proc_address(reg, "lm_ggml_backend_get_features") : nullptr;
+    if (get_features_fn) {
+        for (auto * f = get_features_fn(reg); f && f->name; ++f) {
+            h = llama_fnv1a(h, f->name, strlen(f->name));
+            h = llama_fnv1a(h, f->value, strlen(f->value));
+        }
+    }
+
+    for (size_t i = 0; i < ml.files.size(); ++i) {
+        const size_t size = ml.files[i]->size();
+        h = llama_fnv1a(h, &size, sizeof(size));
+    }
+
+    uint8_t sample[128];
+    for (lm_ggml_tensor * t = lm_ggml_get_first_tensor(ctx); t != nullptr; t = lm_ggml_get_next_tensor(ctx, t)) {
+        h = llama_fnv1a(h, t->name, strlen(t->name));
+        h = llama_fnv1a(h, &t->type, sizeof(t->type));
+        h = llama_fnv1a(h, t->ne, sizeof(t->ne));
+
+        const auto * w = ml.get_weight(lm_ggml_get_name(t));
+        if (w == nullptr) {
+            continue;
+        }
+        h = llama_fnv1a(h, &w->idx, sizeof(w->idx));
+        h = llama_fnv1a(h, &w->offs, sizeof(w->offs));
+
+        // first and last bytes of the tensor
+        const size_t n_size = lm_ggml_nbytes(t);
+        const size_t n_half = std::min(n_size, sizeof(sample)) / 2;
+        ml.read_tensor_data(*w, 0, sample, n_half);
+        ml.read_tensor_data(*w, n_size - n_half, sample + n_half, n_half);
+        h = llama_fnv1a(h, sample, 2 * n_half);
+    }
+
+    return h;
+}
+
+static std::string llama_repack_cache_path(const char * dir, uint64_t key) {
+    std::string path = dir;
+    if (!path.empty() && path.back() != '/' && path.back() != '\\') {
+        path += '/';
+    }
+    return path + format("%016" PRIx64 ".lrpk", key);
+}
+
+// wrap a mapped cache image in a buffer of buft: the CPU backend's read-only repack buffer for CPU_REPACK,
+// a host pointer buffer of the device otherwise
+static lm_ggml_backend_buffer_t llama_repack_cache_buffer_from_ptr(lm_ggml_backend_buffer_type_t buft, void * ptr, size_t size, size_t max_size) {
+    lm_ggml_backend_dev_t dev = lm_ggml_backend_buft_get_device(buft);
+    if (dev == nullptr) {
+        // same workaround as load_tensors: the CPU backend buft has a NULL device
+        dev = lm_ggml_backend_dev_by_type(LM_GGML_BACKEND_DEVICE_TYPE_CPU);
+        if (dev == nullptr) {
+            return nullptr;
+        }
+    }
+    if (llama_buft_is_cpu_repack(buft)) {
+        auto buffer_from_ptr_fn = (lm_ggml_backend_cpu_repack_buffer_from_ptr_t)
+            lm_ggml_backend_reg_get_proc_address(lm_ggml_backend_dev_backend_reg(dev), "lm_ggml_backend_cpu_repack_buffer_from_ptr");
+        return buffer_from_ptr_fn ? buffer_from_ptr_fn(ptr, size) : nullptr;
+    }
+    lm_ggml_backend_dev_props props;
+    lm_ggml_backend_dev_get_props(dev, &props);
+    if (!props.caps.buffer_from_host_ptr || buft != lm_ggml_backend_dev_buffer_type(dev)) {
+        return nullptr;
+    }
+    return lm_ggml_backend_dev_buffer_from_host_ptr(dev, ptr, size, max_size);
+}
+
+// map a cache file and place every tensor of ctx in it; returns nullptr on any mismatch
+lm_ggml_backend_buffer_t llama_repack_cache_load(
+        const char * path, uint64_t key, lm_ggml_context * ctx, lm_ggml_backend_buffer_type_t buft, llama_mmaps & mappings) {
+    if (!llama_mmap::SUPPORTED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<llama_mmap> mapping;
+    std::map<std::string, std::pair<uint64_t, uint64_t>> entries;
+    llama_repack_cache_header hdr = {};
+    try {
+        llama_file file(path, "rb");
+        if (file.size() < sizeof(hdr)) {
+            return nullptr;
+        }
+        file.read_raw(&hdr, sizeof(hdr));
+        // the header comes from disk: compare against what is left of the file instead of adding to offsets,
+        // which could wrap around, and bound the table by the space in front of the data section
+        const uint64_t entry_min_size = sizeof(uint32_t) + 2*sizeof(uint64_t);
+        if (hdr.magic != LLAMA_REPACK_CACHE_MAGIC || hdr.version != LLAMA_REPACK_CACHE_VERSION || hdr.key != key ||
+                hdr.data_offset % LLAMA_REPACK_CACHE_ALIGN != 0 || hdr.data_offset < sizeof(hdr) ||
+                hdr.data_offset > file.size() || hdr.data_size > file.size() - hdr.data_offset ||
+                hdr.n_tensors > (hdr.data_offset - sizeof(hdr)) / entry_min_size) {
+            return nullptr;
+        }
+        for (uint64_t i = 0; i < hdr.n_tensors; ++i) {
+            const uint32_t name_len = file.read_u32();
+            if (name_len > LM_GGML_MAX_NAME) {
+                return nullptr;
+            }
+            std::string name(name_len, '\0');
+            file.read_raw(name.data(), name_len);
+            uint64_t offs_size[2];
+            file.read_raw(offs_size, sizeof(offs_size));
+            entries[name] = { offs_size[0], offs_size[1] };
+        }
+        mapping = std::make_unique<llama_mmap>(&file);
+    } catch (const std::exception & e) {
+        LLAMA_LOG_WARN("%s: failed to read repack cache '%s': %s\n", __func__, path, e.what());
+        return nullptr;
+    }
+
+    // every tensor must be present with the same size
+    size_t n_tensors = 0;
+    for (lm_ggml_tensor * t = lm_ggml_get_first_tensor(ctx); t != nullptr; t = lm_ggml_get_next_tensor(ctx, t)) {
+        const auto it = entries.find(lm_ggml_get_name(t));
+        if (it == entries.end() || it->second.second != lm_ggml_nbytes(t) ||
+                it->second.first > hdr.data_size || it->second.second > hdr.data_size - it->second.first) {
+            return nullptr;
+        }
+        n_tensors++;
+    }
+    if (n_tensors != entries.size()) {
+        return nullptr;
+    }
+
+    uint8_t * base = (uint8_t *) mapping->addr() + hdr.data_offset;
+    lm_ggml_backend_buffer_t buf = llama_repack_cache_buffer_from_ptr(buft, base, hdr.data_size, lm_ggml_get_max_tensor_size(ctx));
+    if (buf == nullptr) {
+        return nullptr;
+    }
+    for (lm_ggml_tensor * t = lm_ggml_get_first_tensor(ctx); t != nullptr; t = lm_ggml_get_next_tensor(ctx, t)) {
+        if (lm_ggml_backend_tensor_alloc(buf, t, base + entries.at(lm_ggml_get_name(t)).first) != LM_GGML_STATUS_SUCCESS) {
+            lm_ggml_backend_buffer_free(buf);
+            return nullptr;
+        }
+    }
+
+    mappings.emplace_back(std::move(mapping));
+
+    // mark the file as recently used for llama_repack_cache_evict
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return buf;
+}
+
+// keep the LLAMA_REPACK_CACHE_MAX_FILES most recently used cache files of dir and delete the rest,
+// along with temporary files left behind by interrupted writes; every model writes a file about the
+// size of its repacked weights, so an unbounded directory would keep growing as models change
+static void llama_repack_cache_evict(const std::string & dir) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    std::vector<std::pair<fs::file_time_type, fs::path>> files;
+    const auto stale = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (const auto & entry : fs::directory_iterator(dir, ec)) {
+        const fs::path & p = entry.path();
+        const std::string name = p.filename().string();
+        const fs::file_time_type mtime = entry.last_write_time(ec);
+        if (ec || !entry.is_regular_file(ec)) {
+            continue;
+        }
+        if (p.extension() == ".lrpk") {
+            files.emplace_back(mtime, p);
+        } else if (name.size() > 9 && name.compare(name.size() - 9, 9, ".lrpk.tmp") == 0 && mtime < stale) {
+            fs::remove(p, ec);
+        }
+    }
+    if (files.size() <= LLAMA_REPACK_CACHE_MAX_FILES) {
+        return;
+    }
+    std::sort(files.begin(), files.end(), [](const auto & a, const auto & b) { return a.first > b.first; });
+    for (size_t i = LLAMA_REPACK_CACHE_MAX_FILES; i < files.size(); ++i) {
+        if (fs::remove(files[i].second, ec)) {
+            LLAMA_LOG_INFO("%s: evicted repack cache '%s'\n", __func__, files[i].second.string().c_str());
+        }
+    }
+}
+
+// write the loaded buffer image; written to a temporary file first so readers never see a partial cache
+bool llama_repack_cache_save(const char * path, uint64_t key, lm_ggml_context * ctx, lm_ggml_backend_buffer_t buf) {
+    const uint8_t * base = (const uint8_t *) lm_ggml_backend_buffer_get_base(buf);
+    const size_t    size = lm_ggml_backend_buffer_get_size(buf);
+
+    std::vector<uint8_t> table;
+    uint64_t n_tensors = 0;
+    for (lm_ggml_tensor * t = lm_ggml_get_first_tensor(ctx); t != nullptr; t = lm_ggml_get_next_tensor(ctx, t)) {
+        if (t->data == nullptr || t->buffer != buf) {
+            return false;
+        }
+        const uint32_t name_len = (uint32_t) strlen(t->name);
+        const uint64_t offs_size[2] = { (uint64_t) ((const uint8_t *) t->data - base), (uint64_t) lm_ggml_nbytes(t) };
+        table.insert(table.end(), (const uint8_t *) &name_len, (const uint8_t *) &name_len + sizeof(name_len));
+        table.insert(table.end(), (const uint8_t *) t->name, (const uint8_t *) t->name + name_len);
+        table.insert(table.end(), (const uint8_t *) offs_size, (const uint8_t *) offs_size + sizeof(offs_size));
+        n_tensors++;
+    }
+
+    llama_repack_cache_header hdr = {};
+    hdr.magic       = LLAMA_REPACK_CACHE_MAGIC;
+    hdr.version     = LLAMA_REPACK_CACHE_VERSION;
+    hdr.key         = key;
+    hdr.n_tensors   = n_tensors;
+    hdr.data_offset = LM_GGML_PAD(sizeof(hdr) + table.size(), LLAMA_REPACK_CACHE_ALIGN);
+    hdr.data_size   = size;
+
+    const std::string tmp_path = std::string(path) + ".tmp";
+    try {
+        {
+            llama_file file(tmp_path.c_str(), "wb");
+            file.write_raw(&hdr, sizeof(hdr));
+            file.write_raw(table.data(), table.size());
+            const std::vector<uint8_t> pad(hdr.data_offset - sizeof(hdr) - table.size(), 0);
+            file.write_raw(pad.data(), pad.size());
+            file.write_raw(base, size);
+        }
+        if (std::rename(tmp_path.c_str(), path) != 0) {
+            throw std::runtime_error("rename failed");
+        }
+        LLAMA_LOG_INFO("%s: wrote repack cache '%s' (%.2f MiB)\n", __func__, path, size / 1024.0 / 1024.0);
+    } catch (const std::exception & e) {
+        std::remove(tmp_path.c_str());
+        LLAMA_LOG_WARN("%s: failed to write repack cache '%s': %s\n", __func__, path, e.what());
+        return false;
+    }
+    return true;
+}
+
 bool llama_model_base::load_tensors(llama_model_loader & ml) {
     const auto & split_mode   = params.split_mode;
     const bool use_mlock      = params.load_mode == LLAMA_LOAD_MODE_MLOCK || params.load_mode == LLAMA_LOAD_MODE_MMAP_MLOCK;
@@ -1565,6 +1844,16 @@ bool llama_model_base::load_tensors(llama_model_loader & ml) {
     const size_t n_max_backend_buffer = ml.ctx_map.size() * ml.files.size();
     pimpl->ctxs_bufs.reserve(n_max_backend_buffer);
 
+    // repacked buffers to write to the cache once their data is loaded
+    struct repack_cache_pending {
+        lm_ggml_context * ctx;
+        lm_ggml_backend_buffer_t buf;
+        std::string path;
+        uint64_t key;
+    };
+    std::vector<repack_cache_pending> repack_cache_writes;
+    const bool use_repack_cache = params.repack_cache_dir && params.repack_cache_dir[0] != '\0' && !ml.files.empty();
+
     for (auto & [buft, ctx_ptr] : ml.ctx_map) {
         lm_ggml_context * ctx = ctx_ptr.get();
 
@@ -1619,6 +1908,26 @@ bool llama_model_base::load_tensors(llama_model_loader & ml) {
                 for (lm_ggml_tensor * t = lm_ggml_get_first_tensor(ctx); t != nullptr; t = lm_ggml_get_next_tensor(ctx, t)) {
                     t->buffer = buf; // set dummy buffer for weights so that the backend scheduler won't try to allocate them
                 }
+            } else if (use_repack_cache && llama_buft_is_cpu_repack(buft)) {
+                const uint64_t key = llama_repack_cache_key(ml, ctx, buft);
+                std::string path = llama_repack_cache_path(params.repack_cache_dir, key);
+                buf = llama_repack_cache_load(path.c_str(), key, ctx, buft, pimpl->mappings);
+                if (buf) {
+                    LLAMA_LOG_INFO("%s: using repack cache '%s'\n", __func__, path.c_str());
+                    ml.ctxs_preloaded.insert(ctx);
+                    // the repack buffer type is not host, so the check below does not lock the mapped image
+                    if (use_mlock && !lm_ggml_backend_buffer_is_host(buf)) {
+                        pimpl->mlock_bufs.emplace_back(new llama_mlock);
+                        auto & mlock_buf = pimpl->mlock_bufs.back();
+                        mlock_buf->init   (lm_ggml_backend_buffer_get_base(buf));
+                        mlock_buf->grow_to(lm_ggml_backend_buffer_get_size(buf));
+                    }
+                } else {
+                    buf = lm_ggml_backend_alloc_ctx_tensors_from_buft(ctx, buft);
+                    if (buf) {
+                        repack_cache_writes.push_back({ ctx, buf, std::move(path), key });
+                    }
+                }
             } else {
                 buf = lm_ggml_backend_alloc_ctx_tensors_from_buft(ctx, buft); // real buffer
             }
@@ -1683,6 +1992,12 @@ bool llama_model_base::load_tensors(llama_model_loader & ml) {
         }
     }
 
+    for (const auto & w : repack_cache_writes) {
+        if (llama_repack_cache_save(w.path.c_str(), w.key, w.ctx, w.buf)) {
+            llama_repack_cache_evict(params.repack_cache_dir);
+        }
+    }
+
     if (use_mmap_buffer) {
         for (auto & mapping : ml.mappings) {
             pimpl->mappings.emplace_back(std::move(mapping));
@@ -2432,7 +2747,8 @@ llama_memory_i * llama_model::create_memory(const llama_memory_params & params,
                                 nullptr,
                                 filter,
                                 nullptr,
-                                nullptr);
+                                nullptr,
+                                params.n_kv_hot);
                     }
                 }
             }
@@ -2484,6 +2800,7 @@ llama_model_params llama_model_default_params() {
         /*.no_host                     =*/ false,
         /*.no_alloc                    =*/ false,
         /*.load_mtp                    =*/ false,
+        /*.repack_cache_dir            =*/ nullptr,
     };
 
     return result;
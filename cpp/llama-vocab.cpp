@@ -13,12 +13,17 @@
 #include <cfloat>
 #include <cmath>
 #include <cstdarg>
+#include <cstdlib>
 #include <cstring>
 #include <forward_list>
 #include <limits>
+#include <list>
 #include <map>
+#include <mutex>
 #include <queue>
 #include <set>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 
 //
@@ -258,6 +263,11 @@ public:
     }
 
     void pop() =  delete;
+
+    // keeps the allocated storage for reuse
+    void clear() {
+        this->c.clear();
+    }
 };
 
 struct llm_bigram_bpe {
@@ -271,9 +281,128 @@ struct llm_bigram_bpe {
     using queue = llama_priority_queue<llm_bigram_bpe, queue_storage, comparator>;
     llm_symbol::index left;
     llm_symbol::index right;
-    std::string text;
+    size_t left_n;  // symbol sizes when the bigram was queued, used to detect outdated bigrams
+    size_t right_n;
     int rank;
-    size_t size;
+    llama_token merged; // token of the merged symbol, LLAMA_TOKEN_NULL if it is not in the vocab
+};
+
+// BPE merges keyed on the (left, right) token ids, open addressing with linear probing
+// only merges whose both sides are tokens of the vocab are stored, the rest is looked up by text
+struct llm_bpe_merge_table {
+    struct entry {
+        uint64_t    key;
+        int32_t     rank; // -1 = empty slot
+        llama_token merged;
+    };
+
+    static uint64_t make_key(llama_token left, llama_token right) {
+        return ((uint64_t) (uint32_t) left << 32) | (uint32_t) right;
+    }
+
+    static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    void reserve(size_t n) {
+        size_t size = 16;
+        while (size < n + n/2) {
+            size *= 2;
+        }
+        entries.assign(size, entry{0, -1, LLAMA_TOKEN_NULL});
+        mask = size - 1;
+    }
+
+    // keeps the first insertion of a pair
+    void insert(llama_token left, llama_token right, int32_t rank, llama_token merged) {
+        const uint64_t key = make_key(left, right);
+        for (size_t i = hash(key) & mask; ; i = (i + 1) & mask) {
+            entry & e = entries[i];
+            if (e.rank < 0) {
+                e = entry{key, rank, merged};
+                return;
+            }
+            if (e.key == key) {
+                return;
+            }
+        }
+    }
+
+    int32_t find(llama_token left, llama_token right, llama_token & merged) const {
+        if (entries.empty()) {
+            return -1;
+        }
+        const uint64_t key = make_key(left, right);
+        for (size_t i = hash(key) & mask; ; i = (i + 1) & mask) {
+            const entry & e = entries[i];
+            if (e.rank < 0) {
+                return -1;
+            }
+            if (e.key == key) {
+                merged = e.merged;
+                return e.rank;
+            }
+        }
+    }
+
+    std::vector<entry> entries;
+    size_t mask = 0;
+};
+
+// bounded LRU of pre-tokenized words to their tokens, shared by all sessions of a BPE tokenizer
+// sharded so that concurrent tokenize calls rarely contend on the same lock
+struct llm_bpe_word_cache {
+    static constexpr size_t n_shards        = 16;
+    static constexpr size_t max_per_shard   = 1024;
+    static constexpr size_t max_word_length = 128;
+
+    static bool cacheable(const std::string & word) {
+        return word.size() > 1 && word.size() <= max_word_length;
+    }
+
+    // appends the cached tokens of word to output, returns false on a miss
+    bool get(const std::string & word, std::vector<llama_token> & output) {
+        shard & sh = shards[std::hash<std::string_view>{}(word) % n_shards];
+        std::lock_guard<std::mutex> lock(sh.mutex);
+        auto it = sh.index.find(word);
+        if (it == sh.index.end()) {
+            return false;
+        }
+        sh.lru.splice(sh.lru.begin(), sh.lru, it->second);
+        output.insert(output.end(), it->second->tokens.begin(), it->second->tokens.end());
+        return true;
+    }
+
+    void put(const std::string & word, const llama_token * tokens, size_t n_tokens) {
+        shard & sh = shards[std::hash<std::string_view>{}(word) % n_shards];
+        std::lock_guard<std::mutex> lock(sh.mutex);
+        if (sh.index.find(word) != sh.index.end()) {
+            return;
+        }
+        if (sh.lru.size() >= max_per_shard) {
+            sh.index.erase(sh.lru.back().word);
+            sh.lru.pop_back();
+        }
+        sh.lru.push_front(item{word, std::vector<llama_token>(tokens, tokens + n_tokens)});
+        sh.index.emplace(sh.lru.front().word, sh.lru.begin());
+    }
+
+private:
+    struct item {
+        std::string              word;
+        std::vector<llama_token> tokens;
+    };
+
+    struct shard {
+        std::mutex      mutex;
+        std::list<item> lru;
+        std::unordered_map<std::string_view, std::list<item>::iterator> index; // keys point into lru
+    };
+
+    shard shards[n_shards];
 };
 
 struct llm_tokenizer_bpe : llm_tokenizer {
@@ -556,6 +685,8 @@ struct llm_tokenizer_bpe : llm_tokenizer {
 
     std::vector<std::string> regex_exprs;
     bool byte_encode = true; // GPT-2 byte encoding; false for SPM-style BPE (raw UTF-8)
+
+    mutable llm_bpe_word_cache word_cache;
 };
 
 struct llm_tokenizer_bpe_session {
@@ -601,138 +732,145 @@ struct llm_tokenizer_bpe_session {
     }
 
     virtual void tokenize(const std::string & text, std::vector<llama_token> & output) {
-        int final_prev_index = -1;
         const auto word_collection = unicode_regex_split(text, tokenizer.regex_exprs, tokenizer.byte_encode);
 
-        symbols_final.clear();
-        auto tok_pre = vocab.get_pre_type();
-
         for (const auto & word : word_collection) {
-            work_queue = llm_bigram_bpe::queue();
-            symbols.clear();
+            if (!llm_bpe_word_cache::cacheable(word)) {
+                tokenize_word(word, output);
+                continue;
+            }
 
-            int index = 0;
-            size_t offset = 0;
+            if (tokenizer.word_cache.get(word, output)) {
+                continue;
+            }
+
+            const size_t n_before = output.size();
+            tokenize_word(word, output);
+            tokenizer.word_cache.put(word, output.data() + n_before, output.size() - n_before);
+        }
+    }
+
+private:
+    // merges a single pre-tokenized word and appends its tokens to output
+    void tokenize_word(const std::string & word, std::vector<llama_token> & output) {
+        work_queue.clear();
+        symbols.clear();
+        symbol_ids.clear();
 
-            //if (vocab.tokenizer_ignore_merges && vocab.token_to_id.find(word) != vocab.token_to_id.end()) {
-            if (vocab.get_ignore_merges() && vocab.text_to_token(word) != LLAMA_TOKEN_NULL) {
+        int index = 0;
+        size_t offset = 0;
+
+        //if (vocab.tokenizer_ignore_merges && vocab.token_to_id.find(word) != vocab.token_to_id.end()) {
+        const llama_token word_id = vocab.get_ignore_merges() ? vocab.text_to_token(word) : LLAMA_TOKEN_NULL;
+        if (word_id != LLAMA_TOKEN_NULL) {
+            symbols.emplace_back(llm_symbol{-1, -1, word.c_str(), word.size()});
+            symbol_ids.push_back(word_id);
+            offset = word.size();
+        } else if (vocab.get_pre_type() == LLAMA_VOCAB_PRE_TYPE_GEMMA4 && word.find_first_not_of('\n') == std::string::npos) {
+            // fix for gemma 4, ref: https://github.com/ggml-org/llama.cpp/pull/21343
+            auto tok = vocab.text_to_token(word);
+            if (tok != LLAMA_TOKEN_NULL) {
                 symbols.emplace_back(llm_symbol{-1, -1, word.c_str(), word.size()});
+                symbol_ids.push_back(tok);
                 offset = word.size();
-            } else if (tok_pre == LLAMA_VOCAB_PRE_TYPE_GEMMA4 && word.find_first_not_of('\n') == std::string::npos) {
-                // fix for gemma 4, ref: https://github.com/ggml-org/llama.cpp/pull/21343
-                auto tok = vocab.text_to_token(word);
-                if (tok != LLAMA_TOKEN_NULL) {
-                    symbols.emplace_back(llm_symbol{-1, -1, word.c_str(), word.size()});
-                    offset = word.size();
-                }
-            }
-
-            while (offset < word.size()) {
-                llm_symbol sym;
-                size_t char_len = std::min(word.size() - offset, (size_t) unicode_len_utf8(word[offset]));
-                sym.text = word.c_str() + offset;
-                sym.n = char_len;
-                offset += sym.n;
-                sym.prev = index - 1;
-                sym.next = offset == word.size() ? -1 : index + 1;
-                index++;
-                symbols.emplace_back(sym);
-            }
-            for (int i = 1; i < (int) symbols.size(); ++i) {
-                add_new_bigram(i - 1, i);
             }
+        }
 
-            // build token(s)
-            while (!work_queue.empty()) {
-                auto bigram = work_queue.pop_move();
+        while (offset < word.size()) {
+            llm_symbol sym;
+            size_t char_len = std::min(word.size() - offset, (size_t) unicode_len_utf8(word[offset]));
+            sym.text = word.c_str() + offset;
+            sym.n = char_len;
+            offset += sym.n;
+            sym.prev = index - 1;
+            sym.next = offset == word.size() ? -1 : index + 1;
+            index++;
+            symbols.emplace_back(sym);
+            symbol_ids.push_back(vocab.text_to_token(std::string(sym.text, sym.n)));
+        }
+        for (int i = 1; i < (int) symbols.size(); ++i) {
+            add_new_bigram(i - 1, i);
+        }
 
-                auto & left_symbol = symbols[bigram.left];
-                auto & right_symbol = symbols[bigram.right];
+        // build token(s)
+        while (!work_queue.empty()) {
+            const auto bigram = work_queue.pop_move();
 
-                if (left_symbol.n == 0 || right_symbol.n == 0) {
-                    continue;
-                }
-                std::string left_token = std::string(left_symbol.text, left_symbol.n);
-                std::string right_token = std::string(right_symbol.text, right_symbol.n);
-                if (left_token + right_token != bigram.text) {
-                    continue;  // Skip this bigram if it's outdated
-                }
+            auto & left_symbol = symbols[bigram.left];
+            auto & right_symbol = symbols[bigram.right];
 
-                // merge the right sym into the left one
-                left_symbol.n += right_symbol.n;
-                right_symbol.n = 0;
+            if (left_symbol.n == 0 || right_symbol.n == 0) {
+                continue;
+            }
+            if (left_symbol.n != bigram.left_n || right_symbol.n != bigram.right_n) {
+                continue;  // Skip this bigram if it's outdated
+            }
 
-                // remove the right sym from the chain
-                left_symbol.next = right_symbol.next;
-                if (right_symbol.next >= 0) {
-                    symbols[right_symbol.next].prev = bigram.left;
-                }
+            // merge the right sym into the left one
+            left_symbol.n += right_symbol.n;
+            right_symbol.n = 0;
+            symbol_ids[bigram.left] = bigram.merged;
 
-                add_new_bigram(left_symbol.prev, bigram.left);  // left side of current symbol
-                add_new_bigram(bigram.left, left_symbol.next);  // right side of current symbol
+            // remove the right sym from the chain
+            left_symbol.next = right_symbol.next;
+            if (right_symbol.next >= 0) {
+                symbols[right_symbol.next].prev = bigram.left;
             }
 
-            // add the finished tokens to the final list keeping correct order for next and prev
-            for (auto & sym : symbols) {
-                if (sym.n > 0) {
-                    sym.prev = final_prev_index;
-                    sym.next = -1;
-                    if (final_prev_index != -1) {
-                        symbols_final[final_prev_index].next = symbols_final.size();
-                    }
-                    symbols_final.emplace_back(sym);
-                    final_prev_index = symbols_final.size() - 1;
-                }
-            }
+            add_new_bigram(left_symbol.prev, bigram.left);  // left side of current symbol
+            add_new_bigram(bigram.left, left_symbol.next);  // right side of current symbol
         }
 
-        symbols = symbols_final;
-
-        if (!symbols.empty()) {
-            for (int i = 0; i != -1; i = symbols[i].next) {
-                auto & symbol = symbols[i];
-                if (symbol.n == 0) {
-                    continue;
-                }
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            const auto & symbol = symbols[i];
+            if (symbol.n == 0) {
+                continue;
+            }
 
-                const std::string str = std::string(symbol.text, symbol.n);
-                const auto token = vocab.text_to_token(str);
+            if (symbol_ids[i] != LLAMA_TOKEN_NULL) {
+                output.push_back(symbol_ids[i]);
+                continue;
+            }
 
-                if (token == LLAMA_TOKEN_NULL) {
-                    for (auto j = str.begin(); j != str.end(); ++j) {
-                        llama_token token_multibyte = LLAMA_TOKEN_NULL;
-                        if (tokenizer.byte_encode) {
-                            std::string byte_str(1, *j);
-                            token_multibyte = vocab.text_to_token(byte_str);
-                        } else {
-                            // For non-byte-encoded BPE (e.g. gemma-4), byte tokens use <0xXX> format
-                            static const char * hex = "0123456789ABCDEF";
-                            const uint8_t ch = (uint8_t)*j;
-                            const char buf[7] = { '<', '0', 'x', hex[ch >> 4], hex[ch & 15], '>', 0 };
-                            token_multibyte = vocab.text_to_token(buf);
-                        }
-                        if (token_multibyte != LLAMA_TOKEN_NULL) {
-                            output.push_back(token_multibyte);
-                        }
-                    }
+            for (size_t j = 0; j < symbol.n; ++j) {
+                llama_token token_multibyte = LLAMA_TOKEN_NULL;
+                if (tokenizer.byte_encode) {
+                    std::string byte_str(1, symbol.text[j]);
+                    token_multibyte = vocab.text_to_token(byte_str);
                 } else {
-                    output.push_back(token);
+                    // For non-byte-encoded BPE (e.g. gemma-4), byte tokens use <0xXX> format
+                    static const char * hex = "0123456789ABCDEF";
+                    const uint8_t ch = (uint8_t) symbol.text[j];
+                    const char buf[7] = { '<', '0', 'x', hex[ch >> 4], hex[ch & 15], '>', 0 };
+                    token_multibyte = vocab.text_to_token(buf);
+                }
+                if (token_multibyte != LLAMA_TOKEN_NULL) {
+                    output.push_back(token_multibyte);
                 }
             }
         }
     }
 
-private:
     void add_new_bigram(int left, int right) {
         if (left == -1 || right == -1) {
             return;
         }
-        std::string left_token  = std::string(symbols[left].text,  symbols[left].n);
-        std::string right_token = std::string(symbols[right].text, symbols[right].n);
 
+        llama_token merged = LLAMA_TOKEN_NULL;
         int rank_found = -1;
 
-        rank_found = vocab.find_bpe_rank(left_token, right_token);
+        if (symbol_ids[left] != LLAMA_TOKEN_NULL && symbol_ids[right] != LLAMA_TOKEN_NULL) {
+            rank_found = vocab.find_bpe_rank(symbol_ids[left], symbol_ids[right], merged);
+        } else {
+            // at least one side is not a token of the vocab, fall back to the text lookup
+            std::string left_token  = std::string(symbols[left].text,  symbols[left].n);
+            std::string right_token = std::string(symbols[right].text, symbols[right].n);
+
+            rank_found = vocab.find_bpe_rank(left_token, right_token);
+            if (rank_found >= 0) {
+                merged = vocab.text_to_token(left_token + right_token);
+            }
+        }
 
         if (rank_found < 0) {
             return;
@@ -740,11 +878,12 @@ private:
 
         llm_bigram_bpe bigram;
 
-        bigram.left  = left;
-        bigram.right = right;
-        bigram.text  = left_token + right_token;
-        bigram.size  = left_token.size() + right_token.size();
-        bigram.rank  = rank_found;
+        bigram.left    = left;
+        bigram.right   = right;
+        bigram.left_n  = symbols[left].n;
+        bigram.right_n = symbols[right].n;
+        bigram.rank    = rank_found;
+        bigram.merged  = merged;
 
         work_queue.push(bigram);
     }
@@ -752,9 +891,9 @@ private:
     const llama_vocab & vocab;
     const llm_tokenizer_bpe & tokenizer;
 
-    std::vector<llm_symbol> symbols;
-    std::vector<llm_symbol> symbols_final;
-    llm_bigram_bpe::queue work_queue;
+    std::vector<llm_symbol>  symbols;
+    std::vector<llama_token> symbol_ids; // token of each symbol, LLAMA_TOKEN_NULL if its text is not in the vocab
+    llm_bigram_bpe::queue    work_queue;
 };
 
 //
@@ -1778,6 +1917,116 @@ struct fragment_buffer_variant {
     const uint64_t length;
 };
 
+// Aho-Corasick automaton over the special token texts
+// all occurrences of all patterns are reported in a single pass over the input
+struct llm_special_token_matcher {
+    struct node {
+        uint32_t edge_begin = 0; // outgoing edges in [edge_begin, edge_end), sorted by byte
+        uint32_t edge_end   = 0;
+        uint32_t fail       = 0;
+        int32_t  out        = -1; // pattern ending at this node
+        int32_t  out_next   = -1; // next node on the fail chain with an output
+    };
+
+    // patterns are identified by their index in the input, empty patterns are never reported
+    void build(const std::vector<std::string> & patterns) {
+        nodes.clear();
+        edge_byte.clear();
+        edge_node.clear();
+        pattern_len.clear();
+
+        std::vector<std::map<uint8_t, uint32_t>> trie(1);
+        std::vector<int32_t> out(1, -1);
+
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            pattern_len.push_back((uint32_t) patterns[i].size());
+            if (patterns[i].empty()) {
+                continue;
+            }
+            uint32_t cur = 0;
+            for (const char c : patterns[i]) {
+                auto res = trie[cur].emplace((uint8_t) c, (uint32_t) trie.size());
+                if (res.second) {
+                    trie.emplace_back();
+                    out.push_back(-1);
+                }
+                cur = res.first->second;
+            }
+            if (out[cur] < 0) {
+                out[cur] = (int32_t) i;
+            }
+        }
+
+        nodes.resize(trie.size());
+        for (size_t i = 0; i < trie.size(); ++i) {
+            nodes[i].edge_begin = (uint32_t) edge_byte.size();
+            for (const auto & e : trie[i]) {
+                edge_byte.push_back(e.first);
+                edge_node.push_back(e.second);
+            }
+            nodes[i].edge_end = (uint32_t) edge_byte.size();
+            nodes[i].out      = out[i];
+        }
+
+        root_next.assign(256, 0);
+        for (const auto & e : trie[0]) {
+            root_next[e.first] = e.second;
+        }
+
+        // breadth-first fail links; a node's fail target is always shallower, so it is complete when visited
+        std::queue<uint32_t> bfs;
+        for (const auto & e : trie[0]) {
+            bfs.push(e.second);
+        }
+        while (!bfs.empty()) {
+            const uint32_t cur = bfs.front();
+            bfs.pop();
+            for (const auto & e : trie[cur]) {
+                const uint32_t child = e.second;
+                nodes[child].fail     = next(nodes[cur].fail, e.first);
+                nodes[child].out_next = nodes[nodes[child].fail].out >= 0 ? (int32_t) nodes[child].fail : nodes[nodes[child].fail].out_next;
+                bfs.push(child);
+            }
+        }
+    }
+
+    bool empty() const {
+        return nodes.size() <= 1;
+    }
+
+    // calls cb(pattern, start) for every occurrence inside text[offset, offset + length)
+    template <typename F>
+    void find_all(const std::string & text, size_t offset, size_t length, F && cb) const {
+        uint32_t cur = 0;
+        for (size_t i = offset; i < offset + length; ++i) {
+            cur = next(cur, (uint8_t) text[i]);
+            for (int32_t n = nodes[cur].out >= 0 ? (int32_t) cur : nodes[cur].out_next; n >= 0; n = nodes[n].out_next) {
+                const int32_t p = nodes[n].out;
+                cb(p, i + 1 - pattern_len[p]);
+            }
+        }
+    }
+
+    uint32_t next(uint32_t cur, uint8_t c) const {
+        while (cur != 0) {
+            const uint8_t * begin = edge_byte.data() + nodes[cur].edge_begin;
+            const uint8_t * end   = edge_byte.data() + nodes[cur].edge_end;
+            const uint8_t * it    = std::lower_bound(begin, end, c);
+            if (it != end && *it == c) {
+                return edge_node[it - edge_byte.data()];
+            }
+            cur = nodes[cur].fail;
+        }
+        return root_next[c];
+    }
+
+    std::vector<node>     nodes;
+    std::vector<uint32_t> root_next; // dense transitions out of the root
+    std::vector<uint8_t>  edge_byte;
+    std::vector<uint32_t> edge_node;
+    std::vector<uint32_t> pattern_len;
+};
+
 struct llama_vocab::impl {
     uint32_t n_token_types = 0; // for BERT-style token types
 
@@ -1828,6 +2077,10 @@ struct llama_vocab::impl {
     std::vector<token_data>                      id_to_token;
 
     std::vector<llama_token> cache_special_tokens;
+    llm_special_token_matcher cache_special_matcher; // patterns follow the cache_special_tokens order
+
+    // long raw text can be tokenized in independent pieces split after a newline, see tokenizer_split_fragments
+    bool split_at_newlines = false;
     std::vector<std::string> cache_token_to_piece; // llama_token_to_piece(special = true);
     struct pair_hash {
         size_t operator()(const std::pair<std::string, std::string> & p) const {
@@ -1836,6 +2089,7 @@ struct llama_vocab::impl {
         }
     };
     std::unordered_map<std::pair<std::string, std::string>, int, pair_hash> bpe_ranks;
+    llm_bpe_merge_table bpe_merges; // bpe_ranks keyed on token ids, built by init_tokenizer
 
     // set of all tokens that cause "end of generation"
     std::set<llama_token> special_eog_ids;
@@ -1873,6 +2127,16 @@ struct llama_vocab::impl {
 
     void tokenizer_st_partition(std::forward_list<fragment_buffer_variant> & buffer, bool parse_special) const;
 
+    using fragment_iterator = std::forward_list<fragment_buffer_variant>::const_iterator;
+
+    // tokenizes the fragments in [begin, end) without BOS/EOS
+    // is_prev_special tells whether the fragment before begin is a token (or begin is the first fragment)
+    void tokenize_fragments(fragment_iterator begin, fragment_iterator end, bool is_prev_special, std::vector<llama_token> & output) const;
+
+    // splits long raw text fragments at newlines and tokenizes them on up to n_threads threads
+    // returns false if the fragments were tokenized serially
+    bool tokenize_fragments_mt(std::forward_list<fragment_buffer_variant> & buffer, int32_t n_threads, std::vector<llama_token> & output) const;
+
     std::string token_to_piece_for_cache(
                   llama_token   token,
                          bool   special) const;
@@ -1881,7 +2145,8 @@ struct llama_vocab::impl {
     std::vector<llama_token> tokenize(
             const std::string & raw_text,
                          bool   add_special,
-                         bool   parse_special = false) const;
+                         bool   parse_special = false,
+                      int32_t   n_threads     = 1) const;
 
     int32_t tokenize(
                    const char * text,
@@ -2960,9 +3225,43 @@ void llama_vocab::impl::load(llama_model_loader & ml, const LLM_KV & kv) {
             }
         );
 
+
+        std::vector<std::string> patterns;
+        patterns.reserve(cache_special_tokens.size());
+        for (const llama_token id : cache_special_tokens) {
+            patterns.push_back(id_to_token[id].text);
+        }
+        cache_special_matcher.build(patterns);
+
         LLAMA_LOG_INFO("%s: special tokens cache size = %u\n", __func__, (uint32_t) cache_special_tokens.size());
     }
 
+    // a newline that ends a non-empty line and is followed by an alphanumeric char is a boundary for all the BPE
+    // pre-tokenizers and for WPM; SPM merges can only cross it if a token contains such a sequence
+    {
+        switch (type) {
+            case LLAMA_VOCAB_TYPE_BPE:
+                split_at_newlines = tokenizer_model != "hybriddna";
+                break;
+            case LLAMA_VOCAB_TYPE_WPM:
+                split_at_newlines = true;
+                break;
+            case LLAMA_VOCAB_TYPE_SPM:
+                split_at_newlines = true;
+                for (const auto & td : id_to_token) {
+                    for (size_t pos = td.text.find('\n'); pos != std::string::npos && split_at_newlines; pos = td.text.find('\n', pos + 1)) {
+                        if (pos + 1 < td.text.size() && isalnum((unsigned char) td.text[pos + 1])) {
+                            split_at_newlines = false;
+                        }
+                    }
+                }
+                break;
+            default:
+                split_at_newlines = false;
+                break;
+        }
+    }
+
     // build token to piece cache
     {
         size_t size_cache = 0;
@@ -3137,8 +3436,19 @@ void llama_vocab::impl::init_tokenizer(enum llama_vocab_type type) {
             tokenizer = std::make_unique<llm_tokenizer_spm>(vocab);
             break;
         case LLAMA_VOCAB_TYPE_BPE:
-            tokenizer = std::make_unique<llm_tokenizer_bpe>(vocab);
-            break;
+            {
+                bpe_merges.reserve(bpe_ranks.size());
+                for (const auto & [pair, rank] : bpe_ranks) {
+                    const auto left  = token_to_id.find(pair.first);
+                    const auto right = token_to_id.find(pair.second);
+                    if (left == token_to_id.end() || right == token_to_id.end()) {
+                        continue;
+                    }
+                    const auto merged = token_to_id.find(pair.first + pair.second);
+                    bpe_merges.insert(left->second, right->second, rank, merged == token_to_id.end() ? LLAMA_TOKEN_NULL : merged->second);
+                }
+                tokenizer = std::make_unique<llm_tokenizer_bpe>(vocab);
+            } break;
         case LLAMA_VOCAB_TYPE_WPM:
             tokenizer = std::make_unique<llm_tokenizer_wpm>(vocab);
             break;
@@ -3163,120 +3473,113 @@ void llama_vocab::impl::init_tokenizer(enum llama_vocab_type type) {
 // #define PRETOKENIZERDEBUG
 
 void llama_vocab::impl::tokenizer_st_partition(std::forward_list<fragment_buffer_variant> & buffer, bool parse_special) const {
-    // for each special token
-    for (const llama_token special_id : cache_special_tokens) {
-        const auto & data = vocab.get_token_data(special_id);
-        const auto & text = data.text;
-
-        if (!parse_special && (data.attr & (LLAMA_TOKEN_ATTR_CONTROL | LLAMA_TOKEN_ATTR_UNKNOWN))) {
-            // Ignore control and unknown tokens when parse_special == false
-            continue;
-            // User-defined tokens are still pre-tokenized before everything else
-            // ref: https://github.com/huggingface/tokenizers/blob/fdd26ba9a3f0c133427aab0423888cbde91362d7/tokenizers/src/tokenizer/mod.rs#L726
-            // This is mostly relevant for neox-style tokenizers (mpt, olmo, stablelm, etc.)
-        }
-
-        // for each text fragment
-        std::forward_list<fragment_buffer_variant>::iterator it = buffer.begin();
-        while (it != buffer.end()) {
-            auto & fragment = (*it);
+    if (cache_special_matcher.empty()) {
+        return;
+    }
 
-            // if a fragment is text ( not yet processed )
-            if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
-                const auto & raw_text = fragment.raw_text;
+    // special tokens are resolved in cache_special_tokens order (longest first): a match is accepted only if
+    // none of its bytes were already taken by an earlier token or removed by an lstrip/rstrip
+    enum : uint8_t { BYTE_TEXT, BYTE_TOKEN, BYTE_STRIPPED };
 
-                auto raw_text_base_offset = fragment.offset;
-                auto raw_text_base_length = fragment.length;
+    std::forward_list<fragment_buffer_variant> result;
+    auto tail = result.before_begin();
+    bool changed = false;
 
-                // loop over the text
-                while (true) {
-                    // find the first occurrence of a given special token in this fragment
-                    //  passing offset argument only limit the "search area" but match coordinates
-                    //  are still relative to the source full raw_text
-                    //  string_view begins at pos 0 for the same reason
-                    auto match = std::string_view(raw_text.data(), raw_text_base_offset + raw_text_base_length).find(text, raw_text_base_offset);
+    std::vector<std::pair<int32_t, uint64_t>> matches; // (index in cache_special_tokens, start)
+    std::vector<std::pair<uint64_t, int32_t>> accepted;
+    std::vector<uint8_t> state;
 
-                    // no occurrences found, stop processing this fragment for a given special token
-                    if (match == std::string::npos) break;
+    for (const auto & fragment : buffer) {
+        if (fragment.type != FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
+            tail = result.emplace_after(tail, fragment.token);
+            continue;
+        }
 
-#ifdef PRETOKENIZERDEBUG
-                    LLAMA_LOG_WARN("FF: (%ld %ld %ld) '%s'\n", raw_text->length(), raw_text_base_offset, raw_text_base_length, raw_text->substr(raw_text_base_offset, raw_text_base_length).c_str());
-#endif
-                    auto source = std::distance(buffer.begin(), it);
-
-                    // if match is further than base offset
-                    //  then we have some text to the left of it
-                    if (match > raw_text_base_offset) {
-                        // left
-                        const int64_t left_reminder_offset = raw_text_base_offset + 0;
-                        int64_t left_reminder_length = match - raw_text_base_offset;
-
-                        if (data.attr & LLAMA_TOKEN_ATTR_LSTRIP) {
-                            while (left_reminder_length > 0 && isspace(raw_text[left_reminder_offset + left_reminder_length - 1])) {
-                                left_reminder_length--;
-                            }
-                        }
+        const auto & raw_text = fragment.raw_text;
+        const uint64_t base = fragment.offset;
 
-                        if (left_reminder_length > 0) {
-                            buffer.emplace_after(it, raw_text, left_reminder_offset, left_reminder_length);
-                            it++;
-                        }
+        matches.clear();
+        cache_special_matcher.find_all(raw_text, base, fragment.length, [&](int32_t idx, size_t start) {
+            // Ignore control and unknown tokens when parse_special == false
+            // User-defined tokens are still pre-tokenized before everything else
+            // ref: https://github.com/huggingface/tokenizers/blob/fdd26ba9a3f0c133427aab0423888cbde91362d7/tokenizers/src/tokenizer/mod.rs#L726
+            // This is mostly relevant for neox-style tokenizers (mpt, olmo, stablelm, etc.)
+            if (!parse_special && (id_to_token[cache_special_tokens[idx]].attr & (LLAMA_TOKEN_ATTR_CONTROL | LLAMA_TOKEN_ATTR_UNKNOWN))) {
+                return;
+            }
+            matches.emplace_back(idx, start - base);
+        });
 
-#ifdef PRETOKENIZERDEBUG
-                        LLAMA_LOG_WARN("FL: (%ld %ld) '%s'\n", left_reminder_offset, left_reminder_length, raw_text->substr(left_reminder_offset, left_reminder_length).c_str());
-#endif
-                    }
+        if (matches.empty()) {
+            tail = result.emplace_after(tail, raw_text, fragment.offset, fragment.length);
+            continue;
+        }
 
-                    // special token
-                    buffer.emplace_after(it, special_id);
-                    it++;
+        changed = true;
+        std::sort(matches.begin(), matches.end());
 
-                    // right
-                    if (match + text.length() < raw_text_base_offset + raw_text_base_length) {
-                        int64_t right_reminder_offset = match + text.length();
-                        int64_t right_reminder_length = raw_text_base_length - ((match - raw_text_base_offset) + text.length());
+        state.assign(fragment.length, BYTE_TEXT);
+        accepted.clear();
 
-                        if (data.attr & LLAMA_TOKEN_ATTR_RSTRIP) {
-                            while (right_reminder_length > 0 && isspace(raw_text[right_reminder_offset])) {
-                                right_reminder_offset++;
-                                right_reminder_length--;
-                            }
-                        }
+        for (const auto & m : matches) {
+            const auto & data = id_to_token[cache_special_tokens[m.first]];
+            const uint64_t start = m.second;
+            const uint64_t end   = start + data.text.size();
 
-                        if (right_reminder_length > 0) {
-                            buffer.emplace_after(it, raw_text, right_reminder_offset, right_reminder_length);
-                            it++;
-                        }
+            bool free = true;
+            for (uint64_t i = start; i < end && free; ++i) {
+                free = state[i] == BYTE_TEXT;
+            }
+            if (!free) {
+                continue;
+            }
 
-#ifdef PRETOKENIZERDEBUG
-                        LLAMA_LOG_WARN("FR: (%ld %ld) '%s'\n", right_reminder_offset, right_reminder_length, raw_text->substr(right_reminder_offset, right_reminder_length).c_str());
-#endif
+            std::fill(state.begin() + start, state.begin() + end, BYTE_TOKEN);
+            accepted.emplace_back(start, m.first);
 
-                        if (source == 0) {
-                            buffer.erase_after(buffer.before_begin());
-                        } else {
-                            buffer.erase_after(std::next(buffer.begin(), (source - 1)));
-                        }
+            if (data.attr & LLAMA_TOKEN_ATTR_LSTRIP) {
+                for (uint64_t i = start; i > 0 && state[i - 1] == BYTE_TEXT && isspace(raw_text[base + i - 1]); --i) {
+                    state[i - 1] = BYTE_STRIPPED;
+                }
+            }
+            if (data.attr & LLAMA_TOKEN_ATTR_RSTRIP) {
+                for (uint64_t i = end; i < fragment.length && state[i] == BYTE_TEXT && isspace(raw_text[base + i]); ++i) {
+                    state[i] = BYTE_STRIPPED;
+                }
+            }
+        }
 
-                        // repeat for the right side
-                        raw_text_base_offset = right_reminder_offset;
-                        raw_text_base_length = right_reminder_length;
+        std::sort(accepted.begin(), accepted.end());
 
-#ifdef PRETOKENIZERDEBUG
-                        LLAMA_LOG_WARN("RR: (%ld %ld) '%s'\n", raw_text_base_offset, raw_text_base_length, raw_text->substr(raw_text_base_offset, raw_text_base_length).c_str());
-#endif
-                    } else {
-                        if (source == 0) {
-                            buffer.erase_after(buffer.before_begin());
-                        } else {
-                            buffer.erase_after(std::next(buffer.begin(), (source - 1)));
-                        }
-                        break;
-                    }
+        // emit the remaining text runs and the accepted tokens in order
+        auto emit_text = [&](uint64_t begin, uint64_t end) {
+            while (begin < end) {
+                while (begin < end && state[begin] != BYTE_TEXT) {
+                    begin++;
                 }
+                uint64_t run = begin;
+                while (run < end && state[run] == BYTE_TEXT) {
+                    run++;
+                }
+                if (run > begin) {
+                    tail = result.emplace_after(tail, raw_text, base + begin, run - begin);
+                }
+                begin = run;
             }
-            it++;
+        };
+
+        uint64_t pos = 0;
+        for (const auto & a : accepted) {
+            const llama_token id = cache_special_tokens[a.second];
+            emit_text(pos, a.first);
+            tail = result.emplace_after(tail, id);
+            pos = a.first + id_to_token[id].text.size();
         }
+        emit_text(pos, fragment.length);
+    }
+
+    if (changed) {
+        buffer.swap(result);
     }
 }
 
@@ -3325,37 +3628,17 @@ static std::string llama_decode_text(const std::string & text) {
     return decoded_text;
 }
 
-std::vector<llama_token> llama_vocab::impl::tokenize(
-        const std::string & raw_text,
-        bool add_special,
-        bool parse_special) const {
-    LM_GGML_ASSERT(tokenizer && "Tokenizer not initialized. Call llama_vocab::init_tokenizer() first.");
-
-    std::vector<llama_token> output;
-    std::forward_list<fragment_buffer_variant> fragment_buffer;
-
-    if (!raw_text.empty()) {
-        fragment_buffer.emplace_front(raw_text, 0, raw_text.length());
-        tokenizer_st_partition(fragment_buffer, parse_special);
-    }
-
+void llama_vocab::impl::tokenize_fragments(
+        fragment_iterator begin,
+        fragment_iterator end,
+        bool is_prev_special,
+        std::vector<llama_token> & output) const {
     switch (get_type()) {
         case LLAMA_VOCAB_TYPE_SPM:
             {
-                // OG tokenizer behavior:
-                //
-                // tokenizer.encode('', add_special_tokens=True)  returns [1]
-                // tokenizer.encode('', add_special_tokens=False) returns []
-
-                bool is_prev_special = true;  // prefix with space if first token
-
-                if (add_special && add_bos) {
-                    LM_GGML_ASSERT(special_bos_id != LLAMA_TOKEN_NULL);
-                    output.push_back(special_bos_id);
-                    is_prev_special = true;
-                }
+                for (auto it = begin; it != end; ++it) {
+                    const auto & fragment = *it;
 
-                for (const auto & fragment : fragment_buffer) {
                     if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
                         std::string text;
 
@@ -3378,18 +3661,6 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
                         is_prev_special = true;
                     }
                 }
-
-                if (add_special && add_bos && output.size() >= 2 && output[1] == special_bos_id) {
-                    LLAMA_LOG_WARN(
-                        "%s: Added a BOS token to the prompt as specified by the model but the prompt "
-                        "also starts with a BOS token. So now the final prompt starts with 2 BOS tokens. "
-                        "Are you sure this is what you want?\n", __FUNCTION__);
-                }
-
-                if (add_special && add_eos) {
-                    LM_GGML_ASSERT(special_eos_id != LLAMA_TOKEN_NULL);
-                    output.push_back(special_eos_id);
-                }
             } break;
         case LLAMA_VOCAB_TYPE_BPE:
             {
@@ -3406,10 +3677,9 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
                     session = std::make_unique<llm_tokenizer_bpe_session>(vocab, *tok_bpe);
                 }
 
-                if (add_special) {
-                    session->append_bos(output);
-                }
-                for (const auto & fragment : fragment_buffer) {
+                for (auto it = begin; it != end; ++it) {
+                    const auto & fragment = *it;
+
                     if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
                         std::string text = fragment.raw_text.substr(fragment.offset, fragment.length);
 
@@ -3425,22 +3695,14 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
                         session->append(fragment.token, output);
                     }
                 }
-
-                if (add_special) {
-                    session->append_eos(output);
-                    session->check_double_bos_eos(output);
-                }
             } break;
         case LLAMA_VOCAB_TYPE_WPM:
             {
-                if (add_special) {
-                    LM_GGML_ASSERT(special_bos_id != LLAMA_TOKEN_NULL);
-                    output.push_back(special_bos_id);
-                }
-
                 llm_tokenizer_wpm_session session(vocab);
 
-                for (const auto & fragment : fragment_buffer) {
+                for (auto it = begin; it != end; ++it) {
+                    const auto & fragment = *it;
+
                     if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
                         std::string text = fragment.raw_text.substr(fragment.offset, fragment.length);
 
@@ -3452,21 +3714,14 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
                         output.push_back(fragment.token);
                     }
                 }
-
-                if (add_special) {
-                    LM_GGML_ASSERT(special_sep_id != LLAMA_TOKEN_NULL);
-                    output.push_back(special_sep_id);
-                }
             } break;
         case LLAMA_VOCAB_TYPE_UGM:
             {
-                if (add_special && add_bos) {
-                    LM_GGML_ASSERT(special_bos_id != LLAMA_TOKEN_NULL);
-                    output.push_back(special_bos_id);
-                }
                 llm_tokenizer_ugm_session session(vocab, *static_cast<const llm_tokenizer_ugm *>(tokenizer.get()));
 
-                for (const auto & fragment : fragment_buffer) {
+                for (auto it = begin; it != end; ++it) {
+                    const auto & fragment = *it;
+
                     if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
                         std::string text = fragment.raw_text.substr(fragment.offset, fragment.length);
 #ifdef PRETOKENIZERDEBUG
@@ -3477,23 +3732,13 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
                         output.push_back(fragment.token);
                     }
                 }
-
-                if (add_special && add_bos && output.size() >= 2 && output[1] == special_bos_id) {
-                    LLAMA_LOG_WARN(
-                        "%s: Added a BOS token to the prompt as specified by the model but the prompt "
-                        "also starts with a BOS token. So now the final prompt starts with 2 BOS tokens. "
-                        "Are you sure this is what you want?\n", __FUNCTION__);
-                }
-
-                if (add_special && add_eos) {
-                    LM_GGML_ASSERT(special_eos_id != LLAMA_TOKEN_NULL);
-                    output.push_back(special_eos_id);
-                }
             } break;
         case LLAMA_VOCAB_TYPE_RWKV:
             {
                 llm_tokenizer_rwkv_session session(vocab, *static_cast<const llm_tokenizer_rwkv *>(tokenizer.get()));
-                for (const auto & fragment : fragment_buffer) {
+                for (auto it = begin; it != end; ++it) {
+                    const auto & fragment = *it;
+
                     if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
                         std::string text = fragment.raw_text.substr(fragment.offset, fragment.length);
 
@@ -3510,7 +3755,9 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
         case LLAMA_VOCAB_TYPE_PLAMO2:
             {
                 llm_tokenizer_plamo2_session session(*static_cast<const llm_tokenizer_plamo2 *>(tokenizer.get()));
-                for (const auto & fragment : fragment_buffer) {
+                for (auto it = begin; it != end; ++it) {
+                    const auto & fragment = *it;
+
                     if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
                         std::string text = fragment.raw_text.substr(fragment.offset, fragment.length);
 
@@ -3527,6 +3774,261 @@ std::vector<llama_token> llama_vocab::impl::tokenize(
         case LLAMA_VOCAB_TYPE_NONE:
             LM_GGML_ABORT("fatal error");
     }
+}
+
+// smallest amount of raw text given to a tokenizer thread
+static constexpr size_t LLAMA_TOKENIZE_MIN_CHUNK = 64*1024;
+
+// first position in [pos, end) right after a '\n' that ends a non-empty line and precedes an alphanumeric char
+static size_t llama_find_newline_split(const std::string & text, size_t pos, size_t end) {
+    pos = std::max<size_t>(pos, 2);
+    while (pos < end) {
+        const void * nl = memchr(text.data() + pos - 1, '\n', end - pos);
+        if (nl == nullptr) {
+            break;
+        }
+        pos = (const char *) nl - text.data() + 1;
+        if (!isspace((unsigned char) text[pos - 2]) && isalnum((unsigned char) text[pos])) {
+            return pos;
+        }
+        pos++;
+    }
+    return std::string::npos;
+}
+
+bool llama_vocab::impl::tokenize_fragments_mt(
+        std::forward_list<fragment_buffer_variant> & buffer,
+        int32_t n_threads,
+        std::vector<llama_token> & output) const {
+    size_t n_bytes = 0;
+    for (const auto & fragment : buffer) {
+        if (fragment.type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
+            n_bytes += fragment.length;
+        }
+    }
+
+    if (n_threads <= 1 || !split_at_newlines || n_bytes < 2*LLAMA_TOKENIZE_MIN_CHUNK) {
+        // prefix with space if first token
+        tokenize_fragments(buffer.begin(), buffer.end(), true, output);
+        return false;
+    }
+
+    const size_t chunk = std::max(LLAMA_TOKENIZE_MIN_CHUNK, (n_bytes + n_threads - 1)/n_threads);
+
+    // cut the long raw text fragments into pieces of about chunk bytes
+    for (auto prev = buffer.before_begin(), it = buffer.begin(); it != buffer.end(); prev = it++) {
+        if (it->type != FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT || it->length < 2*chunk) {
+            continue;
+        }
+
+        const std::string & raw_text = it->raw_text;
+        const size_t end = it->offset + it->length;
+
+        size_t start = it->offset;
+        auto tail = it;
+        while (end - start >= 2*chunk) {
+            const size_t split = llama_find_newline_split(raw_text, start + chunk, end - chunk);
+            if (split == std::string::npos) {
+                break;
+            }
+            tail = buffer.emplace_after(tail, raw_text, start, split - start);
+            start = split;
+        }
+
+        if (tail == it) {
+            continue;
+        }
+
+        tail = buffer.emplace_after(tail, raw_text, start, end - start);
+        buffer.erase_after(prev);
+        it = tail;
+    }
+
+    // group consecutive fragments so that each thread gets about chunk bytes of raw text
+    struct group {
+        fragment_iterator begin;
+        fragment_iterator end;
+        bool is_prev_special;
+    };
+
+    std::vector<group> groups;
+    {
+        size_t cur = 0;
+        bool is_prev_special = true;
+        for (auto it = buffer.cbegin(); it != buffer.cend(); ++it) {
+            if (groups.empty() || cur >= chunk) {
+                if (!groups.empty()) {
+                    groups.back().end = it;
+                }
+                groups.push_back({ it, buffer.cend(), is_prev_special });
+                cur = 0;
+            }
+            if (it->type == FRAGMENT_BUFFER_VARIANT_TYPE_RAW_TEXT) {
+                cur += it->length;
+            }
+            is_prev_special = it->type == FRAGMENT_BUFFER_VARIANT_TYPE_TOKEN;
+        }
+    }
+
+    if (groups.size() <= 1) {
+        tokenize_fragments(buffer.begin(), buffer.end(), true, output);
+        return false;
+    }
+
+    std::vector<std::vector<llama_token>> results(groups.size());
+    std::vector<std::exception_ptr> errors(groups.size());
+
+    std::vector<std::thread> workers;
+    workers.reserve(groups.size() - 1);
+    for (size_t i = 1; i < groups.size(); ++i) {
+        workers.emplace_back([&, i]() {
+            try {
+                tokenize_fragments(groups[i].begin, groups[i].end, groups[i].is_prev_special, results[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+
+    try {
+        tokenize_fragments(groups[0].begin, groups[0].end, groups[0].is_prev_special, output);
+    } catch (...) {
+        errors[0] = std::current_exception();
+    }
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    for (const auto & error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (size_t i = 1; i < groups.size(); ++i) {
+        output.insert(output.end(), results[i].begin(), results[i].end());
+    }
+
+    return true;
+}
+
+std::vector<llama_token> llama_vocab::impl::tokenize(
+        const std::string & raw_text,
+        bool add_special,
+        bool parse_special,
+        int32_t n_threads) const {
+    LM_GGML_ASSERT(tokenizer && "Tokenizer not initialized. Call llama_vocab::init_tokenizer() first.");
+
+    std::vector<llama_token> output;
+    std::forward_list<fragment_buffer_variant> fragment_buffer;
+
+    if (!raw_text.empty()) {
+        fragment_buffer.emplace_front(raw_text, 0, raw_text.length());
+        tokenizer_st_partition(fragment_buffer, parse_special);
+    }
+
+    bool parallel = false;
+
+    switch (get_type()) {
+        case LLAMA_VOCAB_TYPE_SPM:
+            {
+                // OG tokenizer behavior:
+                //
+                // tokenizer.encode('', add_special_tokens=True)  returns [1]
+                // tokenizer.encode('', add_special_tokens=False) returns []
+
+                if (add_special && add_bos) {
+                    LM_GGML_ASSERT(special_bos_id != LLAMA_TOKEN_NULL);
+                    output.push_back(special_bos_id);
+                }
+
+                parallel = tokenize_fragments_mt(fragment_buffer, n_threads, output);
+
+                if (add_special && add_bos && output.size() >= 2 && output[1] == special_bos_id) {
+                    LLAMA_LOG_WARN(
+                        "%s: Added a BOS token to the prompt as specified by the model but the prompt "
+                        "also starts with a BOS token. So now the final prompt starts with 2 BOS tokens. "
+                        "Are you sure this is what you want?\n", __FUNCTION__);
+                }
+
+                if (add_special && add_eos) {
+                    LM_GGML_ASSERT(special_eos_id != LLAMA_TOKEN_NULL);
+                    output.push_back(special_eos_id);
+                }
+            } break;
+        case LLAMA_VOCAB_TYPE_BPE:
+            {
+                const llm_tokenizer_bpe_session session(vocab, *static_cast<const llm_tokenizer_bpe *>(tokenizer.get()));
+
+                if (add_special) {
+                    session.append_bos(output);
+                }
+
+                parallel = tokenize_fragments_mt(fragment_buffer, n_threads, output);
+
+                if (add_special) {
+                    session.append_eos(output);
+                    session.check_double_bos_eos(output);
+                }
+            } break;
+        case LLAMA_VOCAB_TYPE_WPM:
+            {
+                if (add_special) {
+                    LM_GGML_ASSERT(special_bos_id != LLAMA_TOKEN_NULL);
+                    output.push_back(special_bos_id);
+                }
+
+                parallel = tokenize_fragments_mt(fragment_buffer, n_threads, output);
+
+                if (add_special) {
+                    LM_GGML_ASSERT(special_sep_id != LLAMA_TOKEN_NULL);
+                    output.push_back(special_sep_id);
+                }
+            } break;
+        case LLAMA_VOCAB_TYPE_UGM:
+            {
+                if (add_special && add_bos) {
+                    LM_GGML_ASSERT(special_bos_id != LLAMA_TOKEN_NULL);
+                    output.push_back(special_bos_id);
+                }
+
+                parallel = tokenize_fragments_mt(fragment_buffer, n_threads, output);
+
+                if (add_special && add_bos && output.size() >= 2 && output[1] == special_bos_id) {
+                    LLAMA_LOG_WARN(
+                        "%s: Added a BOS token to the prompt as specified by the model but the prompt "
+                        "also starts with a BOS token. So now the final prompt starts with 2 BOS tokens. "
+                        "Are you sure this is what you want?\n", __FUNCTION__);
+                }
+
+                if (add_special && add_eos) {
+                    LM_GGML_ASSERT(special_eos_id != LLAMA_TOKEN_NULL);
+                    output.push_back(special_eos_id);
+                }
+            } break;
+        case LLAMA_VOCAB_TYPE_RWKV:
+        case LLAMA_VOCAB_TYPE_PLAMO2:
+            {
+                parallel = tokenize_fragments_mt(fragment_buffer, n_threads, output);
+            } break;
+        case LLAMA_VOCAB_TYPE_NONE:
+            LM_GGML_ABORT("fatal error");
+    }
+
+    // LLAMA_TOKENIZE_SELF_CHECK: verify that the parallel result matches serial tokenization
+    if (parallel && getenv("LLAMA_TOKENIZE_SELF_CHECK")) {
+        auto expected = tokenize(raw_text, add_special, parse_special, 1);
+        if (expected != output) {
+            size_t i = 0;
+            while (i < expected.size() && i < output.size() && expected[i] == output[i]) {
+                i++;
+            }
+            LLAMA_LOG_ERROR("%s: parallel tokenization differs from serial at token %zu (%zu vs %zu tokens), using the serial result\n",
+                    __func__, i, output.size(), expected.size());
+            output = std::move(expected);
+        }
+    }
 
     return output;
 }
@@ -4057,6 +4559,10 @@ int llama_vocab::find_bpe_rank(const std::string & token_left, const std::string
     return it->second;
 }
 
+int llama_vocab::find_bpe_rank(llama_token token_left, llama_token token_right, llama_token & token_merged) const {
+    return pimpl->bpe_merges.find(token_left, token_right, token_merged);
+}
+
 std::vector<std::string> llama_vocab::get_bpe_merges() const {
     int max_rank = -1;
     for (const auto & pair : pimpl->bpe_ranks) {
@@ -4081,8 +4587,9 @@ int32_t llama_vocab::tokenize(
                  llama_token * tokens,
                      int32_t   n_tokens_max,
                         bool   add_special,
-                        bool   parse_special) const {
-    auto res = tokenize(std::string(text, text_len), add_special, parse_special);
+                        bool   parse_special,
+                     int32_t   n_threads) const {
+    auto res = tokenize(std::string(text, text_len), add_special, parse_special, n_threads);
     if (res.size() >= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
         LLAMA_LOG_ERROR("%s: tokenization result size %zu exceeds int32_t limit\n", __func__, res.size());
         return std::numeric_limits<int32_t>::min();
@@ -4103,8 +4610,9 @@ int32_t llama_vocab::tokenize(
 std::vector<llama_token> llama_vocab::tokenize(
         const std::string & raw_text,
         bool add_special,
-        bool parse_special) const {
-    return pimpl->tokenize(raw_text, add_special, parse_special);
+        bool parse_special,
+        int32_t n_threads) const {
+    return pimpl->tokenize(raw_text, add_special, parse_special, n_threads);
 }
 
 const std::string & llama_vocab::token_to_piece(llama_token token) const {
@@ -4375,6 +4883,18 @@ int32_t llama_tokenize(
     return vocab->tokenize(text, text_len, tokens, n_tokens_max, add_special, parse_special);
 }
 
+int32_t llama_tokenize_parallel(
+    const struct llama_vocab * vocab,
+                  const char * text,
+                     int32_t   text_len,
+                 llama_token * tokens,
+                     int32_t   n_tokens_max,
+                        bool   add_special,
+                        bool   parse_special,
+                     int32_t   n_threads) {
+    return vocab->tokenize(text, text_len, tokens, n_tokens_max, add_special, parse_special, n_threads);
+}
+
 int32_t llama_token_to_piece(
     const struct llama_vocab * vocab,
                  llama_token   token,
@@ -155,6 +155,8 @@ struct llama_vocab {
     int max_token_len() const;
 
     int find_bpe_rank(const std::string & token_left, const std::string & token_right) const;
+    // same as above for two tokens of the vocab, also returns the merged token (LLAMA_TOKEN_NULL if not in the vocab)
+    int find_bpe_rank(llama_token token_left, llama_token token_right, llama_token & token_merged) const;
     std::vector<std::string> get_bpe_merges() const;
 
     std::vector<char> get_precompiled_charsmap() const;
@@ -165,12 +167,15 @@ struct llama_vocab {
                   llama_token * tokens,
                       int32_t   n_tokens_max,
                          bool   add_special,
-                         bool   parse_special) const;
+                         bool   parse_special,
+                      int32_t   n_threads = 1) const;
 
+    // n_threads > 1 tokenizes long inputs in parallel, the result is the same as with n_threads = 1
     std::vector<llama_token> tokenize(
             const std::string & raw_text,
                          bool   add_special,
-                         bool   parse_special = false) const;
+                         bool   parse_special = false,
+                      int32_t   n_threads     = 1) const;
 
     // does not write null-terminator to buf
     int32_t token_to_piece(
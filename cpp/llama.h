@@ -339,6 +339,11 @@ extern "C" {
         bool no_host;         // bypass host buffer allowing extra buffers to be used
         bool no_alloc;        // only load metadata and simulate memory allocations
         bool load_mtp;        // whether to load MTP layers
+
+        // directory for the repacked weight cache (NULL or empty = disabled)
+        // weights repacked for the CPU are stored there on first load and mmapped on later loads;
+        // only the few most recently used cache files are kept
+        const char * repack_cache_dir;
     };
 
     struct llama_sampler_seq_config {
@@ -373,7 +378,7 @@ extern "C" {
         float    yarn_beta_fast;   // YaRN low correction dim
         float    yarn_beta_slow;   // YaRN high correction dim
         uint32_t yarn_orig_ctx;    // YaRN original context size
-        float    defrag_thold;     // [DEPRECATED] defragment the KV cache if holes/size > thold, <= 0 disabled (default)
+        float    defrag_thold;     // compact the KV cache if holes/used range > thold, <= 0 disabled (default)
 
         lm_ggml_backend_sched_eval_callback cb_eval;
         void * cb_eval_user_data;
@@ -408,6 +413,18 @@ extern "C" {
         // a source/target/parent context
         // can be utilized in various ways, for example by sharing results or llama_memory between 2 contexts
         struct llama_context * ctx_other;
+
+        // [EXPERIMENTAL]
+        // with a quantized K cache, keep the keys of the last n_kv_hot positions of each sequence in F16, 0 = disabled
+        // only K is tiered: requires a non-quantized V cache and the non-FA path - flash_attn_type AUTO resolves to
+        // disabled, ENABLED turns the hot window off
+        uint32_t n_kv_hot;
+
+        // [EXPERIMENTAL]
+        // host compute arena shared with contexts that never compute at the same time (see lm_ggml_backend_arena_new)
+        // the CPU compute buffer is placed in the arena and llama_encode/llama_decode hold a lease on it
+        // the arena must outlive the context
+        lm_ggml_backend_arena_t compute_arena;
     };
 
     struct llama_model_tensor_override {
@@ -1009,6 +1026,10 @@ extern "C" {
     // Set abort callback
     LLAMA_API void llama_set_abort_callback(struct llama_context * ctx, lm_ggml_abort_callback abort_callback, void * abort_callback_data);
 
+    // Attach a per-op profiler to the CPU backend of the context (NULL to detach)
+    // The profiler is not owned by the context and must outlive it or be detached first
+    LLAMA_API void llama_set_cpu_profiler(struct llama_context * ctx, struct lm_ggml_cpu_profiler * profiler);
+
     // Wait until all computations are finished
     // This is automatically done when using one of the functions below to obtain the computation results
     // and is not necessary to call it explicitly in most cases
@@ -1166,6 +1187,20 @@ extern "C" {
                             bool   add_special,
                             bool   parse_special);
 
+    /// @details Same as llama_tokenize, but long inputs are split after newlines into pieces that are tokenized on up
+    ///          to n_threads threads. The result is identical to llama_tokenize; vocabularies that cannot be split
+    ///          safely and short inputs are tokenized serially.
+    ///          Set LLAMA_TOKENIZE_SELF_CHECK in the environment to verify each parallel result against llama_tokenize.
+    LLAMA_API int32_t llama_tokenize_parallel(
+        const struct llama_vocab * vocab,
+                      const char * text,
+                         int32_t   text_len,
+                     llama_token * tokens,
+                         int32_t   n_tokens_max,
+                            bool   add_special,
+                            bool   parse_special,
+                         int32_t   n_threads);
+
     // Token Id -> Piece.
     // Uses the vocabulary in the provided context.
     // Does not write null terminator to the buffer.
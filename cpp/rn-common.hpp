@@ -10,6 +10,7 @@
 #include <cstring>
 #include <cinttypes>
 #include "llama.h"
+#include "llama-ext.h"  // llama_memory_seq_evict_sink
 
 // Include backend device support
 #include "ggml-backend.h"
@@ -155,6 +156,40 @@ static size_t find_partial_stop_string(const std::string& stop, const std::strin
   return std::string::npos;
 }
 
+// Attention-sink streaming eviction (StreamingLLM): when a sequence fills its n_ctx
+// budget, evict the oldest n_evict tokens that follow the first n_sink ones and
+// re-base the remaining window right after the sinks. The same range is erased from
+// `tokens` so the token history keeps matching the KV positions.
+// Returns the number of evicted tokens, 0 when nothing could be evicted.
+static int32_t evict_sink_window(
+    llama_context *ctx,
+    llama_seq_id seq_id,
+    int32_t n_ctx,
+    int32_t n_sink,
+    int32_t n_evict,
+    std::vector<llama_token> &tokens
+) {
+    n_sink = std::max(0, std::min(n_sink, n_ctx - 2));
+    n_evict = std::max(1, std::min(n_evict, n_ctx - n_sink - 1));
+
+    // the window is measured on what the KV cache holds, which can be less than n_ctx
+    // (the last sampled token is not decoded yet when the budget runs out)
+    llama_memory_t mem = llama_get_memory(ctx);
+    const llama_pos n_kv = llama_memory_seq_pos_max(mem, seq_id) + 1;
+
+    const llama_pos n_evicted = llama_memory_seq_evict_sink(
+        mem, seq_id, n_sink, std::max<llama_pos>(0, n_kv - n_sink - n_evict));
+    if (n_evicted <= 0) {
+        return 0;
+    }
+
+    const size_t i0 = std::min<size_t>(n_sink, tokens.size());
+    const size_t i1 = std::min<size_t>(i0 + n_evicted, tokens.size());
+    tokens.erase(tokens.begin() + i0, tokens.begin() + i1);
+
+    return n_evicted;
+}
+
 // Helper function to find the length of common prefix between two token vectors
 static size_t find_common_prefix_length(const std::vector<llama_token> &a, const std::vector<llama_token> &b) {
   size_t i;
@@ -402,7 +402,8 @@ void llama_rn_context_completion::loadPrompt(const std::vector<std::string> &med
         }
 
         // Text-only path - use modified tokenization for encoder-decoder models
-        text_tokens = ::common_tokenize(parent_ctx->ctx, parent_ctx->params.prompt, add_bos || is_enc_dec, true);
+        text_tokens = ::common_tokenize(parent_ctx->ctx, parent_ctx->params.prompt, add_bos || is_enc_dec, true,
+                                        llama_n_threads_batch(parent_ctx->ctx));
         num_prompt_tokens = text_tokens.size();
 
         // LOG tokens
@@ -854,6 +855,7 @@ bool llama_rn_context_completion::refillMTPTokens() {
                          spec_n_past + (llama_pos) i + 1, { seq_id }, true);
     }
 
+    const int64_t t_verify_us = lm_ggml_time_us();
     const int ret = llama_decode(parent_ctx->ctx, spec_batch);
     if (ret != 0) {
         throw std::runtime_error("failed to evaluate MTP target batch, ret=" + std::to_string(ret));
@@ -862,7 +864,9 @@ bool llama_rn_context_completion::refillMTPTokens() {
         throw std::runtime_error("failed to process MTP target batch");
     }
 
+    // reading the logits waits for the decode, so no extra synchronization is needed for the timing
     auto accepted = common_sampler_sample_and_accept_n(ctx_sampling, parent_ctx->ctx, spec_draft);
+    common_speculative_observe_decode(spec, (lm_ggml_time_us() - t_verify_us) / 1e3, spec_batch.n_tokens);
     if (accepted.empty()) {
         return false;
     }
@@ -961,28 +965,49 @@ completion_token_output llama_rn_context_completion::nextToken()
             return result;
         }
 
-        // Shift context
+        if (parent_ctx->params.n_sink > 0) {
+            // Attention-sink streaming: evict a small block behind the sinks
+            // instead of discarding half of the context at once.
+            const int n_evicted = evict_sink_window(
+                parent_ctx->ctx, 0, parent_ctx->params.n_ctx,
+                parent_ctx->params.n_sink, parent_ctx->params.n_sink_evict, embd);
+            if (n_evicted == 0) {
+                LOG_WARNING("context full and sink eviction not supported, n_ctx: %d, tokens: %d", parent_ctx->params.n_ctx, embd.size());
+                has_next_token = false;
+                context_full = true;
+                return result;
+            }
 
-        const int n_left    = n_past - parent_ctx->params.n_keep - 1;
-        const int n_discard = n_left/2;
+            n_past -= n_evicted;
+            truncated = true;
 
-        auto * kv = llama_get_memory(parent_ctx->ctx);
-        llama_memory_seq_rm (kv, 0, parent_ctx->params.n_keep + 1            , parent_ctx->params.n_keep + n_discard + 1);
-        llama_memory_seq_add(kv, 0, parent_ctx->params.n_keep + 1 + n_discard, n_past, -n_discard);
+            clearStateCheckpoints();
 
-        for (size_t i = parent_ctx->params.n_keep + 1 + n_discard; i < embd.size(); i++)
-        {
-            embd[i - n_discard] = embd[i];
-        }
-        embd.resize(embd.size() - n_discard);
+            LOG_VERBOSE("sink window shifted, evicted: %d, new n_past: %d, new size: %d", n_evicted, n_past, embd.size());
+        } else {
+            // Shift context
 
-        n_past -= n_discard;
-        truncated = true;
+            const int n_left    = n_past - parent_ctx->params.n_keep - 1;
+            const int n_discard = n_left/2;
 
-        // A context shift remaps positions; old snapshots no longer line up.
-        clearStateCheckpoints();
+            auto * kv = llama_get_memory(parent_ctx->ctx);
+            llama_memory_seq_rm (kv, 0, parent_ctx->params.n_keep + 1            , parent_ctx->params.n_keep + n_discard + 1);
+            llama_memory_seq_add(kv, 0, parent_ctx->params.n_keep + 1 + n_discard, n_past, -n_discard);
+
+            for (size_t i = parent_ctx->params.n_keep + 1 + n_discard; i < embd.size(); i++)
+            {
+                embd[i - n_discard] = embd[i];
+            }
+            embd.resize(embd.size() - n_discard);
 
-        LOG_VERBOSE("context shifted, new n_past: %d, new size: %d", n_past, embd.size());
+            n_past -= n_discard;
+            truncated = true;
+
+            // A context shift remaps positions; old snapshots no longer line up.
+            clearStateCheckpoints();
+
+            LOG_VERBOSE("context shifted, new n_past: %d, new size: %d", n_past, embd.size());
+        }
     }
 
     // Continuous-latent TTS flow (BlueMagpie-TTS / VoxCPM): after every
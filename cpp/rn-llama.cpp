@@ -14,7 +14,11 @@
 #include <algorithm>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <sys/stat.h>
 
 namespace rnllama {
 
@@ -48,6 +52,96 @@ bool has_speculative_type(const common_params_speculative &speculative, common_s
 
 } // namespace
 
+namespace {
+
+std::mutex model_registry_mutex;
+std::unordered_map<std::string, std::weak_ptr<llama_model>> model_registry;
+
+} // namespace
+
+std::string model_registry_key(common_params &params) {
+    struct stat st;
+    if (params.model.path.empty() || stat(params.model.path.c_str(), &st) != 0) {
+        return "";
+    }
+
+    const llama_model_params mparams = common_model_params_to_llama(params);
+
+    std::ostringstream key;
+    key << params.model.path
+        << '|' << (uint64_t) st.st_dev << ':' << (uint64_t) st.st_ino
+        << ':' << (uint64_t) st.st_size << ':' << (int64_t) st.st_mtime
+        << '|' << mparams.n_gpu_layers << ',' << (int) mparams.split_mode << ',' << (int) mparams.load_mode
+        << ',' << mparams.main_gpu
+        << ',' << mparams.vocab_only << mparams.check_tensors << mparams.use_extra_bufts
+        << mparams.no_host << mparams.no_alloc << mparams.load_mtp
+        << '|' << (mparams.repack_cache_dir != nullptr ? mparams.repack_cache_dir : "");
+
+    key << "|split";
+    for (size_t i = 0; mparams.tensor_split != nullptr && i < llama_max_devices(); ++i) {
+        key << ',' << mparams.tensor_split[i];
+    }
+
+    key << "|dev";
+    for (auto dev = mparams.devices; dev != nullptr && *dev != nullptr; ++dev) {
+        key << ',' << (const void *) *dev;
+    }
+
+    key << "|buft";
+    for (auto ov = mparams.tensor_buft_overrides; ov != nullptr && ov->pattern != nullptr; ++ov) {
+        key << ',' << ov->pattern << '=' << (const void *) ov->buft;
+    }
+
+    key << "|kv";
+    for (auto ov = mparams.kv_overrides; ov != nullptr && ov->key[0] != 0; ++ov) {
+        key << ',' << ov->key << '=' << (int) ov->tag << ':';
+        switch (ov->tag) {
+            case LLAMA_KV_OVERRIDE_TYPE_INT:   key << ov->val_i64;  break;
+            case LLAMA_KV_OVERRIDE_TYPE_FLOAT: key << ov->val_f64;  break;
+            case LLAMA_KV_OVERRIDE_TYPE_BOOL:  key << ov->val_bool; break;
+            case LLAMA_KV_OVERRIDE_TYPE_STR:   key << ov->val_str;  break;
+        }
+    }
+
+    return key.str();
+}
+
+std::shared_ptr<llama_model> model_registry_find(const std::string &key) {
+    if (key.empty()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(model_registry_mutex);
+    auto it = model_registry.find(key);
+    if (it == model_registry.end()) {
+        return nullptr;
+    }
+    auto model = it->second.lock();
+    if (model == nullptr) {
+        model_registry.erase(it);
+    }
+    return model;
+}
+
+void model_registry_add(const std::string &key, const std::shared_ptr<llama_model> &model) {
+    if (key.empty() || model == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(model_registry_mutex);
+    for (auto it = model_registry.begin(); it != model_registry.end();) {
+        it = it->second.expired() ? model_registry.erase(it) : std::next(it);
+    }
+    model_registry[key] = model;
+}
+
+size_t model_registry_size() {
+    std::lock_guard<std::mutex> lock(model_registry_mutex);
+    size_t n = 0;
+    for (const auto &entry : model_registry) {
+        n += entry.second.expired() ? 0 : 1;
+    }
+    return n;
+}
+
 std::string get_backend_devices_info() {
     return backend_devices_info();
 }
@@ -388,6 +482,119 @@ void llama_rn_context::cleanupThreadpools() {
     }
 }
 
+void llama_rn_context::enableProfiler() {
+    if (cpu_profiler == nullptr) {
+        cpu_profiler = lm_ggml_cpu_profiler_new();
+    }
+    if (ctx != nullptr) {
+        llama_set_cpu_profiler(ctx, cpu_profiler);
+    }
+}
+
+void llama_rn_context::disableProfiler() {
+    if (cpu_profiler == nullptr) {
+        return;
+    }
+    // detaching blocks until a graph that is still recording into the profiler is done
+    if (ctx != nullptr) {
+        llama_set_cpu_profiler(ctx, nullptr);
+    }
+    lm_ggml_cpu_profiler_free(cpu_profiler);
+    cpu_profiler = nullptr;
+}
+
+void llama_rn_context::resetProfiler() {
+    if (cpu_profiler != nullptr) {
+        lm_ggml_cpu_profiler_reset(cpu_profiler);
+    }
+}
+
+std::string llama_rn_context::getProfileJson() const {
+    json result = {
+        {"enabled", cpu_profiler != nullptr},
+    };
+    if (cpu_profiler == nullptr) {
+        return result.dump();
+    }
+
+    int64_t n_graphs = 0;
+    int64_t t_graph_ns = 0;
+    lm_ggml_cpu_profiler_get_totals(cpu_profiler, &n_graphs, &t_graph_ns);
+    result["n_graphs"] = n_graphs;
+    result["graph_us"] = t_graph_ns / 1e3;
+
+    json threads = json::array();
+    for (int ith = 0; ith < lm_ggml_cpu_profiler_n_threads(cpu_profiler); ++ith) {
+        int64_t t_busy_ns = 0;
+        int64_t t_wait_ns = 0;
+        lm_ggml_cpu_profiler_get_thread(cpu_profiler, ith, &t_busy_ns, &t_wait_ns);
+        threads.push_back({{"busy_us", t_busy_ns / 1e3}, {"wait_us", t_wait_ns / 1e3}});
+    }
+    result["threads"] = threads;
+
+    // snapshot the per-node stats: a decode on another thread may add stats (and grow the table) meanwhile
+    std::vector<lm_ggml_cpu_profile_stat> stats;
+    for (int n_stats = lm_ggml_cpu_profiler_get_stats(cpu_profiler, nullptr, 0); ; ) {
+        stats.resize(n_stats);
+        n_stats = lm_ggml_cpu_profiler_get_stats(cpu_profiler, stats.data(), (int) stats.size());
+        if (n_stats <= (int) stats.size()) {
+            stats.resize(n_stats);
+            break;
+        }
+    }
+
+    // the same stats folded by op type
+    std::vector<lm_ggml_cpu_profile_stat> ops;
+    for (const auto & stat : stats) {
+        auto it = std::find_if(ops.begin(), ops.end(), [&](const lm_ggml_cpu_profile_stat & op) {
+            return strcmp(op.op, stat.op) == 0;
+        });
+        if (it == ops.end()) {
+            lm_ggml_cpu_profile_stat op = {};
+            op.op = stat.op;
+            it = ops.insert(ops.end(), op);
+        }
+        it->n_calls   += stat.n_calls;
+        it->n_bytes   += stat.n_bytes;
+        it->t_wall_ns += stat.t_wall_ns;
+        it->t_busy_ns += stat.t_busy_ns;
+        it->t_wait_ns += stat.t_wait_ns;
+    }
+
+    auto stat_to_json = [](const lm_ggml_cpu_profile_stat & stat, bool with_name) {
+        json j = {{"op", stat.op}};
+        if (with_name) {
+            j["name"] = stat.name;
+        }
+        j["n_calls"] = stat.n_calls;
+        j["bytes"]   = stat.n_bytes;
+        j["wall_us"] = stat.t_wall_ns / 1e3;
+        j["busy_us"] = stat.t_busy_ns / 1e3;
+        j["wait_us"] = stat.t_wait_ns / 1e3;
+        return j;
+    };
+
+    std::sort(ops.begin(), ops.end(), [](const lm_ggml_cpu_profile_stat & a, const lm_ggml_cpu_profile_stat & b) {
+        return a.t_wall_ns > b.t_wall_ns;
+    });
+    std::sort(stats.begin(), stats.end(), [](const lm_ggml_cpu_profile_stat & a, const lm_ggml_cpu_profile_stat & b) {
+        return a.t_wall_ns > b.t_wall_ns;
+    });
+
+    json ops_json = json::array();
+    for (const auto & op : ops) {
+        ops_json.push_back(stat_to_json(op, false));
+    }
+    json nodes_json = json::array();
+    for (const auto & stat : stats) {
+        nodes_json.push_back(stat_to_json(stat, true));
+    }
+    result["ops"] = ops_json;
+    result["nodes"] = nodes_json;
+
+    return result.dump();
+}
+
 bool llama_rn_context::attachThreadpoolsIfAvailable() {
     if (ctx == nullptr) {
         return false;
@@ -448,6 +655,7 @@ llama_rn_context::~llama_rn_context() {
 
     removeLoraAdapters();
     cleanupThreadpools();
+    disableProfiler();
 
     if (completion != nullptr) {
         delete completion;
@@ -473,10 +681,37 @@ bool llama_rn_context::loadModel(common_params &params_)
         LOG_INFO("Using n_parallel: %d (enables up to %d parallel slots)", params.n_parallel, params.n_parallel);
     }
 
-    llama_init = common_init_from_params(params);
+    // the model, multimodal projector and vocoder never compute at the same
+    // time, so their CPU compute buffers can time-share one host buffer
+    params.compute_arena = nullptr;
+    if (params.shared_compute_arena) {
+        if (compute_arena == nullptr) {
+            compute_arena.reset(lm_ggml_backend_arena_new(lm_ggml_backend_cpu_buffer_type()));
+        }
+        params.compute_arena = compute_arena.get();
+    }
+
+    // reuse the weights of another context that loaded the same model with the same parameters
+    const std::string model_key = model_registry_key(params);
+    std::shared_ptr<llama_model> shared = model_registry_find(model_key);
+    model_shared = shared != nullptr;
+    if (model_shared) {
+        LOG_INFO("Sharing already loaded model: %s (%ld other users)", params.model.path.c_str(), shared.use_count() - 1);
+        if (params.progress_callback != nullptr) {
+            params.progress_callback(1.0f, params.progress_callback_user_data);
+        } else if (params.load_progress_callback != nullptr) {
+            params.load_progress_callback(1.0f, params.load_progress_callback_user_data);
+        }
+    }
+
+    llama_init = common_init_from_params(params, false, std::move(shared));
     model = llama_init != nullptr ? llama_init->model() : nullptr;
     ctx = llama_init != nullptr ? llama_init->context() : nullptr;
 
+    if (model != nullptr && !model_shared) {
+        model_registry_add(model_key, llama_init->shared_model());
+    }
+
     // common_init_from_params() can fail after loading the model but before
     // constructing the context, so both pointers must be validated here.
     if (model == nullptr || ctx == nullptr) {
@@ -488,6 +723,10 @@ bool llama_rn_context::loadModel(common_params &params_)
         return false;
     }
 
+    if (cpu_profiler != nullptr) {
+        llama_set_cpu_profiler(ctx, cpu_profiler);
+    }
+
     if (params.speculative.has_dft() &&
         has_speculative_type(params.speculative, COMMON_SPECULATIVE_TYPE_DRAFT_MTP)) {
         const auto & draft_params = params.speculative.draft;
@@ -504,12 +743,18 @@ bool llama_rn_context::loadModel(common_params &params_)
             params_dft.cpuparams_batch.n_threads = draft_params.cpuparams_batch.n_threads;
         }
 
-        auto mparams_dft = common_model_params_to_llama(params_dft);
-        LOG_INFO("Loading MTP draft model: %s", params_dft.model.path.c_str());
-        draft_model.reset(llama_model_load_from_file(params_dft.model.path.c_str(), mparams_dft));
+        const std::string draft_key = model_registry_key(params_dft);
+        draft_model = model_registry_find(draft_key);
         if (draft_model == nullptr) {
-            LOG_ERROR("unable to load MTP draft model: %s", params_dft.model.path.c_str());
-            return false;
+            auto mparams_dft = common_model_params_to_llama(params_dft);
+            LOG_INFO("Loading MTP draft model: %s", params_dft.model.path.c_str());
+            llama_model * loaded = llama_model_load_from_file(params_dft.model.path.c_str(), mparams_dft);
+            if (loaded == nullptr) {
+                LOG_ERROR("unable to load MTP draft model: %s", params_dft.model.path.c_str());
+                return false;
+            }
+            draft_model.reset(loaded, llama_model_free);
+            model_registry_add(draft_key, draft_model);
         }
     }
 
@@ -666,7 +911,7 @@ llama_rn_tokenize_result llama_rn_context::tokenize(const std::string &text, con
       return tokenize_result;
   }
   std::vector<llama_token> text_tokens;
-  text_tokens = common_tokenize(ctx, text, /* add_special= */ false, /* parse_special= */ true);
+  text_tokens = common_tokenize(ctx, text, /* add_special= */ false, /* parse_special= */ true, llama_n_threads_batch(ctx));
   llama_rn_tokenize_result tokenize_result;
   tokenize_result.tokens = text_tokens;
   tokenize_result.has_media = false;
@@ -764,7 +1009,7 @@ void llama_rn_context::setMediaHashes(const std::vector<std::string> &hashes) {
 
 bool llama_rn_context::initVocoder(const std::string &vocoder_model_path, int batch_size, bool use_gpu) {
     try {
-        tts_wrapper = new llama_rn_context_tts(vocoder_model_path, batch_size, use_gpu);
+        tts_wrapper = new llama_rn_context_tts(vocoder_model_path, batch_size, use_gpu, params.compute_arena);
         has_vocoder = true;
         return true;
     } catch (const std::exception& e) {
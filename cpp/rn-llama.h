@@ -9,6 +9,7 @@
 #include "common.h"
 #include "ggml.h"
 #include "ggml-cpu.h"
+#include "ggml-cpp.h"
 #include "gguf.h"
 #include "llama.h"
 #include "llama-model.h"
@@ -79,6 +80,17 @@ private:
     std::string pending;
 };
 
+// Process-wide registry of loaded models. Contexts that load the same file
+// (path and device/inode/size/mtime) with the same model parameters share one
+// refcounted llama_model, each with its own KV cache and compute buffers.
+// The registry only holds weak references: a model is freed with its last context.
+// An empty key (e.g. the file cannot be stat'ed) disables sharing.
+std::string model_registry_key(common_params & params);
+std::shared_ptr<llama_model> model_registry_find(const std::string & key);
+void model_registry_add(const std::string & key, const std::shared_ptr<llama_model> & model);
+// number of live models in the registry
+size_t model_registry_size();
+
 lm_ggml_type kv_cache_type_from_str(const std::string & s);
 
 enum llama_flash_attn_type flash_attn_type_from_str(const std::string & s);
@@ -107,10 +119,15 @@ struct llama_rn_tokenize_result {
 struct llama_rn_context {
     // Model state fields
     llama_model *model = nullptr;
-    llama_model_ptr draft_model;
+    // true if the model was already loaded by another context (see model_registry_key)
+    bool model_shared = false;
+    std::shared_ptr<llama_model> draft_model;
     float loading_progress = 0;
     bool is_load_interrupted = false;
     common_params params;
+    // shared host compute arena (params.shared_compute_arena), declared before
+    // every context using it so that it is destroyed after them
+    lm_ggml_backend_arena_ptr compute_arena;
     common_init_result_ptr llama_init;
     llama_context *ctx = nullptr;
     common_chat_templates_ptr templates;
@@ -131,6 +148,9 @@ struct llama_rn_context {
     lm_ggml_threadpool *threadpool = nullptr;
     lm_ggml_threadpool *threadpool_batch = nullptr;
 
+    // Per-op CPU backend profiler (see ggml-cpu.h), nullptr when disabled
+    lm_ggml_cpu_profiler *cpu_profiler = nullptr;
+
     ~llama_rn_context();
 
     bool loadModel(common_params &params_);
@@ -140,6 +160,13 @@ struct llama_rn_context {
     void cleanupThreadpools();
     bool attachThreadpoolsIfAvailable();
 
+    // Profiling methods
+    void enableProfiler();
+    // waits for a decode that is computing with the profiler before freeing it
+    void disableProfiler();
+    void resetProfiler();
+    std::string getProfileJson() const;
+
     // Parallel decoding methods
     void enableParallelMode(int32_t n_parallel, int32_t n_batch = 512);
     void disableParallelMode();
@@ -722,6 +722,7 @@ inline llama_rn_context_mtmd::llama_rn_context_mtmd(
     mtmd_params.n_threads = params.cpuparams.n_threads;
     mtmd_params.image_min_tokens = image_min_tokens;
     mtmd_params.image_max_tokens = image_max_tokens;
+    mtmd_params.compute_arena = params.compute_arena;
 
     LOG_INFO("[DEBUG] Initializing mtmd context with threads=%d, image_min_tokens=%d, image_max_tokens=%d",
              mtmd_params.n_threads, mtmd_params.image_min_tokens, mtmd_params.image_max_tokens);
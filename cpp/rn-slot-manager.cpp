@@ -4,8 +4,10 @@
 #include "rn-mtmd.hpp"
 #include "rn-common.hpp"
 #include "ggml.h"
+#include "llama-mmap.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <stdexcept>
 
@@ -31,6 +33,9 @@ llama_rn_slot_manager::~llama_rn_slot_manager() {
     stop_processing_loop();
 
     reset_mtp_speculative();
+    reset_ngram_speculative();
+
+    clear_spill();
 
     // Free batch
     if (batch.token != nullptr) {
@@ -61,8 +66,13 @@ bool llama_rn_slot_manager::init(int32_t n_parallel_, int32_t n_batch_, int32_t
         LOG_VERBOSE("Slot %d initialized with context size %d", i, n_ctx_per_slot);
     }
 
-    // Allocate batch
-    batch = llama_batch_init(n_batch, 0, n_parallel);
+    // Allocate batch; tokens of draft trees carry the ids of all their
+    // branches, which may use every sequence of the context
+    int32_t n_seq_batch = n_parallel;
+    if (parent_ctx != nullptr && parent_ctx->ctx != nullptr) {
+        n_seq_batch = std::max<int32_t>(n_seq_batch, llama_n_seq_max(parent_ctx->ctx));
+    }
+    batch = llama_batch_init(n_batch, 0, n_seq_batch);
     if (batch.token == nullptr) {
         LOG_ERROR("Failed to allocate batch");
         return false;
@@ -72,6 +82,11 @@ bool llama_rn_slot_manager::init(int32_t n_parallel_, int32_t n_batch_, int32_t
     return true;
 }
 
+static bool same_adaptive_params(const common_params_speculative_adaptive& a,
+                                 const common_params_speculative_adaptive& b) {
+    return a.enabled == b.enabled && a.decay == b.decay && a.n_probe == b.n_probe;
+}
+
 common_speculative* llama_rn_slot_manager::ensure_mtp_speculative(common_params& params) {
     if (parent_ctx == nullptr || parent_ctx->ctx == nullptr) {
         throw std::runtime_error("MTP speculative decoding requires an initialized context");
@@ -87,7 +102,8 @@ common_speculative* llama_rn_slot_manager::ensure_mtp_speculative(common_params&
         mtp_spec_backend_sampling == draft.backend_sampling &&
         mtp_spec_n_gpu_layers == draft.n_gpu_layers &&
         mtp_spec_cache_type_k == draft.cache_type_k &&
-        mtp_spec_cache_type_v == draft.cache_type_v;
+        mtp_spec_cache_type_v == draft.cache_type_v &&
+        same_adaptive_params(mtp_spec_adaptive, params.speculative.adaptive);
 
     if (compatible) {
         params.speculative.draft.ctx_tgt = parent_ctx->ctx;
@@ -127,6 +143,7 @@ common_speculative* llama_rn_slot_manager::ensure_mtp_speculative(common_params&
     mtp_spec_n_gpu_layers = draft.n_gpu_layers;
     mtp_spec_cache_type_k = draft.cache_type_k;
     mtp_spec_cache_type_v = draft.cache_type_v;
+    mtp_spec_adaptive = params.speculative.adaptive;
 
     LOG_INFO("Initialized shared MTP speculative state for %d queued slots", n_parallel);
     return mtp_spec;
@@ -138,7 +155,8 @@ llama_context* llama_rn_slot_manager::get_mtp_draft_context() const {
 
 void llama_rn_slot_manager::reset_mtp_speculative() {
     for (auto& slot : slots) {
-        if (!slot.spec_is_shared) {
+        // Slots sharing the n-gram drafter are not ours to release
+        if (!slot.spec_is_shared || (slot.spec != nullptr && slot.spec == ngram_spec)) {
             continue;
         }
         if (slot.spec == mtp_spec) {
@@ -168,6 +186,157 @@ void llama_rn_slot_manager::reset_mtp_speculative() {
     mtp_spec_cache_type_v = LM_GGML_TYPE_F16;
 }
 
+// Draft trees decode their branches as extra sequences that share the slot's
+// cells, which needs a single KV stream and memory that can fork sequences
+static bool supports_draft_trees(const llama_rn_context* ctx) {
+    return ctx != nullptr && ctx->ctx != nullptr && ctx->params.kv_unified &&
+        !llama_model_is_recurrent(ctx->model) && !llama_model_is_hybrid(ctx->model);
+}
+
+static bool same_ngram_map_params(const common_params_speculative_ngram_map& a,
+                                  const common_params_speculative_ngram_map& b) {
+    return a.size_n == b.size_n && a.size_m == b.size_m && a.min_hits == b.min_hits;
+}
+
+static bool same_ngram_params(const common_params_speculative& a, const common_params_speculative& b) {
+    return a.types == b.types &&
+        same_ngram_map_params(a.ngram_simple, b.ngram_simple) &&
+        same_ngram_map_params(a.ngram_map_k, b.ngram_map_k) &&
+        same_ngram_map_params(a.ngram_map_k4v, b.ngram_map_k4v) &&
+        a.ngram_mod.n_match == b.ngram_mod.n_match &&
+        a.ngram_mod.n_max == b.ngram_mod.n_max &&
+        a.ngram_mod.n_min == b.ngram_mod.n_min &&
+        a.ngram_cache.lookup_cache_static == b.ngram_cache.lookup_cache_static &&
+        a.ngram_cache.lookup_cache_dynamic == b.ngram_cache.lookup_cache_dynamic &&
+        same_adaptive_params(a.adaptive, b.adaptive);
+}
+
+common_speculative* llama_rn_slot_manager::ensure_ngram_speculative(const common_params& params) {
+    // Only the n-gram drafters run here: draft-model types would need a draft
+    // context mirroring every slot's memory edits (reuse, spill, eviction)
+    common_params_speculative spec_params = params.speculative;
+    spec_params.types.clear();
+    for (const auto type : params.speculative.types) {
+        if (is_ngram_speculative_type(type)) {
+            spec_params.types.push_back(type);
+        }
+    }
+    spec_params.draft.ctx_tgt = nullptr;
+    spec_params.draft.ctx_dft = nullptr;
+
+    if (spec_params.types.empty()) {
+        return nullptr;
+    }
+
+    if (ngram_spec != nullptr) {
+        if (same_ngram_params(ngram_spec_params, spec_params)) {
+            return ngram_spec;
+        }
+        for (const auto& slot : slots) {
+            if (slot.spec == ngram_spec && slot.state == SLOT_STATE_GENERATING) {
+                LOG_WARNING("N-gram speculative parameters changed while slots are generating, "
+                            "running this request without speculation");
+                return nullptr;
+            }
+        }
+        reset_ngram_speculative();
+    }
+
+    const uint32_t n_seq = std::max<int32_t>(1, n_parallel);
+    ngram_spec = common_speculative_init(spec_params, n_seq);
+    if (ngram_spec == nullptr) {
+        LOG_WARNING("Failed to initialize n-gram speculative decoding");
+        return nullptr;
+    }
+    ngram_spec_params = spec_params;
+
+    LOG_INFO("Initialized shared n-gram speculative state (%s) for %d queued slots",
+             common_speculative_type_name_str(spec_params.types).c_str(), n_parallel);
+    return ngram_spec;
+}
+
+void llama_rn_slot_manager::reset_ngram_speculative() {
+    if (ngram_spec == nullptr) {
+        return;
+    }
+
+    for (auto& slot : slots) {
+        if (slot.spec != ngram_spec) {
+            continue;
+        }
+        slot.spec = nullptr;
+        slot.spec_is_shared = false;
+        slot.spec_prompt.clear();
+        slot.spec_id_last = LLAMA_TOKEN_NULL;
+        slot.spec_draft.clear();
+        slot.spec_i_batch.clear();
+    }
+
+    common_speculative_free(ngram_spec);
+    ngram_spec = nullptr;
+    ngram_spec_params = common_params_speculative();
+}
+
+// Queue a draft request for a slot whose last token was just added to the
+// batch. Returns false when the slot should decode without a draft this step.
+bool llama_rn_slot_manager::begin_ngram_draft(llama_rn_slot& slot) {
+    slot.spec_draft.clear();
+    slot.spec_i_batch.clear();
+
+    // Per-token probabilities come from the last sample only, and media
+    // histories don't map tokens to positions one-to-one
+    if (slot.params->sampling.n_probs > 0 || !slot.bitmap_past_hashes.empty()) {
+        return false;
+    }
+
+    const llama_pos pos_last = slot.n_past - 1;
+    if ((llama_pos) slot.cache_tokens.size() != pos_last + 1) {
+        return false;
+    }
+
+    if (slot.spec == nullptr) {
+        slot.spec = ensure_ngram_speculative(*slot.params);
+        if (slot.spec == nullptr) {
+            return false;
+        }
+        slot.spec_is_shared = true;
+        slot.spec_id_last = LLAMA_TOKEN_NULL;
+    }
+
+    // spec_prompt mirrors the history before the last token; extend it in
+    // place and only restart the drafter when the history was rewritten
+    if (slot.spec_id_last == LLAMA_TOKEN_NULL || (llama_pos) slot.spec_prompt.size() > pos_last) {
+        slot.spec_prompt.assign(slot.cache_tokens.begin(), slot.cache_tokens.end() - 1);
+        common_speculative_begin(slot.spec, slot.id, slot.spec_prompt);
+    } else {
+        slot.spec_prompt.insert(slot.spec_prompt.end(),
+                                slot.cache_tokens.begin() + slot.spec_prompt.size(),
+                                slot.cache_tokens.end() - 1);
+    }
+    slot.spec_id_last = slot.cache_tokens.back();
+
+    const auto limits = common_speculative_get_output_limits(
+        n_batch, n_parallel, common_speculative_n_max(&slot.params->speculative));
+    int32_t n_draft_max = limits.per_seq - 1;
+    if (slot.n_remaining > 0) {
+        n_draft_max = std::min<int32_t>(n_draft_max, slot.n_remaining - 1);
+    }
+    n_draft_max = std::min<int32_t>(n_draft_max, slot.n_ctx - slot.n_past - 1);
+    if (n_draft_max <= 0) {
+        return false;
+    }
+
+    common_speculative_get_draft_params(slot.spec, slot.id) = {
+        /* .drafting = */ true,
+        /* .n_max    = */ n_draft_max,
+        /* .n_past   = */ pos_last,
+        /* .id_last  = */ slot.spec_id_last,
+        /* .prompt   = */ &slot.spec_prompt,
+        /* .result   = */ &slot.spec_draft,
+    };
+    return true;
+}
+
 int32_t llama_rn_slot_manager::reserve_request_id() {
     return next_request_id.fetch_add(1, std::memory_order_relaxed);
 }
@@ -602,6 +771,15 @@ void llama_rn_slot_manager::process_pending_queue() {
                 slot->load_state_size = request.load_state_size;
                 slot->save_state_size = request.save_state_size;
 
+                // Page out the conversation this slot held and page in the
+                // spilled one that shares the longest prefix with the prompt.
+                // Media prompts are left to processMedia's own prefix reuse.
+                if (spill_max_entries > 0 &&
+                    (request.media_paths.empty() || !parent_ctx->isMultimodalEnabled())) {
+                    swap_in_prefix(*slot, request.prompt_tokens, slot->load_state_path.empty());
+                }
+                slot->cache_spillable = true;
+
                 // Load state if provided
                 if (!slot->load_state_path.empty()) {
                     if (!slot->load_state()) {
@@ -652,6 +830,10 @@ void llama_rn_slot_manager::process_pending_queue() {
             }
 
             case SLOT_TASK_TYPE_EMBEDDING: {
+                if (spill_max_entries > 0) {
+                    spill_slot(*slot);
+                }
+                slot->cache_spillable = false;
                 slot->params_storage = request.params;
                 slot->params = &slot->params_storage;
                 // Start timing (no state loading for embeddings)
@@ -670,6 +852,10 @@ void llama_rn_slot_manager::process_pending_queue() {
             }
 
             case SLOT_TASK_TYPE_RERANK: {
+                if (spill_max_entries > 0) {
+                    spill_slot(*slot);
+                }
+                slot->cache_spillable = false;
                 slot->params = nullptr;
                 // Start timing (memory clear is part of the task, not overhead)
                 slot->t_start_process = lm_ggml_time_us();
@@ -717,12 +903,310 @@ void llama_rn_slot_manager::process_pending_queue() {
     }
 }
 
+// Configure KV spill for idle slots
+void llama_rn_slot_manager::set_spill_config(int32_t max_entries, int64_t idle_ms, const std::string& dir) {
+    std::lock_guard<std::mutex> lock(slots_mutex);
+
+    spill_max_entries = std::max(0, max_entries);
+    spill_idle_ms = std::max<int64_t>(0, idle_ms);
+    spill_dir = dir;
+
+    // Entries beyond the new limit are dropped oldest first
+    while ((int32_t) spilled.size() > spill_max_entries) {
+        drop_spill_entry(spilled.front());
+        spilled.pop_front();
+    }
+
+    if (spill_max_entries > 0) {
+        LOG_INFO("KV spill enabled: max %d entries, idle %lld ms, %s",
+                 spill_max_entries, (long long) spill_idle_ms,
+                 spill_dir.empty() ? "host memory" : spill_dir.c_str());
+    }
+
+    // The idle deadline may have changed - let the processing loop re-arm its wait
+    slots_cv.notify_one();
+}
+
+// Page a slot's sequence state out and clear its memory. Returns false when
+// there was nothing worth keeping (the memory is cleared either way).
+bool llama_rn_slot_manager::spill_slot(llama_rn_slot& slot) {
+    if (!parent_ctx || !parent_ctx->ctx) {
+        return false;
+    }
+
+    llama_context * ctx = parent_ctx->ctx;
+    auto * mem = llama_get_memory(ctx);
+
+    std::vector<llama_token> tokens = std::move(slot.cache_tokens);
+    slot.cache_tokens.clear();
+    slot.bitmap_past_hashes.clear();
+
+    const bool spillable = slot.cache_spillable;
+    slot.cache_spillable = false;
+
+    // The last sampled token is in cache_tokens but not yet in the memory
+    const llama_pos n_kv = llama_memory_seq_pos_max(mem, slot.id) + 1;
+    if (!spillable || n_kv <= 0 || tokens.size() < (size_t) n_kv ||
+        std::find(tokens.begin(), tokens.end(), LLAMA_TOKEN_NULL) != tokens.end()) {
+        llama_memory_seq_rm(mem, slot.id, 0, -1);
+        return false;
+    }
+    tokens.resize(n_kv);
+
+    const int64_t t_start = lm_ggml_time_us();
+
+    llama_rn_spill_entry entry;
+    entry.tokens = std::move(tokens);
+
+    std::vector<uint8_t> data(llama_state_seq_get_size(ctx, slot.id));
+    entry.size = llama_state_seq_get_data(ctx, data.data(), data.size(), slot.id);
+    llama_memory_seq_rm(mem, slot.id, 0, -1);
+
+    if (entry.size == 0) {
+        LOG_WARNING("Slot %d: Failed to read sequence state, dropping it", slot.id);
+        return false;
+    }
+
+    if (spill_dir.empty()) {
+        data.resize(entry.size);
+        entry.data = std::move(data);
+    } else {
+        // The manager address keeps the names of several contexts sharing a directory apart
+        char name[64];
+        snprintf(name, sizeof(name), "/rnllama-spill-%p-%llu.bin", (void *) this, (unsigned long long) spill_counter++);
+        entry.path = spill_dir + name;
+        try {
+            llama_file file(entry.path.c_str(), "wb");
+            file.write_raw(data.data(), entry.size);
+        } catch (const std::exception& e) {
+            LOG_WARNING("Slot %d: Failed to write spill file %s: %s", slot.id, entry.path.c_str(), e.what());
+            std::remove(entry.path.c_str());
+            return false;
+        }
+    }
+
+    LOG_INFO("Slot %d: Spilled %zu tokens (%.2f KB) to %s in %.2f ms",
+             slot.id, entry.tokens.size(), entry.size / 1024.0,
+             entry.path.empty() ? "host memory" : entry.path.c_str(),
+             (lm_ggml_time_us() - t_start) / 1000.0);
+
+    spilled.push_back(std::move(entry));
+    while ((int32_t) spilled.size() > spill_max_entries) {
+        drop_spill_entry(spilled.front());
+        spilled.pop_front();
+    }
+
+    return true;
+}
+
+// Page a spilled sequence state back into an empty slot
+bool llama_rn_slot_manager::restore_spill(llama_rn_slot& slot, llama_rn_spill_entry& entry) {
+    llama_context * ctx = parent_ctx->ctx;
+
+    const int64_t t_start = lm_ggml_time_us();
+
+    size_t nread = 0;
+    if (entry.path.empty()) {
+        nread = llama_state_seq_set_data(ctx, entry.data.data(), entry.size, slot.id);
+    } else {
+        try {
+            llama_file file(entry.path.c_str(), "rb");
+            if (llama_mmap::SUPPORTED) {
+                llama_mmap mapping(&file);
+                nread = llama_state_seq_set_data(ctx, (const uint8_t *) mapping.addr(), entry.size, slot.id);
+            } else {
+                std::vector<uint8_t> data(entry.size);
+                file.read_raw(data.data(), entry.size);
+                nread = llama_state_seq_set_data(ctx, data.data(), entry.size, slot.id);
+            }
+        } catch (const std::exception& e) {
+            LOG_WARNING("Slot %d: Failed to read spill file %s: %s", slot.id, entry.path.c_str(), e.what());
+        }
+    }
+
+    if (nread == 0) {
+        LOG_WARNING("Slot %d: Failed to restore spilled state, prompt will be processed from scratch", slot.id);
+        llama_memory_seq_rm(llama_get_memory(ctx), slot.id, 0, -1);
+        drop_spill_entry(entry);
+        return false;
+    }
+
+    slot.cache_tokens = std::move(entry.tokens);
+    slot.bitmap_past_hashes.clear();
+    slot.cache_restored = true;
+
+    LOG_INFO("Slot %d: Restored %zu spilled tokens in %.2f ms",
+             slot.id, slot.cache_tokens.size(), (lm_ggml_time_us() - t_start) / 1000.0);
+
+    drop_spill_entry(entry);
+    return true;
+}
+
+// Give a slot the best cached prefix for the prompt: its own memory, or a
+// spilled conversation (in which case its own memory is spilled first)
+void llama_rn_slot_manager::swap_in_prefix(llama_rn_slot& slot, const std::vector<llama_token>& prompt, bool can_restore) {
+    // Only a prefix covering a good part of both sides counts as the same conversation
+    auto prefix_match = [&](const std::vector<llama_token>& tokens) -> size_t {
+        if (compute_similarity(tokens, prompt) < slot_prompt_similarity) {
+            return 0;
+        }
+        return find_common_prefix_length(tokens, prompt);
+    };
+
+    const size_t n_own = slot.cache_spillable ? prefix_match(slot.cache_tokens) : 0;
+
+    auto best = spilled.end();
+    size_t n_best = 0;
+    if (can_restore) {
+        for (auto it = spilled.begin(); it != spilled.end(); ++it) {
+            const size_t n_match = prefix_match(it->tokens);
+            if (n_match > n_best) {
+                n_best = n_match;
+                best = it;
+            }
+        }
+    }
+
+    if (can_restore && n_own > 0 && n_own >= n_best) {
+        slot.cache_restored = true;
+        return;
+    }
+
+    // Take the entry out first - spilling the slot may evict the oldest entries
+    llama_rn_spill_entry entry;
+    if (best != spilled.end()) {
+        entry = std::move(*best);
+        spilled.erase(best);
+    }
+
+    if (!slot.cache_tokens.empty()) {
+        spill_slot(slot);
+    }
+
+    if (n_best > 0) {
+        restore_spill(slot, entry);
+    }
+}
+
+// Spill idle slots past the idle timeout, and the least recently used idle
+// slots while a unified KV cache is close to full
+void llama_rn_slot_manager::spill_idle_slots() {
+    if (spill_max_entries <= 0 || !parent_ctx || !parent_ctx->ctx) {
+        return;
+    }
+
+    std::vector<llama_rn_slot*> idle;
+    for (auto& slot : slots) {
+        if (slot.state == SLOT_STATE_IDLE && slot.cache_spillable && !slot.cache_tokens.empty()) {
+            idle.push_back(&slot);
+        }
+    }
+    if (idle.empty()) {
+        return;
+    }
+
+    std::sort(idle.begin(), idle.end(), [](const llama_rn_slot* a, const llama_rn_slot* b) {
+        return a->t_last_used < b->t_last_used;
+    });
+
+    const int64_t t_now = lm_ggml_time_us();
+
+    if (spill_idle_ms > 0) {
+        for (auto* slot : idle) {
+            if (t_now - slot->t_last_used >= spill_idle_ms * 1000) {
+                LOG_VERBOSE("Slot %d: Idle for %lld ms, spilling", slot->id,
+                            (long long) ((t_now - slot->t_last_used) / 1000));
+                spill_slot(*slot);
+            }
+        }
+    }
+
+    // Memory pressure: all slots share the cells of a unified cache
+    if (!parent_ctx->params.kv_unified) {
+        return;
+    }
+
+    auto * mem = llama_get_memory(parent_ctx->ctx);
+    const int64_t n_ctx = llama_n_ctx(parent_ctx->ctx);
+
+    int64_t n_used = 0;
+    for (const auto& slot : slots) {
+        const llama_pos p_min = llama_memory_seq_pos_min(mem, slot.id);
+        if (p_min >= 0) {
+            n_used += llama_memory_seq_pos_max(mem, slot.id) - p_min + 1;
+        }
+    }
+
+    for (auto* slot : idle) {
+        if (n_used*10 < n_ctx*9) {
+            break;
+        }
+        if (slot->cache_tokens.empty()) {
+            continue;
+        }
+
+        const llama_pos p_min = llama_memory_seq_pos_min(mem, slot->id);
+        const int64_t n_slot = p_min >= 0 ? llama_memory_seq_pos_max(mem, slot->id) - p_min + 1 : 0;
+
+        LOG_VERBOSE("Slot %d: KV cache %lld/%lld cells used, spilling", slot->id,
+                    (long long) n_used, (long long) n_ctx);
+        spill_slot(*slot);
+        n_used -= n_slot;
+    }
+}
+
+// Earliest time (us) an idle slot reaches the spill timeout, -1 if none
+int64_t llama_rn_slot_manager::spill_next_deadline_us() const {
+    if (spill_max_entries <= 0 || spill_idle_ms <= 0) {
+        return -1;
+    }
+
+    int64_t deadline = -1;
+    for (const auto& slot : slots) {
+        if (slot.state == SLOT_STATE_IDLE && slot.cache_spillable && !slot.cache_tokens.empty()) {
+            const int64_t t = slot.t_last_used + spill_idle_ms * 1000;
+            if (deadline < 0 || t < deadline) {
+                deadline = t;
+            }
+        }
+    }
+
+    return deadline;
+}
+
+void llama_rn_slot_manager::drop_spill_entry(llama_rn_spill_entry& entry) {
+    if (!entry.path.empty()) {
+        std::remove(entry.path.c_str());
+        entry.path.clear();
+    }
+    entry.data.clear();
+    entry.data.shrink_to_fit();
+    entry.tokens.clear();
+    entry.size = 0;
+}
+
+void llama_rn_slot_manager::clear_spill() {
+    for (auto& entry : spilled) {
+        drop_spill_entry(entry);
+    }
+    spilled.clear();
+}
+
 // Build batch from all active slots
 void llama_rn_slot_manager::build_batch() {
     // Clear the batch
     batch.n_tokens = 0;
+    n_batch_gen = 0;
+
+    // A tree that was never verified (failed decode) still holds branch sequences
+    for (auto& slot : slots) {
+        if (!slot.spec_tree_seq_ids.empty()) {
+            slot.release_spec_tree();
+        }
+    }
 
     // First pass: Add tokens from GENERATING slots (previously sampled tokens)
+    std::vector<llama_rn_slot*> drafting;
     for (auto& slot : slots) {
         if (slot.state == SLOT_STATE_GENERATING) {
             if (slot.task_type == SLOT_TASK_TYPE_COMPLETION && slot.should_use_mtp()) {
@@ -742,9 +1226,94 @@ void llama_rn_slot_manager::build_batch() {
                 slot.n_past++; // Increment for next token
 
                 LOG_VERBOSE("Slot %d: Added generated token %d at pos %d", slot.id, token, slot.n_past - 1);
+
+                if (slot.task_type == SLOT_TASK_TYPE_COMPLETION && slot.should_use_ngram() &&
+                    begin_ngram_draft(slot)) {
+                    drafting.push_back(&slot);
+                }
+            }
+        }
+    }
+
+    // Draft every n-gram slot in one call and append the drafts behind the
+    // slots' last tokens so a single decode verifies them all
+    if (!drafting.empty() && ngram_spec != nullptr) {
+        common_speculative_draft(ngram_spec);
+
+        // Sequence ids past the slots are handed out to tree branches for this step
+        llama_seq_id seq_tree_next = n_parallel;
+        const llama_seq_id seq_tree_end = supports_draft_trees(parent_ctx)
+            ? (llama_seq_id) llama_n_seq_max(parent_ctx->ctx) : n_parallel;
+
+        for (auto* slot_ptr : drafting) {
+            auto& slot = *slot_ptr;
+            if (slot.spec != ngram_spec) {
+                continue;
+            }
+
+            const int32_t n_max = common_speculative_get_draft_params(ngram_spec, slot.id).n_max;
+            const int32_t n_room = n_batch - batch.n_tokens;
+            const int32_t n_draft = std::max<int32_t>(0, std::min<int32_t>(n_max, n_room));
+            if ((int32_t) slot.spec_draft.size() > n_draft) {
+                slot.spec_draft.resize(n_draft);
+            }
+
+            const auto& tree_params = slot.params->speculative.tree;
+            const int32_t n_branch = std::min<int32_t>(tree_params.n_branch, 1 + seq_tree_end - seq_tree_next);
+            if (n_branch > 1 && n_room > 0) {
+                // Branch out from the linear draft with the other continuations
+                // the slot's own history has seen
+                if (slot.cache_tokens.size() < slot.spec_tree_cache_n) {
+                    slot.spec_tree_cache.clear();
+                    slot.spec_tree_cache_n = 0;
+                }
+                common_ngram_cache_update(slot.spec_tree_cache, LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX, slot.cache_tokens,
+                                          slot.cache_tokens.size() - slot.spec_tree_cache_n, false);
+                slot.spec_tree_cache_n = slot.cache_tokens.size();
+
+                // The tree may be wider than a linear draft, but no deeper than
+                // the tokens the slot can still take
+                int32_t n_depth = slot.n_ctx - slot.n_past - 1;
+                if (slot.n_remaining > 0) {
+                    n_depth = std::min<int32_t>(n_depth, slot.n_remaining - 1);
+                }
+                common_speculative_tree_draft_ngram(slot.spec_tree, slot.cache_tokens, slot.spec_draft,
+                                                    slot.spec_tree_cache,
+                                                    std::min<int32_t>(tree_params.n_nodes, n_room), n_branch, n_depth);
+
+                if (!slot.spec_tree.empty()) {
+                    const int32_t n_leaf = slot.spec_tree.n_leaves();
+                    slot.spec_tree_seq_ids.assign(1, slot.id);
+                    for (int32_t b = 1; b < n_leaf; ++b) {
+                        slot.spec_tree_seq_ids.push_back(seq_tree_next++);
+                    }
+
+                    common_speculative_tree_prepare(parent_ctx->ctx, slot.spec_tree_seq_ids);
+                    common_speculative_tree_add(batch, slot.i_batch, slot.spec_tree, slot.spec_tree_seq_ids,
+                                                slot.spec_i_batch);
+                    slot.num_draft_tokens += slot.spec_tree.size();
+
+                    LOG_VERBOSE("Slot %d: Added draft tree of %zu tokens in %d branches at pos %d",
+                                slot.id, slot.spec_tree.size(), n_leaf, slot.n_past);
+                    continue;
+                }
             }
+
+            if (slot.spec_draft.empty()) {
+                continue;
+            }
+
+            slot.spec_i_batch.push_back(slot.i_batch);
+            for (size_t i = 0; i < slot.spec_draft.size(); ++i) {
+                llama_batch_add(&batch, slot.spec_draft[i], slot.n_past + (llama_pos) i, {slot.id}, true);
+                slot.spec_i_batch.push_back(batch.n_tokens - 1);
+            }
+            slot.num_draft_tokens += slot.spec_draft.size();
+
+            LOG_VERBOSE("Slot %d: Added %zu draft tokens at pos %d", slot.id, slot.spec_draft.size(), slot.n_past);
         }
     }
+    n_batch_gen = batch.n_tokens;
 
     // Second pass: Add prompt tokens from PROCESSING_PROMPT slots
     for (auto& slot : slots) {
@@ -1011,6 +1580,8 @@ bool llama_rn_slot_manager::process_batch() {
         return false;
     }
 
+    const int64_t t_start_us = lm_ggml_time_us();
+
     // Call llama_decode with the unified batch
     int ret = llama_decode(parent_ctx->ctx, batch);
 
@@ -1035,6 +1606,12 @@ bool llama_rn_slot_manager::process_batch() {
     // This is critical for accurate performance metrics when using Metal/GPU
     llama_synchronize(parent_ctx->ctx);
 
+    // Feed the verify cost to the adaptive draft length controller; prompt-only
+    // batches say nothing about the cost of a generation step
+    if (n_batch_gen > 0) {
+        common_speculative_observe_decode(ngram_spec, (lm_ggml_time_us() - t_start_us) / 1e3, batch.n_tokens);
+    }
+
     LOG_VERBOSE("Batch processed successfully");
     return true;
 }
@@ -1200,113 +1777,204 @@ void llama_rn_slot_manager::sample_and_callback() {
                     continue;
                 }
 
-                llama_token new_token_id;
-                if (slot.i_batch == -1 && slot.media_pending_token != LLAMA_TOKEN_NULL) {
-                    // Pre-sampled right after media ingest (see build_batch);
-                    // the context logits no longer belong to this slot here
-                    new_token_id = slot.media_pending_token;
-                    slot.media_pending_token = LLAMA_TOKEN_NULL;
-                } else {
-                    new_token_id = common_sampler_sample(slot.ctx_sampling, parent_ctx->ctx, slot.i_batch);
-                }
-                common_sampler_accept(slot.ctx_sampling, new_token_id, true);
+                std::vector<llama_token> new_tokens;
+                const bool has_tree = !slot.spec_tree.empty() &&
+                    slot.spec_i_batch.size() == slot.spec_tree.size() + 1;
+                const bool has_draft = has_tree || (!slot.spec_draft.empty() &&
+                    slot.spec_i_batch.size() == slot.spec_draft.size() + 1);
+                if (has_tree) {
+                    // Walk the tree along the target's own samples and keep the
+                    // KV of the accepted path in the slot's sequence
+                    std::vector<int32_t> path;
+                    new_tokens = common_sampler_sample_and_accept_tree(
+                        slot.ctx_sampling, parent_ctx->ctx, slot.spec_i_batch, slot.spec_tree, path);
+                    common_speculative_tree_commit(parent_ctx->ctx, slot.spec_tree, path, slot.n_past,
+                                                   slot.spec_tree_seq_ids);
+
+                    slot.num_draft_tokens_accepted += path.size();
+
+                    // The drafter only learns how much of its own draft held up,
+                    // and nothing when the tree grew without one
+                    if (!slot.spec_draft.empty()) {
+                        size_t n_accepted_linear = 0;
+                        while (n_accepted_linear < path.size() && n_accepted_linear < slot.spec_draft.size() &&
+                               slot.spec_tree.tokens[path[n_accepted_linear]] == slot.spec_draft[n_accepted_linear]) {
+                            n_accepted_linear++;
+                        }
+                        common_speculative_accept(slot.spec, slot.id, (uint16_t) n_accepted_linear);
+                    }
 
-                if (llama_vocab_is_eog(vocab, new_token_id)) {
-                    slot.stopped_eos = true;
-                    LOG_INFO("Slot %d: Stopped on EOS token", slot.id);
+                    LOG_VERBOSE("Slot %d: Accepted %zu/%zu tree tokens in %zu branches",
+                               slot.id, path.size(), slot.spec_tree.size(), slot.spec_tree_seq_ids.size());
 
-                    // Save state if path is provided
-                    if (!slot.save_state_path.empty()) {
-                        slot.save_state();
-                    }
+                    slot.spec_tree.clear();
+                    slot.spec_tree_seq_ids.clear();
+                } else if (has_draft) {
+                    // Verify the n-gram draft: keeps the longest agreeing prefix
+                    // plus one token sampled from the target's own distribution
+                    new_tokens = common_sampler_sample_and_accept_n(
+                        slot.ctx_sampling, parent_ctx->ctx, slot.spec_i_batch, slot.spec_draft);
 
-                    complete_slot(slot);
-                    continue;
-                }
+                    const size_t n_accepted = new_tokens.empty() ? 0 : new_tokens.size() - 1;
+                    slot.num_draft_tokens_accepted += n_accepted;
+                    common_speculative_accept(slot.spec, slot.id, (uint16_t) n_accepted);
 
-                std::string token_text = common_token_to_piece(parent_ctx->ctx, new_token_id);
-                token_text = slot.utf8_gate.feed(token_text);
-                slot.generated_text += token_text;
-
-                // Update token generation timing
-                const int64_t t_current = lm_ggml_time_us();
-                slot.t_token_generation = (t_current - slot.t_start_generation) / 1e6;
-
-                completion_token_output token_output;
-                token_output.tok = new_token_id;
-                token_output.text = token_text;
-                token_output.request_id = slot.request_id;
-
-                const int32_t n_probs = slot.params->sampling.n_probs;
-                if (n_probs > 0) {
-                  llama_token_data_array cur_p = *common_sampler_get_candidates(slot.ctx_sampling, true);
-                  for (size_t i = 0; i < std::min(cur_p.size, (size_t)n_probs); ++i)
-                  {
-                      token_output.probs.push_back({cur_p.data[i].id, cur_p.data[i].p});
-                  }
+                    LOG_VERBOSE("Slot %d: Accepted %zu/%zu draft tokens",
+                               slot.id, n_accepted, slot.spec_draft.size());
+                } else {
+                    llama_token new_token_id;
+                    if (slot.i_batch == -1 && slot.media_pending_token != LLAMA_TOKEN_NULL) {
+                        // Pre-sampled right after media ingest (see build_batch);
+                        // the context logits no longer belong to this slot here
+                        new_token_id = slot.media_pending_token;
+                        slot.media_pending_token = LLAMA_TOKEN_NULL;
+                    } else {
+                        new_token_id = common_sampler_sample(slot.ctx_sampling, parent_ctx->ctx, slot.i_batch);
+                    }
+                    common_sampler_accept(slot.ctx_sampling, new_token_id, true);
+                    new_tokens.push_back(new_token_id);
                 }
 
-                slot.generated_tokens.push_back(new_token_id);
-                slot.n_decoded++;
-                slot.num_tokens_predicted++;
+                for (size_t i_token = 0; i_token < new_tokens.size(); ++i_token) {
+                    const llama_token new_token_id = new_tokens[i_token];
+                    if (i_token > 0) {
+                        // The previous token was decoded as part of the draft
+                        slot.n_past++;
+                    }
 
-                // Update cache_tokens to keep track of all processed tokens
-                // This is needed for state saving
-                slot.cache_tokens.push_back(new_token_id);
+                    if (llama_vocab_is_eog(vocab, new_token_id)) {
+                        slot.stopped_eos = true;
+                        LOG_INFO("Slot %d: Stopped on EOS token", slot.id);
 
-                // still emit an empty delta when it carries requested probs
-                if (slot.on_token_callback && (!token_output.text.empty() || !token_output.probs.empty())) {
-                    slot.on_token_callback(token_output);
-                }
+                        if (has_draft) {
+                            llama_memory_seq_rm(llama_get_memory(parent_ctx->ctx), slot.id, slot.n_past, -1);
+                        }
 
-                bool should_stop = false;
+                        // Save state if path is provided
+                        if (!slot.save_state_path.empty()) {
+                            slot.save_state();
+                        }
 
-                if (slot.n_remaining > 0) {
-                    slot.n_remaining--;
-                    if (slot.n_remaining == 0) {
-                        slot.stopped_limit = true;
-                        should_stop = true;
-                        LOG_INFO("Slot %d: Stopped on token limit", slot.id);
+                        complete_slot(slot);
+                        break;
                     }
-                }
 
-                if (slot.n_past >= slot.n_ctx) {
-                    slot.context_full = true;
-                    should_stop = true;
-                    LOG_WARNING("Slot %d: Context full", slot.id);
-                }
+                    std::string token_text = common_token_to_piece(parent_ctx->ctx, new_token_id);
+                    token_text = slot.utf8_gate.feed(token_text);
+                    slot.generated_text += token_text;
+
+                    // Update token generation timing
+                    const int64_t t_current = lm_ggml_time_us();
+                    slot.t_token_generation = (t_current - slot.t_start_generation) / 1e6;
+
+                    completion_token_output token_output;
+                    token_output.tok = new_token_id;
+                    token_output.text = token_text;
+                    token_output.request_id = slot.request_id;
+
+                    const int32_t n_probs = slot.params->sampling.n_probs;
+                    if (n_probs > 0) {
+                      llama_token_data_array cur_p = *common_sampler_get_candidates(slot.ctx_sampling, true);
+                      for (size_t i = 0; i < std::min(cur_p.size, (size_t)n_probs); ++i)
+                      {
+                          token_output.probs.push_back({cur_p.data[i].id, cur_p.data[i].p});
+                      }
+                    }
+
+                    slot.generated_tokens.push_back(new_token_id);
+                    slot.n_decoded++;
+                    slot.num_tokens_predicted++;
 
-                if (!slot.stop_words.empty() && !slot.generated_text.empty()) {
-                    const std::string& text = slot.generated_text;
-                    const size_t last_token_size = token_text.size();
+                    // Update cache_tokens to keep track of all processed tokens
+                    // This is needed for state saving
+                    slot.cache_tokens.push_back(new_token_id);
+
+                    // still emit an empty delta when it carries requested probs
+                    if (slot.on_token_callback && (!token_output.text.empty() || !token_output.probs.empty())) {
+                        slot.on_token_callback(token_output);
+                    }
 
-                    for (const std::string& word : slot.stop_words) {
-                        const size_t search_start = text.size() > word.size() + last_token_size
-                            ? text.size() - word.size() - last_token_size
-                            : 0;
-                        size_t pos = text.find(word, search_start);
+                    bool should_stop = false;
 
-                        if (pos != std::string::npos) {
-                            slot.stopped_word = true;
-                            slot.stopping_word = word;
+                    if (slot.n_remaining > 0) {
+                        slot.n_remaining--;
+                        if (slot.n_remaining == 0) {
+                            slot.stopped_limit = true;
                             should_stop = true;
-                            LOG_INFO("Slot %d: Stopped on word '%s'", slot.id, word.c_str());
-                            break;
+                            LOG_INFO("Slot %d: Stopped on token limit", slot.id);
                         }
                     }
-                }
 
-                if (should_stop) {
-                    // Save state if path is provided
-                    if (!slot.save_state_path.empty()) {
-                        slot.save_state();
+                    if (slot.n_past >= slot.n_ctx && slot.params->ctx_shift && slot.params->n_sink > 0 &&
+                        slot.bitmap_past_hashes.empty()) {
+                        // Attention-sink streaming: keep generating within a constant
+                        // budget by evicting a small block behind the sinks
+                        const int32_t n_evicted = evict_sink_window(
+                            parent_ctx->ctx, slot.id, slot.n_ctx,
+                            slot.params->n_sink, slot.params->n_sink_evict, slot.cache_tokens);
+                        if (n_evicted > 0) {
+                            slot.n_past -= n_evicted;
+                            slot.truncated = true;
+                            // The drafter's history no longer matches; restart it
+                            slot.spec_id_last = LLAMA_TOKEN_NULL;
+                            LOG_VERBOSE("Slot %d: Sink window shifted, evicted %d, n_past = %d",
+                                        slot.id, n_evicted, (int) slot.n_past);
+                        }
                     }
 
-                    complete_slot(slot);
+                    if (slot.n_past >= slot.n_ctx) {
+                        slot.context_full = true;
+                        should_stop = true;
+                        LOG_WARNING("Slot %d: Context full", slot.id);
+                    }
+
+                    if (!slot.stop_words.empty() && !slot.generated_text.empty()) {
+                        const std::string& text = slot.generated_text;
+                        const size_t last_token_size = token_text.size();
+
+                        for (const std::string& word : slot.stop_words) {
+                            const size_t search_start = text.size() > word.size() + last_token_size
+                                ? text.size() - word.size() - last_token_size
+                                : 0;
+                            size_t pos = text.find(word, search_start);
+
+                            if (pos != std::string::npos) {
+                                slot.stopped_word = true;
+                                slot.stopping_word = word;
+                                should_stop = true;
+                                LOG_INFO("Slot %d: Stopped on word '%s'", slot.id, word.c_str());
+                                break;
+                            }
+                        }
+                    }
+
+                    LOG_VERBOSE("Slot %d: Generated token %d ('%s'), n_past=%d, n_decoded=%d",
+                               slot.id, new_token_id, token_text.c_str(), slot.n_past, slot.n_decoded);
+
+                    if (should_stop) {
+                        if (has_draft) {
+                            // Drop accepted draft positions past the stopping token
+                            // so memory matches cache_tokens before saving
+                            llama_memory_seq_rm(llama_get_memory(parent_ctx->ctx), slot.id, slot.n_past, -1);
+                        }
+
+                        // Save state if path is provided
+                        if (!slot.save_state_path.empty()) {
+                            slot.save_state();
+                        }
+
+                        complete_slot(slot);
+                        break;
+                    }
                 }
 
-                LOG_VERBOSE("Slot %d: Generated token %d ('%s'), n_past=%d, n_decoded=%d",
-                           slot.id, new_token_id, token_text.c_str(), slot.n_past, slot.n_decoded);
+                if (has_draft) {
+                    // Rejected draft positions are stale; the last accepted token
+                    // is decoded at n_past in the next batch
+                    llama_memory_seq_rm(llama_get_memory(parent_ctx->ctx), slot.id, slot.n_past, -1);
+                    slot.spec_draft.clear();
+                    slot.spec_i_batch.clear();
+                }
                 break;
             }
 
@@ -1421,6 +2089,9 @@ void llama_rn_slot_manager::update_slots() {
         // Releasing interrupted slots first lets the next queued request claim
         // the slot in this update rather than waiting for another worker turn.
         process_pending_queue();
+
+        // Page out idle conversations once the queue had its pick of them
+        spill_idle_slots();
     }
 
     // Step 2: Check if any slots are active (with mutex)
@@ -1591,10 +2262,18 @@ void llama_rn_slot_manager::start_processing_loop() {
 
             // If no work, wait for notification
             if (!has_work && processing_active.load()) {
-                slots_cv.wait(lock, [this]() {
+                auto wake = [this]() {
                     // Wake up if: there are pending requests, or processing should stop
                     return !queue_requests.empty() || !processing_active.load();
-                });
+                };
+                // Idle slots waiting for the spill timeout bound the wait
+                const int64_t deadline = spill_next_deadline_us();
+                if (deadline >= 0) {
+                    const int64_t t_wait = std::max<int64_t>(0, deadline - lm_ggml_time_us());
+                    slots_cv.wait_for(lock, std::chrono::microseconds(t_wait), wake);
+                } else {
+                    slots_cv.wait(lock, wake);
+                }
             } else if (has_work) {
                 lock.unlock();
                 std::this_thread::sleep_for(std::chrono::microseconds(100));
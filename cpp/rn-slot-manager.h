@@ -92,6 +92,16 @@ struct llama_rn_queued_request {
     {}
 };
 
+// Sequence state of an idle slot that was paged out to make room for other
+// conversations. The state lives in host memory, or in a spill file when a
+// spill directory is configured.
+struct llama_rn_spill_entry {
+    std::vector<llama_token> tokens;   // Tokens backing the saved positions [0, tokens.size())
+    std::vector<uint8_t> data;         // Host-memory copy (empty for file-backed entries)
+    std::string path;                  // Spill file (empty for host-memory entries)
+    size_t size = 0;                   // Size of the sequence state in bytes
+};
+
 // Slot manager for parallel decoding
 struct llama_rn_slot_manager {
     // Parent context reference
@@ -111,6 +121,7 @@ struct llama_rn_slot_manager {
     // Batch processing
     llama_batch batch;
     int32_t n_batch;                       // Max batch size
+    int32_t n_batch_gen = 0;               // Generation tokens (last tokens and drafts) in the batch
 
     // Shared MTP speculative decoding state. llama.cpp's MTP driver is
     // multi-sequence, so queued slots borrow this instead of creating one
@@ -124,11 +135,25 @@ struct llama_rn_slot_manager {
     int32_t mtp_spec_n_gpu_layers = -1;
     lm_ggml_type mtp_spec_cache_type_k = LM_GGML_TYPE_F16;
     lm_ggml_type mtp_spec_cache_type_v = LM_GGML_TYPE_F16;
+    common_params_speculative_adaptive mtp_spec_adaptive;
+
+    // Shared n-gram speculative state. N-gram drafting needs no draft model,
+    // so one multi-sequence drafter serves every slot and all drafts are
+    // verified together in the slot batch.
+    common_speculative *ngram_spec = nullptr;
+    common_params_speculative ngram_spec_params;
 
     // Configuration
     float slot_prompt_similarity;          // Threshold for cache reuse (0.0-1.0)
     bool continuous_batching;              // Allow mixing prompt/generation
 
+    // KV spill for idle slots (disabled when spill_max_entries is 0)
+    int32_t spill_max_entries = 0;         // Max spilled conversations kept (LRU)
+    int64_t spill_idle_ms = 0;             // Spill slots idle for longer than this (0 = only on demand)
+    std::string spill_dir;                 // Directory for spill files (empty = host memory)
+    std::deque<llama_rn_spill_entry> spilled; // Oldest first
+    uint64_t spill_counter = 0;            // Used to name spill files
+
     // Processing loop control
     std::mutex slots_mutex;                // Mutex for thread-safe access to slots
     std::condition_variable slots_cv;      // Condition variable for efficient waiting
@@ -213,9 +238,25 @@ struct llama_rn_slot_manager {
     llama_context* get_mtp_draft_context() const;
     void reset_mtp_speculative();
 
+    // N-gram speculation: drafts are appended to the slot batch after each
+    // slot's last token and verified in sample_and_callback
+    common_speculative* ensure_ngram_speculative(const common_params& params);
+    void reset_ngram_speculative();
+    bool begin_ngram_draft(llama_rn_slot& slot);
+
     // Process pending queue
     void process_pending_queue();
 
+    // KV spill
+    void set_spill_config(int32_t max_entries, int64_t idle_ms, const std::string& dir);
+    bool spill_slot(llama_rn_slot& slot);
+    bool restore_spill(llama_rn_slot& slot, llama_rn_spill_entry& entry);
+    void swap_in_prefix(llama_rn_slot& slot, const std::vector<llama_token>& prompt, bool can_restore);
+    void spill_idle_slots();
+    int64_t spill_next_deadline_us() const;
+    void drop_spill_entry(llama_rn_spill_entry& entry);
+    void clear_spill();
+
     // Release completed slots
     void release_completed_slots();
 
@@ -12,6 +12,19 @@
 
 namespace rnllama {
 
+bool is_ngram_speculative_type(common_speculative_type type) {
+    switch (type) {
+        case COMMON_SPECULATIVE_TYPE_NGRAM_SIMPLE:
+        case COMMON_SPECULATIVE_TYPE_NGRAM_MAP_K:
+        case COMMON_SPECULATIVE_TYPE_NGRAM_MAP_K4V:
+        case COMMON_SPECULATIVE_TYPE_NGRAM_MOD:
+        case COMMON_SPECULATIVE_TYPE_NGRAM_CACHE:
+            return true;
+        default:
+            return false;
+    }
+}
+
 // Constructor
 llama_rn_slot::llama_rn_slot() :
     id(-1),
@@ -24,6 +37,8 @@ llama_rn_slot::llama_rn_slot() :
     n_decoded(0),
     n_remaining(-1),
     i_batch(-1),
+    cache_spillable(false),
+    cache_restored(false),
     embd_normalize(-1),
     num_prompt_tokens(0),
     num_tokens_predicted(0),
@@ -173,6 +188,11 @@ void llama_rn_slot::load_prompt(const std::vector<llama_token>& tokens) {
     state = SLOT_STATE_PROCESSING_PROMPT;
     n_decoded = 0;
 
+    // The memory holds a prefix worth reusing: loaded from a state file or
+    // paged back in from a spill entry
+    const bool reuse_cache = !load_state_path.empty() || cache_restored;
+    cache_restored = false;
+
     // Check if model is recurrent/hybrid - needs special handling for state reuse
     bool is_recurrent_or_hybrid = false;
     if (parent_ctx && parent_ctx->ctx) {
@@ -189,7 +209,7 @@ void llama_rn_slot::load_prompt(const std::vector<llama_token>& tokens) {
         n_prompt_tokens_cache = 0;
         LOG_VERBOSE("Slot %d (req=%d): Media prompt, deferring memory reuse to processMedia (%zu cached tokens)",
                    id, request_id, cache_tokens.size());
-    } else if (!load_state_path.empty() && !cache_tokens.empty()) {
+    } else if (reuse_cache && !cache_tokens.empty()) {
         // Find how many tokens match between cached state and new prompt
         size_t n_matching = find_common_prefix_length(cache_tokens, tokens);
 
@@ -339,6 +359,15 @@ bool llama_rn_slot::should_use_mtp() const {
     return std::find(types.begin(), types.end(), COMMON_SPECULATIVE_TYPE_DRAFT_MTP) != types.end();
 }
 
+bool llama_rn_slot::should_use_ngram() const {
+    if (params == nullptr || should_use_mtp()) {
+        return false;
+    }
+
+    const auto & types = params->speculative.types;
+    return std::any_of(types.begin(), types.end(), is_ngram_speculative_type);
+}
+
 void llama_rn_slot::reset_speculative() {
     if (spec != nullptr) {
         if (!spec_is_shared) {
@@ -363,6 +392,23 @@ void llama_rn_slot::reset_speculative() {
     spec_n_past = 0;
     spec_draft.clear();
     spec_pending_tokens.clear();
+    spec_i_batch.clear();
+    release_spec_tree();
+    spec_tree_cache.clear();
+    spec_tree_cache_n = 0;
+}
+
+// Drop a tree that was drafted but never verified (e.g. the decode failed),
+// so its branch sequences don't keep cells alive
+void llama_rn_slot::release_spec_tree() {
+    if (spec_tree_seq_ids.size() > 1 && parent_ctx != nullptr && parent_ctx->ctx != nullptr) {
+        auto * mem = llama_get_memory(parent_ctx->ctx);
+        for (size_t i = 1; i < spec_tree_seq_ids.size(); ++i) {
+            llama_memory_seq_rm(mem, spec_tree_seq_ids[i], -1, -1);
+        }
+    }
+    spec_tree.clear();
+    spec_tree_seq_ids.clear();
 }
 
 void llama_rn_slot::init_mtp() {
@@ -537,6 +583,7 @@ bool llama_rn_slot::refill_mtp_tokens() {
                          spec_n_past + (llama_pos) i + 1, { seq_id }, true);
     }
 
+    const int64_t t_verify_us = lm_ggml_time_us();
     const int ret = llama_decode(parent_ctx->ctx, spec_batch);
     if (ret != 0) {
         throw std::runtime_error("failed to evaluate MTP target batch, ret=" + std::to_string(ret));
@@ -545,7 +592,9 @@ bool llama_rn_slot::refill_mtp_tokens() {
         throw std::runtime_error("failed to process MTP target batch");
     }
 
+    // reading the logits waits for the decode, so no extra synchronization is needed for the timing
     auto accepted = common_sampler_sample_and_accept_n(ctx_sampling, parent_ctx->ctx, spec_draft);
+    common_speculative_observe_decode(spec, (lm_ggml_time_us() - t_verify_us) / 1e3, spec_batch.n_tokens);
     if (accepted.empty()) {
         return false;
     }
@@ -657,6 +706,16 @@ slot_timings llama_rn_slot::get_timings() const {
         timings.predicted_per_second = n_decoded / t_token_generation;
     }
 
+    if (spec != nullptr) {
+        const auto stats = common_speculative_get_adaptive_stats(spec, id);
+        timings.draft_n = stats.n_draft;
+        timings.draft_acceptance = stats.p_accept;
+        timings.draft_per_token_ms = stats.t_draft_per_token_ms;
+        timings.verify_ms = stats.t_verify_ms;
+        timings.verify_per_token_ms = stats.t_verify_per_token_ms;
+        timings.draft_expected_per_second = stats.expected_per_second;
+    }
+
     return timings;
 }
 
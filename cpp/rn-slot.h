@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "llama.h"
+#include "ngram-cache.h"
 #include "rn-llama.h"
 #include "sampling.h"
 #include "speculative.h"
@@ -31,6 +32,13 @@ struct slot_timings {
     double predicted_ms = 0.0;             // Total time for token generation (ms)
     double predicted_per_token_ms = 0.0;   // Time per generated token (ms)
     double predicted_per_second = 0.0;     // Tokens per second for generation
+
+    int32_t draft_n = -1;                  // Adaptive draft length of the last step (0 = paused, -1 = not adaptive)
+    double draft_acceptance = 0.0;         // Rolling probability that a draft token is accepted
+    double draft_per_token_ms = 0.0;       // Rolling time to draft one token (ms)
+    double verify_ms = 0.0;                // Fixed cost of a target decode step (ms)
+    double verify_per_token_ms = 0.0;      // Extra target decode cost per verified token (ms)
+    double draft_expected_per_second = 0.0; // Expected tokens per second at the chosen draft length
 };
 
 // Slot task types
@@ -48,6 +56,9 @@ enum llama_rn_slot_state {
     SLOT_STATE_DONE                // Completed (ready for cleanup)
 };
 
+// Whether a speculative type drafts from n-gram lookups instead of a draft model
+bool is_ngram_speculative_type(common_speculative_type type);
+
 // Per-slot completion state
 struct llama_rn_slot {
     // Slot identification
@@ -67,6 +78,8 @@ struct llama_rn_slot {
     // Token management
     std::vector<llama_token> prompt_tokens;
     std::vector<llama_token> cache_tokens;  // For KV cache reuse
+    bool cache_spillable;                   // cache_tokens back a completion that may be spilled
+    bool cache_restored;                    // cache_tokens were paged back in, reuse them in load_prompt
     std::vector<llama_token> generated_tokens;
     std::string generated_text;
     utf8_stream_gate utf8_gate;
@@ -114,7 +127,9 @@ struct llama_rn_slot {
     common_params* params;
     common_sampler* ctx_sampling;
 
-    // Speculative decoding context for MTP.
+    // Speculative decoding context for MTP, or the manager's shared n-gram
+    // drafter. N-gram drafts ride along in the shared batch; spec_i_batch holds
+    // the batch rows of [last token, draft...] for verification.
     common_speculative *spec = nullptr;
     llama_context *spec_ctx = nullptr;
     bool spec_is_shared = false;
@@ -125,6 +140,14 @@ struct llama_rn_slot {
     llama_pos spec_n_past = 0;
     llama_tokens spec_draft;
     std::deque<llama_token> spec_pending_tokens;
+    std::vector<int32_t> spec_i_batch;
+    // Token tree verified in place of spec_draft when tree drafting is on:
+    // branch i is decoded as spec_tree_seq_ids[i], [0] being the slot's own
+    // sequence, and spec_i_batch holds [last token, nodes...]
+    common_speculative_tree spec_tree;
+    std::vector<llama_seq_id> spec_tree_seq_ids;
+    common_ngram_cache spec_tree_cache; // n-grams of cache_tokens, source of the alternative branches
+    size_t spec_tree_cache_n = 0;       // cache_tokens already counted in spec_tree_cache
     size_t num_draft_tokens;
     size_t num_draft_tokens_accepted;
 
@@ -183,7 +206,9 @@ struct llama_rn_slot {
     completion_token_output get_next_token();
     completion_chat_output parseChatOutput(bool is_partial);
     bool should_use_mtp() const;
+    bool should_use_ngram() const;
     void reset_speculative();
+    void release_spec_tree();
     void init_mtp();
     void eval_mtp_prompt();
     bool refill_mtp_tokens();
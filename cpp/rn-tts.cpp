@@ -20,10 +20,19 @@
 #include <codecvt>
 #include <cstdlib>
 #include <cstring>
+#include <future>
 #include <limits>
 #include <locale>
 #include <memory>
 
+#ifdef _WIN32
+#    define rn_speaker_ftell _ftelli64
+#    define rn_speaker_fseek _fseeki64
+#else
+#    define rn_speaker_ftell ftello
+#    define rn_speaker_fseek fseeko
+#endif
+
 namespace rnllama {
 
 // ── Backbone text-embedding table reader (MOSS-TTS-Realtime) ───────────
@@ -428,7 +437,7 @@ static std::string outetts_v1_codes_from_speaker(json speaker) {
 }
 
 // Constructor and destructor implementations
-llama_rn_context_tts::llama_rn_context_tts(const std::string &vocoder_model_path, int /* batch_size */, bool use_gpu) {
+llama_rn_context_tts::llama_rn_context_tts(const std::string &vocoder_model_path, int /* batch_size */, bool use_gpu, lm_ggml_backend_arena_t compute_arena) {
   struct codec_model_params model_params = codec_model_default_params();
   model_params.use_gpu = use_gpu;
   codec_model = codec_model_load_from_file(vocoder_model_path.c_str(), model_params);
@@ -443,6 +452,7 @@ llama_rn_context_tts::llama_rn_context_tts(const std::string &vocoder_model_path
   }
 
   struct codec_context_params context_params = codec_context_default_params();
+  context_params.compute_arena = compute_arena;
   codec_ctx = codec_init_from_model(codec_model, context_params);
   if (codec_ctx == nullptr) {
       codec_model_free(codec_model);
@@ -468,6 +478,7 @@ llama_rn_context_tts::llama_rn_context_tts(const std::string &vocoder_model_path
       }
   }
 
+  codec_path = vocoder_model_path;
   type = UNKNOWN; // Will be determined when used
 }
 
@@ -488,6 +499,10 @@ llama_rn_context_tts::~llama_rn_context_tts() {
       codec_lm_free(codec_lm);
       codec_lm = nullptr;
   }
+  if (codec_decode_ctx != nullptr) {
+      codec_free(codec_decode_ctx);
+      codec_decode_ctx = nullptr;
+  }
   if (codec_ctx != nullptr) {
       codec_free(codec_ctx);
       codec_ctx = nullptr;
@@ -2020,6 +2035,643 @@ llama_rn_audio_codes_result llama_rn_context_tts::generateAudioCodes(
     return result;
 }
 
+// generateAudioCodesBatch — N utterances as parallel backbone sequences.
+//
+// Each utterance gets its own llama sequence id, codec_lm_state, sampler
+// RNG and position counter.  Prompts are packed into shared prefill
+// batches; after that every AR step is
+//
+//   codec_lm_step_begin_batch(all hiddens)
+//   per codebook: codec_lm_step_logits_batch → sample → push_code
+//   per sequence: step_finish → EOS check → compose_next_embd
+//   one llama_decode with one embd row per still-active sequence
+//
+// so the codec_lm heads (parallel_heads_delay logits, residual_depth_ar
+// c0 head + KV depth steps) run once per codebook for the whole group
+// instead of once per utterance.  The per-sequence semantics match the
+// legacy single-utterance path in tryCodecLmAudioStep, so each result
+// equals what generateAudioCodes produces for the same options.
+//
+// Utterances are grouped up to llama_n_seq_max and the context size;
+// the completion context's KV cache is cleared before and after.
+std::vector<llama_rn_audio_codes_result> llama_rn_context_tts::generateAudioCodesBatch(
+    llama_rn_context * main_ctx,
+    const std::vector<llama_rn_audio_codes_options> & opts) {
+
+    std::vector<llama_rn_audio_codes_result> results(opts.size());
+    if (opts.empty()) {
+        return results;
+    }
+    if (main_ctx == nullptr || main_ctx->ctx == nullptr || main_ctx->model == nullptr ||
+        main_ctx->completion == nullptr) {
+        LOG_ERROR("generateAudioCodesBatch: main context not initialized");
+        return results;
+    }
+    if (codec_model == nullptr) {
+        LOG_ERROR("generateAudioCodesBatch: codec model not loaded");
+        return results;
+    }
+    if (codec_lm == nullptr && !codec_lm_probed) {
+        codec_lm_probed = true;
+        codec_lm = ::codec_lm_create(codec_model);
+    }
+    const ::codec_lm_info * info = codec_lm != nullptr ? ::codec_lm_get_info(codec_lm) : nullptr;
+
+    // The batched driver covers the direct codec_lm_state flow only.
+    bool batchable = opts.size() > 1 && info != nullptr && !info->is_continuous &&
+                     llama_model_n_embd(main_ctx->model) == info->hidden_dim &&
+                     llama_n_seq_max(main_ctx->ctx) > 1;
+    if (batchable) {
+        const tts_model_profile & profile = profile_for_type(type);
+        const int compose_ed = info->compose_audio_embed_dim > 0
+            ? info->compose_audio_embed_dim : info->audio_embed_dim;
+        batchable = profile.decode_kind == tts_decode_kind::CODEC_LM_AR &&
+                    profile.audio_codebook_offset == 0 &&
+                    compose_ed == info->hidden_dim &&
+                    llama_vocab_type(llama_model_get_vocab(main_ctx->model)) != LLAMA_VOCAB_TYPE_NONE;
+    }
+    if (batchable && audio_lm_ctx != nullptr) {
+        codec_common::audio_lm_prompt_info pi{};
+        const bool have_pi = codec_common::audio_lm_get_prompt_info(audio_lm_ctx, &pi);
+        batchable = !(have_pi && (codec_common::audio_lm_talker_has_projection(audio_lm_ctx) ||
+                                  pi.cb0_from_backbone || pi.streaming_interleave));
+    }
+    if (!batchable) {
+        for (size_t i = 0; i < opts.size(); ++i) {
+            results[i] = generateAudioCodes(main_ctx, opts[i]);
+        }
+        return results;
+    }
+
+    llama_context * lctx   = main_ctx->ctx;
+    llama_memory_t  mem    = llama_get_memory(lctx);
+    const int n_cb         = info->n_codebook;
+    const int hidden       = info->hidden_dim;
+    const int n_seq_max    = (int) llama_n_seq_max(lctx);
+    const int n_ctx        = (int) llama_n_ctx(lctx);
+    const int n_ctx_seq    = (int) llama_n_ctx_seq(lctx);
+    const int n_batch      = std::max(1, (int) llama_n_batch(lctx));
+    const bool add_bos     = llama_vocab_get_add_bos(llama_model_get_vocab(main_ctx->model));
+
+    struct utterance {
+        size_t               index;       // into opts / results
+        llama_seq_id         seq_id;
+        std::vector<llama_token> prompt;
+        ::codec_lm_state *   st = nullptr;
+        uint64_t             rng = 0;
+        llama_pos            n_past = 0;
+        int                  max_frames = 0;
+        int                  step = 0;
+        bool                 active = true;
+    };
+
+    // The batch owns the backbone: drop whatever the completion cached.
+    main_ctx->completion->rewind();
+    main_ctx->completion->embd.clear();
+    llama_set_embeddings(lctx, true);
+
+    const auto now_us = []() -> int64_t {
+        const auto t = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::microseconds>(t).count();
+    };
+    const int64_t loop_t0 = now_us();
+    int total_frames = 0;
+
+    size_t next = 0;
+    while (next < opts.size()) {
+        // ── Group: as many utterances as fit in sequences and context ──
+        std::vector<utterance> group;
+        int ctx_used = 0;
+        while (next < opts.size() && (int) group.size() < n_seq_max) {
+            utterance u;
+            u.index      = next;
+            u.seq_id     = (llama_seq_id) group.size();
+            u.prompt     = ::common_tokenize(lctx, opts[next].prompt, add_bos, true);
+            u.max_frames = std::max(opts[next].max_frames, 1);
+            if ((int) u.prompt.size() >= n_ctx_seq) {
+                LOG_ERROR("generateAudioCodesBatch: prompt %zu exceeds n_ctx_seq (%d)", next, n_ctx_seq);
+                ++next;
+                continue;
+            }
+            u.max_frames = std::min(u.max_frames, n_ctx_seq - (int) u.prompt.size());
+            const int need = (int) u.prompt.size() + u.max_frames;
+            if (!group.empty() && ctx_used + need > n_ctx) {
+                break;
+            }
+            ctx_used += need;
+            u.rng = opts[next].seed ? (uint64_t) opts[next].seed : 0xC0DEC1ABULL;
+            group.push_back(std::move(u));
+            ++next;
+        }
+        if (group.empty()) {
+            continue;
+        }
+        const int n_group = (int) group.size();
+
+        llama_memory_clear(mem, false);
+        for (auto & u : group) {
+            u.st = ::codec_lm_state_new(codec_lm);
+            if (u.st == nullptr) {
+                LOG_ERROR("generateAudioCodesBatch: codec_lm_state_new failed");
+                u.active = false;
+            }
+        }
+
+        // ── Prefill: prompts packed into n_batch-sized batches, output
+        //    requested only at each prompt's last token. ────────────────
+        std::vector<float> h_all((size_t) n_group * hidden, 0.0f);
+        {
+            llama_batch b = llama_batch_init(n_batch, 0, 1);
+            std::vector<std::pair<int, int>> outputs;   // (group idx, batch row)
+            auto flush = [&]() -> bool {
+                if (b.n_tokens == 0) return true;
+                if (llama_decode(lctx, b) != 0) return false;
+                for (const auto & o : outputs) {
+                    const float * h = llama_get_embeddings_ith(lctx, o.second);
+                    if (h == nullptr) return false;
+                    std::memcpy(h_all.data() + (size_t) o.first * hidden, h, (size_t) hidden * sizeof(float));
+                }
+                common_batch_clear(b);
+                outputs.clear();
+                return true;
+            };
+            bool ok = true;
+            for (int g = 0; g < n_group && ok; ++g) {
+                utterance & u = group[(size_t) g];
+                if (!u.active) continue;
+                for (size_t t = 0; t < u.prompt.size() && ok; ++t) {
+                    const bool last = t + 1 == u.prompt.size();
+                    if (last) outputs.emplace_back(g, b.n_tokens);
+                    common_batch_add(b, u.prompt[t], u.n_past++, { u.seq_id }, last);
+                    if (b.n_tokens == n_batch) ok = flush();
+                }
+            }
+            ok = ok && flush();
+            llama_batch_free(b);
+            if (!ok) {
+                LOG_ERROR("generateAudioCodesBatch: prompt decode failed");
+                for (auto & u : group) u.active = false;
+            }
+        }
+
+        // ── AR loop ─────────────────────────────────────────────────────
+        llama_batch eb = llama_batch_init(n_group, hidden, 1);
+        std::vector<::codec_lm_state *> states;
+        std::vector<int> live;                    // group indices, step order
+        std::vector<const float *> logits((size_t) n_group, nullptr);
+        std::vector<int32_t> codes((size_t) n_cb, 0);
+        std::vector<float> h_step;
+        for (;;) {
+            states.clear();
+            live.clear();
+            h_step.clear();
+            for (int g = 0; g < n_group; ++g) {
+                if (!group[(size_t) g].active) continue;
+                live.push_back(g);
+                states.push_back(group[(size_t) g].st);
+                h_step.insert(h_step.end(), h_all.begin() + (size_t) g * hidden,
+                              h_all.begin() + (size_t) (g + 1) * hidden);
+            }
+            if (live.empty()) break;
+            const int n_live = (int) live.size();
+
+            bool ok = ::codec_lm_step_begin_batch(states.data(), n_live, h_step.data()) == CODEC_STATUS_SUCCESS;
+            for (int cb = 0; cb < n_cb && ok; ++cb) {
+                int32_t cb_idx = -1, vocab = 0;
+                ok = ::codec_lm_step_logits_batch(states.data(), n_live, logits.data(), &cb_idx, &vocab)
+                        == CODEC_STATUS_SUCCESS;
+                for (int i = 0; i < n_live && ok; ++i) {
+                    utterance & u = group[(size_t) live[(size_t) i]];
+                    const auto & o = opts[u.index];
+                    const float   temp = o.temperature;
+                    const float   topp = o.top_p > 0 ? o.top_p : 0.95f;
+                    const int32_t topk = o.top_k > 0 ? o.top_k : 50;
+                    const int32_t code = sample_codec_logits(logits[(size_t) i], vocab, temp, topk, topp, &u.rng);
+                    ok = ::codec_lm_step_push_code(u.st, code) == CODEC_STATUS_SUCCESS;
+                }
+            }
+            if (!ok) {
+                const char * err = ::codec_lm_state_get_last_error(states[0]);
+                LOG_ERROR("generateAudioCodesBatch: codec_lm step failed: %s",
+                          err && *err ? err : "(no error message)");
+                break;
+            }
+
+            common_batch_clear(eb);
+            for (int i = 0; i < n_live; ++i) {
+                const int g = live[(size_t) i];
+                utterance & u = group[(size_t) g];
+                llama_rn_audio_codes_result & r = results[u.index];
+                if (::codec_lm_step_finish(u.st, codes.data()) != CODEC_STATUS_SUCCESS) {
+                    LOG_ERROR("generateAudioCodesBatch: codec_lm_step_finish failed");
+                    u.active = false;
+                    continue;
+                }
+
+                bool is_eos = false;
+                if (info->eos_code_c0 >= 0) {
+                    int32_t eos_flag = 0;
+                    if (::codec_lm_step_is_eos(u.st, codes.data(), n_cb, &eos_flag) == CODEC_STATUS_SUCCESS) {
+                        is_eos = eos_flag != 0;
+                    }
+                } else if (type == CSM_1B) {
+                    is_eos = u.step > 0 && codes[0] == 0;
+                }
+                if (is_eos) {
+                    r.stopped_on_eos = true;
+                    u.active = false;
+                    continue;
+                }
+
+                r.codes.insert(r.codes.end(), codes.begin(), codes.end());
+                u.step++;
+                total_frames++;
+                if (u.step >= u.max_frames) {
+                    u.active = false;
+                    continue;
+                }
+
+                const int row = eb.n_tokens;
+                if (::codec_lm_compose_next_embd(codec_lm, codes.data(), u.step - 1,
+                                                 eb.embd + (size_t) row * hidden) != CODEC_STATUS_SUCCESS) {
+                    const char * err = ::codec_lm_get_last_error(codec_lm);
+                    LOG_ERROR("generateAudioCodesBatch: compose_next_embd failed: %s",
+                              err && *err ? err : "(no error message)");
+                    u.active = false;
+                    continue;
+                }
+                eb.pos[row]       = u.n_past++;
+                eb.n_seq_id[row]  = 1;
+                eb.seq_id[row][0] = u.seq_id;
+                eb.logits[row]    = 1;
+                eb.n_tokens++;
+            }
+            if (eb.n_tokens == 0) continue;
+
+            if (llama_decode(lctx, eb) != 0) {
+                LOG_ERROR("generateAudioCodesBatch: embd decode failed");
+                break;
+            }
+            // Rows were added in live order, skipping sequences that stopped.
+            int row = 0;
+            for (int i = 0; i < n_live; ++i) {
+                utterance & u = group[(size_t) live[(size_t) i]];
+                if (!u.active) continue;
+                const float * h = llama_get_embeddings_ith(lctx, row++);
+                if (h == nullptr) {
+                    u.active = false;
+                    continue;
+                }
+                std::memcpy(h_all.data() + (size_t) live[(size_t) i] * hidden, h, (size_t) hidden * sizeof(float));
+            }
+        }
+        llama_batch_free(eb);
+
+        for (auto & u : group) {
+            llama_rn_audio_codes_result & r = results[u.index];
+            r.n_codebook = n_cb;
+            r.n_frames   = (int) (r.codes.size() / (size_t) std::max(n_cb, 1));
+            if (u.st != nullptr) {
+                ::codec_lm_state_free(u.st);
+            }
+        }
+    }
+    llama_memory_clear(mem, false);
+
+    const int64_t loop_us = now_us() - loop_t0;
+    LOG_INFO("generateAudioCodesBatch done: %zu utterances, %d frames in %.2fs (%.1f frames/s)",
+             opts.size(), total_frames, (double) loop_us / 1e6,
+             (double) total_frames / std::max((double) loop_us / 1e6, 1e-6));
+    return results;
+}
+
+// ─────────────────────────────────────────────────────────────────────
+// Long-form synthesis: sentence segmentation + generate/decode pipeline.
+// ─────────────────────────────────────────────────────────────────────
+
+namespace {
+
+// Length of the UTF-8 sentence terminator at `s[i]`, or 0.  Covers ASCII
+// . ! ? plus the CJK full-width 。！？ and the ellipsis …; the CJK forms
+// end a sentence without trailing whitespace.
+size_t sentence_terminator_len(const std::string & s, size_t i, bool & cjk) {
+    static const char * const wide[] = { "\xE3\x80\x82", "\xEF\xBC\x81", "\xEF\xBC\x9F", "\xE2\x80\xA6" };
+    cjk = false;
+    const char c = s[i];
+    if (c == '.' || c == '!' || c == '?') {
+        return 1;
+    }
+    for (const char * w : wide) {
+        if (s.compare(i, 3, w) == 0) {
+            cjk = w[0] == '\xE3' || w[0] == '\xEF';
+            return 3;
+        }
+    }
+    return 0;
+}
+
+// True when the '.' at `dot` closes a common abbreviation or an initial
+// ("Dr.", "e.g.", "J.") rather than a sentence.
+bool is_abbreviation(const std::string & s, size_t dot) {
+    static const char * const abbrev[] = {
+        "mr", "mrs", "ms", "dr", "prof", "st", "sr", "jr", "vs", "etc", "e.g", "i.e", "no", "fig",
+    };
+    size_t b = dot;
+    while (b > 0 && !std::isspace((unsigned char) s[b - 1])) {
+        --b;
+    }
+    std::string word = s.substr(b, dot - b);
+    if (word.size() == 1 && std::isupper((unsigned char) word[0])) {
+        return true;
+    }
+    for (char & ch : word) {
+        ch = (char) std::tolower((unsigned char) ch);
+    }
+    for (const char * a : abbrev) {
+        if (word == a) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string trim_ws(const std::string & s) {
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace((unsigned char) s[b])) ++b;
+    while (e > b && std::isspace((unsigned char) s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+} // namespace
+
+// Split `text` into sentences, then pack consecutive sentences into
+// segments of at most `max_chars` bytes (0 = one sentence per segment;
+// paragraph breaks always end a sentence).  A sentence that alone exceeds
+// the limit is cut at the last clause mark (, ; :) or space before it;
+// cuts only ever land on ASCII bytes, so UTF-8 sequences stay whole.
+std::vector<std::string> split_tts_segments(const std::string & text, size_t max_chars) {
+    std::vector<std::string> sentences;
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ) {
+        if (text[i] == '\n' && i + 1 < text.size() && text[i + 1] == '\n') {
+            sentences.push_back(text.substr(start, i - start));
+            start = i + 2;
+            i += 2;
+            continue;
+        }
+        bool cjk = false;
+        const size_t n = sentence_terminator_len(text, i, cjk);
+        if (n == 0) {
+            ++i;
+            continue;
+        }
+        size_t end = i + n;
+        // Runs like "?!" or "..." and closing quotes / brackets stay with
+        // the sentence they end.
+        bool more = false;
+        while (end < text.size() && (sentence_terminator_len(text, end, more) > 0 ||
+                                     text[end] == '"' || text[end] == '\'' || text[end] == ')' ||
+                                     text[end] == ']')) {
+            end += std::max<size_t>(1, sentence_terminator_len(text, end, more));
+        }
+        const bool boundary = cjk || end == text.size() || std::isspace((unsigned char) text[end]);
+        if (boundary && !(n == 1 && text[i] == '.' && end == i + 1 && is_abbreviation(text, i))) {
+            sentences.push_back(text.substr(start, end - start));
+            start = end;
+        }
+        i = end;
+    }
+    if (start < text.size()) {
+        sentences.push_back(text.substr(start));
+    }
+
+    std::vector<std::string> segments;
+    std::string cur;
+    auto flush = [&]() {
+        cur = trim_ws(cur);
+        if (!cur.empty()) segments.push_back(cur);
+        cur.clear();
+    };
+    for (std::string sent : sentences) {
+        sent = trim_ws(sent);
+        if (sent.empty()) continue;
+        while (max_chars > 0 && sent.size() > max_chars) {
+            size_t cut = std::string::npos;
+            for (size_t j = max_chars; j > max_chars / 2; --j) {
+                const char c = sent[j];
+                if (c == ',' || c == ';' || c == ':') { cut = j + 1; break; }
+                if (cut == std::string::npos && c == ' ') cut = j;
+            }
+            if (cut == std::string::npos) {
+                cut = sent.find(' ', max_chars);
+                if (cut == std::string::npos) break;
+            }
+            flush();
+            cur = sent.substr(0, cut);
+            flush();
+            sent = trim_ws(sent.substr(cut));
+        }
+        if (!cur.empty() && (max_chars == 0 || cur.size() + 1 + sent.size() > max_chars)) {
+            flush();
+        }
+        if (!cur.empty()) cur += ' ';
+        cur += sent;
+    }
+    flush();
+    return segments;
+}
+
+static std::vector<float> decode_codes_on(
+    ::codec_context * cctx, ::codec_model * codec_model, ::codec_lm * codec_lm,
+    const tts_model_profile & profile, const std::vector<llama_token> & tokens, int n_threads);
+static std::vector<float> decode_latents_on(
+    ::codec_context * cctx, const std::vector<float> & embeddings, int embedding_dim, int n_threads);
+
+// synthesizeLongForm — one completion per segment, decode overlapped with
+// the next segment's generation.
+//
+//   gen(0) ─ gen(1) ─ gen(2) ─ …
+//            dec(0)   dec(1)   …
+//
+// Each segment runs the same getFormattedAudioCompletion + completion
+// loop a JS caller would run, with the same speaker JSON / speaker id, so
+// the voice (and a registry speaker's baked embedding) carries across
+// segments.  The finished segment's codes or latents are copied out and
+// decoded on a worker while the backbone generates the next segment; at
+// most one decode is in flight, so memory stays bounded by two segments.
+// Chunks reach `on_chunk` in segment order.
+//
+// The worker decodes on codec_decode_ctx, a second codec_context on the
+// same codec_model with a backend instance of its own, so it shares only
+// the (read-only) weights with the codec_lm steps of the next segment.
+// Flows whose decode reads the audio_lm accumulator (talker, MOSS-TTSD,
+// realtime, Chatterbox) cannot overlap — the next segment's rewind()
+// resets that accumulator — so they decode inline before moving on.
+llama_rn_long_form_tts_result llama_rn_context_tts::synthesizeLongForm(
+    llama_rn_context * main_ctx,
+    const llama_rn_long_form_tts_options & opts,
+    const llama_rn_audio_chunk_cb & on_chunk) {
+
+    llama_rn_long_form_tts_result result;
+    result.sample_rate = getAudioSampleRate();
+    if (main_ctx == nullptr || main_ctx->ctx == nullptr || main_ctx->completion == nullptr) {
+        LOG_ERROR("synthesizeLongForm: main context not initialized");
+        return result;
+    }
+    if (codec_ctx == nullptr || codec_model == nullptr) {
+        LOG_ERROR("synthesizeLongForm: codec context is not initialized");
+        return result;
+    }
+
+    const std::vector<std::string> segments = !opts.segments.empty()
+        ? opts.segments
+        : split_tts_segments(opts.text, (size_t) std::max(opts.max_segment_chars, 0));
+    if (segments.empty()) {
+        return result;
+    }
+
+    auto & params = main_ctx->params;
+    params.sampling.temp  = opts.temperature;
+    params.sampling.top_p = opts.top_p;
+    params.sampling.top_k = opts.top_k;
+    if (opts.seed != 0) {
+        params.sampling.seed = opts.seed;
+    }
+    if (opts.n_predict > 0) {
+        params.n_predict = opts.n_predict;
+    }
+    const int n_threads = std::max(1, params.cpuparams.n_threads);
+    const int decode_threads = opts.decode_threads > 0
+        ? opts.decode_threads : std::max(1, n_threads / 2);
+
+    // Resolve the profile here: getTTSType may create codec_lm lazily and
+    // must not run on the worker.
+    const tts_model_profile & profile = profile_for_type(getTTSType(main_ctx));
+    const bool overlap = !decodesViaAudioLm(main_ctx);
+    if (overlap && codec_decode_ctx == nullptr) {
+        // No compute arena: the worker computes while generation does.
+        struct codec_context_params decode_params = codec_context_default_params();
+        decode_params.own_backend = true;
+        codec_decode_ctx = codec_init_from_model(codec_model, decode_params);
+        if (codec_decode_ctx == nullptr) {
+            LOG_ERROR("synthesizeLongForm: failed to initialize the decode codec context");
+            return result;
+        }
+    }
+
+    // One decoded segment's payload: codes for token flows, latents for
+    // hidden-state / continuous flows.
+    struct segment_payload {
+        int index = 0;
+        std::vector<llama_token> tokens;
+        std::vector<float> embd;
+        int embd_dim = 0;
+    };
+    auto decode = [this, &profile, decode_threads](const segment_payload & p) -> std::vector<float> {
+        if (p.embd_dim > 0) {
+            return decode_latents_on(codec_decode_ctx, p.embd, p.embd_dim, decode_threads);
+        }
+        return decode_codes_on(codec_decode_ctx, codec_model, codec_lm, profile, p.tokens, decode_threads);
+    };
+
+    std::future<std::vector<float>> in_flight;
+    int in_flight_index = -1;
+    // Wait for the in-flight decode and hand its PCM to the caller.
+    auto drain = [&]() -> bool {
+        if (!in_flight.valid()) return true;
+        std::vector<float> pcm = in_flight.get();
+        result.n_samples += (int64_t) pcm.size();
+        return !on_chunk || on_chunk(in_flight_index, pcm);
+    };
+
+    const auto now_us = []() -> int64_t {
+        const auto t = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::microseconds>(t).count();
+    };
+    const int64_t t0 = now_us();
+
+    for (int k = 0; k < (int) segments.size(); ++k) {
+        const llama_rn_audio_completion_result fmt =
+            getFormattedAudioCompletion(main_ctx, opts.speaker_json, segments[(size_t) k], opts.speaker_id);
+        if (fmt.flow.empty() && fmt.prompt.empty() && fmt.talker_prefix_embd.empty()) {
+            LOG_ERROR("synthesizeLongForm: could not format segment %d", k);
+            break;
+        }
+
+        // Same sequence as the JSI completion binding: rewind (which also
+        // resets per-generation tts state), then this segment's params.
+        main_ctx->completion->rewind();
+        params.prompt    = fmt.prompt;
+        params.embedding = fmt.embedding;
+        llama_set_embeddings(main_ctx->ctx, fmt.embedding);
+        if (!fmt.grammar.empty()) {
+            params.sampling.grammar = {COMMON_GRAMMAR_TYPE_USER, fmt.grammar};
+        }
+        if (!main_ctx->completion->initSampling()) {
+            LOG_ERROR("synthesizeLongForm: initSampling failed");
+            break;
+        }
+        main_ctx->completion->beginCompletion();
+        main_ctx->completion->loadPrompt({});
+        if (main_ctx->completion->context_full) {
+            main_ctx->completion->endCompletion();
+            LOG_ERROR("synthesizeLongForm: segment %d exceeds n_ctx (%d)", k, main_ctx->n_ctx);
+            break;
+        }
+        while (main_ctx->completion->has_next_token && !main_ctx->completion->is_interrupted) {
+            (void) main_ctx->completion->doCompletion();
+        }
+        main_ctx->completion->endCompletion();
+        if (main_ctx->completion->is_interrupted) {
+            result.aborted = true;
+            break;
+        }
+
+        // Segment k-1 decoded while segment k generated; emit it first to
+        // keep chunks in order.
+        if (!drain()) {
+            result.aborted = true;
+            break;
+        }
+        result.n_segments++;
+
+        if (!overlap) {
+            // The accumulator this decode reads is reset by the next rewind().
+            std::vector<float> pcm = decodeAudioTokens(main_ctx, audio_tokens, decode_threads);
+            result.n_samples += (int64_t) pcm.size();
+            if (on_chunk && !on_chunk(k, pcm)) {
+                result.aborted = true;
+                break;
+            }
+            continue;
+        }
+
+        segment_payload payload;
+        payload.index = k;
+        if (!audio_embeddings.empty() && audio_embedding_dim > 0) {
+            payload.embd     = audio_embeddings;
+            payload.embd_dim = audio_embedding_dim;
+        } else if (profile.decode_kind == tts_decode_kind::HIDDEN_STATES) {
+            payload.embd     = main_ctx->completion->embeddings;
+            payload.embd_dim = main_ctx->completion->embedding_dim;
+        } else {
+            payload.tokens = audio_tokens;
+        }
+        in_flight_index = k;
+        in_flight = std::async(std::launch::async, decode, std::move(payload));
+    }
+    // Also reached on abort: the worker must finish before returning.
+    if (!drain()) {
+        result.aborted = true;
+    }
+
+    const double secs = (double) (now_us() - t0) / 1e6;
+    const double audio_secs = result.sample_rate > 0 ? (double) result.n_samples / result.sample_rate : 0.0;
+    LOG_INFO("synthesizeLongForm done: %d/%zu segments, %.2fs audio in %.2fs (RTF %.2f)",
+             result.n_segments, segments.size(), audio_secs, secs, audio_secs > 0 ? secs / audio_secs : 0.0);
+    return result;
+}
+
 // ─────────────────────────────────────────────────────────────────────
 // Continuous-latent codec_lm per-step hook (BlueMagpie-TTS / VoxCPM).
 //
@@ -3108,86 +3760,21 @@ static int32_t codec_meta_i32(::codec_model *codec_model, const char *key, int32
     return fallback;
 }
 
-std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* main_ctx, const std::vector<llama_token> &tokens) {
-    if (codec_ctx == nullptr || codec_model == nullptr) {
-        LOG_ERROR("Codec context is not initialized");
-        return std::vector<float>();
-    }
-
-    tts_type tts_type = getTTSType(main_ctx);
-    const tts_model_profile &profile = profile_for_type(tts_type);
-    if (profile.decode_kind == tts_decode_kind::HIDDEN_STATES) {
-        if (main_ctx->completion == nullptr) {
-            LOG_ERROR("Completion context is not initialized");
-            return std::vector<float>();
-        }
-        return decodeAudioEmbeddings(main_ctx, main_ctx->completion->embeddings, main_ctx->completion->embedding_dim);
-    }
-    if (profile.decode_kind == tts_decode_kind::UNSUPPORTED) {
-        // Chatterbox T3 with audio_lm path active decodes via audio_lm_decode_audio.
-        // Codes were accumulated into audio_tokens by the legacy codec_lm_state_*
-        // step path (Chatterbox doesn't hit the audio_lm Phase B fork today), so
-        // push them into the audio_lm accumulator first — decode_audio applies
-        // the codec's expected shape unshift internally.
-        if (audio_lm_ctx != nullptr) {
-            if (!tokens.empty()) {
-                const int32_t n_q = 1;  // Chatterbox S3G is single-codebook
-                const int32_t n_frames = (int32_t) tokens.size() / n_q;
-                std::vector<int32_t> flat(tokens.begin(), tokens.end());
-                if (!codec_common::audio_lm_push_codes(audio_lm_ctx, flat.data(),
-                                                       n_frames, n_q)) {
-                    LOG_ERROR("decodeAudioTokens: audio_lm_push_codes failed: %s",
-                              codec_common::audio_lm_last_error(audio_lm_ctx));
-                    return {};
-                }
-            }
-            codec_common::audio_lm_audio_output pcm_out;
-            if (!codec_common::audio_lm_decode_audio(audio_lm_ctx, &pcm_out)) {
-                LOG_ERROR("decodeAudioTokens: audio_lm_decode_audio failed: %s",
-                          codec_common::audio_lm_last_error(audio_lm_ctx));
-                return {};
-            }
-            return pcm_out.pcm;
-        }
-        LOG_ERROR("This TTS model's codec is not supported by codec.cpp yet");
-        return std::vector<float>();
-    }
-
-    // For codec_lm-AR models that used the audio_lm_ctx path (Qwen3-TTS /
-    // MOSS-TTSD / MOSS-TTS-Realtime), audio_lm_decode_audio reads the
-    // internal accumulator filled by audio_lm_observe_codes, applies the
-    // correct delay-pattern unshift and cb0_speech_offset remapping, and
-    // calls codec_decode.  This is the codec_common-canonical decode path
-    // and avoids the duplicate logic below.
-    if (profile.decode_kind == tts_decode_kind::CODEC_LM_AR && audio_lm_ctx != nullptr) {
-        // Check that we actually used the audio_lm step machine (not the
-        // legacy codec_lm_state path): the audio_lm accumulator has codes
-        // iff observe_codes was called at least once.
-        codec_common::audio_lm_prompt_info pi{};
-        const bool have_pi = codec_common::audio_lm_get_prompt_info(audio_lm_ctx, &pi);
-        const bool used_alm_path = have_pi && (
-            codec_common::audio_lm_talker_has_projection(audio_lm_ctx) ||
-            pi.cb0_from_backbone ||
-            pi.streaming_interleave);
-        if (used_alm_path) {
-            codec_common::audio_lm_audio_output pcm_out;
-            if (!codec_common::audio_lm_decode_audio(audio_lm_ctx, &pcm_out)) {
-                LOG_ERROR("decodeAudioTokens: audio_lm_decode_audio failed: %s",
-                          codec_common::audio_lm_last_error(audio_lm_ctx));
-                return {};
-            }
-            if (!pcm_out.pcm.empty()) return pcm_out.pcm;
-            // Empty PCM from audio_lm_decode_audio — fall through to direct path
-            // (may happen if the accumulator is empty due to EOS on frame 0).
-            LOG_WARNING("decodeAudioTokens: audio_lm_decode_audio returned empty PCM; falling back to direct path");
-        }
-    }
-
+// (T × n_cb) completion codes → (n_frames × n_q) codes in the codec's
+// quantizer space.  Shared by decodeAudioTokens / decodeAudioTokensBatch.
+static bool prepare_codec_tokens(
+    const tts_model_profile & profile,
+    ::codec_model * codec_model,
+    ::codec_lm * codec_lm,
+    const std::vector<llama_token> & tokens,
+    std::vector<int32_t> & out_codes,
+    int32_t & out_n_frames,
+    int32_t & out_n_q) {
     std::vector<llama_token> tokens_audio = tokens;
 
     if (tokens_audio.empty()) {
         LOG_ERROR("No audio codec tokens found in %zu completion tokens", tokens.size());
-        return std::vector<float>();
+        return false;
     }
 
     const int n_cb_in = profile.audio.n_codebook > 0 ? profile.audio.n_codebook : 1;
@@ -3196,11 +3783,12 @@ std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* mai
     const int n_q = (audio_cb_off > 0)
         ? (n_cb_in - audio_cb_off)
         : codec_decode_n_q_for_profile(profile, codec_model);
+    out_n_q = n_q;
     // Need at least one complete (T × n_cb_in) frame to produce any audio.
     if ((int)tokens_audio.size() < n_cb_in) {
         LOG_ERROR("Audio token count %zu is below the minimum frame size n_cb=%d",
                   tokens_audio.size(), n_cb_in);
-        return std::vector<float>();
+        return false;
     }
     // If the trailing tokens don't form a complete frame, drop them and warn.
     // This typically happens when the model is cut off mid-frame (n_predict
@@ -3245,7 +3833,7 @@ std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* mai
     if (max_delay > 0 && (int) n_frames <= max_delay) {
         LOG_ERROR("Audio frames %zu insufficient to cover delay_pattern (max_delay=%d)",
                   n_frames, max_delay);
-        return std::vector<float>();
+        return false;
     }
     const size_t n_frames_aligned = (max_delay > 0) ? (n_frames - (size_t) max_delay) : n_frames;
 
@@ -3257,7 +3845,8 @@ std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* mai
     const int32_t cb0_speech_offset = codec_meta_i32(codec_model, "codec.lm.cb0_speech_offset", 0);
     const int32_t codebook_sz = codec_model_codebook_size(codec_model);
 
-    std::vector<int32_t> codec_tokens;
+    std::vector<int32_t> & codec_tokens = out_codes;
+    codec_tokens.clear();
     if (audio_cb_off > 0 || max_delay > 0 || cb0_speech_offset != 0) {
         codec_tokens.resize(n_frames_aligned * (size_t) n_q);
         for (size_t t = 0; t < n_frames_aligned; ++t) {
@@ -3280,28 +3869,142 @@ std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* mai
     } else {
         codec_tokens.assign(tokens_audio.begin(), tokens_audio.end());
     }
-    struct codec_token_buffer token_buffer = {};
-    token_buffer.data = codec_tokens.data();
-    token_buffer.n_tokens = (int32_t)codec_tokens.size();
     // Delay-unshift trims max_delay tail frames; the buffer carries
     // n_frames_aligned frames (== n_frames when no delay).  Upstream
     // audio_lm_decode_audio uses the trimmed count (n_frames_out) here.
-    token_buffer.n_frames = (int32_t) n_frames_aligned;
+    out_n_frames = (int32_t) n_frames_aligned;
+    return true;
+}
+
+bool llama_rn_context_tts::decodesViaAudioLm(llama_rn_context* main_ctx) {
+    if (audio_lm_ctx == nullptr) {
+        return false;
+    }
+    const tts_model_profile &profile = profile_for_type(getTTSType(main_ctx));
+    if (profile.decode_kind == tts_decode_kind::UNSUPPORTED) {
+        return true;
+    }
+    if (profile.decode_kind != tts_decode_kind::CODEC_LM_AR) {
+        return false;
+    }
+    codec_common::audio_lm_prompt_info pi{};
+    const bool have_pi = codec_common::audio_lm_get_prompt_info(audio_lm_ctx, &pi);
+    return have_pi && (codec_common::audio_lm_talker_has_projection(audio_lm_ctx) ||
+                       pi.cb0_from_backbone || pi.streaming_interleave);
+}
+
+std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* main_ctx, const std::vector<llama_token> &tokens, int n_threads) {
+    if (codec_ctx == nullptr || codec_model == nullptr) {
+        LOG_ERROR("Codec context is not initialized");
+        return std::vector<float>();
+    }
+
+    tts_type tts_type = getTTSType(main_ctx);
+    const tts_model_profile &profile = profile_for_type(tts_type);
+    if (profile.decode_kind == tts_decode_kind::HIDDEN_STATES) {
+        if (main_ctx->completion == nullptr) {
+            LOG_ERROR("Completion context is not initialized");
+            return std::vector<float>();
+        }
+        return decodeAudioEmbeddings(main_ctx, main_ctx->completion->embeddings, main_ctx->completion->embedding_dim, n_threads);
+    }
+    if (profile.decode_kind == tts_decode_kind::UNSUPPORTED) {
+        // Chatterbox T3 with audio_lm path active decodes via audio_lm_decode_audio.
+        // Codes were accumulated into audio_tokens by the legacy codec_lm_state_*
+        // step path (Chatterbox doesn't hit the audio_lm Phase B fork today), so
+        // push them into the audio_lm accumulator first — decode_audio applies
+        // the codec's expected shape unshift internally.
+        if (audio_lm_ctx != nullptr) {
+            if (!tokens.empty()) {
+                const int32_t n_q = 1;  // Chatterbox S3G is single-codebook
+                const int32_t n_frames = (int32_t) tokens.size() / n_q;
+                std::vector<int32_t> flat(tokens.begin(), tokens.end());
+                if (!codec_common::audio_lm_push_codes(audio_lm_ctx, flat.data(),
+                                                       n_frames, n_q)) {
+                    LOG_ERROR("decodeAudioTokens: audio_lm_push_codes failed: %s",
+                              codec_common::audio_lm_last_error(audio_lm_ctx));
+                    return {};
+                }
+            }
+            codec_common::audio_lm_audio_output pcm_out;
+            if (!codec_common::audio_lm_decode_audio(audio_lm_ctx, &pcm_out)) {
+                LOG_ERROR("decodeAudioTokens: audio_lm_decode_audio failed: %s",
+                          codec_common::audio_lm_last_error(audio_lm_ctx));
+                return {};
+            }
+            return pcm_out.pcm;
+        }
+        LOG_ERROR("This TTS model's codec is not supported by codec.cpp yet");
+        return std::vector<float>();
+    }
+
+    // For codec_lm-AR models that used the audio_lm_ctx path (Qwen3-TTS /
+    // MOSS-TTSD / MOSS-TTS-Realtime), audio_lm_decode_audio reads the
+    // internal accumulator filled by audio_lm_observe_codes, applies the
+    // correct delay-pattern unshift and cb0_speech_offset remapping, and
+    // calls codec_decode.  This is the codec_common-canonical decode path
+    // and avoids the duplicate logic below.
+    if (profile.decode_kind == tts_decode_kind::CODEC_LM_AR && audio_lm_ctx != nullptr) {
+        // Check that we actually used the audio_lm step machine (not the
+        // legacy codec_lm_state path): the audio_lm accumulator has codes
+        // iff observe_codes was called at least once.
+        codec_common::audio_lm_prompt_info pi{};
+        const bool have_pi = codec_common::audio_lm_get_prompt_info(audio_lm_ctx, &pi);
+        const bool used_alm_path = have_pi && (
+            codec_common::audio_lm_talker_has_projection(audio_lm_ctx) ||
+            pi.cb0_from_backbone ||
+            pi.streaming_interleave);
+        if (used_alm_path) {
+            codec_common::audio_lm_audio_output pcm_out;
+            if (!codec_common::audio_lm_decode_audio(audio_lm_ctx, &pcm_out)) {
+                LOG_ERROR("decodeAudioTokens: audio_lm_decode_audio failed: %s",
+                          codec_common::audio_lm_last_error(audio_lm_ctx));
+                return {};
+            }
+            if (!pcm_out.pcm.empty()) return pcm_out.pcm;
+            // Empty PCM from audio_lm_decode_audio — fall through to direct path
+            // (may happen if the accumulator is empty due to EOS on frame 0).
+            LOG_WARNING("decodeAudioTokens: audio_lm_decode_audio returned empty PCM; falling back to direct path");
+        }
+    }
+
+    if (n_threads <= 0) {
+        n_threads = main_ctx->params.cpuparams.n_threads;
+    }
+    return decode_codes_on(codec_ctx, codec_model, codec_lm, profile, tokens, n_threads);
+}
+
+// Direct codec decode of completion codes on `cctx` — everything in
+// decodeAudioTokens past the audio_lm paths.  Reads no generation state,
+// so synthesizeLongForm runs it on its decode worker.
+static std::vector<float> decode_codes_on(
+    ::codec_context * cctx, ::codec_model * codec_model, ::codec_lm * codec_lm,
+    const tts_model_profile & profile, const std::vector<llama_token> & tokens, int n_threads) {
+    std::vector<int32_t> codec_tokens;
+    int32_t n_frames_aligned = 0;
+    int32_t n_q = 0;
+    if (!prepare_codec_tokens(profile, codec_model, codec_lm, tokens, codec_tokens, n_frames_aligned, n_q)) {
+        return std::vector<float>();
+    }
+    struct codec_token_buffer token_buffer = {};
+    token_buffer.data = codec_tokens.data();
+    token_buffer.n_tokens = (int32_t)codec_tokens.size();
+    token_buffer.n_frames = n_frames_aligned;
     token_buffer.n_q = n_q;
     token_buffer.codebook_size = codec_model_codebook_size(codec_model);
     token_buffer.sample_rate = codec_model_sample_rate(codec_model);
     token_buffer.hop_size = codec_model_hop_size(codec_model);
 
     struct codec_decode_params decode_params = codec_decode_default_params();
-    if (main_ctx->params.cpuparams.n_threads > 0) {
-        decode_params.n_threads = main_ctx->params.cpuparams.n_threads;
+    if (n_threads > 0) {
+        decode_params.n_threads = n_threads;
     }
     decode_params.n_q = n_q;
 
     struct codec_pcm_buffer pcm = {};
-    const enum codec_status status = codec_decode(codec_ctx, &token_buffer, &pcm, decode_params);
+    const enum codec_status status = codec_decode(cctx, &token_buffer, &pcm, decode_params);
     if (status != CODEC_STATUS_SUCCESS) {
-        const char *err = codec_get_last_error(codec_ctx);
+        const char *err = codec_get_last_error(cctx);
         LOG_ERROR("codec_decode() failed: %s", err != nullptr ? err : "unknown error");
         return std::vector<float>();
     }
@@ -3311,19 +4014,108 @@ std::vector<float> llama_rn_context_tts::decodeAudioTokens(llama_rn_context* mai
     return audio;
 }
 
-std::vector<float> llama_rn_context_tts::decodeAudioEmbeddings(llama_rn_context* main_ctx, const std::vector<float> &embeddings, int embedding_dim) {
+std::vector<std::vector<float>> llama_rn_context_tts::decodeAudioTokensBatch(llama_rn_context* main_ctx, const std::vector<std::vector<llama_token>> &tokens) {
+    std::vector<std::vector<float>> audio(tokens.size());
+    if (tokens.empty()) {
+        return audio;
+    }
+    if (codec_ctx == nullptr || codec_model == nullptr) {
+        LOG_ERROR("Codec context is not initialized");
+        return audio;
+    }
+
+    // Only flows that hand raw codes to codec_decode can share a batch;
+    // hidden-state vocoders and audio_lm accumulators decode one by one.
+    const tts_model_profile &profile = profile_for_type(getTTSType(main_ctx));
+    const bool direct = profile.decode_kind != tts_decode_kind::HIDDEN_STATES &&
+                        profile.decode_kind != tts_decode_kind::UNSUPPORTED &&
+                        !decodesViaAudioLm(main_ctx);
+    if (!direct) {
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            audio[i] = decodeAudioTokens(main_ctx, tokens[i]);
+        }
+        return audio;
+    }
+
+    std::vector<std::vector<int32_t>> seq_codes(tokens.size());
+    std::vector<int32_t> seq_frames(tokens.size(), 0);
+    std::vector<int32_t> seq_n_q(tokens.size(), 0);
+    int32_t codes_total = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (prepare_codec_tokens(profile, codec_model, codec_lm, tokens[i],
+                                 seq_codes[i], seq_frames[i], seq_n_q[i])) {
+            codes_total += (int32_t) seq_codes[i].size();
+        } else {
+            seq_frames[i] = 0;
+        }
+    }
+    if (codes_total == 0) {
+        return audio;
+    }
+
+    const int32_t n_seq = (int32_t) tokens.size();
+    struct codec_batch batch = codec_batch_init_codes(n_seq, codes_total, n_seq);
+    std::vector<int32_t> batch_index(tokens.size(), -1);
+    int32_t n_added = 0;
+    for (int32_t i = 0; i < n_seq; ++i) {
+        if (seq_frames[(size_t) i] <= 0) {
+            continue;
+        }
+        if (codec_batch_add_seq_codes(&batch, i, seq_frames[(size_t) i], seq_n_q[(size_t) i],
+                                      seq_codes[(size_t) i].data()) < 0) {
+            LOG_ERROR("decodeAudioTokensBatch: codec_batch_add_seq_codes failed for seq %d", i);
+            continue;
+        }
+        batch_index[(size_t) i] = n_added++;
+    }
+
+    struct codec_decode_params decode_params = codec_decode_default_params();
+    if (main_ctx->params.cpuparams.n_threads > 0) {
+        decode_params.n_threads = main_ctx->params.cpuparams.n_threads;
+    }
+    decode_params.n_q = seq_n_q.empty() ? 0 : *std::max_element(seq_n_q.begin(), seq_n_q.end());
+
+    std::vector<struct codec_pcm_buffer> pcm((size_t) std::max(n_added, 1));
+    const enum codec_status status = codec_decode_batch(codec_ctx, &batch, pcm.data(), decode_params);
+    codec_batch_free(batch);
+    if (status != CODEC_STATUS_SUCCESS) {
+        const char *err = codec_get_last_error(codec_ctx);
+        LOG_ERROR("codec_decode_batch() failed: %s", err != nullptr ? err : "unknown error");
+        return audio;
+    }
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const int32_t b = batch_index[i];
+        if (b < 0) {
+            continue;
+        }
+        audio[i].assign(pcm[(size_t) b].data, pcm[(size_t) b].data + pcm[(size_t) b].n_samples);
+        codec_pcm_buffer_free(&pcm[(size_t) b]);
+    }
+    return audio;
+}
+
+std::vector<float> llama_rn_context_tts::decodeAudioEmbeddings(llama_rn_context* main_ctx, const std::vector<float> &embeddings, int embedding_dim, int n_threads) {
     if (codec_ctx == nullptr || codec_model == nullptr) {
         LOG_ERROR("Codec context is not initialized");
         return std::vector<float>();
     }
+    if (n_threads <= 0) {
+        n_threads = main_ctx->params.cpuparams.n_threads;
+    }
+    return decode_latents_on(codec_ctx, embeddings, embedding_dim, n_threads);
+}
+
+// Latent decode on `cctx`; see decode_codes_on.
+static std::vector<float> decode_latents_on(
+    ::codec_context * cctx, const std::vector<float> & embeddings, int embedding_dim, int n_threads) {
     if (embeddings.empty() || embedding_dim <= 0 || embeddings.size() % (size_t) embedding_dim != 0) {
         LOG_ERROR("Invalid audio embedding shape: %zu values, dim=%d", embeddings.size(), embedding_dim);
         return std::vector<float>();
     }
 
     struct codec_decode_params decode_params = codec_decode_default_params();
-    if (main_ctx->params.cpuparams.n_threads > 0) {
-        decode_params.n_threads = main_ctx->params.cpuparams.n_threads;
+    if (n_threads > 0) {
+        decode_params.n_threads = n_threads;
     }
 
     struct codec_pcm_buffer pcm = {};
@@ -3341,14 +4133,14 @@ std::vector<float> llama_rn_context_tts::decodeAudioEmbeddings(llama_rn_context*
         }
     }
     const enum codec_status status = codec_decode_quantized_representation(
-        codec_ctx,
+        cctx,
         chan_major.data(),
         embedding_dim,
         n_frames,
         &pcm,
         decode_params);
     if (status != CODEC_STATUS_SUCCESS) {
-        const char *err = codec_get_last_error(codec_ctx);
+        const char *err = codec_get_last_error(cctx);
         LOG_ERROR("codec_decode_quantized_representation() failed: %s", err != nullptr ? err : "unknown error");
         return std::vector<float>();
     }
@@ -3444,6 +4236,282 @@ static uint64_t fnv1a_pcm(const std::vector<float> & pcm) {
     return h;
 }
 
+// ── Speaker files ────────────────────────────────────────────────────────────
+// A baked speaker persisted to disk so a voice loads without re-running the
+// speaker encoder.  Layout (little-endian, as written by the host):
+//
+//   rn_speaker_file_header
+//   ref_text bytes                      (ref_text_len)
+//   pad to 32 bytes
+//   emb   f32[rows * hidden_dim]        at emb_offset
+//   pcm   f32[n_pcm]                    at pcm_offset (only with FLAG_PCM)
+//
+// The embedding block is aligned so the file can be mapped and used in
+// place.  `model_key` fingerprints the speaker encoder + backbone the
+// embedding was produced for; files from another model are rejected.
+#define RN_SPEAKER_FILE_MAGIC   0x4b505352u // "RSPK"
+#define RN_SPEAKER_FILE_VERSION 1
+
+struct rn_speaker_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t model_key;
+    uint64_t audio_hash;
+    int32_t  rows;
+    int32_t  hidden_dim;
+    int32_t  sample_rate;
+    float    emotion;
+    uint32_t flags;
+    uint32_t ref_text_len;
+    uint64_t n_pcm;
+    uint64_t emb_offset;
+    uint64_t pcm_offset;
+};
+
+enum : uint32_t {
+    RN_SPEAKER_FILE_FLAG_EMOTION = 1u << 0,
+    RN_SPEAKER_FILE_FLAG_PCM     = 1u << 1,
+};
+
+static uint64_t fnv1a_bytes(uint64_t h, const void * data, size_t n) {
+    const uint8_t * p = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (uint64_t) p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Content fingerprint of a model file: its size plus 16 blocks of 64 KiB
+// spread evenly over it.  Every block past the GGUF header lands in tensor
+// data, so two fine-tunes of one architecture hash differently while a
+// copy of the same file under another path or on another device does not.
+// 0 when the file cannot be read.
+static uint64_t fingerprint_model_file(const std::string & path) {
+    FILE * f = path.empty() ? nullptr : std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return 0;
+    }
+    rn_speaker_fseek(f, 0, SEEK_END);
+    const int64_t size = (int64_t) rn_speaker_ftell(f);
+    uint64_t h = fnv1a_bytes(14695981039346656037ULL, &size, sizeof(size));
+    constexpr int     n_blocks   = 16;
+    constexpr int64_t block_size = 64 * 1024;
+    std::vector<uint8_t> buf((size_t) block_size);
+    for (int i = 0; i < n_blocks && size > 0; ++i) {
+        const int64_t off = std::max<int64_t>(0, size - block_size) * i / (n_blocks - 1);
+        const size_t n = rn_speaker_fseek(f, off, SEEK_SET) == 0 ? std::fread(buf.data(), 1, buf.size(), f) : 0;
+        h = fnv1a_bytes(h, buf.data(), n);
+    }
+    std::fclose(f);
+    return h;
+}
+
+bool write_speaker_file(const std::string & path, const rn_speaker & spk,
+                        uint64_t model_key, bool include_pcm) {
+    const bool with_pcm = include_pcm && !spk.pcm.empty();
+    const size_t n_emb  = (size_t) spk.rows * (size_t) spk.hidden_dim;
+
+    rn_speaker_file_header hdr = {};
+    hdr.magic        = RN_SPEAKER_FILE_MAGIC;
+    hdr.version      = RN_SPEAKER_FILE_VERSION;
+    hdr.model_key    = model_key;
+    hdr.audio_hash   = spk.audio_hash;
+    hdr.rows         = spk.rows;
+    hdr.hidden_dim   = spk.hidden_dim;
+    hdr.sample_rate  = spk.sample_rate;
+    hdr.emotion      = spk.emotion;
+    hdr.flags        = (spk.has_emotion ? RN_SPEAKER_FILE_FLAG_EMOTION : 0u) |
+                       (with_pcm ? RN_SPEAKER_FILE_FLAG_PCM : 0u);
+    hdr.ref_text_len = (uint32_t) spk.ref_text.size();
+    hdr.n_pcm        = with_pcm ? (uint64_t) spk.pcm.size() : 0;
+    hdr.emb_offset   = ((uint64_t) sizeof(hdr) + hdr.ref_text_len + 31) & ~(uint64_t) 31;
+    hdr.pcm_offset   = with_pcm ? hdr.emb_offset + n_emb * sizeof(float) : 0;
+
+    // Write next to the target and rename, so a reader never sees a
+    // half-written file under the final name.
+    const std::string tmp = path + ".tmp";
+    FILE * f = std::fopen(tmp.c_str(), "wb");
+    if (f == nullptr) {
+        LOG_ERROR("saveSpeaker: cannot open %s for writing", tmp.c_str());
+        return false;
+    }
+    static const char zeros[32] = {};
+    const size_t pad = (size_t) hdr.emb_offset - sizeof(hdr) - hdr.ref_text_len;
+    bool ok = std::fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              std::fwrite(spk.ref_text.data(), 1, hdr.ref_text_len, f) == hdr.ref_text_len &&
+              std::fwrite(zeros, 1, pad, f) == pad &&
+              std::fwrite(spk.emb.data(), sizeof(float), n_emb, f) == n_emb;
+    if (ok && with_pcm) {
+        ok = std::fwrite(spk.pcm.data(), sizeof(float), spk.pcm.size(), f) == spk.pcm.size();
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOG_ERROR("saveSpeaker: failed to write %s", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Reads a speaker file written for `model_key` into `out` (baked).
+// Returns false, logging why, for a missing, foreign or damaged file.
+bool read_speaker_file(const std::string & path, uint64_t model_key, rn_speaker & out) {
+    FILE * f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    rn_speaker_fseek(f, 0, SEEK_END);
+    const int64_t end = (int64_t) rn_speaker_ftell(f);
+    rn_speaker_fseek(f, 0, SEEK_SET);
+    const uint64_t file_size = end > 0 ? (uint64_t) end : 0;
+
+    rn_speaker_file_header hdr = {};
+    bool ok = file_size >= sizeof(hdr) && std::fread(&hdr, sizeof(hdr), 1, f) == 1;
+    if (!ok || hdr.magic != RN_SPEAKER_FILE_MAGIC || hdr.version != RN_SPEAKER_FILE_VERSION) {
+        LOG_ERROR("loadSpeaker: %s is not a speaker file (or an unsupported version)", path.c_str());
+        std::fclose(f);
+        return false;
+    }
+    if (hdr.model_key != model_key) {
+        LOG_ERROR("loadSpeaker: %s was baked for a different model", path.c_str());
+        std::fclose(f);
+        return false;
+    }
+    // Offsets and counts come from the file, so compare each block against
+    // the bytes left after its offset rather than summing (which can wrap).
+    const uint64_t n_emb = (uint64_t) std::max(hdr.rows, 0) * (uint64_t) std::max(hdr.hidden_dim, 0);
+    const bool has_pcm = (hdr.flags & RN_SPEAKER_FILE_FLAG_PCM) != 0;
+    auto fits = [file_size](uint64_t offset, uint64_t n_floats) {
+        return offset <= file_size && n_floats <= (file_size - offset) / sizeof(float);
+    };
+    if (n_emb == 0 || hdr.emb_offset < sizeof(hdr) + hdr.ref_text_len ||
+        !fits(hdr.emb_offset, n_emb) || (has_pcm && !fits(hdr.pcm_offset, hdr.n_pcm))) {
+        LOG_ERROR("loadSpeaker: %s is truncated or corrupted", path.c_str());
+        std::fclose(f);
+        return false;
+    }
+
+    rn_speaker spk;
+    spk.ref_text.resize(hdr.ref_text_len);
+    spk.emb.resize((size_t) n_emb);
+    ok = std::fread(&spk.ref_text[0], 1, hdr.ref_text_len, f) == hdr.ref_text_len &&
+         rn_speaker_fseek(f, (int64_t) hdr.emb_offset, SEEK_SET) == 0 &&
+         std::fread(spk.emb.data(), sizeof(float), (size_t) n_emb, f) == (size_t) n_emb;
+    if (ok && has_pcm) {
+        spk.pcm.resize((size_t) hdr.n_pcm);
+        ok = rn_speaker_fseek(f, (int64_t) hdr.pcm_offset, SEEK_SET) == 0 &&
+             std::fread(spk.pcm.data(), sizeof(float), spk.pcm.size(), f) == spk.pcm.size();
+    }
+    std::fclose(f);
+    if (!ok) {
+        LOG_ERROR("loadSpeaker: failed to read %s", path.c_str());
+        return false;
+    }
+
+    spk.sample_rate = hdr.sample_rate;
+    spk.emotion     = hdr.emotion;
+    spk.has_emotion = (hdr.flags & RN_SPEAKER_FILE_FLAG_EMOTION) != 0;
+    spk.audio_hash  = hdr.audio_hash;
+    spk.rows        = hdr.rows;
+    spk.hidden_dim  = hdr.hidden_dim;
+    spk.baked       = true;
+    out = std::move(spk);
+    return true;
+}
+
+// Fingerprint of everything a baked embedding depends on: the codec_lm's
+// speaker section and host arch, the contents of the codec file, and the
+// backbone it is injected into (its file contents when it was loaded from
+// a path).  0 when the codec has no speaker encoder (nothing to persist).
+uint64_t llama_rn_context_tts::speakerModelKey(llama_rn_context * main_ctx) {
+    if (codec_lm == nullptr && !codec_lm_probed && codec_model != nullptr) {
+        codec_lm_probed = true;
+        codec_lm = ::codec_lm_create(codec_model);
+    }
+    const ::codec_lm_speaker_info * sp_info =
+        codec_lm != nullptr ? ::codec_lm_speaker_get_info(codec_lm) : nullptr;
+    if (sp_info == nullptr) {
+        return 0;
+    }
+    const ::codec_lm_info * info = ::codec_lm_get_info(codec_lm);
+
+    uint64_t h = 14695981039346656037ULL;
+    const int32_t dims[] = {
+        sp_info->n_rows, sp_info->hidden_dim,
+        info != nullptr ? info->n_codebook : 0,
+        info != nullptr ? info->hidden_dim : 0,
+        codec_model_sample_rate(codec_model),
+    };
+    h = fnv1a_bytes(h, dims, sizeof(dims));
+    if (info != nullptr && info->host_arch != nullptr) {
+        h = fnv1a_bytes(h, info->host_arch, std::strlen(info->host_arch));
+    }
+    if (codec_file_hash == 0) {
+        codec_file_hash = fingerprint_model_file(codec_path);
+    }
+    h = fnv1a_bytes(h, &codec_file_hash, sizeof(codec_file_hash));
+    if (main_ctx != nullptr && main_ctx->model != nullptr) {
+        char desc[256] = {};
+        llama_model_desc(main_ctx->model, desc, sizeof(desc));
+        const uint64_t n_params = llama_model_n_params(main_ctx->model);
+        h = fnv1a_bytes(h, desc, std::strlen(desc));
+        h = fnv1a_bytes(h, &n_params, sizeof(n_params));
+        if (backbone_file_model != main_ctx->model) {
+            backbone_file_model = main_ctx->model;
+            backbone_file_hash  = fingerprint_model_file(main_ctx->params.model.path);
+        }
+        h = fnv1a_bytes(h, &backbone_file_hash, sizeof(backbone_file_hash));
+    }
+    return h;
+}
+
+bool llama_rn_context_tts::saveSpeaker(llama_rn_context * main_ctx, int id,
+                                       const std::string & path, bool include_pcm) {
+    const rn_speaker * spk = autoBakeSpeaker(main_ctx, id);
+    if (spk == nullptr) {
+        LOG_ERROR("saveSpeaker: speaker id=%d not found or could not be baked", id);
+        return false;
+    }
+    const uint64_t model_key = speakerModelKey(main_ctx);
+    if (model_key == 0) {
+        LOG_ERROR("saveSpeaker: this model has no speaker encoder");
+        return false;
+    }
+    return write_speaker_file(path, *spk, model_key, include_pcm);
+}
+
+int llama_rn_context_tts::loadSpeaker(llama_rn_context * main_ctx, const std::string & path) {
+    rn_speaker spk;
+    if (!read_speaker_file(path, speakerModelKey(main_ctx), spk)) {
+        return -1;
+    }
+    const int id = next_speaker_id++;
+    speakers[id] = std::move(spk);
+    return id;
+}
+
+// Cache file for a speaker under `speaker_cache_dir`: one file per
+// (model, reference audio, emotion), so a re-created voice skips the bake.
+std::string llama_rn_context_tts::speakerCachePath(llama_rn_context * main_ctx, const rn_speaker & spk) {
+    if (speaker_cache_dir.empty()) {
+        return std::string();
+    }
+    const uint64_t model_key = speakerModelKey(main_ctx);
+    if (model_key == 0) {
+        return std::string();
+    }
+    uint64_t key = fnv1a_bytes(spk.audio_hash, &spk.sample_rate, sizeof(spk.sample_rate));
+    if (spk.has_emotion) {
+        key = fnv1a_bytes(key, &spk.emotion, sizeof(spk.emotion));
+    }
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%016llx.rnspk",
+                  (unsigned long long) model_key, (unsigned long long) key);
+    const char sep = speaker_cache_dir.back() == '/' ? '\0' : '/';
+    return sep ? speaker_cache_dir + sep + name : speaker_cache_dir + name;
+}
+
 // ── Per-context speaker registry ─────────────────────────────────────────────
 
 int llama_rn_context_tts::createSpeaker(
@@ -3478,6 +4546,25 @@ bool llama_rn_context_tts::bakeSpeaker(llama_rn_context * main_ctx, int id) {
     }
     rn_speaker & spk = it->second;
 
+    // Loaded from a file without its reference audio: the stored embedding
+    // is all there is, and re-encoding would wipe it.
+    if (spk.baked && spk.pcm.empty()) {
+        return true;
+    }
+
+    const std::string cache_path = speakerCachePath(main_ctx, spk);
+    if (!cache_path.empty()) {
+        rn_speaker cached;
+        if (read_speaker_file(cache_path, speakerModelKey(main_ctx), cached) &&
+            cached.audio_hash == spk.audio_hash) {
+            spk.emb        = std::move(cached.emb);
+            spk.rows       = cached.rows;
+            spk.hidden_dim = cached.hidden_dim;
+            spk.baked      = true;
+            return true;
+        }
+    }
+
     // For models that need pre-encoded codec tokens, run codec_encode first.
     std::vector<int32_t> ref_codes;
     if (codec_ctx != nullptr && !spk.pcm.empty() && spk.sample_rate > 0) {
@@ -3501,7 +4588,11 @@ bool llama_rn_context_tts::bakeSpeaker(llama_rn_context * main_ctx, int id) {
         codec_token_buffer_free(&tokens);
     }
 
-    return encodeInto(main_ctx, spk, ref_codes);
+    const bool ok = encodeInto(main_ctx, spk, ref_codes);
+    if (ok && !cache_path.empty()) {
+        write_speaker_file(cache_path, spk, speakerModelKey(main_ctx), false);
+    }
+    return ok;
 }
 
 const rn_speaker * llama_rn_context_tts::getSpeaker(int id) const {
@@ -93,11 +93,47 @@ struct llama_rn_audio_codes_result {
     bool aborted = false;
 };
 
+// Options for synthesizeLongForm.  `text` is split at sentence boundaries
+// and packed into segments of at most `max_segment_chars` bytes; callers
+// that pre-process each segment themselves (e.g. phonemization) pass
+// `segments` instead.  The speaker and sampling settings apply to every
+// segment.
+struct llama_rn_long_form_tts_options {
+    std::string text;
+    std::vector<std::string> segments;
+    std::string speaker_json;
+    int   speaker_id = -1;
+    int   max_segment_chars = 300;  // 0 = one sentence per segment
+    int   n_predict = -1;         // per segment; <= 0 keeps params.n_predict
+    float temperature = 0.9f;
+    float top_p = 0.95f;
+    int   top_k = 50;
+    uint32_t seed = 0;
+    int   decode_threads = 0;     // codec threads; 0 = half the context's
+};
+
+// Receives each segment's PCM (mono, codec sample rate) in segment order.
+// Return false to stop after this chunk.
+using llama_rn_audio_chunk_cb =
+    std::function<bool(int segment, const std::vector<float> &pcm)>;
+
+// Split `text` into sentences and pack them into segments of at most
+// `max_chars` bytes (0 = one sentence per segment).  Used by
+// synthesizeLongForm when the caller does not pass its own segments.
+std::vector<std::string> split_tts_segments(const std::string & text, size_t max_chars);
+
+struct llama_rn_long_form_tts_result {
+    int n_segments = 0;
+    int64_t n_samples = 0;
+    int sample_rate = 0;
+    bool aborted = false;
+};
+
 // Native-backed speaker handle.  Stored in per-context registry; the JS
 // side holds only a numeric id.  `baked` is false until bakeSpeaker runs
 // the codec_lm_speaker_encode path and fills emb/rows/hidden_dim.
-// `audio_hash` is a cheap 64-bit FNV-1a hash of the raw PCM samples used
-// for future cache-reuse (Task 5).
+// `audio_hash` is a cheap 64-bit FNV-1a hash of the raw PCM samples; it
+// keys the on-disk speaker cache (see saveSpeaker / speaker_cache_dir).
 struct rn_speaker {
     // Raw PCM + metadata (kept until baked so re-bake is cheap)
     std::vector<float> pcm;
@@ -112,10 +148,17 @@ struct rn_speaker {
     int hidden_dim       = 0;
     bool baked           = false;
 
-    // Cache key: 64-bit FNV-1a hash of the PCM buffer
+    // Cache key: 64-bit FNV-1a hash of the PCM buffer (kept when the
+    // speaker is loaded from a file, even if the PCM itself is not)
     uint64_t audio_hash  = 0;
 };
 
+// Speaker file I/O behind saveSpeaker / loadSpeaker and the speaker cache.
+// read_speaker_file rejects (and logs) a file baked for another model_key
+// or whose offsets do not fit inside it.
+bool write_speaker_file(const std::string & path, const rn_speaker & spk, uint64_t model_key, bool include_pcm);
+bool read_speaker_file(const std::string & path, uint64_t model_key, rn_speaker & out);
+
 // Single source of truth for everything the JS layer needs to drive a TTS
 // session — populated from the native profile so JS doesn't keep its own
 // parallel mapping. Voice resolution lives entirely on the JS side: the
@@ -149,6 +192,9 @@ struct llama_rn_context_tts {
     // Codec runtime handles
     ::codec_model *codec_model = nullptr;
     ::codec_context *codec_ctx = nullptr;
+    // Second context on codec_model with its own backend, created by the
+    // first synthesizeLongForm so its decodes can overlap generation.
+    ::codec_context *codec_decode_ctx = nullptr;
     // codec_lm adaptor (created lazily on first codec_lm-AR call, freed by
     // dtor).  Stays NULL when the loaded codec.gguf has no `lm.*` section,
     // in which case the model is treated as a plain codec.
@@ -232,6 +278,15 @@ struct llama_rn_context_tts {
     // Keyed by monotonically-increasing integer id.  Freed with the context.
     std::unordered_map<int, rn_speaker> speakers;
     int next_speaker_id = 1;
+    // When set, bakeSpeaker looks for `<dir>/<model>-<audio>.rnspk` before
+    // running the speaker encoder and writes one after a successful bake.
+    std::string speaker_cache_dir;
+    // Path the codec was loaded from, and the file fingerprints
+    // speakerModelKey folds in (computed on first use).
+    std::string codec_path;
+    uint64_t codec_file_hash = 0;
+    const llama_model * backbone_file_model = nullptr;
+    uint64_t backbone_file_hash = 0;
 
     // Speaker id threaded from completion params / getFormattedAudioCompletion.
     // -1 means "no speaker override".  Set by parseCompletionParams (via JSI)
@@ -333,7 +388,7 @@ struct llama_rn_context_tts {
     // to whatever backend codec.cpp's `ggml_backend_init_best` picks.
     // Defaults match the loaded backbone's GPU offload state where
     // possible; the caller (JS) can override.
-    llama_rn_context_tts(const std::string &vocoder_model_path, int batch_size = -1, bool use_gpu = false);
+    llama_rn_context_tts(const std::string &vocoder_model_path, int batch_size = -1, bool use_gpu = false, lm_ggml_backend_arena_t compute_arena = nullptr);
     ~llama_rn_context_tts();
 
     // TTS utility methods
@@ -359,6 +414,18 @@ struct llama_rn_context_tts {
     // should skip this and use `completion` + `decodeAudioTokens`
     // directly.  Returns result.codes.empty() on failure (check logs).
     llama_rn_audio_codes_result generateAudioCodes(llama_rn_context* main_ctx, const llama_rn_audio_codes_options &opts, const llama_rn_audio_codes_progress_cb &on_frame = nullptr);
+    // Multi-utterance variant: runs up to llama_n_seq_max utterances as
+    // parallel backbone sequences and steps their codec_lm heads in one
+    // batched graph per codebook (codec_lm_step_*_batch).  One result per
+    // entry of `opts`, in order.  Flows the batched driver does not cover
+    // (audio_lm-driven talker / cb0-from-backbone / realtime, text-
+    // modality cb0, Chatterbox) fall back to sequential generateAudioCodes.
+    std::vector<llama_rn_audio_codes_result> generateAudioCodesBatch(llama_rn_context* main_ctx, const std::vector<llama_rn_audio_codes_options> &opts);
+    // Long-form synthesis: splits the text at sentence boundaries and runs
+    // one completion per segment, decoding segment k on a worker thread
+    // while segment k+1 generates.  PCM chunks reach `on_chunk` in order;
+    // returning false from it stops the run.
+    llama_rn_long_form_tts_result synthesizeLongForm(llama_rn_context* main_ctx, const llama_rn_long_form_tts_options &opts, const llama_rn_audio_chunk_cb &on_chunk);
 
     // True when the loaded codec.gguf's codec_lm reports
     // `is_continuous = true` (BlueMagpie-TTS / VoxCPM continuous-latent
@@ -485,8 +552,29 @@ struct llama_rn_context_tts {
 
     // Remove a speaker from the registry (no-op if id unknown).
     void releaseSpeaker(int id);
-    std::vector<float> decodeAudioTokens(llama_rn_context* main_ctx, const std::vector<llama_token> &tokens);
-    std::vector<float> decodeAudioEmbeddings(llama_rn_context* main_ctx, const std::vector<float> &embeddings, int embedding_dim);
+
+    // Speaker files: a baked embedding (plus, optionally, the reference PCM
+    // that Chatterbox's prefill still needs) in a versioned binary format
+    // keyed by speakerModelKey.  saveSpeaker bakes first if needed;
+    // loadSpeaker registers the file as a new, already-baked speaker and
+    // returns its id, or -1 if the file is missing, damaged or was baked
+    // for another model.
+    uint64_t speakerModelKey(llama_rn_context* main_ctx);
+    bool saveSpeaker(llama_rn_context* main_ctx, int id, const std::string & path, bool include_pcm);
+    int loadSpeaker(llama_rn_context* main_ctx, const std::string & path);
+    std::string speakerCachePath(llama_rn_context* main_ctx, const rn_speaker & spk);
+    // `n_threads` overrides the context's thread count for the codec graph
+    // (0 = use params.cpuparams.n_threads).
+    std::vector<float> decodeAudioTokens(llama_rn_context* main_ctx, const std::vector<llama_token> &tokens, int n_threads = 0);
+    // True when decodeAudioTokens reads the audio_lm accumulator (talker,
+    // cb0-from-backbone, realtime, Chatterbox) instead of the codes passed
+    // in — such decodes must finish before the next generation resets it.
+    bool decodesViaAudioLm(llama_rn_context* main_ctx);
+    // Decode several code sequences (e.g. generateAudioCodesBatch results)
+    // through one codec_decode_batch call.  Falls back to per-sequence
+    // decodeAudioTokens for models that do not decode raw codes directly.
+    std::vector<std::vector<float>> decodeAudioTokensBatch(llama_rn_context* main_ctx, const std::vector<std::vector<llama_token>> &tokens);
+    std::vector<float> decodeAudioEmbeddings(llama_rn_context* main_ctx, const std::vector<float> &embeddings, int embedding_dim, int n_threads = 0);
     int getAudioSampleRate() const;
     bool isAudioToken(llama_rn_context* main_ctx, llama_token token, const std::string &token_text = "");
     bool tryAddAudioToken(llama_rn_context* main_ctx, llama_token token, const std::string &token_text = "");
@@ -585,6 +585,10 @@ struct clip_image_u8 {
         buf = new_buf;
     }
 
+    void cpy_buf(std::vector<uint8_t> && new_buf) {
+        buf = std::move(new_buf);
+    }
+
     const std::vector<uint8_t> & get_ro_buf() const {
         if (is_placeholder()) {
             throw std::runtime_error("this clip_image_u8 is a placeholder");
@@ -670,6 +674,10 @@ struct clip_image_f32 {
         buf = new_buf;
     }
 
+    void cpy_buf(std::vector<float> && new_buf) {
+        buf = std::move(new_buf);
+    }
+
     void from_u8(const clip_image_u8 & img) {
         auto size = img.get_size();
         nx_ = size.width;
@@ -685,6 +693,33 @@ struct clip_image_f32 {
         }
     }
 
+    // same result as from_u8() followed by normalize(), in a single pass:
+    // every u8 value maps through a per-channel lookup table
+    void from_u8(const clip_image_u8 & img, const float mean[3], const float std[3]) {
+        auto size = img.get_size();
+        nx_ = size.width;
+        ny_ = size.height;
+        if (img.is_placeholder()) {
+            buf.clear();
+            return; // no-op
+        }
+        float lut[3][256];
+        for (int c = 0; c < 3; ++c) {
+            for (int v = 0; v < 256; ++v) {
+                lut[c][v] = ((float) v / 255.0f - mean[c]) / std[c];
+            }
+        }
+        buf.resize(img.n_elements());
+        const uint8_t * src = img.get_ro_buf().data();
+        float * dst = buf.data();
+        const size_t n = n_pixels();
+        for (size_t i = 0; i < n; ++i) {
+            dst[i * 3 + 0] = lut[0][src[i * 3 + 0]];
+            dst[i * 3 + 1] = lut[1][src[i * 3 + 1]];
+            dst[i * 3 + 2] = lut[2][src[i * 3 + 2]];
+        }
+    }
+
     size_t n_elements() const {
         return n_pixels() * 3;
     }
@@ -171,6 +171,9 @@ struct clip_ctx {
     lm_ggml_backend_t backend_cpu = nullptr;
     lm_ggml_backend_buffer_ptr buf;
 
+    // shared host compute arena replacing the CPU compute buffer (not owned)
+    lm_ggml_backend_arena_t compute_arena = nullptr;
+
 
     int max_nodes = 8192;
     lm_ggml_backend_sched_ptr sched;
@@ -227,8 +230,11 @@ struct clip_ctx {
             model.hparams.custom_image_max_tokens = ctx_params.image_max_tokens;
         }
 
+        compute_arena = ctx_params.compute_arena;
+
         backend_ptrs.push_back(backend_cpu);
-        backend_buft.push_back(lm_ggml_backend_get_default_buffer_type(backend_cpu));
+        backend_buft.push_back(compute_arena ? lm_ggml_backend_arena_buffer_type(compute_arena)
+                                             : lm_ggml_backend_get_default_buffer_type(backend_cpu));
 
         sched.reset(
             lm_ggml_backend_sched_new(backend_ptrs.data(), backend_buft.data(), backend_ptrs.size(), 8192, false, true)
@@ -4433,7 +4439,26 @@ static std::vector<c2w_state_slot> list_gen_state_slots(const clip_hparams & hpa
     }
 }
 
+// holds the compute arena lease (if any) for the duration of an encode; the graph is rebuilt
+// and re-allocated on every call, so nothing survives another arena user
+struct clip_arena_lease {
+    explicit clip_arena_lease(clip_ctx * ctx) : arena(ctx->compute_arena) {
+        if (arena) {
+            lm_ggml_backend_arena_acquire(arena, ctx);
+        }
+    }
+    ~clip_arena_lease() {
+        if (arena) {
+            lm_ggml_backend_arena_release(arena);
+        }
+    }
+
+    lm_ggml_backend_arena_t arena;
+};
+
 bool clip_encode(struct clip_ctx * ctx, struct clip_encode_params * params) {
+    clip_arena_lease lease(ctx);
+
     const clip_image_f32_batch & imgs = *params->imgs;
     int n_batch_cur = imgs.entries.size();
 
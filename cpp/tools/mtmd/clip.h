@@ -57,6 +57,7 @@ struct clip_context_params {
     bool no_alloc;
     mtmd_progress_callback progress_callback;
     void * progress_callback_user_data;
+    lm_ggml_backend_arena_t compute_arena; // optional shared host compute arena, see mtmd_context_params
 };
 
 struct clip_init_result {
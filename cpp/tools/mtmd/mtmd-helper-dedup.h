@@ -0,0 +1,67 @@
+#pragma once
+
+// near-duplicate video frame detection used by mtmd_helper_video (mtmd-helper.cpp)
+// NOT part of the public mtmd-helper.h API
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// see dedup_threshold / dedup_max_skip in mtmd_helper_video_init_params
+struct mtmd_helper_video_dedup {
+    static constexpr int GRID = 16;
+
+    float   threshold = 0.0f;
+    int32_t max_skip  = 0;
+    int32_t run       = 0;              // consecutive frames skipped since the last emitted one
+    std::vector<float> last_signature;  // signature of the last emitted frame, empty before the first
+
+    // average BT.601 luma over a GRID x GRID grid of cells of a packed RGB frame
+    static void compute_signature(const uint8_t * rgb, uint32_t w, uint32_t h, std::vector<float> & sig) {
+        std::vector<uint64_t> sum(GRID * GRID, 0);
+        std::vector<uint32_t> cnt(GRID * GRID, 0);
+        std::vector<uint32_t> col_cell(w);
+        for (uint32_t x = 0; x < w; x++) {
+            col_cell[x] = (uint32_t)((uint64_t)x * GRID / w);
+        }
+        for (uint32_t y = 0; y < h; y++) {
+            const uint8_t * row = rgb + (size_t)y * w * 3;
+            const uint32_t cy = (uint32_t)((uint64_t)y * GRID / h);
+            for (uint32_t x = 0; x < w; x++) {
+                const uint32_t cx = col_cell[x];
+                const uint8_t * p = row + (size_t)x * 3;
+                sum[cy * GRID + cx] += (77u * p[0] + 150u * p[1] + 29u * p[2]) >> 8;
+                cnt[cy * GRID + cx]++;
+            }
+        }
+        sig.resize(GRID * GRID);
+        for (size_t i = 0; i < sig.size(); i++) {
+            sig[i] = cnt[i] ? (float)sum[i] / (float)cnt[i] : 0.0f;
+        }
+    }
+
+    // true if the frame should be dropped; updates last_signature when it is kept
+    bool is_near_duplicate(const uint8_t * rgb, uint32_t w, uint32_t h) {
+        if (threshold <= 0.0f) {
+            return false;
+        }
+        std::vector<float> sig;
+        compute_signature(rgb, w, h, sig);
+        if (!last_signature.empty() && (max_skip <= 0 || run < max_skip)) {
+            float max_diff = 0.0f;
+            for (size_t i = 0; i < sig.size(); i++) {
+                max_diff = std::max(max_diff, std::fabs(sig[i] - last_signature[i]));
+            }
+            if (max_diff < threshold) {
+                run++;
+                return true;
+            }
+        }
+        run = 0;
+        last_signature = std::move(sig);
+        return false;
+    }
+};
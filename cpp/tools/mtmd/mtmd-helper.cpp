@@ -10,10 +10,12 @@
 #include "mtmd.h"
 #include "mtmd-helper.h"
 #include "mtmd-helper-common.h"
+#include "mtmd-helper-dedup.h"
 #include "llama.h"
 
 #include <algorithm>
 #include <cinttypes>
+#include <cmath>
 #include <vector>
 
 //#define MTMD_AUDIO_DEBUG
@@ -585,6 +587,9 @@ struct mtmd_helper_video {
     std::string pending_text; // text queued to be returned before the next frame
     bool        start_emitted = false;
 
+    // near-duplicate skipping, see mtmd_helper_video_init_params
+    mtmd_helper_video_dedup dedup;
+
     bool is_buf_input() const {
         return !input_buf.empty();
     }
@@ -745,22 +750,30 @@ struct mtmd_helper_video {
         LOG_DBG("%s: reading frame %d, expecting %zu bytes (%ux%u)\n",
                 __func__, current_frame, frame_size, info.width, info.height);
 
-        size_t total_read = 0;
-        while (total_read < frame_size) {
-            size_t n = fread(frame_buf.data() + total_read, 1, frame_size - total_read, fp);
-            if (n == 0) {
-                // clean EOF only if no bytes read yet; partial frame is an error
-                LOG_DBG("%s: fread returned 0 after %zu/%zu bytes (ferror=%d)\n",
-                        __func__, total_read, frame_size, ferror(fp));
-                sp.alive = false;
-                return nullptr;
+        while (true) {
+            size_t total_read = 0;
+            while (total_read < frame_size) {
+                size_t n = fread(frame_buf.data() + total_read, 1, frame_size - total_read, fp);
+                if (n == 0) {
+                    // clean EOF only if no bytes read yet; partial frame is an error
+                    LOG_DBG("%s: fread returned 0 after %zu/%zu bytes (ferror=%d)\n",
+                            __func__, total_read, frame_size, ferror(fp));
+                    sp.alive = false;
+                    return nullptr;
+                }
+                total_read += n;
             }
-            total_read += n;
-        }
 
-        LOG_DBG("%s: frame %d read OK\n", __func__, current_frame);
-        current_frame++;
-        return mtmd_bitmap_init(info.width, info.height, frame_buf.data());
+            LOG_DBG("%s: frame %d read OK\n", __func__, current_frame);
+            current_frame++;
+            if (dedup.is_near_duplicate(frame_buf.data(), info.width, info.height)) {
+                info.n_frames_skipped++;
+                LOG_DBG("%s: frame %d skipped as near-duplicate (%d in a row)\n",
+                        __func__, current_frame - 1, dedup.run);
+                continue;
+            }
+            return mtmd_bitmap_init(info.width, info.height, frame_buf.data());
+        }
     }
 
     int32_t read_next(mtmd_bitmap ** out_bitmap, char ** out_text) {
@@ -802,7 +815,10 @@ struct mtmd_helper_video {
                 float seconds   = elapsed_s - minutes * 60.0f;
                 snprintf(ts_buf, sizeof(ts_buf), "[%dm%.2fs]", minutes, seconds);
                 pending_text = ts_buf;
-                next_timestamp_ms += (float)timestamp_interval_ms;
+                // skipped frames can jump past several intervals at once
+                while (next_timestamp_ms <= elapsed_ms) {
+                    next_timestamp_ms += (float)timestamp_interval_ms;
+                }
             }
         }
 
@@ -828,6 +844,8 @@ mtmd_helper_video_init_params mtmd_helper_video_init_params_default() {
         /* fps_target             */ 4.0f,
         /* ffmpeg_bin_dir         */ nullptr,
         /* timestamp_interval_ms  */ 5000,
+        /* dedup_threshold        */ 0.0f,
+        /* dedup_max_skip         */ 0,
     };
 }
 
@@ -863,6 +881,8 @@ mtmd_helper_video * mtmd_helper_video_init(
     ctx->ffmpeg_bin           = video_resolve_bin(params.ffmpeg_bin_dir, "ffmpeg");
     ctx->ffprobe_bin          = video_resolve_bin(params.ffmpeg_bin_dir, "ffprobe");
     ctx->timestamp_interval_ms = params.timestamp_interval_ms;
+    ctx->dedup.threshold       = params.dedup_threshold;
+    ctx->dedup.max_skip        = params.dedup_max_skip;
 
     if (!ctx->probe(params.fps_target)) {
         LOG_ERR("%s: ffprobe failed for '%s' (is ffprobe in PATH?)\n", __func__, path);
@@ -898,6 +918,8 @@ mtmd_helper_video * mtmd_helper_video_init_from_buf(
     ctx->ffmpeg_bin            = video_resolve_bin(params.ffmpeg_bin_dir, "ffmpeg");
     ctx->ffprobe_bin           = video_resolve_bin(params.ffmpeg_bin_dir, "ffprobe");
     ctx->timestamp_interval_ms = params.timestamp_interval_ms;
+    ctx->dedup.threshold       = params.dedup_threshold;
+    ctx->dedup.max_skip        = params.dedup_max_skip;
 
     if (!ctx->probe(params.fps_target)) {
         LOG_ERR("%s: ffprobe failed on buffer (is ffprobe in PATH?)\n", __func__);
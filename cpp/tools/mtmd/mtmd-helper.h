@@ -121,12 +121,19 @@ struct mtmd_helper_video_info {
     uint32_t height;
     float    fps;      // effective fps (fps_target if set, else original video fps)
     int32_t  n_frames; // estimated total frames at effective fps (-1 if unknown)
+    int32_t  n_frames_skipped; // frames dropped so far as near-duplicates of the previous emitted frame
 };
 
 struct mtmd_helper_video_init_params {
     float fps_target;            // desired output fps; <= 0 means use the video's native fps, defaulted to 4.0f
     const char * ffmpeg_bin_dir; // directory containing ffmpeg/ffprobe binaries; NULL means search PATH
     int64_t timestamp_interval_ms; // interval for adding timestamp as text chunk (example: "[10m50.5s]"); <= 0 means no timestamp, defaulted to 5000ms
+    // near-duplicate frame skipping: each frame is reduced to a 16x16 grid of average luma values;
+    // a frame is dropped when no cell differs from the last emitted frame by dedup_threshold or more
+    // (0-255 scale). the dropped frame is never encoded, so it costs neither encoder time nor context.
+    // opt-in: a threshold around 3.0f suits static screen recordings, but it also drops slow pans and fades
+    float   dedup_threshold;       // <= 0 disables skipping, defaulted to 0 (disabled)
+    int32_t dedup_max_skip;        // emit a frame anyway after this many consecutive skips; <= 0 means no limit, defaulted to 0
     // TODO @ngxson : allow "placeholder" bitmap output for counting tokens
 };
 
@@ -2,21 +2,62 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <thread>
 #include <vector>
 
+// split [0, n) into contiguous ranges and run fn(begin, end) on each, one range per thread
+// the calling thread takes the first range; work below ~64K ops per thread stays single-threaded,
+// so small images and thumbnails never pay for thread creation
+template <typename F>
+static void parallel_for_range(int n, size_t cost_per_item, F && fn) {
+    constexpr size_t min_cost_per_thread = 1 << 16;
+    const size_t total_cost = (size_t) std::max(n, 0) * std::max<size_t>(cost_per_item, 1);
+    int n_threads = (int) std::min<size_t>(total_cost / min_cost_per_thread, (size_t) n);
+    n_threads = std::min(n_threads, (int) std::max(1u, std::thread::hardware_concurrency()));
+    if (n_threads <= 1) {
+        if (n > 0) {
+            fn(0, n);
+        }
+        return;
+    }
+
+    const int chunk = (n + n_threads - 1) / n_threads;
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+    for (int begin = chunk; begin < n; begin += chunk) {
+        workers.emplace_back([&fn, begin, end = std::min(begin + chunk, n)]() { fn(begin, end); });
+    }
+    fn(0, std::min(chunk, n));
+    for (auto & w : workers) {
+        w.join();
+    }
+}
+
 void mtmd_image_preproc_out::append(const clip_hparams & hparams, const clip_image_u8 & img, bool normalized) {
     clip_image_f32 dst;
-    dst.from_u8(img);
     if (normalized) {
-        dst.normalize(hparams.image_mean, hparams.image_std);
+        dst.from_u8(img, hparams.image_mean, hparams.image_std);
+    } else {
+        dst.from_u8(img);
     }
     entries.push_back(std::move(dst));
 }
 
 void mtmd_image_preproc_out::append(const clip_hparams & hparams, const std::vector<clip_image_u8> & imgs, bool normalized) {
-    for (const auto & img : imgs) {
-        append(hparams, img, normalized);
-    }
+    // slices are independent, convert them in parallel
+    const size_t base = entries.size();
+    const size_t cost = imgs.empty() ? 0 : imgs[0].n_elements();
+    entries.resize(base + imgs.size());
+    parallel_for_range((int) imgs.size(), cost, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            if (normalized) {
+                entries[base + i].from_u8(imgs[i], hparams.image_mean, hparams.image_std);
+            } else {
+                entries[base + i].from_u8(imgs[i]);
+            }
+        }
+    });
 }
 
 void mtmd_image_preproc_out::append(const clip_hparams & hparams, clip_image_f32 & img, bool normalized) {
@@ -27,9 +68,10 @@ void mtmd_image_preproc_out::append(const clip_hparams & hparams, clip_image_f32
 }
 
 void mtmd_image_preproc_out::append_overview(const clip_hparams & hparams, const clip_image_u8 & img, bool normalized) {
-    overview.from_u8(img);
     if (normalized) {
-        overview.normalize(hparams.image_mean, hparams.image_std);
+        overview.from_u8(img, hparams.image_mean, hparams.image_std);
+    } else {
+        overview.from_u8(img);
     }
 }
 
@@ -132,11 +174,15 @@ struct img_tool {
             return;
         }
 
+        const int src_nx = image.get_size().width;
+        const uint8_t * src = image.get_ro_buf().data();
+        std::vector<uint8_t> out((size_t) w * h * 3);
         for (int i = 0; i < h; ++i) {
-            for (int j = 0; j < w; ++j) {
-                dst.set_pixel(j, i, image.get_pixel(x + j, y + i));
-            }
+            std::memcpy(out.data() + (size_t) i * w * 3,
+                        src + ((size_t) (y + i) * src_nx + x) * 3,
+                        (size_t) w * 3);
         }
+        dst.cpy_buf(std::move(out));
     }
 
     struct calc_size_opt {
@@ -193,19 +239,29 @@ struct img_tool {
             return;
         }
 
+        if (dst.is_placeholder()) {
+            return;
+        }
+
         const auto src_size = src.get_size();
         const auto dst_size = dst.get_size();
-        for (int y = 0; y < src_size.height; ++y) {
-            for (int x = 0; x < src_size.width; ++x) {
-                int dx = x + offset_x;
-                int dy = y + offset_y;
-                // skip pixels that would be out of bounds in the destination
-                if (dx < 0 || dy < 0 || dx >= dst_size.width || dy >= dst_size.height) {
-                    continue;
-                }
-                dst.set_pixel(dx, dy, src.get_pixel(x, y));
-            }
+        // clip the source rectangle so that it lands inside the destination
+        const int x_begin = std::max(0, -offset_x);
+        const int x_end   = std::min(src_size.width,  dst_size.width  - offset_x);
+        const int y_begin = std::max(0, -offset_y);
+        const int y_end   = std::min(src_size.height, dst_size.height - offset_y);
+        if (x_begin >= x_end || y_begin >= y_end) {
+            return;
         }
+
+        const uint8_t * sp = src.get_ro_buf().data();
+        std::vector<uint8_t> out = dst.get_ro_buf();
+        for (int y = y_begin; y < y_end; ++y) {
+            std::memcpy(out.data() + ((size_t) (y + offset_y) * dst_size.width + x_begin + offset_x) * 3,
+                        sp + ((size_t) y * src_size.width + x_begin) * 3,
+                        (size_t) (x_end - x_begin) * 3);
+        }
+        dst.cpy_buf(std::move(out));
     }
 
     // fill the image with a solid color
@@ -215,12 +271,13 @@ struct img_tool {
             return;
         }
 
-        const auto size = img.get_size();
-        for (int y = 0; y < size.height; ++y) {
-            for (int x = 0; x < size.width; ++x) {
-                img.set_pixel(x, y, color);
-            }
+        std::vector<uint8_t> out(img.n_elements());
+        for (size_t i = 0; i < out.size(); i += 3) {
+            out[i + 0] = color[0];
+            out[i + 1] = color[1];
+            out[i + 2] = color[2];
         }
+        img.cpy_buf(std::move(out));
     }
 
 private:
@@ -241,33 +298,45 @@ private:
         float x_ratio = target_width  > 1 ? static_cast<float>(src_size.width  - 1) / (target_width  - 1) : 0.0f;
         float y_ratio = target_height > 1 ? static_cast<float>(src_size.height - 1) / (target_height - 1) : 0.0f;
 
-        for (int y = 0; y < target_height; ++y) {
-            for (int x = 0; x < target_width; ++x) {
-                float px = x * x_ratio;
-                float py = y * y_ratio;
+        // horizontal taps are the same for every row
+        std::vector<int>   xs0(target_width), xs1(target_width);
+        std::vector<float> xfs(target_width);
+        for (int x = 0; x < target_width; ++x) {
+            float px = x * x_ratio;
+            xs0[x] = std::min(static_cast<int>(px), src_size.width - 1);
+            xs1[x] = std::min(xs0[x] + 1, src_size.width - 1);
+            xfs[x] = px - xs0[x];
+        }
 
-                int x0 = std::min(static_cast<int>(px), src_size.width  - 1);
+        const uint8_t * sp = src.get_ro_buf().data();
+        const size_t src_stride = (size_t) src_size.width * 3;
+        std::vector<uint8_t> out((size_t) target_width * target_height * 3);
+
+        parallel_for_range(target_height, (size_t) target_width * 3, [&](int y_begin, int y_end) {
+            for (int y = y_begin; y < y_end; ++y) {
+                float py = y * y_ratio;
                 int y0 = std::min(static_cast<int>(py), src_size.height - 1);
-                int x1 = std::min(x0 + 1, src_size.width  - 1);
                 int y1 = std::min(y0 + 1, src_size.height - 1);
-
-                float xf = px - x0;
                 float yf = py - y0;
 
-                const auto p00 = src.get_pixel(x0, y0);
-                const auto p10 = src.get_pixel(x1, y0);
-                const auto p01 = src.get_pixel(x0, y1);
-                const auto p11 = src.get_pixel(x1, y1);
-
-                std::array<uint8_t, 3> pixel;
-                for (int c = 0; c < 3; ++c) {
-                    float top    = lerp(static_cast<float>(p00[c]), static_cast<float>(p10[c]), xf);
-                    float bottom = lerp(static_cast<float>(p01[c]), static_cast<float>(p11[c]), xf);
-                    pixel[c] = static_cast<uint8_t>(lerp(top, bottom, yf));
+                const uint8_t * row0 = sp + y0 * src_stride;
+                const uint8_t * row1 = sp + y1 * src_stride;
+                uint8_t * dp = out.data() + (size_t) y * target_width * 3;
+                for (int x = 0; x < target_width; ++x) {
+                    const uint8_t * p00 = row0 + xs0[x] * 3;
+                    const uint8_t * p10 = row0 + xs1[x] * 3;
+                    const uint8_t * p01 = row1 + xs0[x] * 3;
+                    const uint8_t * p11 = row1 + xs1[x] * 3;
+                    const float xf = xfs[x];
+                    for (int c = 0; c < 3; ++c) {
+                        float top    = lerp(static_cast<float>(p00[c]), static_cast<float>(p10[c]), xf);
+                        float bottom = lerp(static_cast<float>(p01[c]), static_cast<float>(p11[c]), xf);
+                        dp[x * 3 + c] = static_cast<uint8_t>(lerp(top, bottom, yf));
+                    }
                 }
-                dst.set_pixel(x, y, pixel);
             }
-        }
+        });
+        dst.cpy_buf(std::move(out));
     }
 
     // Bicubic resize function
@@ -284,42 +353,47 @@ private:
             return;
         }
 
-        float Cc;
-        float C[5] = {};
-        float d0, d2, d3, a0, a1, a2, a3;
-        int i, j, k, jj;
-        int x, y;
-        float dx, dy;
-        float tx, ty;
-
-        tx = (float)nx / (float)target_width;
-        ty = (float)ny / (float)target_height;
+        const float tx = (float)nx / (float)target_width;
+        const float ty = (float)ny / (float)target_height;
 
         // Bicubic interpolation; adapted from ViT.cpp, inspired from :
         //    -> https://github.com/yglukhov/bicubic-interpolation-image-processing/blob/master/libimage.c#L36
         //    -> https://en.wikipedia.org/wiki/Bicubic_interpolation
 
-        for (i = 0; i < target_height; i++) {
-            for (j = 0; j < target_width; j++) {
-                x = (int)(tx * j);
-                y = (int)(ty * i);
-
-                dx = tx * j - x;
-                dy = ty * i - y;
-
-                std::array<uint8_t, 3> pixel;
-                for (k = 0; k < 3; k++) {
-                    for (jj = 0; jj <= 3; jj++) {
-                        d0 = img.get_pixel(clip(x - 1, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k] - img.get_pixel(clip(x, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k];
-                        d2 = img.get_pixel(clip(x + 1, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k] - img.get_pixel(clip(x, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k];
-                        d3 = img.get_pixel(clip(x + 2, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k] - img.get_pixel(clip(x, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k];
-                        a0 = img.get_pixel(clip(x, 0, nx - 1), clip(y - 1 + jj, 0, ny - 1))[k];
-
-                        a1 = -1.0 / 3 * d0 + d2 - 1.0 / 6 * d3;
-                        a2 =  1.0 / 2 * d0 +      1.0 / 2 * d2;
-                        a3 = -1.0 / 6 * d0 -      1.0 / 2 * d2 + 1.0 / 6 * d3;
+        const uint8_t * sp = img.get_ro_buf().data();
+        auto px = [&](int x, int y, int k) -> int {
+            return sp[((size_t) clip(y, 0, ny - 1) * nx + clip(x, 0, nx - 1)) * 3 + k];
+        };
 
-                        C[jj] = a0 + a1 * dx + a2 * dx * dx + a3 * dx * dx * dx;
+        std::vector<uint8_t> out((size_t) target_width * target_height * 3);
+
+        parallel_for_range(target_height, (size_t) target_width * 3 * 32, [&](int i_begin, int i_end) {
+            float C[4];
+            float d0, d2, d3, a0, a1, a2, a3;
+            for (int i = i_begin; i < i_end; i++) {
+                uint8_t * dp = out.data() + (size_t) i * target_width * 3;
+                for (int j = 0; j < target_width; j++) {
+                    const int x = (int)(tx * j);
+                    const int y = (int)(ty * i);
+
+                    const float dx = tx * j - x;
+                    const float dy = ty * i - y;
+
+                    for (int k = 0; k < 3; k++) {
+                        // interpolate 4 rows along x, then the 4 results along y
+                        for (int jj = 0; jj <= 3; jj++) {
+                            const int yy = y - 1 + jj;
+                            d0 = px(x - 1, yy, k) - px(x, yy, k);
+                            d2 = px(x + 1, yy, k) - px(x, yy, k);
+                            d3 = px(x + 2, yy, k) - px(x, yy, k);
+                            a0 = px(x, yy, k);
+
+                            a1 = -1.0 / 3 * d0 + d2 - 1.0 / 6 * d3;
+                            a2 =  1.0 / 2 * d0 +      1.0 / 2 * d2;
+                            a3 = -1.0 / 6 * d0 -      1.0 / 2 * d2 + 1.0 / 6 * d3;
+
+                            C[jj] = a0 + a1 * dx + a2 * dx * dx + a3 * dx * dx * dx;
+                        }
 
                         d0 = C[0] - C[1];
                         d2 = C[2] - C[1];
@@ -328,15 +402,14 @@ private:
                         a1 = -1.0 / 3 * d0 + d2 - 1.0 / 6 * d3;
                         a2 =  1.0 / 2 * d0 +      1.0 / 2 * d2;
                         a3 = -1.0 / 6 * d0 -      1.0 / 2 * d2 + 1.0 / 6 * d3;
-                        Cc = a0 + a1 * dy + a2 * dy * dy + a3 * dy * dy * dy;
+                        const float Cc = a0 + a1 * dy + a2 * dy * dy + a3 * dy * dy * dy;
 
-                        const uint8_t Cc2 = std::min(std::max(std::round(Cc), 0.0f), 255.0f);
-                        pixel[k] = Cc2;
+                        dp[j * 3 + k] = std::min(std::max(std::round(Cc), 0.0f), 255.0f);
                     }
                 }
-                dst.set_pixel(j, i, pixel);
             }
-        }
+        });
+        dst.cpy_buf(std::move(out));
     }
 
     // Pillow-compatible separable resampling (Bicubic and Lanczos)
@@ -520,73 +593,93 @@ private:
         auto resample_horizontal = [&](const clip_image_u8 & imIn, clip_image_u8 & imOut,
                                        int out_nx,
                                        int ksize, const std::vector<int> & bounds, const std::vector<int32_t> & weights) {
+            const int in_nx = imIn.get_size().width;
             const int in_ny = imIn.get_size().height;
-            imOut.set_size({out_nx, in_ny}, false);
-
-            // Process each row independently
-            for (int yy = 0; yy < in_ny; yy++) {
-                // For each output pixel in this row
-                for (int xx = 0; xx < out_nx; xx++) {
-                    // Get the range of input pixels and filter coefficients
-                    int xmin = bounds[xx * 2 + 0];  // First input pixel index
-                    int xcnt = bounds[xx * 2 + 1];  // Number of input pixels
-
-                    // Initialize accumulators for RGB channels with rounding bias (0.5 in fixed-point)
-                    int32_t ss0 = 1 << (PRECISION_BITS - 1);
-                    int32_t ss1 = 1 << (PRECISION_BITS - 1);
-                    int32_t ss2 = 1 << (PRECISION_BITS - 1);
-
-                    // Convolve: sum weighted input pixels
-                    for (int x = 0; x < xcnt; x++) {
-                        const auto src_px = imIn.get_pixel(x + xmin, yy);
-                        ss0 += src_px[0] * weights[xx * ksize + x];  // R channel
-                        ss1 += src_px[1] * weights[xx * ksize + x];  // G channel
-                        ss2 += src_px[2] * weights[xx * ksize + x];  // B channel
-                    }
+            const uint8_t * src = imIn.get_ro_buf().data();
+            std::vector<uint8_t> out((size_t) out_nx * in_ny * 3);
+
+            // Rows are independent: split them across threads
+            parallel_for_range(in_ny, (size_t) out_nx * ksize * 3, [&](int y_begin, int y_end) {
+                for (int yy = y_begin; yy < y_end; yy++) {
+                    const uint8_t * row = src + (size_t) yy * in_nx * 3;
+                    uint8_t * dp = out.data() + (size_t) yy * out_nx * 3;
+                    // For each output pixel in this row
+                    for (int xx = 0; xx < out_nx; xx++) {
+                        // Get the range of input pixels and filter coefficients
+                        const int xmin = bounds[xx * 2 + 0];  // First input pixel index
+                        const int xcnt = bounds[xx * 2 + 1];  // Number of input pixels
+                        const int32_t * k = weights.data() + (size_t) xx * ksize;
+                        const uint8_t * sp = row + (size_t) xmin * 3;
+
+                        // Initialize accumulators for RGB channels with rounding bias (0.5 in fixed-point)
+                        int32_t ss0 = 1 << (PRECISION_BITS - 1);
+                        int32_t ss1 = 1 << (PRECISION_BITS - 1);
+                        int32_t ss2 = 1 << (PRECISION_BITS - 1);
+
+                        // Convolve: sum weighted input pixels
+                        for (int x = 0; x < xcnt; x++) {
+                            ss0 += sp[x * 3 + 0] * k[x];  // R channel
+                            ss1 += sp[x * 3 + 1] * k[x];  // G channel
+                            ss2 += sp[x * 3 + 2] * k[x];  // B channel
+                        }
 
-                    // Convert back from fixed-point (divide by 2^PRECISION_BITS) and clamp to [0,255]
-                    imOut.set_pixel(xx, yy, {clip8(ss0 >> PRECISION_BITS),
-                                             clip8(ss1 >> PRECISION_BITS),
-                                             clip8(ss2 >> PRECISION_BITS)});
+                        // Convert back from fixed-point (divide by 2^PRECISION_BITS) and clamp to [0,255]
+                        dp[xx * 3 + 0] = clip8(ss0 >> PRECISION_BITS);
+                        dp[xx * 3 + 1] = clip8(ss1 >> PRECISION_BITS);
+                        dp[xx * 3 + 2] = clip8(ss2 >> PRECISION_BITS);
+                    }
                 }
-            }
+            });
+
+            imOut.set_size({out_nx, in_ny}, true); // size only, the buffer is moved in below
+            imOut.cpy_buf(std::move(out));
         };
 
         // Vertical resampling pass
         // Resizes height from imIn to out_ny, preserving width
+        //
+        // Each output row is a weighted sum of whole input rows, so the channels are
+        // accumulated row-wise into an int32 scratch row; that inner loop is a plain
+        // multiply-add over contiguous memory which the compiler vectorizes
         auto resample_vertical = [&](const clip_image_u8 & imIn, clip_image_u8 & imOut,
                                      int out_ny,
                                      int ksize, const std::vector<int> & bounds, const std::vector<int32_t> & weight) {
             const int in_nx = imIn.get_size().width;
-            imOut.set_size({in_nx, out_ny}, false);
-
-            // For each output row
-            for (int yy = 0; yy < out_ny; yy++) {
-                // Get the range of input rows and filter coefficients
-                int ymin = bounds[yy * 2 + 0];  // First input row index
-                int ycnt = bounds[yy * 2 + 1];  // Number of input rows
-
-                // Process each column in this output row
-                for (int xx = 0; xx < in_nx; xx++) {
-                    // Initialize accumulators for RGB channels with rounding bias
-                    int32_t ss0 = 1 << (PRECISION_BITS - 1);
-                    int32_t ss1 = 1 << (PRECISION_BITS - 1);
-                    int32_t ss2 = 1 << (PRECISION_BITS - 1);
-
-                    // Convolve: sum weighted input pixels vertically
+            const size_t row_len = (size_t) in_nx * 3;
+            const uint8_t * src = imIn.get_ro_buf().data();
+            std::vector<uint8_t> out(row_len * out_ny);
+
+            parallel_for_range(out_ny, row_len * ksize, [&](int y_begin, int y_end) {
+                std::vector<int32_t> acc(row_len);
+                for (int yy = y_begin; yy < y_end; yy++) {
+                    // Get the range of input rows and filter coefficients
+                    const int ymin = bounds[yy * 2 + 0];  // First input row index
+                    const int ycnt = bounds[yy * 2 + 1];  // Number of input rows
+                    const int32_t * k = weight.data() + (size_t) yy * ksize;
+
+                    // Initialize accumulators with rounding bias
+                    std::fill(acc.begin(), acc.end(), 1 << (PRECISION_BITS - 1));
+
+                    // Convolve: sum weighted input rows
+                    int32_t * ap = acc.data();
                     for (int y = 0; y < ycnt; y++) {
-                        const auto src_px = imIn.get_pixel(xx, y + ymin);
-                        ss0 += src_px[0] * weight[yy * ksize + y];  // R channel
-                        ss1 += src_px[1] * weight[yy * ksize + y];  // G channel
-                        ss2 += src_px[2] * weight[yy * ksize + y];  // B channel
+                        const uint8_t * sp = src + (size_t) (y + ymin) * row_len;
+                        const int32_t w = k[y];
+                        for (size_t i = 0; i < row_len; i++) {
+                            ap[i] += sp[i] * w;
+                        }
                     }
 
                     // Convert back from fixed-point and clamp to [0,255]
-                    imOut.set_pixel(xx, yy, {clip8(ss0 >> PRECISION_BITS),
-                                             clip8(ss1 >> PRECISION_BITS),
-                                             clip8(ss2 >> PRECISION_BITS)});
+                    uint8_t * dp = out.data() + (size_t) yy * row_len;
+                    for (size_t i = 0; i < row_len; i++) {
+                        dp[i] = clip8(ap[i] >> PRECISION_BITS);
+                    }
                 }
-            }
+            });
+
+            imOut.set_size({in_nx, out_ny}, true); // size only, the buffer is moved in below
+            imOut.cpy_buf(std::move(out));
         };
 
         // Main resampling logic using separable two-pass approach
@@ -1252,30 +1345,38 @@ mtmd_image_preproc_out mtmd_image_preprocessor_deepseekocr::preprocess(const cli
         img_tool::resize(img, refined, { tile_size * grid_w, tile_size * grid_h }, RESIZE_ALGO_BICUBIC_PILLOW,
                          PAD_NONE);
 
+        std::vector<clip_image_u8> tiles;
         for (int row = 0; row < grid_h; row++) {
             if (fuse_row) {
                 // concat all tiles in this row into a single image, along the H axis
                 // output image size: w = tile_size, h = tile_size * grid_w
                 // this is to ensure the whole row is always processed together
                 clip_image_u8 row_img;
-                row_img.set_size({tile_size, tile_size * grid_w}, false);
-                for (int col = 0; col < grid_w; col++) {
-                    for (int py = 0; py < tile_size; py++) {
-                        for (int px = 0; px < tile_size; px++) {
-                            row_img.set_pixel(px, col * tile_size + py,
-                                              refined.get_pixel(col * tile_size + px, row * tile_size + py));
+                row_img.set_size({tile_size, tile_size * grid_w}, refined.is_placeholder());
+                if (!refined.is_placeholder()) {
+                    const uint8_t * src = refined.get_ro_buf().data();
+                    const size_t src_stride = (size_t) refined.get_size().width * 3;
+                    const size_t tile_row   = (size_t) tile_size * 3;
+                    std::vector<uint8_t> buf(tile_row * tile_size * grid_w);
+                    for (int col = 0; col < grid_w; col++) {
+                        for (int py = 0; py < tile_size; py++) {
+                            std::memcpy(buf.data() + ((size_t) col * tile_size + py) * tile_row,
+                                        src + ((size_t) row * tile_size + py) * src_stride + col * tile_row,
+                                        tile_row);
                         }
                     }
+                    row_img.cpy_buf(std::move(buf));
                 }
-                output.append(hparams, row_img, true);
+                tiles.push_back(std::move(row_img));
             } else {
                 for (int col = 0; col < grid_w; col++) {
                     clip_image_u8 tile;
                     img_tool::crop(refined, tile, col * tile_size, row * tile_size, tile_size, tile_size);
-                    output.append(hparams, tile, true);
+                    tiles.push_back(std::move(tile));
                 }
             }
         }
+        output.append(hparams, tiles, true);
         if (fuse_row) {
             grid_w = 1; // each fused row is one image; a single output column
         }
@@ -1302,8 +1403,7 @@ void mtmd_image_preprocessor_step3vl::img_u8_resize_bilinear_to_f32(
         const float std[3]) {
     const auto src_size = src.get_size();
     if (src_size.width == target_width && src_size.height == target_height) {
-        dst.from_u8(src);
-        dst.normalize(mean, std);
+        dst.from_u8(src, mean, std);
         return;
     }
 
@@ -1317,41 +1417,60 @@ void mtmd_image_preprocessor_step3vl::img_u8_resize_bilinear_to_f32(
     const float scale_x = static_cast<float>(src_size.width)  / target_width;
     const float scale_y = static_cast<float>(src_size.height) / target_height;
 
-    std::vector<float> local_buf(3 * target_width * target_height);
+    // normalization is folded into the interpolation through a per-channel lookup table
+    float lut[3][256];
+    for (int c = 0; c < 3; ++c) {
+        for (int v = 0; v < 256; ++v) {
+            lut[c][v] = (static_cast<float>(v) / 255.0f - mean[c]) / std[c];
+        }
+    }
 
-    for (int y = 0; y < target_height; ++y) {
-        const float src_y = (static_cast<float>(y) + 0.5f) * scale_y - 0.5f;
-        const int y0_floor = static_cast<int>(std::floor(src_y));
-        const int y0 = std::max(0, std::min(y0_floor,     src_size.height - 1));
-        const int y1 = std::max(0, std::min(y0_floor + 1, src_size.height - 1));
-        const float ly = src_y - y0_floor;
+    // horizontal taps are the same for every row
+    std::vector<int>   xs0(target_width), xs1(target_width);
+    std::vector<float> lxs(target_width);
+    for (int x = 0; x < target_width; ++x) {
+        const float src_x = (static_cast<float>(x) + 0.5f) * scale_x - 0.5f;
+        const int x0_floor = static_cast<int>(std::floor(src_x));
+        xs0[x] = std::max(0, std::min(x0_floor,     src_size.width - 1));
+        xs1[x] = std::max(0, std::min(x0_floor + 1, src_size.width - 1));
+        lxs[x] = src_x - x0_floor;
+    }
 
-        for (int x = 0; x < target_width; ++x) {
-            const float src_x = (static_cast<float>(x) + 0.5f) * scale_x - 0.5f;
-            const int x0_floor = static_cast<int>(std::floor(src_x));
-            const int x0 = std::max(0, std::min(x0_floor,     src_size.width - 1));
-            const int x1 = std::max(0, std::min(x0_floor + 1, src_size.width - 1));
-            const float lx = src_x - x0_floor;
-
-            const auto p00 = src.get_pixel(x0, y0);
-            const auto p01 = src.get_pixel(x1, y0);
-            const auto p10 = src.get_pixel(x0, y1);
-            const auto p11 = src.get_pixel(x1, y1);
-
-            const size_t idx_dst = 3 * (y * target_width + x);
-            for (int c = 0; c < 3; ++c) {
-                const float v00 = (static_cast<float>(p00[c]) / 255.0f - mean[c]) / std[c];
-                const float v01 = (static_cast<float>(p01[c]) / 255.0f - mean[c]) / std[c];
-                const float v10 = (static_cast<float>(p10[c]) / 255.0f - mean[c]) / std[c];
-                const float v11 = (static_cast<float>(p11[c]) / 255.0f - mean[c]) / std[c];
-
-                const float top = v00 + (v01 - v00) * lx;
-                const float bot = v10 + (v11 - v10) * lx;
-                local_buf[idx_dst + c] = top + (bot - top) * ly;
+    const uint8_t * sp = src.get_ro_buf().data();
+    const size_t src_stride = (size_t) src_size.width * 3;
+    std::vector<float> local_buf(3 * (size_t) target_width * target_height);
+
+    parallel_for_range(target_height, (size_t) target_width * 3, [&](int y_begin, int y_end) {
+        for (int y = y_begin; y < y_end; ++y) {
+            const float src_y = (static_cast<float>(y) + 0.5f) * scale_y - 0.5f;
+            const int y0_floor = static_cast<int>(std::floor(src_y));
+            const int y0 = std::max(0, std::min(y0_floor,     src_size.height - 1));
+            const int y1 = std::max(0, std::min(y0_floor + 1, src_size.height - 1));
+            const float ly = src_y - y0_floor;
+
+            const uint8_t * row0 = sp + y0 * src_stride;
+            const uint8_t * row1 = sp + y1 * src_stride;
+            float * dp = local_buf.data() + 3 * (size_t) y * target_width;
+            for (int x = 0; x < target_width; ++x) {
+                const uint8_t * p00 = row0 + xs0[x] * 3;
+                const uint8_t * p01 = row0 + xs1[x] * 3;
+                const uint8_t * p10 = row1 + xs0[x] * 3;
+                const uint8_t * p11 = row1 + xs1[x] * 3;
+                const float lx = lxs[x];
+                for (int c = 0; c < 3; ++c) {
+                    const float v00 = lut[c][p00[c]];
+                    const float v01 = lut[c][p01[c]];
+                    const float v10 = lut[c][p10[c]];
+                    const float v11 = lut[c][p11[c]];
+
+                    const float top = v00 + (v01 - v00) * lx;
+                    const float bot = v10 + (v11 - v10) * lx;
+                    dp[3 * x + c] = top + (bot - top) * ly;
+                }
             }
         }
-    }
-    dst.cpy_buf(local_buf);
+    });
+    dst.cpy_buf(std::move(local_buf));
 }
 
 int mtmd_image_preprocessor_step3vl::get_image_longest_edge(const clip_hparams & params) {
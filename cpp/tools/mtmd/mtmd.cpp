@@ -465,6 +465,7 @@ mtmd_context_params mtmd_context_params_default() {
         /* batch_max_tokens  */ 1024,
         /* progress_callback */ nullptr,
         /* progress_callback_user_data */ nullptr,
+        /* compute_arena     */ nullptr,
     };
     return params;
 }
@@ -569,6 +570,7 @@ struct mtmd_context {
             /* no_alloc          */ no_alloc,
             /* progress_callback */ ctx_params.progress_callback,
             /* progress_callback_user_data */ ctx_params.progress_callback_user_data,
+            /* compute_arena     */ ctx_params.compute_arena,
         };
 
         auto res = clip_init(mmproj_fname, ctx_clip_params);
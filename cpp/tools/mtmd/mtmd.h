@@ -114,6 +114,10 @@ struct mtmd_context_params {
     // If it returns false, model loading is immediately aborted.
     mtmd_progress_callback progress_callback;
     void * progress_callback_user_data;
+
+    // [EXPERIMENTAL] host compute arena shared with contexts that never compute at the same time
+    // (see lm_ggml_backend_arena_new), the arena must outlive the mtmd context (default: NULL)
+    lm_ggml_backend_arena_t compute_arena;
 };
 
 MTMD_API const char * mtmd_default_marker(void);
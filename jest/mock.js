@@ -323,6 +323,10 @@ if (!NativeModules.RNLlama) {
       'llamaDecodeAudioTokens',
       jest.fn(async () => []),
     )
+    setGlobal(
+      'llamaDecodeAudioTokensBatch',
+      jest.fn(async (_id, tokens) => tokens.map(() => [])),
+    )
     setGlobal(
       'llamaGenerateAudioCodes',
       jest.fn(async () => ({
@@ -333,6 +337,18 @@ if (!NativeModules.RNLlama) {
         aborted: false,
       })),
     )
+    setGlobal(
+      'llamaGenerateAudioCodesBatch',
+      jest.fn(async (_id, optsJson) =>
+        JSON.parse(optsJson).map(() => ({
+          codes: [],
+          nCodebook: 0,
+          nFrames: 0,
+          stoppedOnEos: false,
+          aborted: false,
+        })),
+      ),
+    )
     setGlobal(
       'llamaCreateSpeaker',
       jest.fn(async () => ({ id: 1, family: 'chatterbox', rows: 0, baked: false })),
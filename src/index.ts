@@ -26,6 +26,7 @@ import type {
   NativeSpeculativeType,
   ParallelStatus,
   ParallelRequestStatus,
+  ParallelModeConfig,
 } from './types'
 import { BUILD_NUMBER, BUILD_COMMIT } from './version'
 import type { SpeakerPayload } from './tts-voices'
@@ -73,6 +74,7 @@ export type {
   NativeSpeculativeType,
   ParallelStatus,
   ParallelRequestStatus,
+  ParallelModeConfig,
 }
 
 export const RNLLAMA_MTMD_DEFAULT_MEDIA_MARKER = '<__media__>'
@@ -125,10 +127,16 @@ const jsiBindingKeys = [
   'llamaGetFormattedAudioCompletion',
   'llamaGetTTSCapabilities',
   'llamaDecodeAudioTokens',
+  'llamaDecodeAudioTokensBatch',
   'llamaGenerateAudioCodes',
+  'llamaGenerateAudioCodesBatch',
+  'llamaSynthesizeLongForm',
   'llamaCreateSpeaker',
   'llamaBakeSpeaker',
   'llamaReleaseSpeaker',
+  'llamaSaveSpeaker',
+  'llamaLoadSpeaker',
+  'llamaSetSpeakerCacheDir',
   'llamaDecodeAudioEmbeddings',
   'llamaGetAudioSampleRate',
   'llamaReleaseVocoder',
@@ -391,6 +399,17 @@ export class LlamaSpeaker {
     const { llamaReleaseSpeaker } = getJsi()
     await llamaReleaseSpeaker(this.ctxId, this.id)
   }
+
+  /**
+   * Write the baked speaker to `path` (baking first if needed) so it can
+   * be restored with `LlamaContext.loadSpeaker` without re-running the
+   * speaker encoder.  Set `includeAudio` for Chatterbox voices, whose
+   * prefill still reads the reference audio.
+   */
+  async save(path: string, options?: { includeAudio?: boolean }): Promise<boolean> {
+    const { llamaSaveSpeaker } = getJsi()
+    return llamaSaveSpeaker(this.ctxId, this.id, path, options?.includeAudio ?? false)
+  }
 }
 
 export class LlamaContext {
@@ -634,13 +653,13 @@ export class LlamaContext {
         }
       }),
 
-    enable: (config?: { n_parallel?: number; n_batch?: number }) =>
+    enable: (config?: ParallelModeConfig) =>
       getJsi().llamaEnableParallelMode(this.id, { enabled: true, ...config }),
 
     disable: () =>
       getJsi().llamaEnableParallelMode(this.id, { enabled: false }),
 
-    configure: (config: { n_parallel?: number; n_batch?: number }) =>
+    configure: (config: ParallelModeConfig) =>
       getJsi().llamaEnableParallelMode(this.id, { enabled: true, ...config }),
 
     /**
@@ -1225,6 +1244,17 @@ export class LlamaContext {
     return await llamaDecodeAudioTokens(this.id, tokens)
   }
 
+  /**
+   * Decode several code sequences (e.g. the `codes` of
+   * `generateAudioCodesBatch` results) in one codec pass.  Models that do
+   * not decode raw codes directly fall back to one `decodeAudioTokens`
+   * call per sequence.  Results are returned in input order.
+   */
+  async decodeAudioTokensBatch(tokens: number[][]): Promise<Array<Array<number>>> {
+    const { llamaDecodeAudioTokensBatch } = getJsi()
+    return await llamaDecodeAudioTokensBatch(this.id, tokens)
+  }
+
   /**
    * DEPRECATED: source-compat wrapper for codec_lm-AR TTS.
    *
@@ -1266,6 +1296,71 @@ export class LlamaContext {
     return await llamaGenerateAudioCodes(this.id, optsJson, onFrame)
   }
 
+  /**
+   * Generate codes for several utterances at once.  On plain codec_lm-AR
+   * models (CSM, parallel-heads) each utterance runs as its own backbone
+   * sequence and the codec_lm heads are evaluated once per codebook for
+   * the whole group; other models fall back to one `generateAudioCodes`
+   * call per entry.  Results are returned in input order.  At most
+   * `n_parallel` utterances share one pass.
+   */
+  async generateAudioCodesBatch(
+    options: Array<{
+      prompt: string
+      maxFrames?: number
+      temperature?: number
+      topP?: number
+      topK?: number
+      seed?: number
+    }>,
+  ): Promise<
+    Array<{
+      codes: number[]
+      nCodebook: number
+      nFrames: number
+      stoppedOnEos: boolean
+      aborted: boolean
+    }>
+  > {
+    const { llamaGenerateAudioCodesBatch } = getJsi()
+    return await llamaGenerateAudioCodesBatch(this.id, JSON.stringify(options))
+  }
+
+  /**
+   * Synthesize arbitrarily long text.  The text is split at sentence
+   * boundaries (or pass `segments` to segment / phonemize it yourself)
+   * and each segment is generated with the same speaker; while segment
+   * k+1 generates, segment k is decoded on another thread and delivered
+   * to `onChunk` in order.  Stop it with `stopCompletion()`.
+   */
+  async synthesizeLongForm(options: {
+    text?: string
+    segments?: string[]
+    speaker?: object | null
+    speakerId?: number
+    maxSegmentChars?: number
+    nPredict?: number
+    temperature?: number
+    topP?: number
+    topK?: number
+    seed?: number
+    decodeThreads?: number
+    onChunk?: (segment: number, pcm: number[]) => void
+  }): Promise<{
+    nSegments: number
+    nSamples: number
+    sampleRate: number
+    aborted: boolean
+  }> {
+    const { llamaSynthesizeLongForm } = getJsi()
+    const { onChunk, speaker, ...rest } = options
+    const optsJson = JSON.stringify({
+      ...rest,
+      speakerJson: speaker ? JSON.stringify(speaker) : '',
+    })
+    return await llamaSynthesizeLongForm(this.id, optsJson, onChunk)
+  }
+
   async createSpeaker(config: {
     refAudio: Float32Array | number[]
     refAudioSampleRate: number
@@ -1289,6 +1384,26 @@ export class LlamaContext {
     return new LlamaSpeaker(this.id, h)
   }
 
+  /**
+   * Restore a speaker written by `LlamaSpeaker.save`.  Rejects when the
+   * file was baked for a different model.
+   */
+  async loadSpeaker(path: string): Promise<LlamaSpeaker> {
+    const { llamaLoadSpeaker } = getJsi()
+    const h = await llamaLoadSpeaker(this.id, path)
+    return new LlamaSpeaker(this.id, h)
+  }
+
+  /**
+   * Cache baked speakers in `dir`: baking a speaker whose reference audio
+   * was baked before (for this model) reads the cached embedding instead
+   * of running the encoder.  Pass '' to disable.
+   */
+  async setSpeakerCacheDir(dir: string): Promise<void> {
+    const { llamaSetSpeakerCacheDir } = getJsi()
+    await llamaSetSpeakerCacheDir(this.id, dir)
+  }
+
   async decodeAudioEmbeddings(
     embeddings: number[],
     embeddingDim: number,
@@ -1492,6 +1607,7 @@ export async function initLlama(
   const nativeRest = {
     ...rest,
     speculative: normalizeSpeculativeDraftPaths(rest.speculative),
+    repack_cache_dir: normalizeFileUri(rest.repack_cache_dir),
   }
 
   const loraAdapters = normalizeLoraAdapters({
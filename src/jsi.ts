@@ -155,6 +155,10 @@ declare global {
     contextId: number,
     tokens: number[],
   ) => Promise<number[]>
+  var llamaDecodeAudioTokensBatch: (
+    contextId: number,
+    tokens: number[][],
+  ) => Promise<number[][]>
   var llamaGenerateAudioCodes: (
     contextId: number,
     optsJson: string,
@@ -166,6 +170,28 @@ declare global {
     stoppedOnEos: boolean
     aborted: boolean
   }>
+  var llamaGenerateAudioCodesBatch: (
+    contextId: number,
+    optsJson: string,
+  ) => Promise<
+    Array<{
+      codes: number[]
+      nCodebook: number
+      nFrames: number
+      stoppedOnEos: boolean
+      aborted: boolean
+    }>
+  >
+  var llamaSynthesizeLongForm: (
+    contextId: number,
+    optsJson: string,
+    onChunk?: (segment: number, pcm: number[]) => void,
+  ) => Promise<{
+    nSegments: number
+    nSamples: number
+    sampleRate: number
+    aborted: boolean
+  }>
   var llamaCreateSpeaker: (
     contextId: number,
     optsJson: string,
@@ -175,6 +201,17 @@ declare global {
     speakerId: number,
   ) => Promise<{ rows: number; baked: boolean }>
   var llamaReleaseSpeaker: (contextId: number, speakerId: number) => Promise<void>
+  var llamaSaveSpeaker: (
+    contextId: number,
+    speakerId: number,
+    path: string,
+    includePcm: boolean,
+  ) => Promise<boolean>
+  var llamaLoadSpeaker: (
+    contextId: number,
+    path: string,
+  ) => Promise<{ id: number; family: string; rows: number; baked: boolean }>
+  var llamaSetSpeakerCacheDir: (contextId: number, dir: string) => Promise<void>
   var llamaDecodeAudioEmbeddings: (
     contextId: number,
     embeddings: number[],
@@ -187,7 +224,14 @@ declare global {
   // Parallel decoding
   var llamaEnableParallelMode: (
     contextId: number,
-    params: { enabled: boolean; n_parallel?: number; n_batch?: number },
+    params: {
+      enabled: boolean
+      n_parallel?: number
+      n_batch?: number
+      spill_max_entries?: number
+      spill_idle_ms?: number
+      spill_dir?: string
+    },
   ) => Promise<boolean>
   var llamaQueueCompletion: (
     contextId: number,
@@ -9,6 +9,15 @@ export type NativeSpeculativeType =
    * Alias for draft-mtp.
    */
   | 'mtp'
+  /**
+   * N-gram drafters (no draft model). Supported by parallel mode slots,
+   * where drafts of all slots are verified in one batched decode.
+   */
+  | 'ngram-simple'
+  | 'ngram-map-k'
+  | 'ngram-map-k4v'
+  | 'ngram-mod'
+  | 'ngram-cache'
 
 export type NativeSpeculativeParams = {
   enabled?: boolean
@@ -35,6 +44,42 @@ export type NativeSpeculativeParams = {
     cache_type_k?: string
     cache_type_v?: string
   }
+  /**
+   * Verify a token tree instead of a single n-gram draft (parallel mode).
+   * Each extra branch is decoded under a spare sequence id, so it needs
+   * `kv_unified` and a context `n_parallel` above the slot count.
+   */
+  tree?: {
+    /**
+     * Max branches per step (default: 0, linear drafts)
+     */
+    n_branch?: number
+    /**
+     * Max draft tokens in the tree (default: 16)
+     */
+    n_nodes?: number
+  }
+  /**
+   * Pick the draft length per step from the live acceptance rate and the
+   * measured draft/verify costs, pausing drafting when it does not pay off.
+   * `true` enables it with the defaults.
+   */
+  adaptive?:
+    | boolean
+    | {
+        /**
+         * Enable the controller (default: true when the object is given)
+         */
+        enabled?: boolean
+        /**
+         * Decay of the rolling statistics per step (default: 0.9)
+         */
+        decay?: number
+        /**
+         * Steps to wait before probing a paused draft with one token (default: 16)
+         */
+        n_probe?: number
+      }
 }
 
 export type NativeSpeculativeConfig =
@@ -121,6 +166,16 @@ export type NativeContextParams = {
    * KV cache data type for the V (Experimental in llama.cpp)
    */
   cache_type_v?: string
+  /**
+   * Number of most recent tokens per sequence whose keys are kept in F16 when `cache_type_k`
+   * is quantized (e.g. `q8_0`, `q4_0`) and `cache_type_v` is not. Older keys are migrated to the
+   * quantized cache in batches, so near-term attention stays accurate with a quantized K cache.
+   * Values are not tiered and stay in `cache_type_v`.
+   * Flash attention is turned off while this is enabled (unless `flash_attn_type` is `on`, which
+   * disables this instead).
+   * Default: `0` (disabled)
+   */
+  cache_n_hot?: number
 
   use_mlock?: boolean
   use_mmap?: boolean
@@ -133,6 +188,22 @@ export type NativeContextParams = {
    */
   no_extra_bufts?: boolean
 
+  /**
+   * Directory for the repacked weight cache.
+   * Weights repacked for the CPU on the first load are written there and mmapped on later loads,
+   * skipping the repack step and letting the page cache share them across processes.
+   * Only the 4 most recently used cache files are kept; older ones are deleted.
+   * The directory must exist. Default: disabled
+   */
+  repack_cache_dir?: string
+
+  /**
+   * Share one host compute buffer between the model, the multimodal projector and the vocoder
+   * of this context instead of reserving one for each. They take turns using it, so a vision
+   * or audio encode waits for a running decode (and vice versa). Default: false
+   */
+  shared_compute_arena?: boolean
+
   /**
    * Single LoRA adapter path
    */
@@ -171,6 +242,20 @@ export type NativeContextParams = {
    */
   ctx_shift?: boolean
 
+  /**
+   * Attention-sink streaming (StreamingLLM) for context shifting: number of leading tokens
+   * that are always kept when the context is full. The rest of the context acts as a sliding
+   * window of recent tokens, so generation can continue with constant memory.
+   * Requires `ctx_shift`. Also applies to parallel slots. Default: `0` (disabled, halve the context instead)
+   */
+  n_sink?: number
+
+  /**
+   * Number of tokens evicted from the recent window each time the context fills up
+   * while `n_sink` is enabled. Smaller values mean shorter, more frequent shifts. Default: `64`
+   */
+  n_sink_evict?: number
+
   /**
    * Use a unified buffer across the input sequences when computing the attention.
    * Try to disable when n_seq_max > 1 for improved performance when the sequences do not share a large prefix.
@@ -182,6 +267,13 @@ export type NativeContextParams = {
    */
   swa_full?: boolean
 
+  /**
+   * Compact the KV cache when the fraction of empty cells below the highest used cell exceeds this value.
+   * Compaction runs incrementally across decode steps. <= 0 disables it (default).
+   * Useful for long-running parallel slots where `seq_rm` churn scatters the cells.
+   */
+  defrag_thold?: number
+
   /**
    * Number of layers to keep MoE weights on CPU
    */
@@ -296,6 +388,9 @@ export type NativeCompletionParams = {
   spec_draft_n_min?: number
   spec_draft_p_min?: number
   spec_draft_p_split?: number
+  spec_tree_n_branch?: number
+  spec_tree_n_nodes?: number
+  spec_adaptive?: boolean
   /**
    * Limit the next token selection to the K most probable tokens.  Default: `40`
    */
@@ -381,6 +476,14 @@ export type NativeCompletionParams = {
    * Ignore end of stream token and continue generating. Default: `false`
    */
   ignore_eos?: boolean
+  /**
+   * Override the context's attention-sink count for this completion (see `NativeContextParams.n_sink`).
+   */
+  n_sink?: number
+  /**
+   * Override the context's sink eviction block size for this completion (see `NativeContextParams.n_sink_evict`).
+   */
+  n_sink_evict?: number
   /**
    * Modify the likelihood of a token appearing in the generated text completion.
    * For example, use `"logit_bias": [[15043,1.0]]` to increase the likelihood of the token 'Hello', or `"logit_bias": [[15043,-1.0]]` to decrease its likelihood.
@@ -471,6 +574,18 @@ export type NativeCompletionResultTimings = {
   predicted_ms: number
   predicted_per_token_ms: number
   predicted_per_second: number
+  /** Adaptive draft length of the last step (0 = drafting paused). Only set with `speculative.adaptive.enabled` */
+  draft_n?: number
+  /** Rolling probability that a draft token is accepted */
+  draft_acceptance?: number
+  /** Rolling time to draft one token */
+  draft_per_token_ms?: number
+  /** Fixed cost of a target decode step */
+  verify_ms?: number
+  /** Extra target decode cost per verified token */
+  verify_per_token_ms?: number
+  /** Expected tokens per second at the chosen draft length */
+  draft_expected_per_second?: number
 }
 
 export type NativeCompletionResult = {
@@ -673,3 +788,21 @@ export type ParallelStatus = {
   queued_requests: number
   requests: ParallelRequestStatus[]
 }
+
+export type ParallelModeConfig = {
+  /** Number of parallel slots. Default: `2` */
+  n_parallel?: number
+  /** Max batch size. Default: `512` */
+  n_batch?: number
+  /**
+   * Keep up to this many idle conversations paged out of the KV cache.
+   * A slot's conversation is spilled when the slot is handed to another request, when it stays
+   * idle longer than `spill_idle_ms`, or when a unified KV cache is close to full. It is paged back in
+   * when a request shares its prefix. Default: `0` (disabled)
+   */
+  spill_max_entries?: number
+  /** Spill slots that have been idle for this long (ms). Default: `0` (only spill on demand) */
+  spill_idle_ms?: number
+  /** Directory for spill files. Default: host memory */
+  spill_dir?: string
+}
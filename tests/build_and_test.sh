@@ -50,6 +50,14 @@ if [ ! -f "chat_parse_utf8_test" ]; then
 fi
 echo "✓ chat_parse_utf8_test built successfully"
 
+echo "Building repack_kernels_test..."
+make repack_kernels_test -j4
+if [ ! -f "repack_kernels_test" ]; then
+    echo "Error: Failed to build repack_kernels_test"
+    exit 1
+fi
+echo "✓ repack_kernels_test built successfully"
+
 echo ""
 echo "=== Build Successful ==="
 echo ""
@@ -57,6 +65,7 @@ echo "Built executables:"
 echo "  - rnllama_tests (basic integration tests)"
 echo "  - parallel_decoding_test (parallel decoding tests)"
 echo "  - chat_parse_utf8_test (chat parse UTF-8 robustness tests)"
+echo "  - repack_kernels_test (SIMD repack kernels vs generic)"
 echo ""
 echo "To run the tests:"
 echo "  cd tests/build"
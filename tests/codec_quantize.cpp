@@ -0,0 +1,180 @@
+// codec_quantize — quantize the matmul weights of a codec / codec_lm GGUF.
+// Every KV pair and every other tensor is copied through unchanged, so the
+// output loads with the same codec_model_load_from_file call as the input.
+//
+// Usage:
+//   codec_quantize IN.gguf OUT.gguf TYPE [--include REGEX] [--exclude REGEX] [--min-elements N] [--dry-run]
+//
+// A tensor is quantized when it is F32/F16/BF16, at least 2D, its rows are a
+// whole number of TYPE blocks, it has at least --min-elements elements
+// (default 4096), its name matches --include (default: any) and does not
+// match --exclude (default: codebooks and embedding tables, which are looked
+// up by row or compared by distance rather than multiplied).
+//
+// At runtime Q8_0 weights feed lm_ggml_mul_mat directly unless
+// CODEC_MAT_NATIVE_QUANT=0, other quantized types are cast to F32 in the graph
+// (see codec_graph_native_quant); conv weights feed it directly only when their
+// kernel taps fill whole blocks, the rest of a conv stays in its stored float type.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "ggml.h"
+#include "gguf.h"
+
+static bool parse_type(const std::string & name, lm_ggml_type * out) {
+    for (int t = 0; t < LM_GGML_TYPE_COUNT; ++t) {
+        const char * tn = lm_ggml_type_name((lm_ggml_type) t);
+        if (tn == nullptr || !lm_ggml_is_quantized((lm_ggml_type) t)) {
+            continue;
+        }
+        std::string lower = name;
+        for (char & c : lower) c = (char) std::tolower((unsigned char) c);
+        if (lower == tn) {
+            *out = (lm_ggml_type) t;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void to_f32(const lm_ggml_tensor * t, std::vector<float> & out) {
+    const int64_t n = lm_ggml_nelements(t);
+    out.resize((size_t) n);
+    switch (t->type) {
+        case LM_GGML_TYPE_F32:
+            std::memcpy(out.data(), t->data, (size_t) n * sizeof(float));
+            break;
+        case LM_GGML_TYPE_F16:
+            lm_ggml_fp16_to_fp32_row((const lm_ggml_fp16_t *) t->data, out.data(), n);
+            break;
+        case LM_GGML_TYPE_BF16:
+            lm_ggml_bf16_to_fp32_row((const lm_ggml_bf16_t *) t->data, out.data(), n);
+            break;
+        default:
+            out.clear();
+            break;
+    }
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 4) {
+        std::fprintf(stderr,
+            "usage: codec_quantize IN.gguf OUT.gguf TYPE [--include REGEX] [--exclude REGEX]\n"
+            "                      [--min-elements N] [--dry-run]\n"
+            "  TYPE: q8_0, q6_K, q5_K, q4_K, q4_0, ...\n");
+        return 2;
+    }
+
+    const std::string path_in  = argv[1];
+    const std::string path_out = argv[2];
+    lm_ggml_type qtype = LM_GGML_TYPE_COUNT;
+    if (!parse_type(argv[3], &qtype)) {
+        std::fprintf(stderr, "unknown quantization type: %s\n", argv[3]);
+        return 2;
+    }
+    if (lm_ggml_quantize_requires_imatrix(qtype)) {
+        std::fprintf(stderr, "%s needs an importance matrix, which codec_quantize does not compute\n", argv[3]);
+        return 2;
+    }
+
+    std::string include;
+    std::string exclude = "codebook|embed|embd|(^|\\.)emb(\\.|$)";
+    int64_t min_elements = 4096;
+    bool dry_run = false;
+    for (int i = 4; i < argc; ++i) {
+        auto is = [&](const char * k) { return std::strcmp(argv[i], k) == 0; };
+        if      (is("--include")      && i + 1 < argc) include      = argv[++i];
+        else if (is("--exclude")      && i + 1 < argc) exclude      = argv[++i];
+        else if (is("--min-elements") && i + 1 < argc) min_elements = std::atoll(argv[++i]);
+        else if (is("--dry-run"))                      dry_run      = true;
+        else { std::fprintf(stderr, "unknown arg: %s\n", argv[i]); return 2; }
+    }
+
+    std::regex re_include;
+    std::regex re_exclude;
+    try {
+        re_include = std::regex(include.empty() ? ".*" : include);
+        re_exclude = std::regex(exclude.empty() ? "$^" : exclude);
+    } catch (const std::regex_error & e) {
+        std::fprintf(stderr, "invalid regex: %s\n", e.what());
+        return 2;
+    }
+
+    lm_ggml_context * ctx_data = nullptr;
+    lm_gguf_init_params gparams = { /* .no_alloc = */ false, /* .ctx = */ &ctx_data };
+    lm_gguf_context * gin = lm_gguf_init_from_file(path_in.c_str(), gparams);
+    if (gin == nullptr) {
+        std::fprintf(stderr, "failed to read %s\n", path_in.c_str());
+        return 1;
+    }
+
+    lm_gguf_context * gout = lm_gguf_init_empty();
+    lm_gguf_set_kv(gout, gin);
+    lm_gguf_set_val_u32(gout, "general.quantization_version", LM_GGML_QNT_VERSION);
+
+    // quantized buffers must outlive lm_gguf_write_to_file
+    std::vector<std::vector<uint8_t>> qdata;
+    std::vector<float> f32;
+
+    const int64_t blck = lm_ggml_blck_size(qtype);
+    size_t n_bytes_in  = 0;
+    size_t n_bytes_out = 0;
+    int    n_quantized = 0;
+
+    const int64_t n_tensors = lm_gguf_get_n_tensors(gin);
+    for (int64_t i = 0; i < n_tensors; ++i) {
+        const char * name = lm_gguf_get_tensor_name(gin, i);
+        lm_ggml_tensor * t = lm_ggml_get_tensor(ctx_data, name);
+        lm_gguf_add_tensor(gout, t);
+        n_bytes_in += lm_ggml_nbytes(t);
+
+        const bool eligible =
+            (t->type == LM_GGML_TYPE_F32 || t->type == LM_GGML_TYPE_F16 || t->type == LM_GGML_TYPE_BF16) &&
+            lm_ggml_n_dims(t) >= 2 &&
+            t->ne[0] % blck == 0 &&
+            lm_ggml_nelements(t) >= min_elements &&
+            std::regex_search(name, re_include) &&
+            !std::regex_search(name, re_exclude);
+        if (!eligible) {
+            n_bytes_out += lm_ggml_nbytes(t);
+            continue;
+        }
+
+        to_f32(t, f32);
+        const int64_t n_per_row = t->ne[0];
+        const int64_t n_rows    = lm_ggml_nelements(t) / n_per_row;
+        qdata.emplace_back(lm_ggml_row_size(qtype, n_per_row) * (size_t) n_rows);
+        const size_t n_written = lm_ggml_quantize_chunk(qtype, f32.data(), qdata.back().data(), 0, n_rows, n_per_row, nullptr);
+
+        lm_gguf_set_tensor_type(gout, name, qtype);
+        lm_gguf_set_tensor_data(gout, name, qdata.back().data());
+        n_bytes_out += n_written;
+        n_quantized++;
+
+        std::printf("%-48s %-5s -> %-5s [%lld, %lld, %lld]\n", name, lm_ggml_type_name(t->type),
+                    lm_ggml_type_name(qtype), (long long) t->ne[0], (long long) t->ne[1], (long long) t->ne[2]);
+    }
+
+    std::printf("quantized %d / %lld tensors: %.2f MiB -> %.2f MiB\n", n_quantized, (long long) n_tensors,
+                n_bytes_in / 1024.0 / 1024.0, n_bytes_out / 1024.0 / 1024.0);
+
+    bool ok = true;
+    if (!dry_run) {
+        ok = lm_gguf_write_to_file(gout, path_out.c_str(), false);
+        if (!ok) {
+            std::fprintf(stderr, "failed to write %s\n", path_out.c_str());
+        }
+    }
+
+    lm_ggml_quantize_free();
+    lm_gguf_free(gout);
+    lm_gguf_free(gin);
+    lm_ggml_free(ctx_data);
+    return ok ? 0 : 1;
+}
@@ -1144,6 +1144,339 @@ bool test_state_reuse() {
     }
 }
 
+// Test: idle conversations are spilled out of the KV cache and paged back in on a prefix match
+bool test_kv_spill() {
+    try {
+        for (const std::string spill_dir : { "", "/tmp" }) {
+            llama_rn_context ctx;
+
+            common_params params;
+            params.model.path = "../tiny-random-llama.gguf";
+            params.n_ctx = 512;
+            params.n_batch = 128;
+            params.n_parallel = 1;
+            params.cpuparams.n_threads = 1;
+            params.n_gpu_layers = 0;
+            params.no_kv_offload = true;
+            params.n_predict = 2;
+
+            if (!ctx.loadModel(params)) {
+                std::cout << "[SKIP: Model not loaded] ";
+                return true;
+            }
+
+            ctx.enableParallelMode(1, 128);
+            ctx.slot_manager->set_spill_config(4, 0, spill_dir);
+
+            auto run = [&](const std::vector<llama_token>& prompt, int32_t& cache_n) {
+                bool complete = false;
+                int32_t req_id = ctx.slot_manager->queue_request(
+                    params, prompt, std::vector<std::string>(), "", 0, COMMON_REASONING_FORMAT_NONE, "", "", "", "", "", "", -1, -1,
+                    [&](const completion_token_output& token) {},
+                    [&](llama_rn_slot* slot) {
+                        cache_n = slot->n_prompt_tokens_cache;
+                        complete = !slot->incomplete;
+                    }
+                );
+                for (int i = 0; req_id >= 0 && !complete && i < 100; i++) {
+                    ctx.slot_manager->update_slots();
+                }
+                return complete;
+            };
+
+            const std::vector<llama_token> prompt_a = common_tokenize(ctx.ctx, "Hello world, this is the first conversation", false);
+            const std::vector<llama_token> prompt_b = common_tokenize(ctx.ctx, "Another topic entirely", false);
+            std::vector<llama_token> prompt_a2 = prompt_a;
+            const std::vector<llama_token> extra = common_tokenize(ctx.ctx, " and more", false);
+            prompt_a2.insert(prompt_a2.end(), extra.begin(), extra.end());
+
+            int32_t cache_n = -1;
+            if (!run(prompt_a, cache_n) || !run(prompt_b, cache_n)) {
+                std::cout << "[Request did not complete] ";
+                return false;
+            }
+
+            // The single slot was handed to B - A must have been spilled
+            if (ctx.slot_manager->spilled.size() != 1) {
+                std::cout << "[Expected 1 spilled entry, got " << ctx.slot_manager->spilled.size() << "] ";
+                return false;
+            }
+
+            if (!run(prompt_a2, cache_n)) {
+                std::cout << "[Resumed request did not complete] ";
+                return false;
+            }
+
+            // A was paged back in (and B spilled in its place)
+            if (cache_n < (int32_t) prompt_a.size() - 1 || ctx.slot_manager->spilled.size() != 1) {
+                std::cout << "[Spilled prefix not reused: cache_n=" << cache_n << "] ";
+                return false;
+            }
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "[Exception: " << e.what() << "] ";
+        return false;
+    } catch (...) {
+        std::cout << "[Unknown exception] ";
+        return false;
+    }
+}
+
+bool test_ngram_speculative() {
+    try {
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 1024;
+        params.n_batch = 128;
+        params.n_parallel = 2;
+        params.cpuparams.n_threads = 1;
+        params.n_gpu_layers = 0;
+        params.no_kv_offload = true;
+        params.n_predict = 48;
+        params.sampling.temp = 0.0f;
+
+        // Generate with and without n-gram drafts; greedy verification must
+        // not change the output
+        auto generate = [&](bool speculative, std::vector<std::vector<llama_token>>& outputs, size_t& n_drafted) {
+            llama_rn_context ctx;
+            common_params run_params = params;
+            if (speculative) {
+                run_params.speculative.types = { COMMON_SPECULATIVE_TYPE_NGRAM_SIMPLE };
+                run_params.speculative.ngram_simple.size_n = 1;
+                run_params.speculative.ngram_simple.size_m = 4;
+            }
+            if (!ctx.loadModel(run_params)) {
+                return false;
+            }
+            ctx.enableParallelMode(2, 128);
+
+            const std::vector<std::string> prompts = {
+                "one two three one two three one two three one two",
+                "red green blue red green blue red green",
+            };
+            outputs.assign(prompts.size(), {});
+            int completed = 0;
+            n_drafted = 0;
+            for (size_t i = 0; i < prompts.size(); i++) {
+                const std::vector<llama_token> prompt = common_tokenize(ctx.ctx, prompts[i], false);
+                ctx.slot_manager->queue_request(
+                    run_params, prompt, std::vector<std::string>(), "", 0, COMMON_REASONING_FORMAT_NONE, "", "", "", "", "", "", -1, -1,
+                    [&, i](const completion_token_output& token) { outputs[i].push_back(token.tok); },
+                    [&](llama_rn_slot* slot) {
+                        n_drafted += slot->num_draft_tokens;
+                        completed++;
+                    }
+                );
+            }
+            for (int iter = 0; completed < (int) prompts.size() && iter < 500; iter++) {
+                ctx.slot_manager->update_slots();
+            }
+            return completed == (int) prompts.size();
+        };
+
+        std::vector<std::vector<llama_token>> baseline, speculative;
+        size_t n_drafted_baseline = 0, n_drafted = 0;
+        if (!generate(false, baseline, n_drafted_baseline)) {
+            std::cout << "[SKIP: Model not loaded] ";
+            return true;
+        }
+        if (!generate(true, speculative, n_drafted)) {
+            std::cout << "[Speculative requests did not complete] ";
+            return false;
+        }
+
+        std::cout << "[drafted " << n_drafted << "] ";
+        if (n_drafted_baseline != 0 || n_drafted == 0) {
+            return false;
+        }
+        return baseline == speculative;
+    } catch (const std::exception& e) {
+        std::cout << "[Exception: " << e.what() << "] ";
+        return false;
+    } catch (...) {
+        std::cout << "[Unknown exception] ";
+        return false;
+    }
+}
+
+// Test: draft trees decode their branches as spare sequences of a unified KV cache
+bool test_tree_speculative() {
+    try {
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 1024;
+        params.n_batch = 128;
+        params.n_parallel = 6; // 2 slots + 4 spare sequences for branches
+        params.kv_unified = true;
+        params.cpuparams.n_threads = 1;
+        params.n_gpu_layers = 0;
+        params.no_kv_offload = true;
+        params.n_predict = 128;
+        params.sampling.temp = 0.0f;
+
+        // Greedy output must match plain decoding whatever the tree looks like
+        auto generate = [&](bool speculative, std::vector<std::vector<llama_token>>& outputs, size_t& n_drafted) {
+            llama_rn_context ctx;
+            common_params run_params = params;
+            if (speculative) {
+                run_params.speculative.types = { COMMON_SPECULATIVE_TYPE_NGRAM_SIMPLE };
+                run_params.speculative.ngram_simple.size_n = 1;
+                run_params.speculative.ngram_simple.size_m = 4;
+                run_params.speculative.tree.n_branch = 3;
+                run_params.speculative.tree.n_nodes = 8;
+            }
+            if (!ctx.loadModel(run_params)) {
+                return false;
+            }
+            ctx.enableParallelMode(2, 128);
+
+            const std::vector<std::string> prompts = {
+                "one two three one two four one two five one two three one two",
+                "red green blue red green red green yellow red green blue red",
+            };
+            outputs.assign(prompts.size(), {});
+            int completed = 0;
+            n_drafted = 0;
+            for (size_t i = 0; i < prompts.size(); i++) {
+                const std::vector<llama_token> prompt = common_tokenize(ctx.ctx, prompts[i], false);
+                ctx.slot_manager->queue_request(
+                    run_params, prompt, std::vector<std::string>(), "", 0, COMMON_REASONING_FORMAT_NONE, "", "", "", "", "", "", -1, -1,
+                    [&, i](const completion_token_output& token) { outputs[i].push_back(token.tok); },
+                    [&](llama_rn_slot* slot) {
+                        n_drafted += slot->num_draft_tokens;
+                        completed++;
+                    }
+                );
+            }
+            for (int iter = 0; completed < (int) prompts.size() && iter < 500; iter++) {
+                ctx.slot_manager->update_slots();
+            }
+
+            // Branch sequences must not outlive the step that verified them
+            auto * mem = llama_get_memory(ctx.ctx);
+            for (llama_seq_id seq = 2; seq < (llama_seq_id) llama_n_seq_max(ctx.ctx); seq++) {
+                if (llama_memory_seq_pos_max(mem, seq) >= 0) {
+                    std::cout << "[sequence " << seq << " still in use] ";
+                    return false;
+                }
+            }
+            return completed == (int) prompts.size();
+        };
+
+        std::vector<std::vector<llama_token>> baseline, speculative;
+        size_t n_drafted_baseline = 0, n_drafted = 0;
+        if (!generate(false, baseline, n_drafted_baseline)) {
+            std::cout << "[SKIP: Model not loaded] ";
+            return true;
+        }
+        if (!generate(true, speculative, n_drafted)) {
+            std::cout << "[Tree requests did not complete] ";
+            return false;
+        }
+
+        std::cout << "[drafted " << n_drafted << "] ";
+        if (n_drafted == 0) {
+            return false;
+        }
+        return baseline == speculative;
+    } catch (const std::exception& e) {
+        std::cout << "[Exception: " << e.what() << "] ";
+        return false;
+    } catch (...) {
+        std::cout << "[Unknown exception] ";
+        return false;
+    }
+}
+
+// Test: the adaptive controller only picks draft lengths, so greedy output is unchanged
+bool test_adaptive_speculative() {
+    try {
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 1024;
+        params.n_batch = 128;
+        params.n_parallel = 2;
+        params.cpuparams.n_threads = 1;
+        params.n_gpu_layers = 0;
+        params.no_kv_offload = true;
+        params.n_predict = 96;
+        params.sampling.temp = 0.0f;
+
+        auto generate = [&](bool speculative, std::vector<std::vector<llama_token>>& outputs,
+                            std::vector<slot_timings>& timings) {
+            llama_rn_context ctx;
+            common_params run_params = params;
+            if (speculative) {
+                run_params.speculative.types = { COMMON_SPECULATIVE_TYPE_NGRAM_SIMPLE };
+                run_params.speculative.ngram_simple.size_n = 1;
+                run_params.speculative.ngram_simple.size_m = 8;
+                run_params.speculative.adaptive.enabled = true;
+                run_params.speculative.adaptive.n_probe = 4;
+            }
+            if (!ctx.loadModel(run_params)) {
+                return false;
+            }
+            ctx.enableParallelMode(2, 128);
+
+            const std::vector<std::string> prompts = {
+                "one two three one two four one two five one two three one two",
+                "the quick brown fox jumps over the lazy dog",
+            };
+            outputs.assign(prompts.size(), {});
+            timings.assign(prompts.size(), {});
+            int completed = 0;
+            for (size_t i = 0; i < prompts.size(); i++) {
+                const std::vector<llama_token> prompt = common_tokenize(ctx.ctx, prompts[i], false);
+                ctx.slot_manager->queue_request(
+                    run_params, prompt, std::vector<std::string>(), "", 0, COMMON_REASONING_FORMAT_NONE, "", "", "", "", "", "", -1, -1,
+                    [&, i](const completion_token_output& token) { outputs[i].push_back(token.tok); },
+                    [&, i](llama_rn_slot* slot) {
+                        timings[i] = slot->get_timings();
+                        completed++;
+                    }
+                );
+            }
+            for (int iter = 0; completed < (int) prompts.size() && iter < 500; iter++) {
+                ctx.slot_manager->update_slots();
+            }
+            return completed == (int) prompts.size();
+        };
+
+        std::vector<std::vector<llama_token>> baseline, adaptive;
+        std::vector<slot_timings> timings_baseline, timings;
+        if (!generate(false, baseline, timings_baseline)) {
+            std::cout << "[SKIP: Model not loaded] ";
+            return true;
+        }
+        if (!generate(true, adaptive, timings)) {
+            std::cout << "[Adaptive requests did not complete] ";
+            return false;
+        }
+
+        for (const auto& t : timings_baseline) {
+            if (t.draft_n != -1) {
+                std::cout << "[draft_n set without the controller] ";
+                return false;
+            }
+        }
+        for (const auto& t : timings) {
+            std::cout << "[draft_n " << t.draft_n << ", p " << t.draft_acceptance << "] ";
+            if (t.draft_n < 0 || t.draft_acceptance <= 0.0 || t.draft_acceptance >= 1.0) {
+                return false;
+            }
+        }
+        return baseline == adaptive;
+    } catch (const std::exception& e) {
+        std::cout << "[Exception: " << e.what() << "] ";
+        return false;
+    } catch (...) {
+        std::cout << "[Unknown exception] ";
+        return false;
+    }
+}
+
 // Test 23: Status API - get_status() basic functionality
 bool test_status_api_basic() {
     try {
@@ -1552,6 +1885,10 @@ int main() {
     results.run_test("Queue Overflow Handling", test_queue_overflow());
     results.run_test("Queue Request with State", test_queue_request_with_state());
     results.run_test("State Reuse", test_state_reuse());
+    results.run_test("KV Spill for Idle Slots", test_kv_spill());
+    results.run_test("N-gram Speculative Decoding", test_ngram_speculative());
+    results.run_test("Tree Speculative Decoding", test_tree_speculative());
+    results.run_test("Adaptive Draft Length", test_adaptive_speculative());
 
     std::cout << "\n--- Status API Tests ---" << std::endl;
 
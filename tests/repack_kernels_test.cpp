@@ -0,0 +1,407 @@
+// Repack kernel tests (host-only: no model).
+//
+// Runs the arch-specific gemv/gemm kernels for the 8x8-interleaved q4_1 and
+// q5_0 weights against their *_generic reference on random blocks. Both sides
+// read the same interleaved layout, so the blocks are filled with random bytes
+// directly instead of going through the (static) repack functions.
+//
+// The generic kernels share the interleaved layout with the AVX2 ones, so a
+// second set of tests quantizes plain float weights, repacks them through a
+// CPU_REPACK buffer and compares both kernels against the dot products of the
+// dequantized (un-repacked) weights and activations.
+//
+// Built like the probe targets (-march=native, LM_GGML_CPU_GENERIC undefined);
+// without AVX2 the public kernels are the generic ones and the test is skipped.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ggml-alloc.h"
+#include "ggml-backend.h"
+#include "ggml-cpu.h"
+#include "repack.h"
+
+// Test result tracking (same shape as simple_test.cpp)
+struct TestResults {
+    int total_tests = 0;
+    int passed_tests = 0;
+
+    void run_test(const std::string& name, bool result) {
+        total_tests++;
+        std::cout << "TEST: " << name << " ... ";
+        if (result) {
+            std::cout << "PASSED" << std::endl;
+            passed_tests++;
+        } else {
+            std::cout << "FAILED" << std::endl;
+        }
+    }
+
+    void print_summary() {
+        std::cout << "\n=== Test Summary ===" << std::endl;
+        std::cout << "Total tests: " << total_tests << std::endl;
+        std::cout << "Passed: " << passed_tests << std::endl;
+        std::cout << "Failed: " << (total_tests - passed_tests) << std::endl;
+    }
+};
+
+#if defined(__AVX2__)
+
+typedef void (*repack_kernel_fn)(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc);
+
+static std::mt19937 rng(1234);
+
+static void fill_bytes(void * dst, size_t size) {
+    std::uniform_int_distribution<int> dist(0, 255);
+    uint8_t * p = (uint8_t *) dst;
+    for (size_t i = 0; i < size; i++) {
+        p[i] = (uint8_t) dist(rng);
+    }
+}
+
+// q8_0 quants as quantize_row_q8_0 produces them: the AVX2 kernels rely on -128 never occurring
+static void fill_q8(int8_t * dst, size_t count) {
+    std::uniform_int_distribution<int> dist(-127, 127);
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (int8_t) dist(rng);
+    }
+}
+
+static lm_ggml_half random_half(float lo, float hi) {
+    std::uniform_real_distribution<float> dist(lo, hi);
+    return lm_ggml_fp32_to_fp16(dist(rng));
+}
+
+// nc / 8 rows of n / QK8_0 interleaved blocks, as the CPU_REPACK buffer stores them
+static std::vector<block_q4_1x8> random_q4_1x8(int n, int nc) {
+    std::vector<block_q4_1x8> w((size_t) (nc / 8) * (n / QK8_0));
+    for (auto & b : w) {
+        for (int i = 0; i < 8; i++) {
+            b.d[i] = random_half(0.001f, 0.02f);
+            b.m[i] = random_half(-0.1f, 0.1f);
+        }
+        fill_bytes(b.qs, sizeof(b.qs));
+    }
+    return w;
+}
+
+static std::vector<block_q5_0x8> random_q5_0x8(int n, int nc) {
+    std::vector<block_q5_0x8> w((size_t) (nc / 8) * (n / QK8_0));
+    for (auto & b : w) {
+        for (int i = 0; i < 8; i++) {
+            b.d[i] = random_half(-0.02f, 0.02f);
+        }
+        fill_bytes(b.qh, sizeof(b.qh));
+        fill_bytes(b.qs, sizeof(b.qs));
+    }
+    return w;
+}
+
+// one row of q8_0 activations for gemv
+static std::vector<block_q8_0> random_q8_0(int n) {
+    std::vector<block_q8_0> y(n / QK8_0);
+    for (auto & b : y) {
+        b.d = random_half(0.001f, 0.05f);
+        fill_q8(b.qs, sizeof(b.qs));
+    }
+    return y;
+}
+
+// nr / 4 groups of 4 interleaved q8_0 rows for gemm
+static std::vector<block_q8_0x4> random_q8_0x4(int n, int nr) {
+    std::vector<block_q8_0x4> y((size_t) (nr / 4) * (n / QK8_0));
+    for (auto & b : y) {
+        for (int i = 0; i < 4; i++) {
+            b.d[i] = random_half(0.001f, 0.05f);
+        }
+        fill_q8(b.qs, sizeof(b.qs));
+    }
+    return y;
+}
+
+// both kernels only differ in float accumulation order
+static bool outputs_match(const std::vector<float> & got, const std::vector<float> & ref, float rel_tol = 1e-4f) {
+    float max_ref = 0.0f;
+    for (float v : ref) {
+        max_ref = std::max(max_ref, std::fabs(v));
+    }
+    if (max_ref == 0.0f) {
+        std::cout << "[reference is all zeros] ";
+        return false;
+    }
+    const float tol = rel_tol * std::max(max_ref, 1.0f);
+    for (size_t i = 0; i < ref.size(); i++) {
+        if (!std::isfinite(got[i]) || std::fabs(got[i] - ref[i]) > tol) {
+            std::cout << "[index " << i << ": got " << got[i] << ", expected " << ref[i] << "] ";
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_gemv(repack_kernel_fn kernel, repack_kernel_fn generic, const void * vx, int n, int nc) {
+    const std::vector<block_q8_0> y = random_q8_0(n);
+    std::vector<float> got(nc, NAN);
+    std::vector<float> ref(nc, NAN);
+    kernel(n, got.data(), nc, vx, y.data(), 1, nc);
+    generic(n, ref.data(), nc, vx, y.data(), 1, nc);
+    return outputs_match(got, ref);
+}
+
+static bool check_gemm(repack_kernel_fn kernel, repack_kernel_fn generic, const void * vx, int n, int nr, int nc) {
+    const std::vector<block_q8_0x4> y = random_q8_0x4(n, nr);
+    std::vector<float> got((size_t) nr * nc, NAN);
+    std::vector<float> ref((size_t) nr * nc, NAN);
+    kernel(n, got.data(), nc, vx, y.data(), nr, nc);
+    generic(n, ref.data(), nc, vx, y.data(), nr, nc);
+    return outputs_match(got, ref);
+}
+
+static const int SHAPE_N[]  = { 32, 256, 4096 };
+static const int SHAPE_NC[] = { 8, 24, 64 };
+static const int SHAPE_NR[] = { 4, 8, 20 };
+
+bool test_q4_1_8x8_gemv() {
+    try {
+        for (int n : SHAPE_N) {
+            for (int nc : SHAPE_NC) {
+                const auto w = random_q4_1x8(n, nc);
+                if (!check_gemv(lm_ggml_gemv_q4_1_8x8_q8_0, lm_ggml_gemv_q4_1_8x8_q8_0_generic, w.data(), n, nc)) {
+                    std::cout << "[n=" << n << " nc=" << nc << "] ";
+                    return false;
+                }
+            }
+        }
+        return true;
+    } catch (const std::exception & e) {
+        std::cout << "[" << e.what() << "] ";
+        return false;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool test_q4_1_8x8_gemm() {
+    try {
+        for (int n : SHAPE_N) {
+            for (int nc : SHAPE_NC) {
+                const auto w = random_q4_1x8(n, nc);
+                for (int nr : SHAPE_NR) {
+                    if (!check_gemm(lm_ggml_gemm_q4_1_8x8_q8_0, lm_ggml_gemm_q4_1_8x8_q8_0_generic, w.data(), n, nr, nc)) {
+                        std::cout << "[n=" << n << " nr=" << nr << " nc=" << nc << "] ";
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    } catch (const std::exception & e) {
+        std::cout << "[" << e.what() << "] ";
+        return false;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool test_q5_0_8x8_gemv() {
+    try {
+        for (int n : SHAPE_N) {
+            for (int nc : SHAPE_NC) {
+                const auto w = random_q5_0x8(n, nc);
+                if (!check_gemv(lm_ggml_gemv_q5_0_8x8_q8_0, lm_ggml_gemv_q5_0_8x8_q8_0_generic, w.data(), n, nc)) {
+                    std::cout << "[n=" << n << " nc=" << nc << "] ";
+                    return false;
+                }
+            }
+        }
+        return true;
+    } catch (const std::exception & e) {
+        std::cout << "[" << e.what() << "] ";
+        return false;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool test_q5_0_8x8_gemm() {
+    try {
+        for (int n : SHAPE_N) {
+            for (int nc : SHAPE_NC) {
+                const auto w = random_q5_0x8(n, nc);
+                for (int nr : SHAPE_NR) {
+                    if (!check_gemm(lm_ggml_gemm_q5_0_8x8_q8_0, lm_ggml_gemm_q5_0_8x8_q8_0_generic, w.data(), n, nr, nc)) {
+                        std::cout << "[n=" << n << " nr=" << nr << " nc=" << nc << "] ";
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    } catch (const std::exception & e) {
+        std::cout << "[" << e.what() << "] ";
+        return false;
+    } catch (...) {
+        return false;
+    }
+}
+
+static std::vector<float> random_floats(size_t count) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> v(count);
+    for (float & f : v) {
+        f = dist(rng);
+    }
+    return v;
+}
+
+// quantizes and dequantizes nrows rows of n floats, i.e. the values a kernel sees
+static std::vector<float> quantized_values(lm_ggml_type type, const std::vector<float> & x, int nrows, int n) {
+    std::vector<uint8_t> q(lm_ggml_row_size(type, n) * nrows);
+    lm_ggml_quantize_chunk(type, x.data(), q.data(), 0, nrows, n, nullptr);
+    std::vector<float> out(x.size());
+    lm_ggml_get_type_traits(type)->to_float(q.data(), out.data(), (int64_t) nrows * n);
+    return out;
+}
+
+// dst[r * nc + c] = dot(row c of w, row r of x) on dequantized values
+static std::vector<float> reference_matmul(const std::vector<float> & w, const std::vector<float> & x, int n, int nr, int nc) {
+    std::vector<float> dst((size_t) nr * nc);
+    for (int r = 0; r < nr; r++) {
+        for (int c = 0; c < nc; c++) {
+            double sum = 0.0;
+            for (int k = 0; k < n; k++) {
+                sum += (double) w[(size_t) c * n + k] * x[(size_t) r * n + k];
+            }
+            dst[(size_t) r * nc + c] = (float) sum;
+        }
+    }
+    return dst;
+}
+
+// Quantizes random weights to `type`, repacks them through the CPU_REPACK buffer
+// and checks gemv (one activation row) and gemm (4-row interleaved activations)
+// of both the AVX2 and the generic kernel against reference_matmul.
+static bool check_repacked_vs_dequant(lm_ggml_type type, repack_kernel_fn gemv, repack_kernel_fn gemv_generic,
+                                      repack_kernel_fn gemm, repack_kernel_fn gemm_generic) {
+    for (int n : SHAPE_N) {
+        for (int nc : SHAPE_NC) {
+            lm_ggml_init_params ip = { /*.mem_size =*/ lm_ggml_tensor_overhead(), /*.mem_buffer =*/ nullptr, /*.no_alloc =*/ true };
+            lm_ggml_context * ctx = lm_ggml_init(ip);
+            lm_ggml_tensor * t = lm_ggml_new_tensor_2d(ctx, type, n, nc);
+            lm_ggml_backend_buffer_t buf = lm_ggml_backend_alloc_ctx_tensors_from_buft(ctx, lm_ggml_backend_cpu_repack_buffer_type());
+            if (buf == nullptr || t->extra == nullptr) {
+                std::cout << "[no repack traits for " << lm_ggml_type_name(type) << "] ";
+                lm_ggml_backend_buffer_free(buf);
+                lm_ggml_free(ctx);
+                return false;
+            }
+
+            const std::vector<float> w = random_floats((size_t) nc * n);
+            std::vector<uint8_t> w_q(lm_ggml_nbytes(t));
+            lm_ggml_quantize_chunk(type, w.data(), w_q.data(), 0, nc, n, nullptr);
+            lm_ggml_backend_tensor_set(t, w_q.data(), 0, w_q.size());
+            const std::vector<float> w_ref = quantized_values(type, w, nc, n);
+
+            bool ok = true;
+            {
+                const std::vector<float> x = random_floats(n);
+                std::vector<uint8_t> y(lm_ggml_row_size(LM_GGML_TYPE_Q8_0, n));
+                lm_ggml_quantize_chunk(LM_GGML_TYPE_Q8_0, x.data(), y.data(), 0, 1, n, nullptr);
+                const std::vector<float> ref = reference_matmul(w_ref, quantized_values(LM_GGML_TYPE_Q8_0, x, 1, n), n, 1, nc);
+
+                std::vector<float> got(nc, NAN);
+                std::vector<float> got_generic(nc, NAN);
+                gemv(n, got.data(), nc, t->data, y.data(), 1, nc);
+                gemv_generic(n, got_generic.data(), nc, t->data, y.data(), 1, nc);
+                ok = outputs_match(got, ref, 1e-3f) && outputs_match(got_generic, ref, 1e-3f);
+                if (!ok) {
+                    std::cout << "[gemv n=" << n << " nc=" << nc << "] ";
+                }
+            }
+            for (int nr : SHAPE_NR) {
+                if (!ok) {
+                    break;
+                }
+                const std::vector<float> x = random_floats((size_t) nr * n);
+                std::vector<block_q8_0x4> y((size_t) (nr / 4) * (n / QK8_0));
+                for (int r = 0; r < nr; r += 4) {
+                    lm_ggml_quantize_mat_q8_0_4x8(x.data() + (size_t) r * n, y.data() + (size_t) (r / 4) * (n / QK8_0), n);
+                }
+                const std::vector<float> ref = reference_matmul(w_ref, quantized_values(LM_GGML_TYPE_Q8_0, x, nr, n), n, nr, nc);
+
+                std::vector<float> got((size_t) nr * nc, NAN);
+                std::vector<float> got_generic((size_t) nr * nc, NAN);
+                gemm(n, got.data(), nc, t->data, y.data(), nr, nc);
+                gemm_generic(n, got_generic.data(), nc, t->data, y.data(), nr, nc);
+                ok = outputs_match(got, ref, 1e-3f) && outputs_match(got_generic, ref, 1e-3f);
+                if (!ok) {
+                    std::cout << "[gemm n=" << n << " nr=" << nr << " nc=" << nc << "] ";
+                }
+            }
+
+            lm_ggml_backend_buffer_free(buf);
+            lm_ggml_free(ctx);
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool test_q4_1_8x8_repacked_vs_dequant() {
+    try {
+        return check_repacked_vs_dequant(LM_GGML_TYPE_Q4_1,
+            lm_ggml_gemv_q4_1_8x8_q8_0, lm_ggml_gemv_q4_1_8x8_q8_0_generic,
+            lm_ggml_gemm_q4_1_8x8_q8_0, lm_ggml_gemm_q4_1_8x8_q8_0_generic);
+    } catch (const std::exception & e) {
+        std::cout << "[" << e.what() << "] ";
+        return false;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool test_q5_0_8x8_repacked_vs_dequant() {
+    try {
+        return check_repacked_vs_dequant(LM_GGML_TYPE_Q5_0,
+            lm_ggml_gemv_q5_0_8x8_q8_0, lm_ggml_gemv_q5_0_8x8_q8_0_generic,
+            lm_ggml_gemm_q5_0_8x8_q8_0, lm_ggml_gemm_q5_0_8x8_q8_0_generic);
+    } catch (const std::exception & e) {
+        std::cout << "[" << e.what() << "] ";
+        return false;
+    } catch (...) {
+        return false;
+    }
+}
+
+#endif // __AVX2__
+
+int main() {
+    std::cout << "=== repack kernel tests ===" << std::endl;
+
+#if defined(__AVX2__)
+    // the fp16 conversion table, without it every scale reads as 0
+    lm_ggml_cpu_init();
+
+    TestResults results;
+    results.run_test("q4_1 8x8 gemv AVX2 == generic", test_q4_1_8x8_gemv());
+    results.run_test("q4_1 8x8 gemm AVX2 == generic", test_q4_1_8x8_gemm());
+    results.run_test("q5_0 8x8 gemv AVX2 == generic", test_q5_0_8x8_gemv());
+    results.run_test("q5_0 8x8 gemm AVX2 == generic", test_q5_0_8x8_gemm());
+    results.run_test("q4_1 8x8 repacked == dequantized reference", test_q4_1_8x8_repacked_vs_dequant());
+    results.run_test("q5_0 8x8 repacked == dequantized reference", test_q5_0_8x8_repacked_vs_dequant());
+
+    results.print_summary();
+    return results.passed_tests == results.total_tests ? 0 : 1;
+#else
+    std::cout << "skipped: built without AVX2, the public kernels are the generic ones" << std::endl;
+    return 0;
+#endif
+}
@@ -34,6 +34,12 @@ if [ ! -f "chat_parse_utf8_test" ]; then
     exit 1
 fi
 
+if [ ! -f "repack_kernels_test" ]; then
+    echo "Error: repack_kernels_test executable not found"
+    echo "Please run ./build_and_test.sh first"
+    exit 1
+fi
+
 echo "Found all test executables"
 
 TESTS_PASSED=0
@@ -75,10 +81,22 @@ fi
 
 echo ""
 
+# Run repack kernel tests (SIMD vs generic reference)
+echo "--- Running Repack Kernel Tests ---"
+if ./repack_kernels_test; then
+    echo "✓ Repack kernel tests passed"
+    TESTS_PASSED=$((TESTS_PASSED + 1))
+else
+    echo "✗ Repack kernel tests failed"
+    TESTS_FAILED=$((TESTS_FAILED + 1))
+fi
+
+echo ""
+
 # Run KV-cache-reuse tests (only if the GGUF models have been downloaded)
-TOTAL_SUITES=3
+TOTAL_SUITES=4
 if [ -f "kv_cache_reuse_test" ] && ls ../models/*.gguf >/dev/null 2>&1; then
-    TOTAL_SUITES=4
+    TOTAL_SUITES=5
     echo "--- Running KV-cache-reuse Tests ---"
     if ./kv_cache_reuse_test; then
         echo "✓ KV-cache-reuse tests passed"
@@ -9,6 +9,27 @@
 #include "rn-completion.h"
 #include "rn-tts.h"
 #include "common.h"
+#include "llama-ext.h"
+#include "llama-mmap.h"
+#include "ngram-cache.h"
+#include "ggml-cpu.h"
+#include "gguf.h"
+#include "codec/src/ops/conv1d.h"
+#include "codec/src/ops/lm_attn.h"
+#include "codec/src/ops/lm_ggml_ops.h"
+#include "codec/src/runtime/graph.h"
+#include "codec/src/runtime/tensor_utils.h"
+#include "codec_lm.h"
+#include "mtmd-helper.h"
+#include "mtmd-helper-dedup.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
 
 using namespace rnllama;
 
@@ -136,6 +157,488 @@ bool test_tokenization() {
     }
 }
 
+// Parallel tokenization must give the same tokens as serial tokenization
+bool test_parallel_tokenization() {
+    try {
+        llama_rn_context ctx;
+
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 256;
+        params.n_batch = 32;
+        params.cpuparams.n_threads = 1;
+        params.n_gpu_layers = 0;
+
+        if (!ctx.loadModel(params)) {
+            return false;
+        }
+
+        const llama_vocab * vocab = llama_model_get_vocab(ctx.model);
+
+        // long enough to be split into several pieces, with special tokens and whitespace runs around the newlines
+        std::string text;
+        for (int i = 0; text.size() < 512*1024; ++i) {
+            text += "line " + std::to_string(i) + ": the quick brown fox,  jumps over the lazy dog!";
+            text += i % 7 == 0 ? " </s>\n" : i % 5 == 0 ? "\n\n  " : "\n";
+        }
+
+        for (const bool parse_special : { false, true }) {
+            const auto serial   = common_tokenize(vocab, text, true, parse_special, 1);
+            const auto parallel = common_tokenize(vocab, text, true, parse_special, 4);
+            if (serial.empty() || serial != parallel) {
+                std::cout << "Parallel tokens differ from serial (parse_special = " << parse_special << ")" << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Vocab-only GGUF with the given token list for the tokenizer tests, written to the temp directory
+// ids 1 and 2 are used as BOS/EOS; no space prefix so that raw text maps to tokens one to one
+static std::string make_vocab_test_model(const std::string & file, const std::string & tokenizer_model,
+        const std::string & tokenizer_pre, const std::string & name, const std::vector<std::string> & tokens,
+        const std::vector<int32_t> & token_types, const std::vector<std::string> & merges = {}) {
+    const std::string path = (std::filesystem::temp_directory_path() / file).string();
+
+    std::vector<const char *> token_ptrs;
+    for (const auto & t : tokens) {
+        token_ptrs.push_back(t.c_str());
+    }
+    std::vector<const char *> merge_ptrs;
+    for (const auto & m : merges) {
+        merge_ptrs.push_back(m.c_str());
+    }
+
+    lm_gguf_context * gguf = lm_gguf_init_empty();
+    lm_gguf_set_val_str (gguf, "general.architecture", "llama");
+    lm_gguf_set_val_str (gguf, "general.name", name.c_str());
+    lm_gguf_set_val_str (gguf, "tokenizer.ggml.model", tokenizer_model.c_str());
+    if (!tokenizer_pre.empty()) {
+        lm_gguf_set_val_str(gguf, "tokenizer.ggml.pre", tokenizer_pre.c_str());
+    }
+    lm_gguf_set_arr_str (gguf, "tokenizer.ggml.tokens", token_ptrs.data(), token_ptrs.size());
+    lm_gguf_set_arr_data(gguf, "tokenizer.ggml.token_type", LM_GGUF_TYPE_INT32, token_types.data(), token_types.size());
+    if (!merges.empty()) {
+        lm_gguf_set_arr_str(gguf, "tokenizer.ggml.merges", merge_ptrs.data(), merge_ptrs.size());
+    }
+    lm_gguf_set_val_u32 (gguf, "tokenizer.ggml.bos_token_id", 1);
+    lm_gguf_set_val_u32 (gguf, "tokenizer.ggml.eos_token_id", 2);
+    lm_gguf_set_val_bool(gguf, "tokenizer.ggml.add_space_prefix", false);
+
+    const bool ok = lm_gguf_write_to_file(gguf, path.c_str(), true);
+    lm_gguf_free(gguf);
+
+    return ok ? path : "";
+}
+
+static llama_model * load_vocab_test_model(const std::string & path) {
+    llama_model_params mparams = llama_model_default_params();
+    mparams.vocab_only = true;
+    return path.empty() ? nullptr : llama_model_load_from_file(path.c_str(), mparams);
+}
+
+// Test the special token partition (single-pass matcher) against fixed ids: overlapping special tokens,
+// repeated and self-overlapping occurrences, rstrip/lstrip next to other special tokens and parse_special off
+bool test_special_token_partition() {
+    try {
+        struct partition_case {
+            const char *             text;
+            bool                     parse_special;
+            std::vector<llama_token> expected;
+        };
+
+        auto check = [](const llama_vocab * vocab, const std::vector<partition_case> & cases) {
+            for (const auto & c : cases) {
+                const auto got = common_tokenize(vocab, c.text, false, c.parse_special);
+                if (got != c.expected) {
+                    std::cout << "[\"" << c.text << "\" parse_special = " << c.parse_special << ":";
+                    for (const llama_token t : got) {
+                        std::cout << " " << t;
+                    }
+                    std::cout << "] ";
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // SPM vocab named like phi-3: every special token except <unk>, <s> and <|endoftext|> gets rstrip
+        //   0 <unk>  1 <s>  2 </s>  3 <|endoftext|>  4 a  5 b  6 ▁  7 aab (user)  8 baba (user)  9 abba (control)
+        {
+            const std::string path = make_vocab_test_model("vocab-partition-rstrip.gguf", "llama", "", "phi-3 partition test",
+                { "<unk>", "<s>", "</s>", "<|endoftext|>", "a", "b", "\xe2\x96\x81", "aab", "baba", "abba" },
+                { LLAMA_TOKEN_TYPE_UNKNOWN, LLAMA_TOKEN_TYPE_CONTROL, LLAMA_TOKEN_TYPE_CONTROL, LLAMA_TOKEN_TYPE_CONTROL,
+                  LLAMA_TOKEN_TYPE_NORMAL, LLAMA_TOKEN_TYPE_NORMAL, LLAMA_TOKEN_TYPE_NORMAL,
+                  LLAMA_TOKEN_TYPE_USER_DEFINED, LLAMA_TOKEN_TYPE_USER_DEFINED, LLAMA_TOKEN_TYPE_CONTROL });
+            llama_model * model = load_vocab_test_model(path);
+            if (model == nullptr) {
+                return false;
+            }
+            const bool ok = check(llama_model_get_vocab(model), {
+                { "aababa",       true,  { 4, 4, 8 } },          // overlap: the longer baba wins, aab loses its last byte
+                { "baab",         true,  { 5, 7 } },
+                { "bababa",       true,  { 8, 5, 4 } },          // self-overlap: the second baba is not taken
+                { "babababa",     true,  { 8, 8 } },
+                { "abbaabba",     true,  { 9, 9 } },
+                { "aab  b",       true,  { 7, 5 } },             // rstrip
+                { "aab  abba  b", true,  { 7, 9, 5 } },          // rstrip up to the next special token
+                { "<s> aab</s>",  true,  { 1, 6, 7, 2 } },       // <s> keeps the space
+                { "abbaaab",      true,  { 9, 7 } },
+                { "abbaaab",      false, { 4, 5, 5, 4, 7 } },    // control tokens stay text, user tokens do not
+                { "aab abba",     false, { 7, 4, 5, 5, 4 } },
+                { "a  abba",      false, { 4, 6, 6, 4, 5, 5, 4 } },
+            });
+            llama_model_free(model);
+            std::remove(path.c_str());
+            if (!ok) {
+                return false;
+            }
+        }
+
+        // SPM vocab with a jina pre-tokenizer name: <mask> gets lstrip
+        //   0 <unk>  1 <s>  2 </s>  3 a  4 b  5 ▁  6 <mask> (user)  7 abab (control)  8 bbb (user)
+        {
+            const std::string path = make_vocab_test_model("vocab-partition-lstrip.gguf", "llama", "jina-v2-de", "partition test",
+                { "<unk>", "<s>", "</s>", "a", "b", "\xe2\x96\x81", "<mask>", "abab", "bbb" },
+                { LLAMA_TOKEN_TYPE_UNKNOWN, LLAMA_TOKEN_TYPE_CONTROL, LLAMA_TOKEN_TYPE_CONTROL,
+                  LLAMA_TOKEN_TYPE_NORMAL, LLAMA_TOKEN_TYPE_NORMAL, LLAMA_TOKEN_TYPE_NORMAL,
+                  LLAMA_TOKEN_TYPE_USER_DEFINED, LLAMA_TOKEN_TYPE_CONTROL, LLAMA_TOKEN_TYPE_USER_DEFINED });
+            llama_model * model = load_vocab_test_model(path);
+            if (model == nullptr) {
+                return false;
+            }
+            const bool ok = check(llama_model_get_vocab(model), {
+                { "a  <mask>",      true,  { 3, 6 } },           // lstrip
+                { "abab  <mask>",   true,  { 7, 6 } },           // lstrip back to the previous special token
+                { "<mask> <mask>",  true,  { 6, 6 } },
+                { "bbb <mask> bbb", true,  { 8, 6, 5, 8 } },     // no rstrip: the space after <mask> stays
+                { "<mask>bbbb",     true,  { 6, 8, 4 } },
+                { "ababab",         true,  { 7, 3, 4 } },
+                { "abab  <mask>",   false, { 3, 4, 3, 4, 6 } },
+                { "ababab",         false, { 3, 4, 3, 4, 3, 4 } },
+            });
+            llama_model_free(model);
+            std::remove(path.c_str());
+            if (!ok) {
+                return false;
+            }
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test the BPE word cache and the id-keyed merges against fixed ids: cold and warm tokenization, words too long
+// for the cache, more distinct words than the cache holds, ignore_merges (llama-bpe) and parallel tokenization
+bool test_bpe_word_cache() {
+    try {
+        // byte-level BPE vocab: Ġ is the space, Ċ the newline
+        const std::vector<std::string> tokens = {
+            "<|pad|>", "<|begin|>", "<|end|>",                                     //  0 -  2
+            "a", "c", "d", "e", "h", "l", "o", "r", "t", "w", "\xc4\xa0", "\xc4\x8a", //  3 - 14
+            "he", "ll", "hell", "hello",                                            // 15 - 18
+            "\xc4\xa0w", "or", "\xc4\xa0wor", "\xc4\xa0worl", "\xc4\xa0world",      // 19 - 23
+            "\xc4\xa0t", "\xc4\xa0the", "at", "\xc4\xa0" "cat",                     // 24 - 27
+        };
+        std::vector<int32_t> types(tokens.size(), LLAMA_TOKEN_TYPE_NORMAL);
+        types[0] = types[1] = types[2] = LLAMA_TOKEN_TYPE_CONTROL;
+        // Ġcat is in the vocab but no merge builds it: only ignore_merges emits it
+        const std::vector<std::string> merges = {
+            "h e", "l l", "he ll", "hell o", "\xc4\xa0 w", "o r", "\xc4\xa0w or", "\xc4\xa0wor l", "\xc4\xa0worl d",
+            "\xc4\xa0 t", "\xc4\xa0t he", "a t",
+        };
+
+        std::string long_word;
+        std::vector<llama_token> long_word_ids;
+        for (int i = 0; i < 40; ++i) {
+            long_word += "hello";
+            long_word_ids.push_back(18);
+        }
+
+        for (const bool ignore_merges : { false, true }) {
+            const std::string path = make_vocab_test_model(ignore_merges ? "vocab-bpe-llama.gguf" : "vocab-bpe-default.gguf",
+                "gpt2", ignore_merges ? "llama-bpe" : "default", "bpe cache test", tokens, types, merges);
+            llama_model * model = load_vocab_test_model(path);
+            if (model == nullptr) {
+                return false;
+            }
+            const llama_vocab * vocab = llama_model_get_vocab(model);
+
+            std::vector<llama_token> cat_ids = { 13, 4, 26 };
+            if (ignore_merges) {
+                cat_ids = { 27 };
+            }
+
+            const std::string line = "hello world the cat\n";
+            std::vector<llama_token> line_ids = { 18, 23, 25 };
+            line_ids.insert(line_ids.end(), cat_ids.begin(), cat_ids.end());
+            line_ids.push_back(14);
+
+            const std::string mixed = "hello  hello the " + long_word + " world cat";
+            std::vector<llama_token> mixed_ids = { 18, 13, 13, 18, 25, 13 };
+            mixed_ids.insert(mixed_ids.end(), long_word_ids.begin(), long_word_ids.end());
+            mixed_ids.push_back(23);
+            mixed_ids.insert(mixed_ids.end(), cat_ids.begin(), cat_ids.end());
+
+            bool ok = true;
+            for (const char * pass : { "cold", "warm" }) {
+                if (common_tokenize(vocab, line, false, false) != line_ids || common_tokenize(vocab, mixed, false, false) != mixed_ids) {
+                    std::cout << "[" << pass << " tokens differ, ignore_merges = " << ignore_merges << "] ";
+                    ok = false;
+                    break;
+                }
+            }
+
+            // more distinct words than the cache holds, so the second pass hits evicted entries too
+            std::string words;
+            const char letters[] = "acdehlortw";
+            for (int i = 0; ok && i < 20000; ++i) {
+                words += ' ';
+                for (int v = i, k = 0; k < 5; ++k, v /= 10) {
+                    words += letters[v % 10];
+                }
+            }
+            if (ok && common_tokenize(vocab, words, false, false) != common_tokenize(vocab, words, false, false)) {
+                std::cout << "[tokens changed after eviction, ignore_merges = " << ignore_merges << "] ";
+                ok = false;
+            }
+
+            // several threads share the cache
+            if (ok) {
+                std::string text;
+                std::vector<llama_token> expected;
+                for (int i = 0; i < 16384; ++i) {
+                    text += line;
+                    expected.insert(expected.end(), line_ids.begin(), line_ids.end());
+                }
+                if (common_tokenize(vocab, text, false, false, 4) != expected) {
+                    std::cout << "[parallel tokens differ, ignore_merges = " << ignore_merges << "] ";
+                    ok = false;
+                }
+            }
+
+            llama_model_free(model);
+            std::remove(path.c_str());
+            if (!ok) {
+                return false;
+            }
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Contexts loading the same model with the same model params share one llama_model
+bool test_model_sharing() {
+    try {
+        auto make_params = [](int n_ctx) {
+            common_params params;
+            params.model.path = "../tiny-random-llama.gguf";
+            params.n_ctx = n_ctx;
+            params.n_batch = 32;
+            params.cpuparams.n_threads = 1;
+            params.n_gpu_layers = 0;
+            return params;
+        };
+
+        auto decode_ok = [](llama_rn_context & ctx) {
+            llama_batch batch = llama_batch_init(4, 0, 1);
+            for (int j = 0; j < 4; ++j) {
+                common_batch_add(batch, (llama_token) j, j, { 0 }, j == 3);
+            }
+            const int ret = llama_decode(ctx.ctx, batch);
+            llama_batch_free(batch);
+            return ret == 0;
+        };
+
+        auto second = std::make_unique<llama_rn_context>();
+        {
+            llama_rn_context first;
+            auto params_first = make_params(256);
+            auto params_second = make_params(512);
+            if (!first.loadModel(params_first) || !second->loadModel(params_second)) {
+                return false;
+            }
+            if (first.model != second->model || first.model_shared || !second->model_shared || first.ctx == second->ctx) {
+                std::cout << "Model was not shared between contexts" << std::endl;
+                return false;
+            }
+            if (llama_n_ctx(first.ctx) == llama_n_ctx(second->ctx)) {
+                std::cout << "Contexts sharing a model should keep their own n_ctx" << std::endl;
+                return false;
+            }
+
+            // different model params load a separate model
+            llama_rn_context other;
+            auto params_other = make_params(256);
+            params_other.no_extra_bufts = true;
+            if (!other.loadModel(params_other)) {
+                return false;
+            }
+            if (other.model == first.model || other.model_shared || model_registry_size() != 2) {
+                std::cout << "Different model params must not share a model" << std::endl;
+                return false;
+            }
+        }
+
+        // the model outlives the context that loaded it
+        if (!decode_ok(*second) || model_registry_size() != 1) {
+            std::cout << "Shared model did not outlive its first context" << std::endl;
+            return false;
+        }
+
+        second.reset();
+        if (model_registry_size() != 0) {
+            return false;
+        }
+
+        // a second context with n_ctx = 0 is fitted next to the resident weights and ends up like the first
+        {
+            llama_rn_context first;
+            llama_rn_context second_fit;
+            auto params_first = make_params(0);
+            auto params_second = make_params(0);
+            if (!first.loadModel(params_first) || !second_fit.loadModel(params_second)) {
+                return false;
+            }
+            if (first.model != second_fit.model || !second_fit.model_shared) {
+                std::cout << "Model was not shared between fitted contexts" << std::endl;
+                return false;
+            }
+            if (llama_n_ctx(first.ctx) == 0 || llama_n_ctx(first.ctx) != llama_n_ctx(second_fit.ctx)) {
+                std::cout << "Fitted n_ctx differs: " << llama_n_ctx(first.ctx) << " vs " << llama_n_ctx(second_fit.ctx) << std::endl;
+                return false;
+            }
+            if (!decode_ok(second_fit)) {
+                return false;
+            }
+        }
+        return model_registry_size() == 0;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Contexts leasing one host compute arena must decode exactly like a context
+// with its own compute buffer, even when their graphs interleave
+bool test_shared_compute_arena() {
+    try {
+        llama_rn_context ctx;
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 256;
+        params.n_batch = 32;
+        params.cpuparams.n_threads = 1;
+        params.n_gpu_layers = 0;
+        params.shared_compute_arena = true;
+        if (!ctx.loadModel(params) || !ctx.compute_arena) {
+            std::cout << "Context was not created with a compute arena" << std::endl;
+            return false;
+        }
+        lm_ggml_backend_arena_t arena = ctx.compute_arena.get();
+
+        auto make_context = [&](lm_ggml_backend_arena_t compute_arena, uint32_t n_ctx) {
+            llama_context_params cparams = llama_context_default_params();
+            cparams.n_ctx = n_ctx;
+            cparams.n_batch = 64;
+            cparams.n_ubatch = 64;
+            cparams.n_threads = 1;
+            cparams.n_threads_batch = 1;
+            cparams.compute_arena = compute_arena;
+            return llama_context_ptr(llama_init_from_model(ctx.model, cparams));
+        };
+        // a second arena user with a larger graph, and a reference without arena
+        llama_context_ptr other = make_context(arena, 512);
+        llama_context_ptr ref = make_context(nullptr, 256);
+        if (!other || !ref) {
+            return false;
+        }
+
+        auto decode = [](llama_context * lctx, llama_pos pos0, int n_tokens) {
+            llama_batch batch = llama_batch_init(n_tokens, 0, 1);
+            for (int j = 0; j < n_tokens; ++j) {
+                common_batch_add(batch, (llama_token) (pos0 + j + 1), pos0 + j, { 0 }, j == n_tokens - 1);
+            }
+            const int ret = llama_decode(lctx, batch);
+            llama_batch_free(batch);
+            return ret == 0;
+        };
+        auto same_logits = [&](llama_context * a, llama_context * b) {
+            const int n_vocab = llama_vocab_n_tokens(llama_model_get_vocab(ctx.model));
+            const float * la = llama_get_logits_ith(a, -1);
+            const float * lb = llama_get_logits_ith(b, -1);
+            for (int i = 0; i < n_vocab; ++i) {
+                if (std::fabs(la[i] - lb[i]) > 1e-4f) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // the arena owns no memory until the first lease
+        if (!decode(ctx.ctx, 0, 4) || !decode(ref.get(), 0, 4) || !same_logits(ctx.ctx, ref.get())) {
+            std::cout << "Arena-backed decode differs from the reference" << std::endl;
+            return false;
+        }
+        const size_t size = lm_ggml_backend_arena_get_size(arena);
+        if (size == 0) {
+            std::cout << "Arena was not allocated" << std::endl;
+            return false;
+        }
+
+        // the other context clobbers the arena between two steps of the first
+        if (!decode(other.get(), 0, 48)) {
+            return false;
+        }
+        if (!decode(ctx.ctx, 4, 1) || !decode(ref.get(), 4, 1) || !same_logits(ctx.ctx, ref.get())) {
+            std::cout << "Decode after an interleaved arena lease differs from the reference" << std::endl;
+            return false;
+        }
+        if (lm_ggml_backend_arena_get_size(arena) < size) {
+            std::cout << "Arena shrank below a registered graph" << std::endl;
+            return false;
+        }
+
+        // the memory is released with the last arena user
+        other.reset();
+        ref.reset();
+        ctx.llama_init.reset();
+        ctx.ctx = nullptr;
+        ctx.model = nullptr;
+        return lm_ggml_backend_arena_get_size(arena) == 0;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
 // Test completion functionality
 bool test_completion() {
     try {
@@ -309,6 +812,1492 @@ bool test_utilities() {
     }
 }
 
+// Test the sentence segmentation synthesizeLongForm runs on
+bool test_split_tts_segments() {
+    try {
+        using segs = std::vector<std::string>;
+        auto expect = [](const segs & got, const segs & want, const char * what) {
+            if (got == want) return true;
+            std::cout << "[" << what << ": got " << got.size() << " segments";
+            for (const auto & g : got) std::cout << " |" << g << "|";
+            std::cout << "] ";
+            return false;
+        };
+
+        // One sentence per segment; terminator runs and closing quotes stay attached
+        if (!expect(split_tts_segments("Hello there.  How are you?! \"Fine.\" Bye", 0),
+                    { "Hello there.", "How are you?!", "\"Fine.\"", "Bye" }, "sentences")) return false;
+        // Abbreviations and initials do not end a sentence
+        if (!expect(split_tts_segments("Dr. Smith met J. Doe, e.g. at noon. Then left.", 0),
+                    { "Dr. Smith met J. Doe, e.g. at noon.", "Then left." }, "abbreviations")) return false;
+        // Full-width terminators end a sentence without trailing whitespace
+        if (!expect(split_tts_segments("\xE4\xBD\xA0\xE5\xA5\xBD\xE3\x80\x82\xE5\x86\x8D\xE8\xA7\x81\xEF\xBC\x81", 0),
+                    { "\xE4\xBD\xA0\xE5\xA5\xBD\xE3\x80\x82", "\xE5\x86\x8D\xE8\xA7\x81\xEF\xBC\x81" }, "cjk")) return false;
+        // Paragraph breaks end a sentence even without punctuation
+        if (!expect(split_tts_segments("Title line\n\nBody text.", 0), { "Title line", "Body text." }, "paragraph")) return false;
+        // Short sentences pack up to the limit
+        if (!expect(split_tts_segments("One. Two. Three. Four.", 10), { "One. Two.", "Three.", "Four." }, "packing")) return false;
+        if (!expect(split_tts_segments("   ", 10), {}, "blank")) return false;
+
+        // An over-long sentence is cut at a clause mark or space, never inside a word
+        const std::string text = "The quick brown fox, which was very quick indeed, jumped over the lazy dog near the river bank.";
+        const segs cut = split_tts_segments(text, 24);
+        std::string joined;
+        for (const auto & seg : cut) {
+            if (seg.empty() || seg.size() > 24) {
+                return expect(cut, {}, "long sentence");
+            }
+            joined += (joined.empty() ? "" : " ") + seg;
+        }
+        if (cut.size() < 4 || joined != text || cut[0] != "The quick brown fox,") {
+            return expect(cut, {}, "long sentence");
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test that speaker files round-trip and that foreign, truncated or wrapping headers are rejected
+bool test_speaker_file_round_trip() {
+    const std::string path = (std::filesystem::temp_directory_path() / "rnllama-speaker-test.rnspk").string();
+    try {
+        rn_speaker spk;
+        spk.pcm.resize(1000);
+        spk.emb.resize(3 * 16);
+        for (size_t i = 0; i < spk.pcm.size(); ++i) spk.pcm[i] = std::sin(0.01f * (float) i);
+        for (size_t i = 0; i < spk.emb.size(); ++i) spk.emb[i] = 0.25f * (float) i - 3.0f;
+        spk.sample_rate = 24000;
+        spk.ref_text    = "A reference sentence.";
+        spk.emotion     = 0.75f;
+        spk.has_emotion = true;
+        spk.rows        = 3;
+        spk.hidden_dim  = 16;
+        spk.baked       = true;
+        spk.audio_hash  = 0x1234abcdULL;
+        const uint64_t model_key = 0xfeedULL;
+
+        rn_speaker got;
+        if (!write_speaker_file(path, spk, model_key, true) || !read_speaker_file(path, model_key, got) ||
+            got.emb != spk.emb || got.pcm != spk.pcm || got.ref_text != spk.ref_text || got.rows != 3 ||
+            got.hidden_dim != 16 || got.sample_rate != 24000 || got.emotion != 0.75f || !got.has_emotion ||
+            got.audio_hash != spk.audio_hash || !got.baked) {
+            std::cout << "[Round trip differs] ";
+            std::filesystem::remove(path);
+            return false;
+        }
+        if (read_speaker_file(path, model_key + 1, got)) {
+            std::cout << "[Foreign model key accepted] ";
+            std::filesystem::remove(path);
+            return false;
+        }
+
+        // Offsets / counts that overflow when added to each other must not pass the bounds check
+        // (header: n_pcm at 48, emb_offset at 56, pcm_offset at 64)
+        auto rejects_patch = [&](long offset, uint64_t value) {
+            if (!write_speaker_file(path, spk, model_key, true)) return false;
+            std::FILE * f = std::fopen(path.c_str(), "r+b");
+            const bool patched = f != nullptr && std::fseek(f, offset, SEEK_SET) == 0 &&
+                std::fwrite(&value, sizeof(value), 1, f) == 1;
+            if (f != nullptr) std::fclose(f);
+            rn_speaker bad;
+            return patched && !read_speaker_file(path, model_key, bad);
+        };
+        if (!rejects_patch(56, UINT64_MAX - 7) || !rejects_patch(64, UINT64_MAX - 7) ||
+            !rejects_patch(48, UINT64_MAX / 4 + 1)) {
+            std::cout << "[Wrapping header accepted] ";
+            std::filesystem::remove(path);
+            return false;
+        }
+
+        // A truncated file is rejected; one saved without PCM loads with its embedding only
+        write_speaker_file(path, spk, model_key, true);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+        if (read_speaker_file(path, model_key, got)) {
+            std::cout << "[Truncated file accepted] ";
+            std::filesystem::remove(path);
+            return false;
+        }
+        rn_speaker no_pcm;
+        const bool ok = write_speaker_file(path, spk, model_key, false) && read_speaker_file(path, model_key, no_pcm) &&
+                        no_pcm.pcm.empty() && no_pcm.emb == spk.emb;
+        std::filesystem::remove(path);
+        if (!ok) {
+            std::cout << "[Embedding-only file differs] ";
+        }
+        return ok;
+    } catch (const std::exception& e) {
+        std::filesystem::remove(path);
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::filesystem::remove(path);
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+bool test_ngram_lookup_cache() {
+    try {
+        // The hash must see token order
+        const llama_token ab[2] = { 1, 2 };
+        const llama_token ba[2] = { 2, 1 };
+        if (common_ngram_hash(common_ngram(ab, 2)) == common_ngram_hash(common_ngram(ba, 2))) {
+            std::cout << "[Permuted n-grams collide] ";
+            return false;
+        }
+
+        std::vector<llama_token> inp;
+        for (int i = 0; i < 8; ++i) {
+            inp.insert(inp.end(), { 10, 11, 12, 13 });
+        }
+
+        // Incremental updates (one token at a time) must match a single pass
+        common_ngram_cache nc_full;
+        common_ngram_cache_update(nc_full, LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX, inp, inp.size(), false);
+
+        common_ngram_cache nc_inc;
+        std::vector<llama_token> seen;
+        for (llama_token token : inp) {
+            seen.push_back(token);
+            common_ngram_cache_update(nc_inc, LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX, seen, 1, false);
+        }
+
+        auto same_cache = [](const common_ngram_cache & a, const common_ngram_cache & b) {
+            if (a.size() != b.size()) {
+                return false;
+            }
+            for (const common_ngram_cache_entry & entry : a) {
+                if (entry.sum == 0) {
+                    continue;
+                }
+                const common_ngram_cache_entry * other = b.find(entry.ngram);
+                if (other == nullptr || other->sum != entry.sum) {
+                    return false;
+                }
+                for (int i = 0; i < LLAMA_NGRAM_NEXT; ++i) {
+                    if (entry.count[i] > 0 && other->get(entry.next[i]) != entry.count[i]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        };
+
+        if (!same_cache(nc_full, nc_inc)) {
+            std::cout << "[Incremental update differs] ";
+            return false;
+        }
+
+        // The repeated pattern is drafted from the tail of the context alone
+        const common_ngram_cache nc_empty;
+        const std::vector<llama_token> tail = { 11, 12, 13 };
+        std::vector<llama_token> draft = { 13 };
+        common_ngram_cache_draft(tail, draft, 4, LLAMA_NGRAM_MIN, LLAMA_NGRAM_MAX, nc_full, nc_empty, nc_empty);
+        if (draft != std::vector<llama_token>({ 13, 10, 11, 12, 13 })) {
+            std::cout << "[Unexpected draft] ";
+            return false;
+        }
+
+        // Saved caches load back (mapped), stay read-only until modified, and merge
+        const std::string path = (std::filesystem::temp_directory_path() / "rnllama-ngram-cache-test.bin").string();
+        common_ngram_cache_save(nc_full, path);
+        common_ngram_cache nc_loaded = common_ngram_cache_load(path);
+        if (!same_cache(nc_full, nc_loaded)) {
+            std::filesystem::remove(path);
+            std::cout << "[Loaded cache differs] ";
+            return false;
+        }
+
+        // A header whose n_used disagrees with the table is rejected (n_used follows four u32 and n_buckets)
+        {
+            std::FILE * f = std::fopen(path.c_str(), "r+b");
+            uint64_t n_used_bad = nc_full.size() + 1;
+            const bool patched = f != nullptr && std::fseek(f, 24, SEEK_SET) == 0 &&
+                std::fwrite(&n_used_bad, sizeof(n_used_bad), 1, f) == 1;
+            if (f != nullptr) {
+                std::fclose(f);
+            }
+            bool rejected = false;
+            try {
+                common_ngram_cache_load(path);
+            } catch (const std::exception &) {
+                rejected = true;
+            }
+            if (!patched || !rejected) {
+                std::filesystem::remove(path);
+                std::cout << "[Corrupted cache accepted] ";
+                return false;
+            }
+        }
+
+        // A header-only file whose n_buckets makes the table size wrap to 0 is rejected, too
+        {
+            char header[32];
+            std::FILE * f = std::fopen(path.c_str(), "rb");
+            const bool read = f != nullptr && std::fread(header, sizeof(header), 1, f) == 1;
+            if (f != nullptr) {
+                std::fclose(f);
+            }
+            const uint64_t n_buckets_bad = uint64_t(1) << 62;
+            const uint64_t n_used_bad    = 0;
+            std::memcpy(header + 16, &n_buckets_bad, sizeof(n_buckets_bad));
+            std::memcpy(header + 24, &n_used_bad, sizeof(n_used_bad));
+            // a separate file: nc_loaded still maps the saved one
+            const std::string path_bad = path + ".wrap";
+            f = std::fopen(path_bad.c_str(), "wb");
+            const bool written = read && f != nullptr && std::fwrite(header, sizeof(header), 1, f) == 1;
+            if (f != nullptr) {
+                std::fclose(f);
+            }
+            bool rejected = false;
+            try {
+                common_ngram_cache_load(path_bad);
+            } catch (const std::exception &) {
+                rejected = true;
+            }
+            std::filesystem::remove(path_bad);
+            std::filesystem::remove(path);
+            if (!written || !rejected) {
+                std::cout << "[Cache with a wrapping bucket count accepted] ";
+                return false;
+            }
+        }
+
+        common_ngram_cache nc_merged = nc_loaded;
+        common_ngram_cache_merge(nc_merged, nc_full);
+        const common_ngram_cache_entry * entry = nc_merged.find(common_ngram(&inp[0], 1));
+        if (entry == nullptr || entry->sum != 2*nc_full.find(common_ngram(&inp[0], 1))->sum ||
+            !same_cache(nc_full, nc_loaded)) {
+            std::cout << "[Merge failed] ";
+            return false;
+        }
+
+        // Rarely seen continuations give way to frequent ones, the sample size stays exact
+        common_ngram_cache nc_heavy;
+        const common_ngram key(ab, 2);
+        for (int i = 0; i < 16; ++i) {
+            nc_heavy.add(key, 7);
+            nc_heavy.add(key, 100 + i);
+        }
+        const common_ngram_cache_entry * heavy = nc_heavy.find(key);
+        if (heavy == nullptr || heavy->sum != 32 || heavy->get(7) != 16) {
+            std::cout << "[Heavy hitter lost] ";
+            return false;
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test the near-duplicate video frame filter: off by default, a max-cell luma difference, and the forced-emit cap
+bool test_video_frame_dedup() {
+    try {
+        if (mtmd_helper_video_init_params_default().dedup_threshold > 0.0f) {
+            std::cout << "[Skipping is on by default] ";
+            return false;
+        }
+
+        // 40x24 does not divide into the 16x16 grid evenly; every cell still gets pixels
+        const uint32_t w = 40, h = 24;
+        auto frame = [&](uint8_t luma) { return std::vector<uint8_t>((size_t) w * h * 3, luma); };
+
+        std::vector<uint8_t> half = frame(0);
+        for (uint32_t y = 0; y < h; y++) {
+            for (uint32_t x = 0; x < w / 2; x++) {
+                std::fill_n(half.begin() + ((size_t) y * w + x) * 3, 3, (uint8_t) 255);
+            }
+        }
+        std::vector<float> sig;
+        mtmd_helper_video_dedup::compute_signature(half.data(), w, h, sig);
+        for (int cy = 0; cy < mtmd_helper_video_dedup::GRID; cy++) {
+            for (int cx = 0; cx < mtmd_helper_video_dedup::GRID; cx++) {
+                const float want = cx < mtmd_helper_video_dedup::GRID / 2 ? 255.0f : 0.0f;
+                if (sig[cy * mtmd_helper_video_dedup::GRID + cx] != want) {
+                    std::cout << "[Signature cell " << cx << "," << cy << " = " << sig[cy * mtmd_helper_video_dedup::GRID + cx] << "] ";
+                    return false;
+                }
+            }
+        }
+
+        // Disabled filter keeps everything
+        mtmd_helper_video_dedup off;
+        const std::vector<uint8_t> grey = frame(100);
+        if (off.is_near_duplicate(grey.data(), w, h) || off.is_near_duplicate(grey.data(), w, h)) {
+            std::cout << "[Disabled filter dropped a frame] ";
+            return false;
+        }
+
+        // Small global changes are dropped and compared against the last kept frame, so a slow drift
+        // is kept once it adds up; a change confined to one cell is kept
+        mtmd_helper_video_dedup dd;
+        dd.threshold = 3.0f;
+        std::vector<uint8_t> local = grey;
+        for (uint32_t y = 0; y < 2; y++) {
+            for (uint32_t x = 0; x < 3; x++) {
+                std::fill_n(local.begin() + ((size_t) y * w + x) * 3, 3, (uint8_t) 200);
+            }
+        }
+        const std::vector<std::pair<std::vector<uint8_t>, bool>> steps = {
+            { grey, false }, { grey, true }, { frame(101), true }, { frame(102), true }, { frame(103), false },
+            { frame(103), true }, { local, false },
+        };
+        for (size_t i = 0; i < steps.size(); i++) {
+            if (dd.is_near_duplicate(steps[i].first.data(), w, h) != steps[i].second) {
+                std::cout << "[Drift/local step " << i << "] ";
+                return false;
+            }
+        }
+
+        // dedup_max_skip forces a frame after that many skips in a row
+        mtmd_helper_video_dedup capped;
+        capped.threshold = 3.0f;
+        capped.max_skip  = 2;
+        const bool want[] = { false, true, true, false, true, true, false };
+        for (size_t i = 0; i < sizeof(want) / sizeof(want[0]); i++) {
+            if (capped.is_near_duplicate(grey.data(), w, h) != want[i]) {
+                std::cout << "[Max skip step " << i << "] ";
+                return false;
+            }
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test that a repacked weight cache image maps back with the same tensor data and that damaged headers are rejected
+bool test_repack_cache_file() {
+    const std::string path = (std::filesystem::temp_directory_path() / "rnllama-repack-cache-test.lrpk").string();
+    lm_ggml_context * ctx = nullptr;
+    lm_ggml_backend_buffer_t buf = nullptr;
+    try {
+        lm_ggml_init_params ip = { /* .mem_size = */ 4 * lm_ggml_tensor_overhead(), /* .mem_buffer = */ nullptr, /* .no_alloc = */ true };
+        ctx = lm_ggml_init(ip);
+        lm_ggml_tensor * a = lm_ggml_new_tensor_2d(ctx, LM_GGML_TYPE_F32, 64, 3);
+        lm_ggml_tensor * b = lm_ggml_new_tensor_1d(ctx, LM_GGML_TYPE_F32, 100);
+        lm_ggml_set_name(a, "blk.0.ffn_up.weight");
+        lm_ggml_set_name(b, "blk.0.ffn_norm.weight");
+        lm_ggml_backend_buffer_type_t buft = lm_ggml_backend_cpu_buffer_type();
+        buf = lm_ggml_backend_alloc_ctx_tensors_from_buft(ctx, buft);
+        std::vector<float> data_a(64 * 3), data_b(100);
+        for (size_t i = 0; i < data_a.size(); ++i) data_a[i] = 0.5f * (float) i;
+        for (size_t i = 0; i < data_b.size(); ++i) data_b[i] = -1.0f - (float) i;
+        lm_ggml_backend_tensor_set(a, data_a.data(), 0, lm_ggml_nbytes(a));
+        lm_ggml_backend_tensor_set(b, data_b.data(), 0, lm_ggml_nbytes(b));
+        const uint64_t key = 0x5eedULL;
+
+        // Loads into a copy of the context layout so the original stays untouched
+        auto load = [&](uint64_t k, std::vector<float> * out_a, std::vector<float> * out_b) {
+            lm_ggml_context * ctx2 = lm_ggml_init(ip);
+            lm_ggml_tensor * a2 = lm_ggml_dup_tensor(ctx2, a);
+            lm_ggml_tensor * b2 = lm_ggml_dup_tensor(ctx2, b);
+            lm_ggml_set_name(a2, lm_ggml_get_name(a));
+            lm_ggml_set_name(b2, lm_ggml_get_name(b));
+            llama_mmaps mappings;
+            lm_ggml_backend_buffer_t buf2 = llama_repack_cache_load(path.c_str(), k, ctx2, buft, mappings);
+            if (buf2 != nullptr && out_a != nullptr) {
+                out_a->resize(data_a.size());
+                out_b->resize(data_b.size());
+                lm_ggml_backend_tensor_get(a2, out_a->data(), 0, lm_ggml_nbytes(a2));
+                lm_ggml_backend_tensor_get(b2, out_b->data(), 0, lm_ggml_nbytes(b2));
+            }
+            lm_ggml_backend_buffer_free(buf2);
+            lm_ggml_free(ctx2);
+            return buf2 != nullptr;
+        };
+
+        std::vector<float> got_a, got_b;
+        bool ok = llama_repack_cache_save(path.c_str(), key, ctx, buf) && load(key, &got_a, &got_b) &&
+                  got_a == data_a && got_b == data_b;
+        if (!ok) {
+            std::cout << "[Round trip failed] ";
+        } else if (load(key + 1, nullptr, nullptr)) {
+            std::cout << "[Foreign key accepted] ";
+            ok = false;
+        }
+
+        // Sizes and offsets that wrap when added must be rejected
+        // (header: data_offset at 24, data_size at 32; the first table entry's offset follows its u32 name length and name)
+        auto rejects_patch = [&](long offset, uint64_t value) {
+            if (!llama_repack_cache_save(path.c_str(), key, ctx, buf)) return false;
+            std::FILE * f = std::fopen(path.c_str(), "r+b");
+            const bool patched = f != nullptr && std::fseek(f, offset, SEEK_SET) == 0 &&
+                std::fwrite(&value, sizeof(value), 1, f) == 1;
+            if (f != nullptr) std::fclose(f);
+            return patched && !load(key, nullptr, nullptr);
+        };
+        const long entry0_offs = 40 + 4 + (long) std::strlen(lm_ggml_get_name(a));
+        if (ok && (!rejects_patch(32, UINT64_MAX - 4095) || !rejects_patch(24, UINT64_MAX - 65535) ||
+                   !rejects_patch(entry0_offs, UINT64_MAX - 7))) {
+            std::cout << "[Wrapping header accepted] ";
+            ok = false;
+        }
+
+        // A truncated image is rejected
+        if (ok) {
+            llama_repack_cache_save(path.c_str(), key, ctx, buf);
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+            if (load(key, nullptr, nullptr)) {
+                std::cout << "[Truncated cache accepted] ";
+                ok = false;
+            }
+        }
+
+        std::filesystem::remove(path);
+        lm_ggml_backend_buffer_free(buf);
+        lm_ggml_free(ctx);
+        return ok;
+    } catch (const std::exception& e) {
+        std::filesystem::remove(path);
+        lm_ggml_backend_buffer_free(buf);
+        lm_ggml_free(ctx);
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::filesystem::remove(path);
+        lm_ggml_backend_buffer_free(buf);
+        lm_ggml_free(ctx);
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+static size_t kv_context_frag_bytes(const llama_context * lctx) {
+    size_t res = 0;
+    for (const auto & buft_mb : llama_get_memory_breakdown(lctx)) {
+        res += buft_mb.second.context_frag;
+    }
+    return res;
+}
+
+// Fill seq 0 and seq 1 back to back, drop seq 0 so that its cells become a hole in front of
+// seq 1, then decode one more token of seq 1 and return its logits.
+static bool kv_decode_after_hole(llama_context * lctx, int n_tok, std::vector<float> & logits, size_t & frag_before, size_t & frag_after) {
+    const llama_vocab * vocab = llama_model_get_vocab(llama_get_model(lctx));
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+
+    for (llama_seq_id seq = 0; seq < 2; ++seq) {
+        for (int p0 = 0; p0 < n_tok; p0 += 128) {
+            const int n = std::min(128, n_tok - p0);
+            llama_batch batch = llama_batch_init(n, 0, 1);
+            for (int i = 0; i < n; ++i) {
+                common_batch_add(batch, (llama_token) ((p0 + i + 7*seq) % n_vocab), p0 + i, { seq }, false);
+            }
+            const int ret = llama_decode(lctx, batch);
+            llama_batch_free(batch);
+            if (ret != 0) {
+                return false;
+            }
+        }
+    }
+
+    llama_memory_seq_rm(llama_get_memory(lctx), 0, -1, -1);
+    frag_before = kv_context_frag_bytes(lctx);
+
+    llama_batch batch = llama_batch_init(1, 0, 1);
+    common_batch_add(batch, 1, n_tok, { 1 }, true);
+    const int ret = llama_decode(lctx, batch);
+    llama_batch_free(batch);
+    if (ret != 0) {
+        return false;
+    }
+
+    frag_after = kv_context_frag_bytes(lctx);
+
+    const float * out = llama_get_logits_ith(lctx, -1);
+    logits.assign(out, out + n_vocab);
+
+    return true;
+}
+
+// Test that KV cache compaction closes the holes left by seq_rm without changing the results
+bool test_kv_cache_compaction() {
+    try {
+        std::vector<float> logits_ref;
+        std::vector<float> logits_defrag;
+        size_t frag_ref_before = 0, frag_ref_after = 0;
+        size_t frag_before = 0, frag_after = 0;
+
+        for (int i = 0; i < 2; ++i) {
+            llama_rn_context ctx;
+
+            common_params params;
+            params.model.path = "../tiny-random-llama.gguf";
+            params.n_ctx = 1024;
+            params.n_batch = 128;
+            params.n_parallel = 2;
+            params.kv_unified = true;
+            params.cpuparams.n_threads = 1;
+            params.n_gpu_layers = 0;
+            params.no_kv_offload = true;
+            params.defrag_thold = i == 0 ? -1.0f : 0.1f;
+
+            if (!ctx.loadModel(params)) {
+                return false;
+            }
+
+            const bool ok = i == 0
+                ? kv_decode_after_hole(ctx.ctx, 300, logits_ref,    frag_ref_before, frag_ref_after)
+                : kv_decode_after_hole(ctx.ctx, 300, logits_defrag, frag_before,     frag_after);
+            if (!ok) {
+                std::cout << "Decode failed" << std::endl;
+                return false;
+            }
+        }
+
+        if (frag_ref_before == 0 || frag_before == 0) {
+            std::cout << "Expected the removed sequence to leave a hole" << std::endl;
+            return false;
+        }
+
+        // without compaction the single new token lands in the hole, with compaction the hole is gone
+        if (frag_after >= frag_ref_after) {
+            std::cout << "Compaction did not reduce fragmentation: " << frag_after << " >= " << frag_ref_after << std::endl;
+            return false;
+        }
+
+        for (size_t j = 0; j < logits_ref.size(); ++j) {
+            if (std::fabs(logits_ref[j] - logits_defrag[j]) > 1e-3f) {
+                std::cout << "Logits differ after compaction at " << j << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test that attention-sink streaming keeps the sink tokens, evicts exactly n_sink_evict tokens per shift
+// and generates past n_ctx
+bool test_sink_streaming_eviction(int32_t n_sink_evict) {
+    try {
+        llama_rn_context ctx;
+
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 64;
+        params.n_batch = 64;
+        params.cpuparams.n_threads = 1;
+        params.n_gpu_layers = 0;
+        params.no_kv_offload = true;
+        params.ctx_shift = true;
+        params.n_sink = 4;
+        params.n_sink_evict = n_sink_evict;
+        params.n_predict = 150;
+        params.sampling.ignore_eos = true;
+
+        if (!ctx.loadModel(params)) {
+            return false;
+        }
+
+        if (ctx.completion == nullptr) {
+            ctx.completion = new llama_rn_context_completion(&ctx);
+        }
+        if (!ctx.completion->initSampling()) {
+            return false;
+        }
+
+        ctx.params.prompt = "Hello world, this is a streaming test";
+        std::vector<std::string> empty_media;
+        ctx.completion->loadPrompt(empty_media);
+        ctx.completion->beginCompletion();
+
+        const std::vector<llama_token> sinks(ctx.completion->embd.begin(), ctx.completion->embd.begin() + params.n_sink);
+
+        int tokens_generated = 0;
+        int n_shifts = 0;
+        bool evicted_exact = true;
+        while (ctx.completion->has_next_token && tokens_generated < 150) {
+            const size_t n_before = ctx.completion->embd.size();
+            if (ctx.completion->nextToken().tok == -1) {
+                break;
+            }
+            // a shift erases the evicted tokens before the sampled one is appended
+            const size_t n_after = ctx.completion->embd.size();
+            if (n_after <= n_before) {
+                n_shifts++;
+                evicted_exact &= n_before + 1 - n_after == (size_t) n_sink_evict;
+            }
+            tokens_generated++;
+        }
+
+        auto * mem = llama_get_memory(ctx.ctx);
+        const llama_pos p_min = llama_memory_seq_pos_min(mem, 0);
+        const llama_pos p_max = llama_memory_seq_pos_max(mem, 0);
+        const bool sinks_kept = std::equal(sinks.begin(), sinks.end(), ctx.completion->embd.begin());
+        const bool truncated = ctx.completion->truncated;
+
+        ctx.completion->endCompletion();
+
+        if (tokens_generated < 150 || !truncated) {
+            std::cout << "Generation stopped at context limit: " << tokens_generated << std::endl;
+            return false;
+        }
+        if (p_min != 0 || p_max >= params.n_ctx) {
+            std::cout << "Unexpected KV positions: [" << p_min << ", " << p_max << "]" << std::endl;
+            return false;
+        }
+        if (!sinks_kept) {
+            std::cout << "Sink tokens were evicted" << std::endl;
+            return false;
+        }
+        if (n_shifts == 0 || !evicted_exact) {
+            std::cout << "Shifts did not evict " << n_sink_evict << " tokens each (" << n_shifts << " shifts)" << std::endl;
+            return false;
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test that Q8_0 weights feed the codec matmuls natively by default (conv1d, linear and the shared
+// per-pos linear) and stay close to the F32 result, while types outside the parity set are still cast
+bool test_codec_quantized_matmul() {
+    try {
+        const int64_t T = 48, C_in = 4, C_out = 24, K = 32;
+
+        lm_ggml_init_params ip = { /* .mem_size = */ 64 * 1024 * 1024, /* .mem_buffer = */ nullptr, /* .no_alloc = */ false };
+        lm_ggml_context * ctx = lm_ggml_init(ip);
+
+        uint32_t seed = 42;
+        auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return (float) (seed >> 8) / (float) (1u << 24) - 0.5f; };
+        auto fill = [&](lm_ggml_tensor * t) {
+            for (int64_t i = 0; i < lm_ggml_nelements(t); ++i) ((float *) t->data)[i] = rnd();
+        };
+        auto quantized = [&](lm_ggml_tensor * w, lm_ggml_type type) {
+            lm_ggml_tensor * w_q = lm_ggml_new_tensor(ctx, type, lm_ggml_n_dims(w), w->ne);
+            lm_ggml_quantize_chunk(type, (const float *) w->data, w_q->data, 0, lm_ggml_nrows(w), w->ne[0], nullptr);
+            return w_q;
+        };
+
+        lm_ggml_tensor * x      = lm_ggml_new_tensor_2d(ctx, LM_GGML_TYPE_F32, T, C_in);
+        lm_ggml_tensor * w_conv = lm_ggml_new_tensor_3d(ctx, LM_GGML_TYPE_F32, K, C_in, C_out);
+        lm_ggml_tensor * x_lin  = lm_ggml_new_tensor_2d(ctx, LM_GGML_TYPE_F32, 256, T);
+        lm_ggml_tensor * w_lin  = lm_ggml_new_tensor_2d(ctx, LM_GGML_TYPE_F32, 256, C_out);
+        fill(x);
+        fill(w_conv);
+        fill(x_lin);
+        fill(w_lin);
+
+        lm_ggml_tensor * w_conv_q = quantized(w_conv, LM_GGML_TYPE_Q8_0);
+        lm_ggml_tensor * w_lin_q  = quantized(w_lin,  LM_GGML_TYPE_Q8_0);
+        lm_ggml_tensor * w_lin_k  = quantized(w_lin,  LM_GGML_TYPE_Q4_K);
+
+        struct matmul_case {
+            const char *    name;
+            lm_ggml_tensor * w_q;
+            lm_ggml_tensor * y;   // with the F32 weight
+            lm_ggml_tensor * y_q; // with the quantized weight
+            bool            native;
+            double          tol;  // relative to the largest F32 output
+        };
+        const matmul_case cases[] = {
+            { "conv1d",         w_conv_q, codec_conv1d(ctx, x, w_conv, nullptr, 2, 1, 3),
+                                          codec_conv1d(ctx, x, w_conv_q, nullptr, 2, 1, 3), true, 0.02 },
+            { "linear",         w_lin_q,  codec_op_linear(ctx, x_lin, w_lin, nullptr),
+                                          codec_op_linear(ctx, x_lin, w_lin_q, nullptr), true, 0.02 },
+            { "per-pos linear", w_lin_q,  codec_op_lm_per_pos_linear(ctx, w_lin, x_lin, C_out, T),
+                                          codec_op_lm_per_pos_linear(ctx, w_lin_q, x_lin, C_out, T), true, 0.02 },
+            { "linear (Q4_K)",  w_lin_k,  codec_op_linear(ctx, x_lin, w_lin, nullptr),
+                                          codec_op_linear(ctx, x_lin, w_lin_k, nullptr), false, 0.1 },
+        };
+
+        bool ok = true;
+        for (const auto & c : cases) {
+            lm_ggml_cgraph * gf = lm_ggml_new_graph(ctx);
+            lm_ggml_build_forward_expand(gf, c.y);
+            lm_ggml_build_forward_expand(gf, c.y_q);
+
+            // a native weight must not be dequantized in the graph, any other quantized weight must be
+            bool cast = false;
+            for (int i = 0; i < lm_ggml_graph_n_nodes(gf); ++i) {
+                const lm_ggml_tensor * node = lm_ggml_graph_node(gf, i);
+                cast |= node->op == LM_GGML_OP_CPY && node->src[0] == c.w_q;
+            }
+            if (cast == c.native) {
+                std::cout << "[" << c.name << ": quantized weight was " << (cast ? "" : "not ") << "cast] ";
+                ok = false;
+                break;
+            }
+
+            lm_ggml_graph_compute_with_ctx(ctx, gf, 1);
+
+            double max_err = 0.0, max_ref = 0.0;
+            for (int64_t i = 0; lm_ggml_are_same_shape(c.y, c.y_q) && i < lm_ggml_nelements(c.y); ++i) {
+                const float a = ((const float *) c.y->data)[i];
+                const float b = ((const float *) c.y_q->data)[i];
+                max_err = std::max(max_err, (double) std::fabs(a - b));
+                max_ref = std::max(max_ref, (double) std::fabs(a));
+            }
+            if (!lm_ggml_are_same_shape(c.y, c.y_q) || max_ref == 0.0 || max_err >= c.tol * max_ref) {
+                std::cout << "[" << c.name << ": max err " << max_err << " / " << max_ref << "] ";
+                ok = false;
+                break;
+            }
+        }
+
+        lm_ggml_free(ctx);
+        return ok;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+static bool codec_cache_test_build(lm_ggml_context * ctx_eval, void * user_data, lm_ggml_tensor ** out) {
+    const int32_t n = *static_cast<const int32_t *>(user_data);
+    *out = lm_ggml_new_tensor_1d(ctx_eval, LM_GGML_TYPE_F32, n);
+    return true;
+}
+
+struct codec_causal_test_params {
+    int32_t t;
+    int32_t c;
+    int32_t k;
+};
+
+// Causal conv over [t, c] frames (left padding only), standing in for the causal decoders that bucket their lengths
+static bool codec_causal_test_build(lm_ggml_context * ctx_eval, void * user_data, lm_ggml_tensor ** out) {
+    const codec_causal_test_params * p = static_cast<const codec_causal_test_params *>(user_data);
+    lm_ggml_tensor * x = lm_ggml_new_tensor_2d(ctx_eval, LM_GGML_TYPE_F32, p->t, p->c);
+    lm_ggml_set_name(x, "test.x");
+    lm_ggml_tensor * w = lm_ggml_new_tensor_3d(ctx_eval, LM_GGML_TYPE_F32, p->k, p->c, p->c);
+    lm_ggml_set_name(w, "test.w");
+    lm_ggml_tensor * x_pad = lm_ggml_pad_ext(ctx_eval, x, p->k - 1, 0, 0, 0, 0, 0, 0, 0);
+    *out = codec_conv1d(ctx_eval, x_pad, w, nullptr, 1, 1, 0);
+    lm_ggml_set_name(*out, "test.y");
+    return true;
+}
+
+// Run the causal graph at n_frames (>= t_real), repeating the last real frame as padding, and return the first t_real frames
+static bool codec_causal_test_run(codec_context * ctx, int32_t t_real, int32_t n_frames, const std::vector<float> & x,
+                                  const std::vector<float> & w, const codec_causal_test_params & shape, std::vector<float> & y) {
+    codec_causal_test_params p = shape;
+    p.t = n_frames;
+    codec_graph_cache_key key = {};
+    key.kind = 3;
+    key.n_frames = n_frames;
+    std::string err;
+    codec_graph_cache_entry * entry = nullptr;
+    if (!codec_graph_cache_get_or_build(ctx, key, codec_causal_test_build, &p, sizeof(p), &entry, &err) ||
+        !codec_graph_prepare_io(ctx, entry, &err)) {
+        return false;
+    }
+    lm_ggml_tensor * t_x = codec_graph_get_tensor(ctx, entry, "test.x");
+    lm_ggml_tensor * t_w = codec_graph_get_tensor(ctx, entry, "test.w");
+    lm_ggml_tensor * t_y = codec_graph_get_tensor(ctx, entry, "test.y");
+    if (t_x == nullptr || t_w == nullptr || t_y == nullptr || t_y->ne[0] != n_frames) {
+        return false;
+    }
+
+    std::vector<float> x_pad((size_t) n_frames * p.c);
+    for (int32_t ci = 0; ci < p.c; ++ci) {
+        for (int32_t ti = 0; ti < n_frames; ++ti) {
+            x_pad[(size_t) ci * n_frames + ti] = x[(size_t) ci * t_real + std::min(ti, t_real - 1)];
+        }
+    }
+    if (!codec_runtime_write_tensor(t_x, x_pad.data(), x_pad.size() * sizeof(float), &err) ||
+        !codec_runtime_write_tensor(t_w, w.data(), w.size() * sizeof(float), &err) ||
+        !codec_graph_compute(ctx, entry, 1, &err)) {
+        return false;
+    }
+
+    std::vector<float> y_pad((size_t) n_frames * p.c);
+    if (!codec_runtime_read_tensor(t_y, y_pad.data(), y_pad.size() * sizeof(float), &err)) {
+        return false;
+    }
+    y.resize((size_t) t_real * p.c);
+    for (int32_t ci = 0; ci < p.c; ++ci) {
+        std::copy_n(y_pad.begin() + (size_t) ci * n_frames, t_real, y.begin() + (size_t) ci * t_real);
+    }
+    return true;
+}
+
+// Test codec graph shape buckets, that a causal graph decoded at the bucketed length matches the exact length,
+// and that the graph cache stays bounded while entries in use stay valid
+bool test_codec_graph_cache_buckets() {
+    try {
+        const int32_t expect[][2] = { {1, 1}, {3, 4}, {17, 32}, {64, 64}, {65, 128}, {130, 192} };
+        for (const auto & e : expect) {
+            if (codec_graph_bucket_frames(e[0]) != e[1]) {
+                std::cout << "[bucket(" << e[0] << ") = " << codec_graph_bucket_frames(e[0]) << "] ";
+                return false;
+            }
+        }
+
+        codec_context ctx;
+        ctx.model = nullptr;
+        ctx.params = codec_context_default_params();
+        std::string err;
+        bool ok = true;
+        for (int32_t i = 1; ok && i <= 100; ++i) {
+            codec_graph_cache_key key = {};
+            key.kind = 1;
+            key.n_frames = codec_graph_bucket_frames(i);
+            codec_graph_cache_entry * entry = nullptr;
+            ok = codec_graph_cache_get_or_build(&ctx, key, codec_cache_test_build, &key.n_frames, sizeof(int32_t), &entry, &err) &&
+                 entry == ctx.eval_entry && entry->key == key;
+        }
+        // 100 lengths share 8 buckets: 1, 2, 4, 8, 16, 32, 64 and 128
+        const size_t n_bucketed = ctx.graph_cache.size();
+
+        for (int32_t i = 1; ok && i <= 100; ++i) {
+            codec_graph_cache_key key = {};
+            key.kind = 2;
+            key.n_frames = i;
+            codec_graph_cache_entry * entry = nullptr;
+            ok = codec_graph_cache_get_or_build(&ctx, key, codec_cache_test_build, &key.n_frames, sizeof(int32_t), &entry, &err) &&
+                 lm_ggml_nelements(lm_ggml_get_first_tensor(ctx.eval_ctx)) == i;
+        }
+        const size_t n_exact = ctx.graph_cache.size();
+
+        // Trailing pad frames never reach the real frames of a causal graph
+        ctx.backend = lm_ggml_backend_cpu_init();
+        const codec_causal_test_params shape = { 0, 8, 7 };
+        uint32_t seed = 7;
+        auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return (float) (seed >> 8) / (float) (1u << 24) - 0.5f; };
+        for (const int32_t t_real : { 5, 37, 100 }) {
+            std::vector<float> x((size_t) t_real * shape.c), w((size_t) shape.k * shape.c * shape.c);
+            for (float & v : x) v = rnd();
+            for (float & v : w) v = rnd();
+
+            std::vector<float> y_exact, y_bucket;
+            ok = ok && codec_graph_bucket_frames(t_real) > t_real &&
+                 codec_causal_test_run(&ctx, t_real, t_real, x, w, shape, y_exact) &&
+                 codec_causal_test_run(&ctx, t_real, codec_graph_bucket_frames(t_real), x, w, shape, y_bucket);
+            for (size_t i = 0; ok && i < y_exact.size(); ++i) {
+                ok = std::fabs(y_exact[i] - y_bucket[i]) <= 1e-5f * (1.0f + std::fabs(y_exact[i]));
+            }
+            if (!ok) {
+                std::cout << "[Bucketed decode of " << t_real << " frames differs] ";
+                break;
+            }
+        }
+        codec_runtime_free(&ctx);
+        lm_ggml_backend_free(ctx.backend);
+        ctx.backend = nullptr;
+
+        std::cout << "[" << n_bucketed << " bucketed, " << n_exact << " cached] ";
+        return ok && n_bucketed == 8 && n_exact <= 32;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Random-weight codec_lm on the CPU backend, assembled in memory from gguf metadata and F32 tensors
+struct codec_lm_test_model {
+    codec_model model = {};
+
+    codec_lm_test_model(lm_gguf_context * gguf, const std::vector<std::pair<std::string, std::vector<int64_t>>> & tensors) {
+        model.gguf = gguf;
+        model.backend = lm_ggml_backend_cpu_init();
+        model.n_threads = 1;
+
+        lm_ggml_init_params ip = { /* .mem_size = */ (tensors.size() + 1) * lm_ggml_tensor_overhead(), /* .mem_buffer = */ nullptr, /* .no_alloc = */ true };
+        model.weights = lm_ggml_init(ip);
+        for (const auto & t : tensors) {
+            lm_ggml_tensor * w = t.second.size() == 1
+                ? lm_ggml_new_tensor_1d(model.weights, LM_GGML_TYPE_F32, t.second[0])
+                : lm_ggml_new_tensor_2d(model.weights, LM_GGML_TYPE_F32, t.second[0], t.second[1]);
+            lm_ggml_set_name(w, t.first.c_str());
+        }
+        model.weights_buffer = lm_ggml_backend_alloc_ctx_tensors(model.weights, model.backend);
+
+        uint32_t seed = 1234;
+        auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return (float) (seed >> 8) / (float) (1u << 24) - 0.5f; };
+        for (lm_ggml_tensor * w = lm_ggml_get_first_tensor(model.weights); w != nullptr; w = lm_ggml_get_next_tensor(model.weights, w)) {
+            std::vector<float> data((size_t) lm_ggml_nelements(w));
+            for (float & v : data) v = rnd();
+            lm_ggml_backend_tensor_set(w, data.data(), 0, lm_ggml_nbytes(w));
+        }
+    }
+
+    ~codec_lm_test_model() {
+        lm_ggml_backend_buffer_free(model.weights_buffer);
+        lm_ggml_free(model.weights);
+        lm_gguf_free(model.gguf);
+        lm_ggml_backend_free(model.backend);
+    }
+};
+
+// Step n_seq states of lm through n_frames frames, batched or one state at a time; the codes pushed are the
+// argmax of the unbatched logits (codes_ref) so both runs walk the same path. Returns every logits vector in order.
+static bool codec_lm_test_steps(codec_lm * lm, int32_t n_seq, int32_t n_frames, bool batched, const std::vector<float> & h,
+                                std::vector<int32_t> & codes_ref, std::vector<std::vector<float>> & logits_out) {
+    const codec_lm_info * info = codec_lm_get_info(lm);
+    std::vector<codec_lm_state *> states;
+    for (int32_t s = 0; s < n_seq; ++s) {
+        states.push_back(codec_lm_state_new(lm));
+    }
+    bool ok = std::find(states.begin(), states.end(), nullptr) == states.end();
+    std::vector<int32_t> codes((size_t) info->n_codebook);
+    size_t i_code = 0;
+    for (int32_t f = 0; ok && f < n_frames; ++f) {
+        const float * h_f = h.data() + (size_t) f * n_seq * info->hidden_dim;
+        if (batched) {
+            ok = codec_lm_step_begin_batch(states.data(), n_seq, h_f) == CODEC_STATUS_SUCCESS;
+        } else {
+            for (int32_t s = 0; ok && s < n_seq; ++s) {
+                ok = codec_lm_step_begin(states[s], h_f + (size_t) s * info->hidden_dim) == CODEC_STATUS_SUCCESS;
+            }
+        }
+        for (int32_t k = 0; ok && k < info->n_codebook; ++k) {
+            std::vector<const float *> logits((size_t) n_seq, nullptr);
+            if (batched) {
+                ok = codec_lm_step_logits_batch(states.data(), n_seq, logits.data(), nullptr, nullptr) == CODEC_STATUS_SUCCESS;
+            } else {
+                for (int32_t s = 0; ok && s < n_seq; ++s) {
+                    logits[s] = codec_lm_step_logits(states[s], nullptr, nullptr);
+                    ok = logits[s] != nullptr;
+                }
+            }
+            for (int32_t s = 0; ok && s < n_seq; ++s) {
+                const int32_t n = info->codebook_sizes[k];
+                logits_out.emplace_back(logits[s], logits[s] + n);
+                if (!batched) {
+                    codes_ref.push_back((int32_t) (std::max_element(logits[s], logits[s] + n) - logits[s]));
+                }
+                ok = i_code < codes_ref.size() && codec_lm_step_push_code(states[s], codes_ref[i_code++]) == CODEC_STATUS_SUCCESS;
+            }
+        }
+        for (int32_t s = 0; ok && s < n_seq; ++s) {
+            ok = codec_lm_step_finish(states[s], codes.data()) == CODEC_STATUS_SUCCESS;
+        }
+    }
+    for (codec_lm_state * st : states) {
+        codec_lm_state_free(st);
+    }
+    return ok;
+}
+
+// Test that the batched codec_lm step machine gives the same logits as stepping each sequence on its own
+bool test_codec_lm_step_batch() {
+    try {
+        const int64_t H = 16, V = 12, I = 32;
+        const int32_t n_cb = 3, n_seq = 3, n_frames = 2;
+        const int32_t sizes[n_cb] = { (int32_t) V, (int32_t) V, (int32_t) V };
+
+        for (const char * kind : { "parallel_heads_delay", "residual_depth_ar" }) {
+            lm_gguf_context * gguf = lm_gguf_init_empty();
+            lm_gguf_set_val_bool(gguf, "codec.lm.has_adaptor", true);
+            lm_gguf_set_val_str (gguf, "codec.lm.kind", kind);
+            lm_gguf_set_val_i32 (gguf, "codec.lm.hidden_dim", (int32_t) H);
+            lm_gguf_set_val_i32 (gguf, "codec.lm.n_codebook", n_cb);
+            lm_gguf_set_arr_data(gguf, "codec.lm.codebook_sizes", LM_GGUF_TYPE_INT32, sizes, n_cb);
+
+            std::vector<std::pair<std::string, std::vector<int64_t>>> tensors;
+            for (int32_t i = 0; i < n_cb; ++i) {
+                tensors.push_back({ "lm.audio_embd_" + std::to_string(i) + ".weight", { H, V } });
+            }
+            if (std::string(kind) == "parallel_heads_delay") {
+                for (int32_t i = 0; i < n_cb; ++i) {
+                    tensors.push_back({ "lm.heads_" + std::to_string(i) + ".weight", { H, V } });
+                }
+            } else {
+                // CSM layout: c0 from a backbone-side head, c1.. from a one-layer depth decoder with GQA
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_layers", 1);
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_hidden", (int32_t) H);
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_n_heads", 2);
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_n_kv_heads", 1);
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_head_dim", 8);
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_intermediate", (int32_t) I);
+                lm_gguf_set_val_i32(gguf, "codec.lm.residual.depth_max_position", n_cb + 1);
+                tensors.push_back({ "lm.c0_head.weight", { H, V } });
+                for (int32_t i = 0; i < n_cb - 1; ++i) {
+                    tensors.push_back({ "lm.depth.heads_" + std::to_string(i) + ".weight", { H, V } });
+                }
+                tensors.push_back({ "lm.depth.output_norm.weight",      { H } });
+                tensors.push_back({ "lm.depth.blk_0.attn_norm.weight",  { H } });
+                tensors.push_back({ "lm.depth.blk_0.q.weight",          { H, 16 } });
+                tensors.push_back({ "lm.depth.blk_0.k.weight",          { H, 8 } });
+                tensors.push_back({ "lm.depth.blk_0.v.weight",          { H, 8 } });
+                tensors.push_back({ "lm.depth.blk_0.o.weight",          { 16, H } });
+                tensors.push_back({ "lm.depth.blk_0.ffn_norm.weight",   { H } });
+                tensors.push_back({ "lm.depth.blk_0.ffn_gate.weight",   { H, I } });
+                tensors.push_back({ "lm.depth.blk_0.ffn_up.weight",     { H, I } });
+                tensors.push_back({ "lm.depth.blk_0.ffn_down.weight",   { I, H } });
+            }
+
+            codec_lm_test_model tm(gguf, tensors);
+            codec_lm * lm = codec_lm_create(&tm.model);
+            if (lm == nullptr) {
+                std::cout << "[" << kind << ": " << codec_lm_get_create_error() << "] ";
+                return false;
+            }
+
+            uint32_t seed = 99;
+            std::vector<float> h((size_t) n_frames * n_seq * H);
+            for (float & v : h) { seed = seed * 1664525u + 1013904223u; v = (float) (seed >> 8) / (float) (1u << 24) - 0.5f; }
+
+            std::vector<int32_t> codes;
+            std::vector<std::vector<float>> logits_seq, logits_batch;
+            bool ok = codec_lm_test_steps(lm, n_seq, n_frames, false, h, codes, logits_seq) &&
+                      codec_lm_test_steps(lm, n_seq, n_frames, true,  h, codes, logits_batch) &&
+                      logits_seq.size() == (size_t) n_frames * n_cb * n_seq && logits_seq.size() == logits_batch.size();
+            for (size_t i = 0; ok && i < logits_seq.size(); ++i) {
+                for (size_t j = 0; ok && j < logits_seq[i].size(); ++j) {
+                    ok = std::fabs(logits_seq[i][j] - logits_batch[i][j]) <= 1e-4f * (1.0f + std::fabs(logits_seq[i][j]));
+                }
+            }
+            if (!ok) {
+                std::cout << "[" << kind << ": batched logits differ (" << codec_lm_get_last_error(lm) << ")] ";
+            }
+            codec_lm_free(lm);
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Copy of the test model with 2 heads of 32 (instead of 4 heads of 16) so that the K rows fit Q8_0 blocks
+// the tensor shapes are unchanged, only the attention hyperparameters are rewritten
+static std::string make_head32_test_model() {
+    const std::string path = (std::filesystem::temp_directory_path() / "tiny-random-llama-head32.gguf").string();
+
+    lm_ggml_context * meta = nullptr;
+
+    lm_gguf_init_params gparams = { /*.no_alloc =*/ false, /*.ctx =*/ &meta };
+    lm_gguf_context * src = lm_gguf_init_from_file("../tiny-random-llama.gguf", gparams);
+    if (!src) {
+        return "";
+    }
+
+    lm_gguf_context * dst = lm_gguf_init_empty();
+    lm_gguf_set_kv(dst, src);
+    lm_gguf_set_val_u32(dst, "llama.attention.head_count",    2);
+    lm_gguf_set_val_u32(dst, "llama.attention.head_count_kv", 1);
+    lm_gguf_set_val_u32(dst, "llama.rope.dimension_count",    32);
+
+    for (int64_t i = 0; i < lm_gguf_get_n_tensors(src); ++i) {
+        lm_gguf_add_tensor(dst, lm_ggml_get_tensor(meta, lm_gguf_get_tensor_name(src, i)));
+    }
+
+    const bool ok = lm_gguf_write_to_file(dst, path.c_str(), false);
+
+    lm_gguf_free(dst);
+    lm_gguf_free(src);
+    lm_ggml_free(meta);
+
+    return ok ? path : "";
+}
+
+// Test that a two-tier KV cache (F16 keys for the recent cells over a Q8_0 K cache) keeps decoding past
+// the hot window, stays at least as close to an F16 cache as a plain Q8_0 cache and restores its state
+bool test_kv_cache_tiers() {
+    try {
+        const std::string model_path = make_head32_test_model();
+        if (model_path.empty()) {
+            std::cout << "Failed to write the test model" << std::endl;
+            return false;
+        }
+
+        // 600 tokens with a 256-cell hot window (64 per sequence, padded) - the oldest cells migrate twice
+        const int n_tok = 600;
+
+        std::vector<float> logits[3];
+        std::vector<float> logits_restored;
+
+        for (int i = 0; i < 3; ++i) {
+            llama_rn_context ctx;
+
+            common_params params;
+            params.model.path = model_path;
+            params.n_ctx = 1024;
+            params.n_batch = 32;
+            params.cpuparams.n_threads = 1;
+            params.n_gpu_layers = 0;
+            params.no_kv_offload = true;
+            params.flash_attn_type = LLAMA_FLASH_ATTN_TYPE_DISABLED;
+            params.cache_type_k = i == 0 ? LM_GGML_TYPE_F16 : LM_GGML_TYPE_Q8_0;
+            params.cache_n_hot = i == 2 ? 64 : 0;
+
+            if (!ctx.loadModel(params)) {
+                return false;
+            }
+
+            const llama_vocab * vocab = llama_model_get_vocab(ctx.model);
+            const int n_vocab = llama_vocab_n_tokens(vocab);
+
+            auto decode = [&](int p0, int n) {
+                llama_batch batch = llama_batch_init(n, 0, 1);
+                for (int j = 0; j < n; ++j) {
+                    common_batch_add(batch, (llama_token) ((p0 + j) % n_vocab), p0 + j, { 0 }, j == n - 1);
+                }
+                const int ret = llama_decode(ctx.ctx, batch);
+                llama_batch_free(batch);
+                return ret == 0;
+            };
+
+            for (int p0 = 0; p0 < n_tok - 1; p0 += 32) {
+                if (!decode(p0, std::min(32, n_tok - 1 - p0))) {
+                    std::cout << "Decode failed at " << p0 << std::endl;
+                    return false;
+                }
+            }
+
+            // the state holds Q8_0 keys for both tiers
+            std::vector<uint8_t> state;
+            if (i == 2) {
+                state.resize(llama_state_seq_get_size(ctx.ctx, 0));
+                state.resize(llama_state_seq_get_data(ctx.ctx, state.data(), state.size(), 0));
+            }
+
+            if (!decode(n_tok - 1, 1)) {
+                std::cout << "Decode failed at " << n_tok - 1 << std::endl;
+                return false;
+            }
+
+            const float * out = llama_get_logits_ith(ctx.ctx, -1);
+            logits[i].assign(out, out + n_vocab);
+
+            if (i == 2) {
+                llama_memory_clear(llama_get_memory(ctx.ctx), true);
+
+                if (llama_state_seq_set_data(ctx.ctx, state.data(), state.size(), 0) != state.size() || !decode(n_tok - 1, 1)) {
+                    std::cout << "Failed to restore the two-tier state" << std::endl;
+                    return false;
+                }
+
+                out = llama_get_logits_ith(ctx.ctx, -1);
+                logits_restored.assign(out, out + n_vocab);
+            }
+        }
+
+        float err_q8 = 0.0f;
+        float err_tiered = 0.0f;
+        float err_restored = 0.0f;
+        for (size_t j = 0; j < logits[0].size(); ++j) {
+            err_q8       = std::max(err_q8,       std::fabs(logits[1][j] - logits[0][j]));
+            err_tiered   = std::max(err_tiered,   std::fabs(logits[2][j] - logits[0][j]));
+            err_restored = std::max(err_restored, std::fabs(logits_restored[j] - logits[0][j]));
+        }
+
+        if (err_tiered > err_q8 + 1e-3f) {
+            std::cout << "Two-tier cache is less accurate than Q8_0: " << err_tiered << " > " << err_q8 << std::endl;
+            return false;
+        }
+
+        if (err_restored > err_q8 + 1e-3f) {
+            std::cout << "Restored two-tier cache is less accurate than Q8_0: " << err_restored << " > " << err_q8 << std::endl;
+            return false;
+        }
+
+        // a 600-token sequence fills the hot cells first, then two sequences of 150 tokens follow with a
+        // 160-position window each: their tokens take the hot cells that the first sequence no longer needs, so
+        // all their keys stay in F16 and the results match an F16 cache
+        std::vector<float> logits_win[2];
+
+        for (int i = 0; i < 2; ++i) {
+            llama_rn_context ctx;
+
+            common_params params;
+            params.model.path = model_path;
+            params.n_ctx = 2048;
+            params.n_batch = 64;
+            params.n_parallel = 3;
+            params.kv_unified = true;
+            params.cpuparams.n_threads = 1;
+            params.n_gpu_layers = 0;
+            params.no_kv_offload = true;
+            params.flash_attn_type = LLAMA_FLASH_ATTN_TYPE_DISABLED;
+            params.cache_type_k = i == 0 ? LM_GGML_TYPE_F16 : LM_GGML_TYPE_Q8_0;
+            params.cache_n_hot = i == 1 ? 160 : 0;
+
+            if (!ctx.loadModel(params)) {
+                return false;
+            }
+
+            const int n_vocab = llama_vocab_n_tokens(llama_model_get_vocab(ctx.model));
+
+            for (int p0 = 0; p0 < 600; p0 += 32) {
+                llama_batch batch = llama_batch_init(32, 0, 1);
+                for (int j = 0; j < std::min(32, 600 - p0); ++j) {
+                    common_batch_add(batch, (llama_token) ((p0 + j + 3) % n_vocab), p0 + j, { 2 }, false);
+                }
+                const int ret = llama_decode(ctx.ctx, batch);
+                llama_batch_free(batch);
+                if (ret != 0) {
+                    std::cout << "Decode failed at " << p0 << std::endl;
+                    return false;
+                }
+            }
+
+            for (int p0 = 0; p0 < 150; p0 += 25) {
+                llama_batch batch = llama_batch_init(50, 0, 1);
+                for (llama_seq_id seq = 0; seq < 2; ++seq) {
+                    for (int j = 0; j < 25; ++j) {
+                        common_batch_add(batch, (llama_token) ((p0 + j + 7*seq) % n_vocab), p0 + j, { seq }, seq == 1 && p0 + j == 149);
+                    }
+                }
+                const int ret = llama_decode(ctx.ctx, batch);
+                llama_batch_free(batch);
+                if (ret != 0) {
+                    std::cout << "Decode failed at " << p0 << std::endl;
+                    return false;
+                }
+            }
+
+            const float * out = llama_get_logits_ith(ctx.ctx, -1);
+            logits_win[i].assign(out, out + n_vocab);
+        }
+
+        // note: the keys of the tiny test model barely move the logits - a single quantized key already shows
+        for (size_t j = 0; j < logits_win[0].size(); ++j) {
+            if (std::fabs(logits_win[1][j] - logits_win[0][j]) > 1e-7f) {
+                std::cout << "Two-tier cache within the hot windows differs from F16 at " << j << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+// Test the split-KV flash attention path (few query rows, KV chunked across threads) against the reference
+// implementation for quantized K/V, with a fully masked KV chunk, a causal tail and attention sinks
+bool test_flash_attn_split_kv() {
+    try {
+        const int     n_threads = 4;
+        const int64_t D         = 64;
+        const int64_t n_kv      = 1024; // >= 512, split into chunks of n_kv / n_threads
+        const int64_t n_head    = 4;
+        const int64_t n_head_kv = 2;
+
+        lm_ggml_backend_t backend = lm_ggml_backend_cpu_init();
+        if (backend == nullptr) {
+            return false;
+        }
+        lm_ggml_backend_cpu_set_n_threads(backend, n_threads);
+
+        uint32_t seed = 7;
+        auto rnd = [&]() { seed = seed * 1664525u + 1013904223u; return (float) (seed >> 8) / (float) (1u << 24) - 0.5f; };
+
+        bool ok = true;
+        for (const lm_ggml_type type : { LM_GGML_TYPE_Q8_0, LM_GGML_TYPE_Q4_0 }) {
+            // up to LM_GGML_FA_SPLIT_KV_Q (16) query rows take the split path
+            for (const int64_t n_q : { 1, 5, 16 }) {
+                lm_ggml_init_params ip = { /* .mem_size = */ 16 * 1024 * 1024, /* .mem_buffer = */ nullptr, /* .no_alloc = */ false };
+                lm_ggml_context * ctx = lm_ggml_init(ip);
+
+                lm_ggml_tensor * q     = lm_ggml_new_tensor_3d(ctx, LM_GGML_TYPE_F32, D, n_q, n_head);
+                lm_ggml_tensor * k     = lm_ggml_new_tensor_3d(ctx, type, D, n_kv, n_head_kv);
+                lm_ggml_tensor * v     = lm_ggml_new_tensor_3d(ctx, type, D, n_kv, n_head_kv);
+                lm_ggml_tensor * mask  = lm_ggml_new_tensor_2d(ctx, LM_GGML_TYPE_F16, n_kv, n_q);
+                lm_ggml_tensor * sinks = lm_ggml_new_tensor_1d(ctx, LM_GGML_TYPE_F32, n_head);
+
+                for (int64_t i = 0; i < lm_ggml_nelements(q); ++i) {
+                    ((float *) q->data)[i] = rnd();
+                }
+                for (lm_ggml_tensor * t : { k, v }) {
+                    std::vector<float> f(lm_ggml_nelements(t));
+                    for (float & x : f) {
+                        x = rnd();
+                    }
+                    lm_ggml_quantize_chunk(type, f.data(), t->data, 0, lm_ggml_nrows(t), D, nullptr);
+                }
+                for (int64_t i = 0; i < n_head; ++i) {
+                    ((float *) sinks->data)[i] = 2.0f * rnd();
+                }
+                // the second KV chunk is masked out entirely, the last n_q positions causally
+                for (int64_t iq = 0; iq < n_q; ++iq) {
+                    for (int64_t ic = 0; ic < n_kv; ++ic) {
+                        const bool masked = (ic >= n_kv / n_threads && ic < 2 * n_kv / n_threads) || ic > n_kv - n_q + iq;
+                        ((lm_ggml_fp16_t *) mask->data)[iq * n_kv + ic] = lm_ggml_fp32_to_fp16(masked ? -INFINITY : 0.0f);
+                    }
+                }
+
+                lm_ggml_tensor * out = lm_ggml_flash_attn_ext(ctx, q, k, v, mask, 1.0f / std::sqrt((float) D), 0.0f, 0.0f);
+                lm_ggml_flash_attn_ext_add_sinks(out, sinks);
+
+                lm_ggml_cgraph * gf = lm_ggml_new_graph(ctx);
+                lm_ggml_build_forward_expand(gf, out);
+
+                std::vector<float> split(lm_ggml_nelements(out));
+                std::vector<float> ref(lm_ggml_nelements(out));
+                lm_ggml_backend_cpu_set_use_ref(backend, false);
+                ok = lm_ggml_backend_graph_compute(backend, gf) == LM_GGML_STATUS_SUCCESS;
+                memcpy(split.data(), out->data, lm_ggml_nbytes(out));
+                lm_ggml_backend_cpu_set_use_ref(backend, true);
+                ok = ok && lm_ggml_backend_graph_compute(backend, gf) == LM_GGML_STATUS_SUCCESS;
+                memcpy(ref.data(), out->data, lm_ggml_nbytes(out));
+                lm_ggml_free(ctx);
+
+                double max_err = 0.0, max_ref = 0.0;
+                for (size_t i = 0; i < ref.size(); ++i) {
+                    max_err = std::max(max_err, (double) std::fabs(split[i] - ref[i]));
+                    max_ref = std::max(max_ref, (double) std::fabs(ref[i]));
+                }
+                if (!ok || !std::isfinite(max_err) || max_ref == 0.0 || max_err > 1e-4 * max_ref) {
+                    std::cout << "[" << lm_ggml_type_name(type) << " n_q = " << n_q << ": max err " << max_err << " / " << max_ref << "] ";
+                    ok = false;
+                    break;
+                }
+            }
+            if (!ok) {
+                break;
+            }
+        }
+
+        lm_ggml_backend_free(backend);
+        return ok;
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
+bool test_cpu_op_profiler() {
+    try {
+        llama_rn_context ctx;
+
+        common_params params;
+        params.model.path = "../tiny-random-llama.gguf";
+        params.n_ctx = 256;
+        params.n_batch = 32;
+        params.cpuparams.n_threads = 2;
+        params.n_gpu_layers = 0;
+
+        if (!ctx.loadModel(params)) {
+            return false;
+        }
+
+        ctx.enableProfiler();
+
+        llama_batch batch = llama_batch_init(8, 0, 1);
+        for (int j = 0; j < 8; ++j) {
+            common_batch_add(batch, (llama_token) j, j, { 0 }, j == 7);
+        }
+        const int ret = llama_decode(ctx.ctx, batch);
+        llama_batch_free(batch);
+        if (ret != 0) {
+            std::cout << "Decode failed" << std::endl;
+            return false;
+        }
+
+        json profile = json::parse(ctx.getProfileJson());
+        if (!profile["enabled"].get<bool>() || profile["n_graphs"].get<int64_t>() < 1) {
+            std::cout << "Profiler did not record any graph" << std::endl;
+            return false;
+        }
+
+        bool has_mul_mat = false;
+        for (const auto & op : profile["ops"]) {
+            has_mul_mat |= op["op"] == "MUL_MAT" && op["n_calls"].get<int64_t>() > 0 && op["bytes"].get<int64_t>() > 0;
+        }
+        if (!has_mul_mat || profile["nodes"].empty() || profile["threads"].empty()) {
+            std::cout << "Profile is missing MUL_MAT, node or thread stats" << std::endl;
+            return false;
+        }
+
+        // reading the profile while decodes fold new stats in must not race
+        std::atomic<bool> decoding{true};
+        std::atomic<bool> reads_ok{true};
+        std::thread reader([&]() {
+            int64_t n_graphs_last = 0;
+            while (decoding.load()) {
+                const json snapshot = json::parse(ctx.getProfileJson());
+                const int64_t n_graphs = snapshot["n_graphs"].get<int64_t>();
+                if (n_graphs < n_graphs_last || !snapshot["ops"].is_array() || snapshot["ops"].empty()) {
+                    reads_ok = false;
+                }
+                n_graphs_last = n_graphs;
+            }
+        });
+        int n_failed = 0;
+        for (int i = 0; i < 8; ++i) {
+            llama_memory_clear(llama_get_memory(ctx.ctx), true);
+            llama_batch step = llama_batch_init(8, 0, 1);
+            for (int j = 0; j < 8; ++j) {
+                common_batch_add(step, (llama_token) (i + j), j, { 0 }, j == 7);
+            }
+            n_failed += llama_decode(ctx.ctx, step) != 0;
+            llama_batch_free(step);
+        }
+        decoding = false;
+        reader.join();
+        if (n_failed > 0 || !reads_ok || json::parse(ctx.getProfileJson())["n_graphs"].get<int64_t>() < 9) {
+            std::cout << "Profiler lost graphs while being read concurrently" << std::endl;
+            return false;
+        }
+
+        ctx.resetProfiler();
+        if (!json::parse(ctx.getProfileJson())["nodes"].empty()) {
+            std::cout << "Profiler reset did not clear the stats" << std::endl;
+            return false;
+        }
+
+        // disabling while another thread decodes must wait for the graph recording into the profiler
+        std::atomic<bool> decoder_started{false};
+        std::thread decoder([&]() {
+            for (int i = 0; i < 4; ++i) {
+                llama_memory_clear(llama_get_memory(ctx.ctx), true);
+                llama_batch step = llama_batch_init(8, 0, 1);
+                for (int j = 0; j < 8; ++j) {
+                    common_batch_add(step, (llama_token) j, j, { 0 }, j == 7);
+                }
+                llama_decode(ctx.ctx, step);
+                llama_batch_free(step);
+                decoder_started = true;
+            }
+        });
+        while (!decoder_started.load()) {
+            std::this_thread::yield();
+        }
+        ctx.disableProfiler();
+        decoder.join();
+
+        return !json::parse(ctx.getProfileJson())["enabled"].get<bool>();
+    } catch (const std::exception& e) {
+        std::cout << "Exception: " << e.what() << std::endl;
+        return false;
+    } catch (...) {
+        std::cout << "Unknown exception" << std::endl;
+        return false;
+    }
+}
+
 bool test_completion_generation_timing() {
     try {
         llama_rn_context_completion completion(nullptr);
@@ -344,11 +2333,30 @@ int main() {
 
     // Run all tests
     results.run_test("Context Creation and Model Loading", test_context_creation_and_model_loading());
+    results.run_test("Model Sharing", test_model_sharing());
+    results.run_test("Shared Compute Arena", test_shared_compute_arena());
     results.run_test("Tokenization", test_tokenization());
+    results.run_test("Parallel Tokenization", test_parallel_tokenization());
+    results.run_test("Special Token Partition", test_special_token_partition());
+    results.run_test("BPE Word Cache", test_bpe_word_cache());
     results.run_test("Completion", test_completion());
     results.run_test("Completion Generation Timing", test_completion_generation_timing());
     results.run_test("Graceful Context Init Failure", test_context_init_failure_is_graceful());
     results.run_test("Utility Functions", test_utilities());
+    results.run_test("TTS Segment Splitting", test_split_tts_segments());
+    results.run_test("Speaker File Round Trip", test_speaker_file_round_trip());
+    results.run_test("Video Frame Dedup", test_video_frame_dedup());
+    results.run_test("Repack Cache File", test_repack_cache_file());
+    results.run_test("N-gram Lookup Cache", test_ngram_lookup_cache());
+    results.run_test("KV Cache Compaction", test_kv_cache_compaction());
+    results.run_test("Attention-Sink Streaming Eviction", test_sink_streaming_eviction(8));
+    results.run_test("Attention-Sink Streaming Eviction (single token)", test_sink_streaming_eviction(1));
+    results.run_test("Two-Tier KV Cache", test_kv_cache_tiers());
+    results.run_test("Flash Attention Split-KV", test_flash_attn_split_kv());
+    results.run_test("CPU Op Profiler", test_cpu_op_profiler());
+    results.run_test("Codec Quantized Matmul", test_codec_quantized_matmul());
+    results.run_test("Codec Graph Cache Buckets", test_codec_graph_cache_buckets());
+    results.run_test("Codec LM Batched Steps", test_codec_lm_step_batch());
 
     // Print summary
     results.print_summary();
@@ -26,7 +26,12 @@
 // Usage:
 //   tts_probe --backbone LM.gguf --codec CODEC.gguf --text "..." \
 //             [--speaker-json PATH] [--n-predict N] [--threads N] \
-//             [--out-wav PATH]
+//             [--out-wav PATH] [--long-form MAX_CHARS]
+//
+// --long-form runs the text through synthesizeLongForm instead (split at
+// sentence boundaries, segments of at most MAX_CHARS bytes) and checks
+// that every segment's chunk arrives once, in order, before writing the
+// concatenated audio.
 
 #include <chrono>
 #include <cmath>
@@ -106,6 +111,7 @@ int main(int argc, char ** argv) {
     int  n_gpu_layers = 0;   // backbone GPU offload (Metal on macOS)
     float repeat_penalty = 0.0f;  // > 0 overrides the default (1.0 = off)
     bool codec_gpu = false;  // run the codec on GPU (mirrors the app's use_gpu default when ngl > 0)
+    int  long_form = -1;     // >= 0: synthesizeLongForm with this max_segment_chars
 
     for (int i = 1; i < argc; ++i) {
         auto is = [&](const char * k) { return std::strcmp(argv[i], k) == 0; };
@@ -127,13 +133,15 @@ int main(int argc, char ** argv) {
         else if (is("--ngl")          && i + 1 < argc) n_gpu_layers      = std::atoi(argv[++i]);
         else if (is("--repeat-penalty") && i + 1 < argc) repeat_penalty  = (float) std::atof(argv[++i]);
         else if (is("--codec-gpu"))                    codec_gpu         = true;
+        else if (is("--long-form")    && i + 1 < argc) long_form         = std::atoi(argv[++i]);
         else { std::fprintf(stderr, "unknown arg: %s\n", argv[i]); return 2; }
     }
 
     if (backbone_path.empty() || codec_path.empty()) {
         std::fprintf(stderr,
             "usage: tts_probe --backbone LM.gguf --codec CODEC.gguf --text \"...\"\n"
-            "                 [--speaker-json PATH] [--n-predict N] [--threads N] [--out-wav PATH]\n");
+            "                 [--speaker-json PATH] [--n-predict N] [--threads N] [--out-wav PATH]\n"
+            "                 [--long-form MAX_CHARS]\n");
         return 2;
     }
     for (const auto & p : { backbone_path, codec_path }) {
@@ -260,6 +268,45 @@ int main(int argc, char ** argv) {
         codec_common::audio_lm_reset(ctx.tts_wrapper->audio_lm_ctx);
     }
 
+    if (long_form >= 0) {
+        llama_rn_long_form_tts_options lf;
+        lf.text              = text;
+        lf.speaker_json      = speaker_json;
+        lf.max_segment_chars = long_form;
+        lf.n_predict         = n_predict;
+        lf.temperature       = temp;
+        lf.top_p             = top_p;
+        lf.top_k             = top_k;
+        lf.seed              = seed;
+        const size_t n_expected = split_tts_segments(text, (size_t) long_form).size();
+        std::vector<float> pcm;
+        int next_segment = 0;
+        bool in_order = true;
+        const auto tl0 = std::chrono::steady_clock::now();
+        const llama_rn_long_form_tts_result res = ctx.tts_wrapper->synthesizeLongForm(
+            &ctx, lf, [&](int segment, const std::vector<float> & chunk) {
+                const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - tl0).count();
+                std::printf("[probe] segment %d: %zu samples at %.2fs\n", segment, chunk.size(), t);
+                in_order = in_order && segment == next_segment++;
+                pcm.insert(pcm.end(), chunk.begin(), chunk.end());
+                return true;
+            });
+        std::printf("\n[probe] === LONG FORM ===\n");
+        std::printf("  segments    : %d / %zu\n", res.n_segments, n_expected);
+        std::printf("  samples     : %lld\n", (long long) res.n_samples);
+        std::printf("  in order    : %d\n", (int) in_order);
+        if (!in_order || res.aborted || res.n_segments != (int) n_expected ||
+            res.n_samples != (int64_t) pcm.size() || pcm.empty()) {
+            std::fprintf(stderr, "[probe] long-form run incomplete or out of order\n");
+            return 10;
+        }
+        if (!out_wav.empty() && !write_wav_mono16(out_wav, pcm, res.sample_rate)) {
+            std::fprintf(stderr, "[probe] failed to write %s\n", out_wav.c_str());
+            return 9;
+        }
+        return 0;
+    }
+
     // Build prompt via the exact same entry point the JS layer uses.
     const auto formatted = ctx.tts_wrapper->getFormattedAudioCompletion(
         &ctx, speaker_json, text);